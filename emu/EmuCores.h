@@ -12,6 +12,7 @@
 #define FCC_OOTK	0x4F4F544B	// Ootake
 #define FCC_MEDN	0x4D45444E	// Mednafen
 #define FCC_NUKE	0x4E554B45	// Nuked OPx
+#define FCC_NUKV	0x4E554B56	// Nuked OPx, batched sample engine
 #define FCC_NRS_	0x4E525300	// NewRisingSun
 #define FCC_VBEL	0x5642454C	// Valley Bell
 #define FCC_CTR_	0x43545200	// superctr
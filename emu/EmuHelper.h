@@ -2,6 +2,7 @@
 #define __EMUHELPER_H__
 
 #include <stddef.h>	// for NULL
+#include <string.h>	// for memcpy
 #include "../stdtype.h"
 #include "../common_def.h"	// for INLINE
 #include "EmuStructs.h"
@@ -85,4 +86,12 @@ INLINE UINT32 pow2_mask(UINT32 v)
 	return v;
 }
 
+// helper for cores whose state is a single memory block (DEVFUNC_READ_STATE)
+INLINE UINT32 devstate_save_block(const void* chipData, UINT32 stateSize, UINT32 bufSize, void* buffer)
+{
+	if (buffer != NULL && bufSize >= stateSize)
+		memcpy(buffer, chipData, stateSize);
+	return stateSize;
+}
+
 #endif	// __EMUHELPER_H__
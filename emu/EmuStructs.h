@@ -54,10 +54,25 @@ typedef void (*DEVFUNC_WRITE_A16D8)(void* info, UINT16 addr, UINT8 data);
 typedef void (*DEVFUNC_WRITE_A16D16)(void* info, UINT16 addr, UINT16 data);
 typedef void (*DEVFUNC_WRITE_MEMSIZE)(void* info, UINT32 memsize);
 typedef void (*DEVFUNC_WRITE_BLOCK)(void* info, UINT32 offset, UINT32 length, const UINT8* data);
+// use caller-owned ROM data of size "memsize" directly instead of a private copy (data == NULL: release it)
+// The data must stay valid and unchanged until the device is stopped or the ROM is replaced
+// (DEVRW_ROMREF call or DEVRW_MEMSIZE with a different size). DEVRW_BLOCK writes make the device copy it first.
+typedef void (*DEVFUNC_WRITE_ROMREF)(void* info, UINT32 memsize, const UINT8* data);
 typedef void (*DEVFUNC_WRITE_CLOCK)(void* info, UINT32 clock);
 typedef void (*DEVFUNC_WRITE_VOLUME)(void* info, INT32 volume);	// 16.16 fixed point
 typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 
+// save chip state to buffer, returns size of the state data (buffer == NULL: only return the size)
+// Note: The state data is only valid for the device instance it was saved from.
+typedef UINT32 (*DEVFUNC_READ_STATE)(void* info, UINT32 bufSize, void* buffer);
+// restore chip state, returns 0x00 on success or 0xFF if the data doesn't match the device
+typedef UINT8 (*DEVFUNC_WRITE_STATE)(void* info, UINT32 dataSize, const void* data);
+// returns 1 if the output is zero until the next register/memory write, else 0
+// This only describes the output. Skipping Update() calls while silent also pauses free-running
+// state (tone/noise counters, LFO, envelope clock), so the output after the next write is not
+// sample-exact. Callers must only skip updates when the user asked for it.
+typedef UINT8 (*DEVFUNC_READ_SILENCE)(void* info);
+
 #define RWF_WRITE		0x00
 #define RWF_READ		0x01
 #define RWF_QUICKWRITE	(0x02 | RWF_WRITE)
@@ -69,6 +84,8 @@ typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 #define RWF_SRATE		0x82	// sample rate
 #define RWF_VOLUME		0x84	// volume (all speakers)
 #define RWF_VOLUME_LR	0x86	// volume (left/right separately)
+#define RWF_STATE		0x88	// chip state (RWF_READ = save, RWF_WRITE = restore, DEVRW_ALL)
+#define RWF_SILENCE		0x8A	// output silence query (RWF_READ, DEVRW_VALUE)
 #define RWF_CHN_MUTE	0x90	// set channel muting (DEVRW_VALUE = single channel, DEVRW_ALL = mask)
 #define RWF_CHN_PAN		0x92	// set channel panning (DEVRW_VALUE = single channel, DEVRW_ALL = array)
 
@@ -79,6 +96,7 @@ typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 #define DEVRW_A16D16	0x22	// 16-bit address, 16-bit data
 #define DEVRW_BLOCK		0x80	// write sample ROM/RAM
 #define DEVRW_MEMSIZE	0x81	// set ROM/RAM size
+#define DEVRW_ROMREF	0x82	// reference external ROM data (read-only, no copy)
 // chip setting DEVRW constants
 #define DEVRW_VALUE		0x00
 #define DEVRW_ALL		0x01
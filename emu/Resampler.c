@@ -1,5 +1,7 @@
 #include <stddef.h>
 #include <stdlib.h>	// for malloc/free
+#include <string.h>	// for memcpy/memmove
+#include <math.h>	// for sin/sqrt/ceil
 #ifdef _DEBUG
 #include <stdio.h>
 #endif
@@ -7,11 +9,16 @@
 #include "../stdtype.h"
 #include "EmuStructs.h"
 #include "Resampler.h"
+#include "mixkernels.h"
+#include "../utils/OSOnce.h"
 
 static void Resmpl_Exec_Old(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
 static void Resmpl_Exec_LinearUp(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
 static void Resmpl_Exec_Copy(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
 static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
+static void Resmpl_Exec_Sinc(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
+static UINT8 Resmpl_Sinc_Setup(RESMPL_STATE* CAA);
+static void Resmpl_Sinc_Free(RESMPL_STATE* CAA);
 
 // Ensures `CAA->smplBufs[0]` and `CAA->smplBufs[1]` can each contain at least `length` samples.
 static void Resmpl_EnsureBuffers(RESMPL_STATE* CAA, UINT32 length)
@@ -78,6 +85,16 @@ static void Resmpl_ChooseResampler(RESMPL_STATE* CAA)
 		else if (CAA->smpRateSrc > CAA->smpRateDst)
 			CAA->resampler = Resmpl_Exec_Old;
 		break;
+	case RSMODE_SINC:	// polyphase windowed-sinc filter (best quality)
+		if (CAA->smpRateSrc == CAA->smpRateDst)
+			CAA->resampler = Resmpl_Exec_Copy;
+		else if (! Resmpl_Sinc_Setup(CAA))
+			CAA->resampler = Resmpl_Exec_Sinc;
+		else if (CAA->smpRateSrc < CAA->smpRateDst)	// fall back to linear interpolation
+			CAA->resampler = Resmpl_Exec_LinearUp;
+		else
+			CAA->resampler = Resmpl_Exec_LinearDown;
+		break;
 	default:
 #ifdef _DEBUG
 		printf("Invalid resampler mode 0x%02X used!\n", CAA->resampleMode);
@@ -89,6 +106,11 @@ static void Resmpl_ChooseResampler(RESMPL_STATE* CAA)
 
 void Resmpl_Init(RESMPL_STATE* CAA)
 {
+	CAA->firTaps = 0;
+	CAA->firCoefs = NULL;
+	CAA->firBufSize = 0;
+	CAA->firBufs[0] = NULL;
+	CAA->firBufs[1] = NULL;
 	if (! CAA->smpRateSrc)
 	{
 		CAA->resampler = NULL;
@@ -129,6 +151,7 @@ void Resmpl_Deinit(RESMPL_STATE* CAA)
 	free(CAA->smplBufs[0]);
 	CAA->smplBufs[0] = NULL;
 	CAA->smplBufs[1] = NULL;
+	Resmpl_Sinc_Free(CAA);
 	
 	return;
 }
@@ -170,6 +193,8 @@ void Resmpl_ChangeRate(void* DataPtr, UINT32 newSmplRate)
 #define fp2i_floor(x)	((x) / FIXPNT_FACT)
 #define fp2i_ceil(x)	((x + FIXPNT_MASK) / FIXPNT_FACT)
 
+#define RESMPL_BLKSIZE	64	// number of samples processed per mixing kernel call
+
 static void Resmpl_Exec_Old(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample)
 {
 	// RESALGO_OLD: old, but very fast resampler
@@ -253,69 +278,89 @@ static void Resmpl_Exec_LinearUp(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* re
 	DEV_SMPL* CurBufL;
 	DEV_SMPL* CurBufR;
 	DEV_SMPL* StreamPnt[0x02];
-	UINT32 InBase;
 	UINT32 InPos;
 	UINT32 OutPos;
-	UINT32 SmpFrc;	// Sample Fraction
 	UINT32 InPre;
 	UINT32 InNow;
 	SLINT InPosL;
-	INT64 TempSmpL;
-	INT64 TempSmpR;
-	INT32 SmpCnt;	// must be signed, else I'm getting calculation errors
+	SLINT InBaseL;
+	UINT32 BlkLen;
+	UINT32 CurSmpl;
+	UINT32 BlkPos[RESMPL_BLKSIZE];	// input sample index (integer part)
+	UINT32 BlkFrc[RESMPL_BLKSIZE];	// Sample Fraction
 	UINT64 ChipSmpRateFP;
+	UINT64 PosQuot;	// input position (fixed point), calculated incrementally
+	UINT64 PosRem;
+	UINT64 StepQuot;
+	UINT64 StepRem;
 	
 	ChipSmpRateFP = FIXPNT_FACT * (UINT64)CAA->smpRateSrc;
-	// TODO: Make it work *properly* with large blocks. (this is very hackish)
-	for (OutPos = 0; OutPos < length; OutPos ++)
+	
+	// render all input samples required for this block at once
+	InPosL = (SLINT)((CAA->smpP + length - 1) * ChipSmpRateFP / CAA->smpRateDst);
+	InNow = (UINT32)fp2i_ceil(InPosL);
+	Resmpl_EnsureBuffers(CAA, InNow - CAA->smpNext + 3);
+	CurBufL = CAA->smplBufs[0];
+	CurBufR = CAA->smplBufs[1];
+	
+	// buffer index 1 is input sample smpNext, the newly rendered samples follow
+	CurBufL[0] = CAA->lSmpl.L;
+	CurBufR[0] = CAA->lSmpl.R;
+	CurBufL[1] = CAA->nSmpl.L;
+	CurBufR[1] = CAA->nSmpl.R;
+	if (InNow != CAA->smpNext)
 	{
-		InPosL = (SLINT)(CAA->smpP * ChipSmpRateFP / CAA->smpRateDst);
-		InPre = (UINT32)fp2i_floor(InPosL);
-		InNow = (UINT32)fp2i_ceil(InPosL);
-		
-		Resmpl_EnsureBuffers(CAA, InNow - CAA->smpNext + 2);
-		CurBufL = CAA->smplBufs[0];
-		CurBufR = CAA->smplBufs[1];
-		
-		CurBufL[0] = CAA->lSmpl.L;
-		CurBufR[0] = CAA->lSmpl.R;
-		CurBufL[1] = CAA->nSmpl.L;
-		CurBufR[1] = CAA->nSmpl.R;
-		if (InNow != CAA->smpNext)
+		StreamPnt[0] = &CurBufL[2];
+		StreamPnt[1] = &CurBufR[2];
+		CAA->StreamUpdate(CAA->su_DataPtr, InNow - CAA->smpNext, StreamPnt);
+	}
+	// The interpolation kernel reads one sample past the last one. (its weight is 0)
+	CurBufL[InNow - CAA->smpNext + 2] = 0;
+	CurBufR[InNow - CAA->smpNext + 2] = 0;
+	
+	// Note: The position is exactly (smpP * ChipSmpRateFP / smpRateDst), just without a division per sample.
+	InBaseL = (SLINT)CAA->smpNext * FIXPNT_FACT;
+	PosQuot = CAA->smpP * ChipSmpRateFP / CAA->smpRateDst;
+	PosRem = CAA->smpP * ChipSmpRateFP % CAA->smpRateDst;
+	StepQuot = ChipSmpRateFP / CAA->smpRateDst;
+	StepRem = ChipSmpRateFP % CAA->smpRateDst;
+	InPre = InNow = 1;
+	for (OutPos = 0; OutPos < length; OutPos += BlkLen)
+	{
+		BlkLen = length - OutPos;
+		if (BlkLen > RESMPL_BLKSIZE)
+			BlkLen = RESMPL_BLKSIZE;
+		for (CurSmpl = 0; CurSmpl < BlkLen; CurSmpl ++)
 		{
-			StreamPnt[0] = &CurBufL[2];
-			StreamPnt[1] = &CurBufR[2];
-			CAA->StreamUpdate(CAA->su_DataPtr, InNow - CAA->smpNext, StreamPnt);
+			InPosL = (SLINT)PosQuot;
+			// I'm adding 1.0 to avoid negative indexes
+			InPos = FIXPNT_FACT + (UINT32)(InPosL - InBaseL);
+			BlkPos[CurSmpl] = fp2i_floor(InPos);
+			BlkFrc[CurSmpl] = getfraction(InPos);
+			
+			PosQuot += StepQuot;
+			PosRem += StepRem;
+			if (PosRem >= CAA->smpRateDst)
+			{
+				PosRem -= CAA->smpRateDst;
+				PosQuot ++;
+			}
 		}
-		
-		InBase = FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->smpNext * FIXPNT_FACT);
-		SmpCnt = FIXPNT_FACT;
-		CAA->smpLast = InPre;
-		CAA->smpNext = InNow;
-		//for (OutPos = 0; OutPos < length; OutPos ++)
-		//{
-		//InPos = InBase + (UINT32)(OutPos * ChipSmpRateFP / CAA->smpRateDst);
-		InPos = InBase;
-		
-		InPre = fp2i_floor(InPos);
-		InNow = fp2i_ceil(InPos);
-		SmpFrc = getfraction(InPos);
-		
 		// Linear interpolation
-		TempSmpL = ((INT64)CurBufL[InPre] * (FIXPNT_FACT - SmpFrc)) +
-					((INT64)CurBufL[InNow] * SmpFrc);
-		TempSmpR = ((INT64)CurBufR[InPre] * (FIXPNT_FACT - SmpFrc)) +
-					((INT64)CurBufR[InNow] * SmpFrc);
-		retSample[OutPos].L += (INT32)(TempSmpL * CAA->volumeL / SmpCnt);
-		retSample[OutPos].R += (INT32)(TempSmpR * CAA->volumeR / SmpCnt);
-		//}
-		CAA->lSmpl.L = CurBufL[InPre];
-		CAA->lSmpl.R = CurBufR[InPre];
-		CAA->nSmpl.L = CurBufL[InNow];
-		CAA->nSmpl.R = CurBufR[InNow];
-		CAA->smpP ++;
+		MixK_InterpAcc(&retSample[OutPos], CurBufL, CurBufR, BlkPos, BlkFrc, FIXPNT_BITS,
+						BlkLen, CAA->volumeL, CAA->volumeR);
+		InPre = BlkPos[BlkLen - 1];
+		InNow = InPre + (BlkFrc[BlkLen - 1] ? 1 : 0);
 	}
 	
+	CAA->smpLast = CAA->smpNext - 1 + InPre;
+	CAA->smpNext = CAA->smpNext - 1 + InNow;
+	CAA->lSmpl.L = CurBufL[InPre];
+	CAA->lSmpl.R = CurBufR[InPre];
+	CAA->nSmpl.L = CurBufL[InNow];
+	CAA->nSmpl.R = CurBufR[InNow];
+	CAA->smpP += length;
+	
 	if (CAA->smpLast >= CAA->smpRateSrc)
 	{
 		CAA->smpLast -= CAA->smpRateSrc;
@@ -329,17 +374,11 @@ static void Resmpl_Exec_LinearUp(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* re
 static void Resmpl_Exec_Copy(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample)
 {
 	// RESALGO_COPY: Copying
-	UINT32 OutPos;
-	
 	CAA->smpNext = CAA->smpP * CAA->smpRateSrc / CAA->smpRateDst;
 	Resmpl_EnsureBuffers(CAA, length);
 	CAA->StreamUpdate(CAA->su_DataPtr, length, CAA->smplBufs);
 	
-	for (OutPos = 0; OutPos < length; OutPos ++)
-	{
-		retSample[OutPos].L += CAA->smplBufs[0][OutPos] * CAA->volumeL;
-		retSample[OutPos].R += CAA->smplBufs[1][OutPos] * CAA->volumeR;
-	}
+	MixK_ScaleAcc(retSample, CAA->smplBufs[0], CAA->smplBufs[1], length, CAA->volumeL, CAA->volumeR);
 	CAA->smpP += length;
 	CAA->smpLast = CAA->smpNext;
 	
@@ -463,6 +502,349 @@ static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS*
 	return;
 }
 
+// ---- polyphase windowed-sinc resampler ----
+// The filter is centered SINC_HALFTAPS input samples in the past, so the output is delayed by that amount.
+// For downsampling, the filter is stretched by the resampling ratio.
+#define SINC_PHASES		256		// number of filter phases (coefficients are interpolated between phases)
+#define SINC_HALFTAPS	16		// taps on each side of the center (for the lower of both sample rates)
+#define SINC_MAXTAPS	1024	// use linear downsampling for larger ratios
+#define SINC_CUTOFF		0.90	// cutoff frequency, relative to the lower Nyquist frequency
+#define SINC_BETA		8.0		// Kaiser window parameter
+
+#ifndef M_PI
+#define M_PI	3.14159265358979323846
+#endif
+
+typedef void (*SINC_KERNEL)(const float* inL, const float* inR, const float* coef0, const float* coef1,
+							UINT32 taps, float phFrac, float* outL, float* outR);
+
+static void SincKernel_C(const float* inL, const float* inR, const float* coef0, const float* coef1,
+						UINT32 taps, float phFrac, float* outL, float* outR)
+{
+	float accL = 0.0f;
+	float accR = 0.0f;
+	UINT32 curTap;
+	
+	for (curTap = 0; curTap < taps; curTap ++)
+	{
+		float coef = coef0[curTap] + (coef1[curTap] - coef0[curTap]) * phFrac;
+		accL += inL[curTap] * coef;
+		accR += inR[curTap] * coef;
+	}
+	*outL = accL;
+	*outR = accR;
+	return;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#ifdef __SSE2__
+#define SINC_SSE2
+#endif
+#define SINC_AVX2
+#define SINC_TARGET_AVX2	__attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (_MSC_VER >= 1700) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#if defined(_M_X64) || (_M_IX86_FP >= 2)
+#define SINC_SSE2
+#endif
+#define SINC_AVX2
+#define SINC_TARGET_AVX2
+#endif
+
+#ifdef SINC_SSE2
+// requires (taps % 4) == 0
+static void SincKernel_SSE2(const float* inL, const float* inR, const float* coef0, const float* coef1,
+							UINT32 taps, float phFrac, float* outL, float* outR)
+{
+	__m128 accL = _mm_setzero_ps();
+	__m128 accR = _mm_setzero_ps();
+	__m128 frac = _mm_set1_ps(phFrac);
+	UINT32 curTap;
+	
+	for (curTap = 0; curTap < taps; curTap += 4)
+	{
+		__m128 c0 = _mm_loadu_ps(&coef0[curTap]);
+		__m128 c1 = _mm_loadu_ps(&coef1[curTap]);
+		__m128 coef = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(c1, c0), frac));
+		accL = _mm_add_ps(accL, _mm_mul_ps(_mm_loadu_ps(&inL[curTap]), coef));
+		accR = _mm_add_ps(accR, _mm_mul_ps(_mm_loadu_ps(&inR[curTap]), coef));
+	}
+	// horizontal sum: (L0+L2, L1+L3, R0+R2, R1+R3) -> (L, R)
+	{
+		__m128 sumLR = _mm_add_ps(_mm_movelh_ps(accL, accR), _mm_movehl_ps(accR, accL));
+		sumLR = _mm_add_ps(sumLR, _mm_shuffle_ps(sumLR, sumLR, _MM_SHUFFLE(2, 3, 0, 1)));
+		*outL = _mm_cvtss_f32(sumLR);
+		*outR = _mm_cvtss_f32(_mm_movehl_ps(sumLR, sumLR));
+	}
+	return;
+}
+#endif
+
+#ifdef SINC_AVX2
+// requires (taps % 8) == 0
+SINC_TARGET_AVX2 static void SincKernel_AVX2(const float* inL, const float* inR, const float* coef0, const float* coef1,
+											UINT32 taps, float phFrac, float* outL, float* outR)
+{
+	__m256 accL = _mm256_setzero_ps();
+	__m256 accR = _mm256_setzero_ps();
+	__m256 frac = _mm256_set1_ps(phFrac);
+	UINT32 curTap;
+	
+	for (curTap = 0; curTap < taps; curTap += 8)
+	{
+		__m256 c0 = _mm256_loadu_ps(&coef0[curTap]);
+		__m256 c1 = _mm256_loadu_ps(&coef1[curTap]);
+		__m256 coef = _mm256_add_ps(c0, _mm256_mul_ps(_mm256_sub_ps(c1, c0), frac));
+		accL = _mm256_add_ps(accL, _mm256_mul_ps(_mm256_loadu_ps(&inL[curTap]), coef));
+		accR = _mm256_add_ps(accR, _mm256_mul_ps(_mm256_loadu_ps(&inR[curTap]), coef));
+	}
+	{
+		__m256 sum8 = _mm256_hadd_ps(accL, accR);	// (L01 L23 R01 R23 | L45 L67 R45 R67)
+		__m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+		sum4 = _mm_hadd_ps(sum4, sum4);	// (L R L R)
+		*outL = _mm_cvtss_f32(sum4);
+		*outR = _mm_cvtss_f32(_mm_shuffle_ps(sum4, sum4, _MM_SHUFFLE(1, 1, 1, 1)));
+	}
+	return;
+}
+#endif
+
+static SINC_KERNEL sincKernel = NULL;
+static OS_ONCE sincKernelInit = OS_ONCE_INIT;
+
+static void Resmpl_Sinc_InitKernel(void)
+{
+	sincKernel = SincKernel_C;
+#ifdef SINC_SSE2
+	sincKernel = SincKernel_SSE2;
+#endif
+#ifdef SINC_AVX2
+	if (MixK_GetCPUFeatures() & MIXK_CPU_AVX2)
+		sincKernel = SincKernel_AVX2;
+#endif
+	return;
+}
+
+static SINC_KERNEL Resmpl_Sinc_GetKernel(void)
+{
+	// resamplers are used by multiple render threads, so the kernel is selected exactly once
+	OSOnce_Run(&sincKernelInit, Resmpl_Sinc_InitKernel);
+	return sincKernel;
+}
+
+static double BesselI0(double x)
+{
+	// modified Bessel function of the first kind, order 0 (power series)
+	double sum = 1.0;
+	double term = 1.0;
+	double xh2 = x * x / 4.0;
+	UINT32 k;
+	
+	for (k = 1; k < 50; k ++)
+	{
+		term *= xh2 / ((double)k * k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+static void Resmpl_Sinc_Free(RESMPL_STATE* CAA)
+{
+	free(CAA->firCoefs);
+	CAA->firCoefs = NULL;
+	CAA->firTaps = 0;
+	free(CAA->firBufs[0]);
+	CAA->firBufs[0] = NULL;
+	CAA->firBufs[1] = NULL;
+	CAA->firBufSize = 0;
+	
+	return;
+}
+
+// Ensures that the sinc resampler's input buffers can contain at least `length` samples.
+// The history at the beginning of the buffers is kept.
+static void Resmpl_Sinc_EnsureBuffers(RESMPL_STATE* CAA, UINT32 length)
+{
+	float* newBuf;
+	
+	if (CAA->firBufSize >= length)
+		return;
+	
+	newBuf = (float*)malloc(length * 2 * sizeof(float));
+	if (newBuf == NULL)
+		abort();
+	if (CAA->firBufs[0] != NULL)
+	{
+		memcpy(&newBuf[0], CAA->firBufs[0], CAA->firTaps * sizeof(float));
+		memcpy(&newBuf[length], CAA->firBufs[1], CAA->firTaps * sizeof(float));
+		free(CAA->firBufs[0]);
+	}
+	else
+	{
+		memset(newBuf, 0x00, length * 2 * sizeof(float));
+	}
+	CAA->firBufSize = length;
+	CAA->firBufs[0] = &newBuf[0];
+	CAA->firBufs[1] = &newBuf[length];
+	
+	return;
+}
+
+// Calculates the filter coefficients for the current sample rates. Returns 0xFF if the ratio is too large.
+static UINT8 Resmpl_Sinc_Setup(RESMPL_STATE* CAA)
+{
+	double ratio;
+	double cutoff;
+	double halfWidth;
+	double winNorm;
+	UINT32 taps;
+	UINT32 curPh;
+	UINT32 curTap;
+	
+	ratio = (CAA->smpRateSrc > CAA->smpRateDst) ? (double)CAA->smpRateSrc / CAA->smpRateDst : 1.0;
+	taps = (UINT32)ceil(SINC_HALFTAPS * 2 * ratio);
+	taps = (taps + 7) & ~7;	// multiple of 8 for the SIMD kernels
+	if (taps > SINC_MAXTAPS)
+	{
+		Resmpl_Sinc_Free(CAA);
+		return 0xFF;
+	}
+	
+	if (taps != CAA->firTaps)
+	{
+		// The filter length changed - the history isn't usable anymore.
+		Resmpl_Sinc_Free(CAA);
+		CAA->firCoefs = (float*)malloc((SINC_PHASES + 1) * taps * sizeof(float));
+		if (CAA->firCoefs == NULL)
+			return 0xFF;
+		CAA->firTaps = taps;
+	}
+	Resmpl_Sinc_EnsureBuffers(CAA, taps + CAA->smpRateSrc / 10);
+	
+	cutoff = SINC_CUTOFF / ratio;	// relative to the Nyquist frequency of the input
+	halfWidth = taps / 2;
+	winNorm = 1.0 / BesselI0(SINC_BETA);
+	for (curPh = 0; curPh <= SINC_PHASES; curPh ++)
+	{
+		float* coefs = &CAA->firCoefs[curPh * taps];
+		double phFrac = (double)curPh / SINC_PHASES;
+		double coefSum = 0.0;
+		
+		for (curTap = 0; curTap < taps; curTap ++)
+		{
+			// distance (in input samples) between the tap and the filter center
+			double dist = phFrac + halfWidth - 1 - curTap;
+			double winPos = dist / halfWidth;
+			double sincVal;
+			double winVal;
+			
+			if (dist == 0.0)
+				sincVal = cutoff;
+			else
+				sincVal = sin(M_PI * cutoff * dist) / (M_PI * dist);
+			winVal = (winPos <= -1.0 || winPos >= 1.0) ? 0.0 :
+					BesselI0(SINC_BETA * sqrt(1.0 - winPos * winPos)) * winNorm;
+			coefs[curTap] = (float)(sincVal * winVal);
+			coefSum += coefs[curTap];
+		}
+		// normalize for unity gain at DC
+		for (curTap = 0; curTap < taps; curTap ++)
+			coefs[curTap] = (float)(coefs[curTap] / coefSum);
+	}
+	
+	return 0x00;
+}
+
+static void Resmpl_Exec_Sinc(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample)
+{
+	// RESALGO_SINC: polyphase windowed-sinc filter
+	float* CurBufL;
+	float* CurBufR;
+	UINT32 OutPos;
+	UINT32 InLast;
+	UINT32 SmpCnt;
+	UINT32 CurSmpl;
+	UINT32 Taps;
+	UINT32 BufPos;
+	UINT32 PhaseID;
+	float PhaseFrc;
+	float SmplL;
+	float SmplR;
+	SINC_KERNEL kernel = Resmpl_Sinc_GetKernel();
+	UINT64 PosQuot;	// input position (integer part)
+	UINT64 PosRem;	// input position (fraction, in units of 1/smpRateDst)
+	UINT64 StepQuot;
+	UINT64 StepRem;
+	
+	Taps = CAA->firTaps;
+	
+	// render all input samples required for this block at once
+	InLast = (UINT32)((CAA->smpP + length - 1) * (UINT64)CAA->smpRateSrc / CAA->smpRateDst);
+	SmpCnt = (InLast >= CAA->smpNext) ? (InLast + 1 - CAA->smpNext) : 0;
+	Resmpl_Sinc_EnsureBuffers(CAA, Taps + SmpCnt);
+	CurBufL = CAA->firBufs[0];
+	CurBufR = CAA->firBufs[1];
+	if (SmpCnt > 0)
+	{
+		Resmpl_EnsureBuffers(CAA, SmpCnt);
+		CAA->StreamUpdate(CAA->su_DataPtr, SmpCnt, CAA->smplBufs);
+		for (CurSmpl = 0; CurSmpl < SmpCnt; CurSmpl ++)
+		{
+			CurBufL[Taps + CurSmpl] = (float)CAA->smplBufs[0][CurSmpl];
+			CurBufR[Taps + CurSmpl] = (float)CAA->smplBufs[1][CurSmpl];
+		}
+	}
+	
+	// buffer index 0 is input sample (smpNext - Taps)
+	PosQuot = CAA->smpP * (UINT64)CAA->smpRateSrc / CAA->smpRateDst;
+	PosRem = CAA->smpP * (UINT64)CAA->smpRateSrc % CAA->smpRateDst;
+	StepQuot = CAA->smpRateSrc / CAA->smpRateDst;
+	StepRem = CAA->smpRateSrc % CAA->smpRateDst;
+	for (OutPos = 0; OutPos < length; OutPos ++)
+	{
+		// filter input samples (PosQuot - Taps + 1) .. PosQuot
+		BufPos = (UINT32)(PosQuot + 1 - CAA->smpNext);
+		PhaseID = (UINT32)(PosRem * SINC_PHASES / CAA->smpRateDst);
+		PhaseFrc = (float)(PosRem * SINC_PHASES - (UINT64)PhaseID * CAA->smpRateDst) / CAA->smpRateDst;
+		kernel(&CurBufL[BufPos], &CurBufR[BufPos], &CAA->firCoefs[PhaseID * Taps],
+			&CAA->firCoefs[(PhaseID + 1) * Taps], Taps, PhaseFrc, &SmplL, &SmplR);
+		retSample[OutPos].L += (INT32)(SmplL * CAA->volumeL);
+		retSample[OutPos].R += (INT32)(SmplR * CAA->volumeR);
+		
+		PosQuot += StepQuot;
+		PosRem += StepRem;
+		if (PosRem >= CAA->smpRateDst)
+		{
+			PosRem -= CAA->smpRateDst;
+			PosQuot ++;
+		}
+	}
+	
+	// keep the last samples as history for the next block
+	if (SmpCnt > 0)
+	{
+		memmove(&CurBufL[0], &CurBufL[SmpCnt], Taps * sizeof(float));
+		memmove(&CurBufR[0], &CurBufR[SmpCnt], Taps * sizeof(float));
+	}
+	CAA->smpNext += SmpCnt;
+	CAA->smpLast = CAA->smpNext;
+	CAA->smpP += length;
+	
+	// smpNext runs ahead of smpP, so both need to be checked
+	if (CAA->smpP >= CAA->smpRateDst && CAA->smpLast >= CAA->smpRateSrc)
+	{
+		CAA->smpLast -= CAA->smpRateSrc;
+		CAA->smpNext -= CAA->smpRateSrc;
+		CAA->smpP -= CAA->smpRateDst;
+	}
+	
+	return;
+}
+
 void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 smplCount, WAVE_32BS* smplBuffer)
 {
 	if (! smplCount)
@@ -474,3 +856,171 @@ void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 smplCount, WAVE_32BS* smplBuffer)
 		CAA->smpP += CAA->smpRateDst;	// just skip the samples and do nothing else
 	return;
 }
+
+static void Resmpl_SilentStream(void* info, UINT32 samples, DEV_SMPL** outputs)
+{
+	memset(outputs[0], 0x00, samples * sizeof(DEV_SMPL));
+	memset(outputs[1], 0x00, samples * sizeof(DEV_SMPL));
+	return;
+}
+
+// Returns 1 if the resampler holds no input samples other than silence.
+static UINT8 Resmpl_HistoryIsSilent(const RESMPL_STATE* CAA)
+{
+	UINT32 curSmpl;
+	
+	if (CAA->resampler == Resmpl_Exec_Copy)
+		return 1;
+	if (CAA->lSmpl.L || CAA->lSmpl.R)
+		return 0;
+	if (CAA->resampler == Resmpl_Exec_LinearUp)
+		return ! (CAA->nSmpl.L || CAA->nSmpl.R);
+	if (CAA->resampler == Resmpl_Exec_Sinc)
+	{
+		for (curSmpl = 0; curSmpl < CAA->firTaps; curSmpl ++)
+		{
+			if (CAA->firBufs[0][curSmpl] != 0.0f || CAA->firBufs[1][curSmpl] != 0.0f)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+// Advances the resampling position exactly like the resampling functions do.
+// All input and history samples are silent, so the output and history remain silent as well.
+static void Resmpl_AdvanceSilent(RESMPL_STATE* CAA, UINT32 length)
+{
+	UINT64 ChipSmpRateFP = FIXPNT_FACT * (UINT64)CAA->smpRateSrc;
+	SLINT InPosL;
+	
+	if (CAA->resampler == Resmpl_Exec_Old)
+	{
+		if (length > 1)
+			CAA->smpNext = (UINT32)((UINT64)(CAA->smpP + length - 1) * CAA->smpRateSrc / CAA->smpRateDst);
+		CAA->smpLast = CAA->smpNext;
+		CAA->smpP += length;
+		CAA->smpNext = (UINT32)((UINT64)CAA->smpP * CAA->smpRateSrc / CAA->smpRateDst);
+	}
+	else if (CAA->resampler == Resmpl_Exec_LinearUp)
+	{
+		UINT32 InPos;
+		UINT32 InPre;
+		UINT32 InNow;
+		
+		// position of the last output sample, relative to the input sample (smpNext - 1)
+		InPosL = (SLINT)((CAA->smpP + length - 1) * ChipSmpRateFP / CAA->smpRateDst);
+		InPos = FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->smpNext * FIXPNT_FACT);
+		InPre = fp2i_floor(InPos);
+		InNow = InPre + (getfraction(InPos) ? 1 : 0);
+		CAA->smpLast = CAA->smpNext - 1 + InPre;
+		CAA->smpNext = CAA->smpNext - 1 + InNow;
+		CAA->smpP += length;
+	}
+	else if (CAA->resampler == Resmpl_Exec_Copy)
+	{
+		CAA->smpNext = CAA->smpP * CAA->smpRateSrc / CAA->smpRateDst;
+		CAA->smpP += length;
+		CAA->smpLast = CAA->smpNext;
+	}
+	else if (CAA->resampler == Resmpl_Exec_LinearDown)
+	{
+		InPosL = (SLINT)((CAA->smpP + length) * ChipSmpRateFP / CAA->smpRateDst);
+		CAA->smpNext = (UINT32)fp2i_ceil(InPosL);
+#if FIXPNT_OFLW_BIT < 32
+		if (CAA->smpNext < CAA->smpLast)
+		{
+			CAA->smpNext |= CAA->smpLast & ~(((UINT32)1 << FIXPNT_OFLW_BIT) - 1);
+			if (CAA->smpNext < CAA->smpLast)
+				CAA->smpNext += ((UINT32)1 << FIXPNT_OFLW_BIT);
+		}
+#endif
+		CAA->smpP += length;
+		CAA->smpLast = CAA->smpNext;
+	}
+	else if (CAA->resampler == Resmpl_Exec_Sinc)
+	{
+		UINT32 InLast = (UINT32)((CAA->smpP + length - 1) * (UINT64)CAA->smpRateSrc / CAA->smpRateDst);
+		
+		// The history is shifted by the number of new samples, but it stays silent.
+		if (InLast >= CAA->smpNext)
+			CAA->smpNext = InLast + 1;
+		CAA->smpLast = CAA->smpNext;
+		CAA->smpP += length;
+		if (CAA->smpP >= CAA->smpRateDst && CAA->smpLast >= CAA->smpRateSrc)
+		{
+			CAA->smpLast -= CAA->smpRateSrc;
+			CAA->smpNext -= CAA->smpRateSrc;
+			CAA->smpP -= CAA->smpRateDst;
+		}
+		return;
+	}
+	
+	if (CAA->smpLast >= CAA->smpRateSrc)
+	{
+		CAA->smpLast -= CAA->smpRateSrc;
+		CAA->smpNext -= CAA->smpRateSrc;
+		CAA->smpP -= CAA->smpRateDst;
+	}
+	
+	return;
+}
+
+void Resmpl_ExecuteSilent(RESMPL_STATE* CAA, UINT32 smplCount, WAVE_32BS* smplBuffer)
+{
+	DEVFUNC_UPDATE devUpdate;
+	
+	if (! smplCount)
+		return;
+	
+	if (CAA->resampler == NULL)
+	{
+		CAA->smpP += CAA->smpRateDst;	// same as Resmpl_Execute
+	}
+	else if (Resmpl_HistoryIsSilent(CAA))
+	{
+		Resmpl_AdvanceSilent(CAA, smplCount);
+	}
+	else
+	{
+		// resample the tail of the previous samples, followed by silence
+		devUpdate = CAA->StreamUpdate;
+		CAA->StreamUpdate = Resmpl_SilentStream;
+		CAA->resampler(CAA, smplCount, smplBuffer);
+		CAA->StreamUpdate = devUpdate;
+	}
+	return;
+}
+
+UINT32 Resmpl_GetHistorySize(const RESMPL_STATE* CAA)
+{
+	return CAA->firTaps * 2 * sizeof(float);
+}
+
+void Resmpl_SaveHistory(const RESMPL_STATE* CAA, void* buffer)
+{
+	UINT8* bufPtr = (UINT8*)buffer;
+	
+	if (! CAA->firTaps)
+		return;
+	memcpy(bufPtr, CAA->firBufs[0], CAA->firTaps * sizeof(float));	bufPtr += CAA->firTaps * sizeof(float);
+	memcpy(bufPtr, CAA->firBufs[1], CAA->firTaps * sizeof(float));
+	return;
+}
+
+void Resmpl_LoadHistory(RESMPL_STATE* CAA, UINT32 dataSize, const void* data)
+{
+	const UINT8* dataPtr = (const UINT8*)data;
+	
+	if (! CAA->firTaps)
+		return;
+	if (dataSize != Resmpl_GetHistorySize(CAA))
+	{
+		// saved with a different filter - start with a clean history
+		memset(CAA->firBufs[0], 0x00, CAA->firTaps * sizeof(float));
+		memset(CAA->firBufs[1], 0x00, CAA->firTaps * sizeof(float));
+		return;
+	}
+	memcpy(CAA->firBufs[0], dataPtr, CAA->firTaps * sizeof(float));	dataPtr += CAA->firTaps * sizeof(float);
+	memcpy(CAA->firBufs[1], dataPtr, CAA->firTaps * sizeof(float));
+	return;
+}
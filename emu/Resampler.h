@@ -24,6 +24,7 @@ struct _waveform_32bit_stereo
 #define RSMODE_LINEAR	0x00	// linear interpolation (good quality)
 #define RSMODE_NEAREST	0x01	// nearest-neighbour (low quality)
 #define RSMODE_LUP_NDWN	0x02	// nearest-neighbour downsampling, interpolation upsampling
+#define RSMODE_SINC		0x03	// polyphase windowed-sinc filter (best quality, slowest)
 struct _resampling_state
 {
 	UINT32 smpRateSrc;
@@ -41,6 +42,11 @@ struct _resampling_state
 	WAVE_32BS nSmpl;	// Next Sample
 	UINT32 smplBufSize;
 	DEV_SMPL* smplBufs[2];
+	// used by the sinc resampler only
+	UINT32 firTaps;		// number of filter taps
+	float* firCoefs;	// polyphase coefficient table, (phases + 1) * firTaps
+	UINT32 firBufSize;
+	float* firBufs[2];	// input samples, starting with firTaps samples of history
 };
 
 // ---- resampler helper functions (for quick/comfortable initialization) ----
@@ -88,6 +94,42 @@ void Resmpl_ChangeRate(void* DataPtr, UINT32 newSmplRate);
  * @param smplBuffer buffer for output data
  */
 void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 samples, WAVE_32BS* smplBuffer);
+/**
+ * @brief Render samples as if the device output silence, without calling the device's update function.
+ *        Only the remaining tail of previously rendered samples is resampled.
+ *        When there is none, just the resampling position is advanced.
+ *
+ * @param CAA resampler to be executed
+ * @param samples number of output samples to be rendered
+ * @param smplBuffer buffer for output data
+ */
+void Resmpl_ExecuteSilent(RESMPL_STATE* CAA, UINT32 samples, WAVE_32BS* smplBuffer);
+
+// ---- resampler state functions ----
+/**
+ * @brief Returns the size of the resampler's filter history, which isn't part of RESMPL_STATE itself.
+ *        It is 0 for all resamplers except the sinc resampler.
+ *
+ * @param CAA resampler (or a copy of its RESMPL_STATE)
+ * @return size of the history data in bytes
+ */
+UINT32 Resmpl_GetHistorySize(const RESMPL_STATE* CAA);
+/**
+ * @brief Copies the resampler's filter history into a buffer of Resmpl_GetHistorySize() bytes.
+ *
+ * @param CAA resampler whose history is saved
+ * @param buffer buffer for the history data
+ */
+void Resmpl_SaveHistory(const RESMPL_STATE* CAA, void* buffer);
+/**
+ * @brief Restores the resampler's filter history. If the size doesn't match the current filter,
+ *        the history is cleared instead.
+ *
+ * @param CAA resampler whose history is restored
+ * @param dataSize size of the history data in bytes
+ * @param data history data, as written by Resmpl_SaveHistory
+ */
+void Resmpl_LoadHistory(RESMPL_STATE* CAA, UINT32 dataSize, const void* data);
 
 #ifdef __cplusplus
 }
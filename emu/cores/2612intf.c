@@ -25,6 +25,7 @@ static void ym2612_gens_update(void* chip, UINT32 samples, DEV_SMPL** outputs);
 static UINT8 device_start_ym2612_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 device_start_ym2612_gens(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 device_start_ym2612_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
+static UINT8 device_start_ym2612_nuked_soa(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 
 
 #ifdef EC_YM2612_GPGX
@@ -33,6 +34,9 @@ static DEVDEF_RWFUNC devFunc_MAME[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym2612_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym2612_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2612_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ym2612_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ym2612_load_state},
+	{RWF_SILENCE | RWF_READ, DEVRW_VALUE, 0, ym2612_is_silent},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME =
@@ -85,6 +89,8 @@ static DEVDEF_RWFUNC devFunc_Nuked[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, nukedopn2_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, nukedopn2_read},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, nukedopn2_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, nukedopn2_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_Nuked =
@@ -105,6 +111,25 @@ static DEV_DEF devDef_Nuked =
 	
 	devFunc_Nuked,	// rwFuncs
 };
+// same model and state as devDef_Nuked, but generating whole samples instead of single cycles
+static DEV_DEF devDef_NukedSoA =
+{
+	"YM3438", "Nuked OPN2 (SoA)", FCC_NUKV,
+	
+	device_start_ym2612_nuked_soa,
+	nukedopn2_shutdown,
+	nukedopn2_reset_chip,
+	nukedopn2_update_soa,
+	
+	nukedopn2_set_options,	// SetOptionBits
+	nukedopn2_set_mute_mask,	// SetMuteMask
+	NULL,	// SetPanning
+	NULL,	// SetSampleRateChangeCallback
+	NULL,	// SetLoggingCallback
+	NULL,	// LinkDevice
+	
+	devFunc_Nuked,	// rwFuncs
+};
 #endif
 
 static const char* DeviceName_YM2612(const DEV_GEN_CFG* devCfg)
@@ -151,6 +176,7 @@ const DEV_DECL sndDev_YM2612 =
 #endif
 #ifdef EC_YM2612_NUKED
 		&devDef_Nuked,
+		&devDef_NukedSoA,
 #endif
 		NULL
 	}
@@ -232,4 +258,25 @@ static UINT8 device_start_ym2612_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	INIT_DEVINF(retDevInf, devData, rate, &devDef_Nuked);
 	return 0x00;
 }
+
+static UINT8 device_start_ym2612_nuked_soa(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	void* chip;
+	DEV_DATA* devData;
+	UINT32 rate;
+	
+	rate = cfg->clock / 2 / 72;
+	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
+	
+	chip = nukedopn2_init(cfg->clock, rate);
+	if (chip == NULL)
+		return 0xFF;
+	
+	nukedopn2_set_mute_mask(chip, 0x00);
+	
+	devData = (DEV_DATA*)chip;
+	devData->chipInf = chip;
+	INIT_DEVINF(retDevInf, devData, rate, &devDef_NukedSoA);
+	return 0x00;
+}
 #endif
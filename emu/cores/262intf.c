@@ -22,6 +22,7 @@
 static UINT8 device_start_ymf262_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 device_start_ymf262_adlibemu(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 device_start_ymf262_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
+static UINT8 device_start_ymf262_nuked_soa(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 
 
 
@@ -33,6 +34,8 @@ static DEVDEF_RWFUNC devFunc262_MAME[] =
 	{RWF_VOLUME | RWF_WRITE, DEVRW_VALUE, 0, ymf262_set_volume},
 	{RWF_VOLUME_LR | RWF_WRITE, DEVRW_VALUE, 0, ymf262_set_vol_lr},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ymf262_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ymf262_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ymf262_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef262_MAME =
@@ -62,6 +65,8 @@ static DEVDEF_RWFUNC devFunc262_Emu[] =
 	{RWF_VOLUME | RWF_WRITE, DEVRW_VALUE, 0, adlib_OPL3_set_volume},
 	{RWF_VOLUME_LR | RWF_WRITE, DEVRW_VALUE, 0, adlib_OPL3_set_volume_lr},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, adlib_OPL3_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, adlib_OPL3_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, adlib_OPL3_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef262_AdLibEmu =
@@ -91,6 +96,8 @@ static DEVDEF_RWFUNC devFunc262_Nuked[] =
 	{RWF_VOLUME | RWF_WRITE, DEVRW_VALUE, 0, nukedopl3_set_volume},
 	{RWF_VOLUME_LR | RWF_WRITE, DEVRW_VALUE, 0, nukedopl3_set_vol_lr},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, nukedopl3_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, nukedopl3_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, nukedopl3_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef262_Nuked =
@@ -111,6 +118,25 @@ static DEV_DEF devDef262_Nuked =
 	
 	devFunc262_Nuked,	// rwFuncs
 };
+// same model and state as devDef262_Nuked, but running each slot stage for all slots at once
+static DEV_DEF devDef262_NukedSoA =
+{
+	"YMF262", "Nuked OPL3 (stage-ordered)", FCC_NUKV,
+	
+	device_start_ymf262_nuked_soa,
+	nukedopl3_shutdown,
+	nukedopl3_reset_chip,
+	nukedopl3_update_soa,
+	
+	NULL,	// SetOptionBits
+	nukedopl3_set_mute_mask,
+	NULL,	// SetPanning
+	NULL,	// SetSampleRateChangeCallback
+	NULL,	// SetLoggingCallback
+	NULL,	// LinkDevice
+	
+	devFunc262_Nuked,	// rwFuncs
+};
 #endif
 
 static const char* DeviceName(const DEV_GEN_CFG* devCfg)
@@ -156,6 +182,7 @@ const DEV_DECL sndDev_YMF262 =
 #endif
 #ifdef EC_YMF262_NUKED
 		&devDef262_Nuked,
+		&devDef262_NukedSoA,
 #endif
 		NULL
 	}
@@ -231,4 +258,26 @@ static UINT8 device_start_ymf262_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	INIT_DEVINF(retDevInf, devData, rate, &devDef262_Nuked);
 	return 0x00;
 }
+
+static UINT8 device_start_ymf262_nuked_soa(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	void* chip;
+	DEV_DATA* devData;
+	UINT32 rate;
+	
+	rate = cfg->clock / 288;
+	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
+	
+	chip = nukedopl3_init(cfg->clock, rate);
+	if (chip == NULL)
+		return 0xFF;
+	
+	nukedopl3_set_volume(chip, 0x10000);
+	nukedopl3_set_mute_mask(chip, 0x000000);
+	
+	devData = (DEV_DATA*)chip;
+	devData->chipInf = chip;
+	INIT_DEVINF(retDevInf, devData, rate, &devDef262_NukedSoA);
+	return 0x00;
+}
 #endif
@@ -32,7 +32,7 @@
 #endif
 
 #include <math.h>
-#include <stdlib.h> // rand
+#include <stdlib.h>
 #include <string.h> // for memset
 
 #include "../../stdtype.h"
@@ -51,10 +51,7 @@ static Bit32s vibval_const[BLOCKBUF_SIZE];
 static Bit32s tremval_const[BLOCKBUF_SIZE];
 
 // vibrato value tables (used per-operator)
-static Bit32s vibval_var1[BLOCKBUF_SIZE];
-static Bit32s vibval_var2[BLOCKBUF_SIZE];
-//static Bit32s vibval_var3[BLOCKBUF_SIZE];
-//static Bit32s vibval_var4[BLOCKBUF_SIZE];
+// moved to adlib_getsample, so that multiple chips can be rendered in parallel
 
 // vibrato/trmolo value table pointers
 //static Bit32s *vibval1, *vibval2, *vibval3, *vibval4;
@@ -171,10 +168,15 @@ INLINE void operator_advance_drums(OPL_DATA* chip, op_type* op_pt1, Bit32s vib1,
 	Bit32u c3 = op_pt3->tcount/FIXEDPT;
 	Bit32u phasebit = (((c1 & 0x88) ^ ((c1<<5) & 0x80)) | ((c3 ^ (c3<<2)) & 0x20)) ? 0x02 : 0x00;
 
-	Bit32u noisebit = rand()&1;
+	Bit32u noisebit = chip->noise_rng & 1;
 
 	Bit32u snare_phase_bit = (((Bitu)((op_pt1->tcount/FIXEDPT) / 0x100))&1);
 
+	// 23-bit noise LFSR (per chip, the global rand() can't be used when rendering chips in parallel)
+	if (chip->noise_rng & 1)
+		chip->noise_rng ^= 0x800302;
+	chip->noise_rng >>= 1;
+
 	//Hihat
 	Bit32u inttm = (phasebit<<8) | (0x34<<(phasebit ^ (noisebit<<1)));
 	op_pt1->wfpos = inttm*FIXEDPT;				// waveform position
@@ -691,6 +693,7 @@ void* ADLIBEMU(init)(UINT32 clock, UINT32 samplerate)
 	// tremolo at 3.7hz
 	OPL->tremtab_add = (Bit32u)((fltype)TREMTAB_SIZE * TREM_FREQ * FIXEDPT_LFO / (fltype)OPL->int_samplerate);
 	OPL->tremtab_pos = 0;
+	OPL->noise_rng = 1;
 
 	ADLIBEMU(set_update_handler)(OPL, adlibemu_update_req, OPL);
 	//ADLIBEMU(reset)(OPL);
@@ -717,6 +720,7 @@ void ADLIBEMU(reset)(void *chip)
 	memset(OPL->adlibreg, 0x00, sizeof(OPL->adlibreg));
 	memset(OPL->op, 0x00, sizeof(op_type) * MAXOPERATORS);
 	memset(OPL->wave_sel, 0x00, sizeof(OPL->wave_sel));
+	OPL->noise_rng = 1;
 	
 	for (i=0;i<MAXOPERATORS;i++)
 	{
@@ -1195,6 +1199,9 @@ void ADLIBEMU(getsample)(void *chip, UINT32 numsamples, DEV_SMPL** sndptr)
 	// vibrato/tremolo lookup tables (global, to possibly be used by all operators)
 	Bit32s vib_lut[BLOCKBUF_SIZE];
 	Bit32s trem_lut[BLOCKBUF_SIZE];
+	// vibrato value tables (used per-operator)
+	Bit32s vibval_var1[BLOCKBUF_SIZE];
+	Bit32s vibval_var2[BLOCKBUF_SIZE];
 
 	Bit32u cursmp;
 	Bit32s vib_tshift;
@@ -1969,3 +1976,18 @@ void ADLIBEMU(set_volume_lr)(void *chip, INT32 volLeft, INT32 volRight)
 
 	return;
 }
+
+UINT32 ADLIBEMU(save_state)(void *chip, UINT32 bufSize, void* buffer)
+{
+	if (buffer != NULL && bufSize >= sizeof(OPL_DATA))
+		memcpy(buffer, chip, sizeof(OPL_DATA));
+	return sizeof(OPL_DATA);
+}
+
+UINT8 ADLIBEMU(load_state)(void *chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(OPL_DATA))
+		return 0xFF;
+	memcpy(chip, data, sizeof(OPL_DATA));
+	return 0x00;
+}
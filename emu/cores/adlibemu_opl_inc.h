@@ -184,6 +184,7 @@ typedef struct opl_chip
 	Bit32u tremtab_add;
 	
 	Bit32u generator_add;	// should be a chip parameter
+	Bit32u noise_rng;		// noise generator for the rhythm section
 	
 	fltype recipsamp;	// inverse of sampling rate
 	fltype frqmul[16];
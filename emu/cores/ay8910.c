@@ -555,6 +555,8 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_CLOCK | RWF_WRITE, DEVRW_VALUE, 0, ay8910_set_clock},
 	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, ay8910_get_sample_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ay8910_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ay8910_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ay8910_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_AY8910_MAME =
@@ -1622,3 +1624,21 @@ void ay8910_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&info->logger, info, func, param);
 	return;
 }
+
+UINT32 ay8910_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(ay8910_context), bufSize, buffer);
+}
+
+UINT8 ay8910_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	ay8910_context *psg = (ay8910_context *)chip;
+	UINT32 oldRate = ay8910_get_sample_rate(psg);
+	
+	if (dataSize != sizeof(ay8910_context))
+		return 0xFF;
+	memcpy(psg, data, sizeof(ay8910_context));
+	if (psg->SmpRateFunc != NULL && ay8910_get_sample_rate(psg) != oldRate)
+		psg->SmpRateFunc(psg->SmpRateData, ay8910_get_sample_rate(psg));
+	return 0x00;
+}
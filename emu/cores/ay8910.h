@@ -93,5 +93,7 @@ void ay8910_set_mute_mask(void *chip, UINT32 MuteMask);
 void ay8910_set_stereo_mask(void *chip, UINT32 StereoMask);
 void ay8910_set_srchg_cb(void *chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 void ay8910_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 ay8910_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 ay8910_load_state(void *chip, UINT32 dataSize, const void* data);
 
 #endif	// __AY8910_H__
@@ -39,6 +39,7 @@ static void c352_w(void *chip, UINT16 offset, UINT16 data);
 
 static void c352_alloc_rom(void* chip, UINT32 memsize);
 static void c352_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8* data);
+static void c352_ref_rom(void* chip, UINT32 memsize, const UINT8* data);
 
 static void c352_set_mute_mask(void *chip, UINT32 MuteMask);
 static UINT32 c352_get_mute_mask(void *chip);
@@ -51,6 +52,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A16D16, 0, c352_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, c352_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, c352_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, c352_ref_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, c352_set_mute_mask},
 	{0x00, 0x00, 0, NULL}
 };
@@ -165,6 +167,7 @@ typedef struct {
 	UINT8* wave;
 	UINT32 wavesize;
 	UINT32 wave_mask;
+	UINT8 waveIsRef;	// wave points to external ROM data (must not be written or freed)
 
 	UINT8 muteRear;     // flag from VGM header
 	UINT8 optMuteRear;  // option
@@ -326,6 +329,7 @@ static UINT8 device_start_c352(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 
 	c->wave = NULL;
 	c->wavesize = 0x00;
+	c->waveIsRef = 0;
 
 	//c->sample_rate_base = cfg->clock / 576;	// sample rate according to superctr
 	c->sample_rate_base = cfg->clock / 288;	// TODO: output at 43 KHz and fix sample reading/interpolation code
@@ -362,7 +366,8 @@ static void device_stop_c352(void *chip)
 {
 	C352 *c = (C352 *)chip;
 	
-	free(c->wave);
+	if (! c->waveIsRef)
+		free(c->wave);
 	free(c);
 	
 	return;
@@ -460,6 +465,11 @@ static void c352_alloc_rom(void* chip, UINT32 memsize)
 	if (c->wavesize == memsize)
 		return;
 	
+	if (c->waveIsRef)
+	{
+		c->wave = NULL;	// detach from the external ROM
+		c->waveIsRef = 0;
+	}
 	c->wave = (UINT8*)realloc(c->wave, memsize);
 	c->wavesize = memsize;
 	memset(c->wave, 0xFF, memsize);
@@ -477,11 +487,35 @@ static void c352_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8
 	if (offset + length > c->wavesize)
 		length = c->wavesize - offset;
 	
+	if (c->waveIsRef)
+	{
+		// make a private copy of the external ROM before modifying it
+		UINT8* romCopy = (UINT8*)malloc(c->wavesize);
+		memcpy(romCopy, c->wave, c->wavesize);
+		c->wave = romCopy;
+		c->waveIsRef = 0;
+	}
 	memcpy(c->wave + offset, data, length);
 	
 	return;
 }
 
+static void c352_ref_rom(void* chip, UINT32 memsize, const UINT8* data)
+{
+	C352 *c = (C352 *)chip;
+	
+	if (! c->waveIsRef)
+		free(c->wave);
+	if (data == NULL)
+		memsize = 0x00;
+	c->wave = (UINT8*)data;	// Note: The data is only read from while waveIsRef is set.
+	c->wavesize = memsize;
+	c->wave_mask = pow2_mask(memsize);
+	c->waveIsRef = (data != NULL);
+	
+	return;
+}
+
 static void c352_set_mute_mask(void *chip, UINT32 MuteMask)
 {
 	C352 *c = (C352 *)chip;
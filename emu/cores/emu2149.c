@@ -53,6 +53,8 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_SRATE | RWF_WRITE, DEVRW_VALUE, 0, EPSG_set_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, EPSG_setMuteMask},
 	{RWF_CHN_PAN | RWF_WRITE, DEVRW_ALL, 0, ay8910_emu_pan},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, EPSG_saveState},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, EPSG_loadState},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_YM2149_Emu =
@@ -283,6 +285,21 @@ EPSG_setStereoMask (EPSG *psg, UINT32 mask)
   }  
 }
 
+UINT32
+EPSG_saveState (EPSG * psg, UINT32 bufSize, void* buffer)
+{
+  return devstate_save_block(psg, sizeof(EPSG), bufSize, buffer);
+}
+
+UINT8
+EPSG_loadState (EPSG * psg, UINT32 dataSize, const void* data)
+{
+  if (dataSize != sizeof(EPSG))
+    return 0xFF;
+  memcpy(psg, data, sizeof(EPSG));
+  return 0x00;
+}
+
 void
 EPSG_reset (EPSG * psg)
 {
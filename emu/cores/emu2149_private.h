@@ -97,6 +97,8 @@ extern "C"
   uint32_t EPSG_toggleMask (EPSG *, uint32_t mask);
   void EPSG_setMuteMask (EPSG *, UINT32 mask);
   void EPSG_setStereoMask (EPSG *psg, UINT32 mask);
+  UINT32 EPSG_saveState (EPSG * psg, UINT32 bufSize, void* buffer);
+  UINT8 EPSG_loadState (EPSG * psg, UINT32 dataSize, const void* data);
   void EPSG_set_pan (EPSG * psg, uint8_t ch, int16_t pan);
   static void ay8910_emu_set_options(void *chip, UINT32 Flags);
   static void ay8910_emu_pan(void* chip, const INT16* PanVals);
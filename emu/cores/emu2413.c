@@ -20,6 +20,7 @@
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "emu2413.h"
 #include "emu2413_private.h"
 #include "../panning.h" // Maxim
@@ -30,6 +31,8 @@ static UINT8 device_start_ym2413_emu(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 static void ym2413_update_emu(void *chip, UINT32 samples, DEV_SMPL **out);
 static void ym2413_set_mute_mask_emu(void *chip, UINT32 MuteMask);
 static void ym2413_pan_emu(void* chip, const INT16* PanVals);
+static UINT32 ym2413_save_state_emu(void *chip, UINT32 bufSize, void* buffer);
+static UINT8 ym2413_load_state_emu(void *chip, UINT32 dataSize, const void* data);
 
 
 static DEVDEF_RWFUNC devFunc[] =
@@ -38,6 +41,8 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D8, 0, EOPLL_writeReg},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2413_set_mute_mask_emu},
 	{RWF_CHN_PAN | RWF_WRITE, DEVRW_ALL, 0, ym2413_pan_emu},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ym2413_save_state_emu},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ym2413_load_state_emu},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_YM2413_Emu =
@@ -427,14 +432,14 @@ static void makeDefaultPatch(void) {
       EOPLL_getDefaultPatch(i, j, &default_patch[i][j * 2]);
 }
 
-static uint8_t table_initialized = 0;
+static OS_ONCE table_initialized = OS_ONCE_INIT;
 
+/* called once, the tables are shared by all instances */
 static void initializeTables(void) {
   makeTllTable();
   makeRksTable();
   makeSinTable();
   makeDefaultPatch();
-  table_initialized = 1;
 }
 
 /*********************************************************
@@ -1110,9 +1115,7 @@ EOPLL *EOPLL_new(uint32_t clk, uint32_t rate) {
   EOPLL *opll;
   int i;
 
-  if (!table_initialized) {
-    initializeTables();
-  }
+  OSOnce_Run(&table_initialized, initializeTables);
 
   opll = (EOPLL *)calloc(1, sizeof(EOPLL));
   if (opll == NULL)
@@ -1627,3 +1630,59 @@ static void ym2413_pan_emu(void* chip, const INT16* PanVals)
 	
 	return;
 }
+
+// The state consists of the EOPLL struct, followed by the rate converter's timer and sample history (if used).
+static UINT32 ym2413_get_state_size_emu(const EOPLL *opll)
+{
+	UINT32 stateSize = sizeof(EOPLL);
+	if (opll->conv != NULL)
+		stateSize += sizeof(double) + opll->conv->ch * LW * sizeof(int32_t);
+	return stateSize;
+}
+
+static UINT32 ym2413_save_state_emu(void *chip, UINT32 bufSize, void* buffer)
+{
+	EOPLL *opll = (EOPLL *)chip;
+	UINT32 stateSize = ym2413_get_state_size_emu(opll);
+	UINT8* dataPtr = (UINT8*)buffer;
+	int curChn;
+	
+	if (buffer == NULL || bufSize < stateSize)
+		return stateSize;
+	
+	memcpy(dataPtr, opll, sizeof(EOPLL));	dataPtr += sizeof(EOPLL);
+	if (opll->conv != NULL)
+	{
+		memcpy(dataPtr, &opll->conv->timer, sizeof(double));	dataPtr += sizeof(double);
+		for (curChn = 0; curChn < opll->conv->ch; curChn ++)
+		{
+			memcpy(dataPtr, opll->conv->buf[curChn], LW * sizeof(int32_t));
+			dataPtr += LW * sizeof(int32_t);
+		}
+	}
+	return stateSize;
+}
+
+static UINT8 ym2413_load_state_emu(void *chip, UINT32 dataSize, const void* data)
+{
+	EOPLL *opll = (EOPLL *)chip;
+	EOPLL_RateConv *conv = opll->conv;
+	const UINT8* dataPtr = (const UINT8*)data;
+	int curChn;
+	
+	if (dataSize != ym2413_get_state_size_emu(opll))
+		return 0xFF;
+	
+	memcpy(opll, dataPtr, sizeof(EOPLL));	dataPtr += sizeof(EOPLL);
+	opll->conv = conv;
+	if (conv != NULL)
+	{
+		memcpy(&conv->timer, dataPtr, sizeof(double));	dataPtr += sizeof(double);
+		for (curChn = 0; curChn < conv->ch; curChn ++)
+		{
+			memcpy(conv->buf[curChn], dataPtr, LW * sizeof(int32_t));
+			dataPtr += LW * sizeof(int32_t);
+		}
+	}
+	return 0x00;
+}
@@ -78,6 +78,7 @@ Revision History:
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "../logging.h"
 
 #ifndef SNDDEV_SELECT
@@ -588,10 +589,6 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
-static int num_lock = 0;
-
-
 #define SLOT7_1 (&OPL->P_CH[7].SLOT[SLOT1])
 #define SLOT7_2 (&OPL->P_CH[7].SLOT[SLOT2])
 #define SLOT8_1 (&OPL->P_CH[8].SLOT[SLOT1])
@@ -599,7 +596,7 @@ static int num_lock = 0;
 
 
 
-static UINT8 tablesInit = 0;
+static OS_ONCE tablesInit = OS_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void OPL_STATUS_SET(FM_OPL *OPL,int flag)
@@ -1121,17 +1118,13 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 }
 
 
-/* generic table initialize */
-static int init_tables(void)
+/* generic table initialize (called once, the tables are shared by all chips) */
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1223,12 +1216,7 @@ static int init_tables(void)
 	}
 	/*logerror("FMOPL.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
 
-
-	return 1;
-}
-
-static void OPLCloseTable( void )
-{
+	return;
 }
 
 
@@ -1687,34 +1675,6 @@ static void OPLWriteReg(FM_OPL *OPL, UINT8 r, UINT8 v)
 	}
 }
 
-/* lock/unlock for common table */
-static int OPL_LockTable(void)
-{
-	num_lock++;
-	if(num_lock>1) return 0;
-
-	/* first time */
-
-	/* allocate total level table (128kb space) */
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
-
-	return 0;
-}
-
-static void OPL_UnLockTable(void)
-{
-	if(num_lock) num_lock--;
-	if(num_lock) return;
-
-	/* last time */
-
-	OPLCloseTable();
-}
-
 static void OPLResetChip(FM_OPL *OPL)
 {
 	int c,s;
@@ -1776,7 +1736,7 @@ static FM_OPL *OPLCreate(UINT32 clock, UINT32 rate, int type)
 	FM_OPL *OPL;
 	int state_size;
 
-	if (OPL_LockTable() == -1) return NULL;
+	OSOnce_Run(&tablesInit, init_tables);
 
 	/* calculate OPL state size */
 	state_size  = sizeof(FM_OPL);
@@ -1813,7 +1773,6 @@ static FM_OPL *OPLCreate(UINT32 clock, UINT32 rate, int type)
 /* Destroy one of virtual YM3812 */
 static void OPLDestroy(FM_OPL *OPL)
 {
-	OPL_UnLockTable();
 	free(OPL);
 }
 
@@ -2451,3 +2410,46 @@ void opl_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&opl->logger, opl, func, param);
 	return;
 }
+
+static UINT32 opl_get_state_size(const FM_OPL *opl)
+{
+	UINT32 stateSize = sizeof(FM_OPL);
+#if BUILD_Y8950
+	if (opl->type & OPL_TYPE_ADPCM)
+		stateSize += sizeof(YM_DELTAT);	/* allocated right after the FM_OPL struct */
+#endif
+	return stateSize;
+}
+
+UINT32 opl_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	FM_OPL *opl = (FM_OPL *)chip;
+	return devstate_save_block(opl, opl_get_state_size(opl), bufSize, buffer);
+}
+
+UINT8 opl_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	FM_OPL *opl = (FM_OPL *)chip;
+#if BUILD_Y8950
+	YM_DELTAT *deltat = opl->deltat;
+	YM_DELTAT dtBackup;
+#endif
+	
+	if (dataSize != opl_get_state_size(opl))
+		return 0xFF;
+#if BUILD_Y8950
+	if (deltat != NULL)
+		dtBackup = *deltat;
+#endif
+	memcpy(opl, data, dataSize);
+#if BUILD_Y8950
+	if (deltat != NULL)
+	{
+		/* keep the current sample ROM */
+		deltat->memory = dtBackup.memory;
+		deltat->memory_size = dtBackup.memory_size;
+		deltat->memory_mask = dtBackup.memory_mask;
+	}
+#endif
+	return 0x00;
+}
@@ -103,5 +103,7 @@ void y8950_set_update_handler(void *chip, OPL_UPDATEHANDLER UpdateHandler, void
 
 void opl_set_mute_mask(void *chip, UINT32 MuteMask);
 void opl_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 opl_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 opl_load_state(void *chip, UINT32 dataSize, const void* data);
 
 #endif	// __FMOPL_H__
@@ -165,6 +165,7 @@
 #include "../snddef.h"
 #include "../EmuHelper.h"
 #include "../logging.h"
+#include "../../utils/OSOnce.h"
 
 #ifndef SNDDEV_SELECT
 #define SNDDEV_YM2203
@@ -730,7 +731,7 @@ typedef struct
 }
 
 
-static UINT8 tablesInit = 0;
+static OS_ONCE tablesInit = OS_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void FM_STATUS_SET(FM_ST *ST,int flag)
@@ -1626,6 +1627,23 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm)
 	return tl_tab[p];
 }
 
+/* A channel is idle when all four operators are in EG_OFF and produce no output.
+   EG_OFF is left only by a Key On, which also resets the phase counter,
+   so the phases of an idle channel are never heard and need not be advanced. */
+INLINE int chan_is_idle(const FM_CH *CH)
+{
+	const FM_SLOT *SLOT = &CH->SLOT[0];
+	unsigned int i;
+
+	for (i = 0; i < 4; i ++, SLOT ++)
+	{
+		/* (the LegacyMode Key Off can leave an audible vol_out in EG_OFF) */
+		if (SLOT->state != EG_OFF || SLOT->vol_out < ENV_QUIET)
+			return 0;
+	}
+	return 1;
+}
+
 INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH, int chnum)
 {
 	INT32 out = 0;
@@ -1635,6 +1653,17 @@ INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH, int chnum)
 	if (CH->Muted)
 		return;
 
+	if (chan_is_idle(CH))
+	{
+		/* silent channel: only keep the feedback and MEM state in sync,
+		   so that a later Key On starts exactly as it would have */
+		CH->op1_out[0] = CH->op1_out[1];
+		CH->op1_out[1] = 0;
+		if (CH->mem_connect != &OPN->mem)
+			CH->mem_value = 0;  /* algorithms 0-3, 5: MEM is fed by silent operators */
+		return;
+	}
+
 	OPN->m2 = OPN->c1 = OPN->c2 = OPN->mem = 0;
 
 	*CH->mem_connect = CH->mem_value;  /* restore delayed sample (MEM) value to m2 or c2 */
@@ -2095,17 +2124,13 @@ static void reset_channels( FM_ST *ST , FM_CH *CH , int num )
 	}
 }
 
-/* initialize generic tables */
+/* initialize generic tables (called once, the tables are shared by all chips) */
 static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return;
-	tablesInit = 1;
-
 	/* build Linear Power Table */
 	for (x=0; x<TL_RES_LEN; x++)
 	{
@@ -2525,7 +2550,7 @@ void * ym2203_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	OSOnce_Run(&tablesInit, init_tables);
 
 	F2203->OPN.ST.param = param;
 	F2203->OPN.type = TYPE_YM2203;
@@ -2670,6 +2695,20 @@ void ym2203_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&F2203->OPN.logger, F2203, func, param);
 	return;
 }
+
+UINT32 ym2203_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(YM2203), bufSize, buffer);
+}
+
+UINT8 ym2203_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	/* Note: The SSG is a separate device and has to be restored separately. */
+	if (dataSize != sizeof(YM2203))
+		return 0xFF;
+	memcpy(chip, data, sizeof(YM2203));
+	return 0x00;
+}
 #endif /* BUILD_YM2203 */
 
 
@@ -2748,6 +2787,7 @@ static const int step_inc[8] = { -1*16, -1*16, -1*16, -1*16, 2*16, 5*16, 7*16, 9
 
 /* speedup purposes only */
 static int jedi_table[ 49*16 ];
+static OS_ONCE adpcmaTableInit = OS_ONCE_INIT;
 
 
 static void Init_ADPCMATable(void)
@@ -3207,7 +3247,7 @@ void * ym2608_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	OSOnce_Run(&tablesInit, init_tables);
 
 	F2608->OPN.ST.param = param;
 	F2608->OPN.type = TYPE_YM2608;
@@ -3244,7 +3284,7 @@ void * ym2608_init(void *param, UINT32 clock, UINT32 rate,
 	F2608->pcmbuf   = (UINT8*)YM2608_ADPCM_ROM;
 	F2608->pcm_size = 0x2000;
 
-	Init_ADPCMATable();
+	OSOnce_Run(&adpcmaTableInit, Init_ADPCMATable);
 
 	ym2608_set_mute_mask(F2608, 0x00);
 
@@ -3588,6 +3628,39 @@ void ym2608_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&F2608->OPN.logger, F2608, func, param);
 	return;
 }
+
+/* The YM2608 state includes the contents of the ADPCM RAM. */
+UINT32 ym2608_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	YM2608 *F2608 = (YM2608 *)chip;
+	UINT32 stateSize = sizeof(YM2608) + F2608->deltaT.memory_size;
+	
+	if (buffer != NULL && bufSize >= stateSize)
+	{
+		memcpy(buffer, F2608, sizeof(YM2608));
+		if (F2608->deltaT.memory_size)
+			memcpy((UINT8*)buffer + sizeof(YM2608), F2608->deltaT.memory, F2608->deltaT.memory_size);
+	}
+	return stateSize;
+}
+
+UINT8 ym2608_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	YM2608 *F2608 = (YM2608 *)chip;
+	UINT8* ramPtr = F2608->deltaT.memory;
+	UINT32 ramSize = F2608->deltaT.memory_size;
+	UINT32 ramMask = F2608->deltaT.memory_mask;
+	
+	if (dataSize != sizeof(YM2608) + ramSize)
+		return 0xFF;	/* RAM was resized since saving the state */
+	memcpy(F2608, data, sizeof(YM2608));
+	F2608->deltaT.memory = ramPtr;
+	F2608->deltaT.memory_size = ramSize;
+	F2608->deltaT.memory_mask = ramMask;
+	if (ramSize)
+		memcpy(ramPtr, (const UINT8*)data + sizeof(YM2608), ramSize);
+	return 0x00;
+}
 #endif /* BUILD_YM2608 */
 
 
@@ -3968,7 +4041,7 @@ void *ym2610_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	OSOnce_Run(&tablesInit, init_tables);
 
 	/* FM */
 	F2610->OPN.ST.param = param;
@@ -3998,7 +4071,7 @@ void *ym2610_init(void *param, UINT32 clock, UINT32 rate,
 
 	YM_DELTAT_ADPCM_Init(&F2610->deltaT,YM_DELTAT_EMULATION_MODE_YM2610,8,F2610->OPN.out_delta,1<<23);
 
-	Init_ADPCMATable();
+	OSOnce_Run(&adpcmaTableInit, Init_ADPCMATable);
 
 	ym2610_set_mute_mask(F2610, 0x00);
 
@@ -4331,6 +4404,32 @@ void ym2610_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&F2610->OPN.logger, F2610, func, param);
 	return;
 }
+
+UINT32 ym2610_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(YM2610), bufSize, buffer);
+}
+
+UINT8 ym2610_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	YM2610 *F2610 = (YM2610 *)chip;
+	UINT8* pcmBuf = F2610->pcmbuf;
+	UINT32 pcmSize = F2610->pcm_size;
+	UINT8* dtMem = F2610->deltaT.memory;
+	UINT32 dtMemSize = F2610->deltaT.memory_size;
+	UINT32 dtMemMask = F2610->deltaT.memory_mask;
+	
+	if (dataSize != sizeof(YM2610))
+		return 0xFF;
+	/* keep the current sample ROMs */
+	memcpy(F2610, data, sizeof(YM2610));
+	F2610->pcmbuf = pcmBuf;
+	F2610->pcm_size = pcmSize;
+	F2610->deltaT.memory = dtMem;
+	F2610->deltaT.memory_size = dtMemSize;
+	F2610->deltaT.memory_mask = dtMemMask;
+	return 0x00;
+}
 #endif /* (BUILD_YM2610||BUILD_YM2610B) */
 
 
@@ -4577,7 +4676,7 @@ void * ym2612_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	OSOnce_Run(&tablesInit, init_tables);
 
 	/* FM */
 	F2612->OPN.ST.param = param;
@@ -4810,4 +4909,38 @@ void ym2612_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&F2612->OPN.logger, F2612, func, param);
 	return;
 }
+
+UINT32 ym2612_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(YM2612), bufSize, buffer);
+}
+
+UINT8 ym2612_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(YM2612))
+		return 0xFF;
+	memcpy(chip, data, sizeof(YM2612));
+	return 0x00;
+}
+
+/* The chip is silent when all FM channels are idle and neither the DAC nor CSM mode
+   (Key On by Timer A) can produce output. The output latches must be cleared as well. */
+UINT8 ym2612_is_silent(void *chip)
+{
+	YM2612 *F2612 = (YM2612 *)chip;
+	int c;
+
+	if ((F2612->dacen || F2612->dac_test) && ! F2612->MuteDAC)
+		return 0;
+	if (F2612->OPN.ST.mode & 0x80)
+		return 0;
+	if (F2612->WaveL || F2612->WaveR)
+		return 0;
+	for (c = 0; c < 6; c++)
+	{
+		if (! F2612->CH[c].Muted && ! chan_is_idle(&F2612->CH[c]))
+			return 0;
+	}
+	return 1;
+}
 #endif /* (BUILD_YM2612) */
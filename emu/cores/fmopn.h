@@ -144,6 +144,12 @@ void ym2203_set_mute_mask(void *chip, UINT32 MuteMask);
 **  logging function
 */
 void ym2203_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+
+/*
+**  state save/restore
+*/
+UINT32 ym2203_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 ym2203_load_state(void *chip, UINT32 dataSize, const void* data);
 #endif /* BUILD_YM2203 */
 
 #if BUILD_YM2608
@@ -164,6 +170,8 @@ void ym2608_write_pcmromb(void* chip, UINT32 offset, UINT32 length, const UINT8*
 
 void ym2608_set_mute_mask(void *chip, UINT32 MuteMask);
 void ym2608_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 ym2608_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 ym2608_load_state(void *chip, UINT32 dataSize, const void* data);
 #endif /* BUILD_YM2608 */
 
 #if (BUILD_YM2610||BUILD_YM2610B)
@@ -189,6 +197,8 @@ void ym2610_write_pcmromb(void* chip, UINT32 offset, UINT32 length, const UINT8*
 
 void ym2610_set_mute_mask(void *chip, UINT32 MuteMask);
 void ym2610_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 ym2610_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 ym2610_load_state(void *chip, UINT32 dataSize, const void* data);
 #endif /* (BUILD_YM2610||BUILD_YM2610B) */
 
 #if (BUILD_YM2612||BUILD_YM3438)
@@ -205,6 +215,9 @@ UINT8 ym2612_timer_over(void *chip, UINT8 c );
 void ym2612_set_mute_mask(void *chip, UINT32 MuteMask);
 void ym2612_set_options(void *chip, UINT32 Flags);
 void ym2612_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 ym2612_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 ym2612_load_state(void *chip, UINT32 dataSize, const void* data);
+UINT8 ym2612_is_silent(void *chip);
 #endif /* (BUILD_YM2612||BUILD_YM3438) */
 
 #endif	// __FMOPN_H__
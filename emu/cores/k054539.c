@@ -36,6 +36,7 @@ static void k054539_set_gain(void *chip, UINT8 channel, double _gain);
 
 static void k054539_alloc_rom(void* chip, UINT32 memsize);
 static void k054539_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8* data);
+static void k054539_ref_rom(void* chip, UINT32 memsize, const UINT8* data);
 
 static void k054539_set_mute_mask(void *chip, UINT32 MuteMask);
 static void k054539_set_log_cb(void* chip, DEVCB_LOG func, void* param);
@@ -47,6 +48,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A16D8, 0, k054539_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, k054539_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, k054539_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, k054539_ref_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, k054539_set_mute_mask},
 	{0x00, 0x00, 0, NULL}
 };
@@ -171,6 +173,7 @@ struct _k054539_state {
 	UINT8 *rom;
 	UINT32 rom_size;
 	UINT32 rom_mask;
+	UINT8 rom_is_ref;	// rom points to external ROM data (must not be written or freed)
 
 	k054539_channel channels[8];
 	UINT8 Muted[8];
@@ -639,6 +642,7 @@ static UINT8 device_start_k054539(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	info->rom = NULL;
 	info->rom_size = 0x00;
 	info->rom_mask = 0x00;
+	info->rom_is_ref = 0;
 
 	k054539_init_flags(info, cfg->flags);
 
@@ -654,7 +658,9 @@ static void device_stop_k054539(void *chip)
 {
 	k054539_state *info = (k054539_state *)chip;
 	
-	free(info->rom);	info->rom = NULL;
+	if (! info->rom_is_ref)
+		free(info->rom);
+	info->rom = NULL;
 	free(info->ram);	info->ram = NULL;
 	free(info);
 	
@@ -683,6 +689,11 @@ static void k054539_alloc_rom(void* chip, UINT32 memsize)
 	if (info->rom_size == memsize)
 		return;
 	
+	if (info->rom_is_ref)
+	{
+		info->rom = NULL;	// detach from the external ROM
+		info->rom_is_ref = 0;
+	}
 	info->rom = (UINT8*)realloc(info->rom, memsize);
 	info->rom_size = memsize;
 	memset(info->rom, 0xFF, memsize);
@@ -701,11 +712,35 @@ static void k054539_write_rom(void *chip, UINT32 offset, UINT32 length, const UI
 	if (offset + length > info->rom_size)
 		length = info->rom_size - offset;
 	
+	if (info->rom_is_ref)
+	{
+		// make a private copy of the external ROM before modifying it
+		UINT8* romCopy = (UINT8*)malloc(info->rom_size);
+		memcpy(romCopy, info->rom, info->rom_size);
+		info->rom = romCopy;
+		info->rom_is_ref = 0;
+	}
 	memcpy(info->rom + offset, data, length);
 	
 	return;
 }
 
+static void k054539_ref_rom(void* chip, UINT32 memsize, const UINT8* data)
+{
+	k054539_state *info = (k054539_state *)chip;
+	
+	if (! info->rom_is_ref)
+		free(info->rom);
+	if (data == NULL)
+		memsize = 0x00;
+	info->rom = (UINT8*)data;	// Note: The data is only read from while rom_is_ref is set.
+	info->rom_size = memsize;
+	info->rom_mask = pow2_mask(memsize);
+	info->rom_is_ref = (data != NULL);
+	
+	return;
+}
+
 
 static void k054539_set_mute_mask(void *chip, UINT32 MuteMask)
 {
@@ -20,6 +20,7 @@
 #include "../logging.h"
 #include "../SoundDevs.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "emutypes.h"
 #include "msm5232.h"
 
@@ -96,9 +97,12 @@ typedef struct {
 
 	UINT8 per_out_vol[MSM5232_NUM_OUTPUTS]; // per-output volume
 	UINT8 Muted[MSM5232_NUM_OUTPUTS];
-	double vol_ctrl[16];
 } MSM5232_STATE;
 
+// TA7630 volume table, shared by all chips
+static double vol_ctrl[16];
+static OS_ONCE vol_ctrl_init = OS_ONCE_INIT;
+
 // Forward declarations
 static UINT8 device_start_msm5232(const MSM5232_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_msm5232(void* info);
@@ -184,6 +188,23 @@ INLINE void WriteLE32(UINT8* buffer, UINT32 value)
 	return;
 }
 
+// called once, the table is shared by all chips
+static void init_vol_table(void)
+{
+	double db = 0.0;
+	double db_step = 1.50; /* 1.50 dB step (at least, maybe more) */
+	double db_step_inc = 0.125;
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		double max = 100.0 / pow(10.0, db / 20.0);
+		vol_ctrl[15 - i] = max / 100.0;
+		db += db_step;
+		db_step += db_step_inc;
+	}
+}
+
 static void init_tables(MSM5232_STATE* chip)
 {
 	const double R51 = 870.0;		// attack resistance
@@ -259,19 +280,7 @@ static UINT8 device_start_msm5232(const MSM5232_CFG* cfg, DEV_INFO* retDevInf)
 		chip->smpRateNative = (abs(sRateDiff) <= 2);
 	}
 
-	{
-		double db = 0.0;
-		double db_step = 1.50; /* 1.50 dB step (at least, maybe more) */
-		double db_step_inc = 0.125;
-		for (i = 0; i < 16; i++)
-		{
-			double max = 100.0 / pow(10.0, db / 20.0);
-			chip->vol_ctrl[15 - i] = max / 100.0;
-			db += db_step;
-			db_step += db_step_inc;
-		}
-	}
-
+	OSOnce_Run(&vol_ctrl_init, init_vol_table);
     init_tables(chip);
     for (i = 0; i < MSM5232_NUM_CHANNELS; i++)
     {
@@ -290,8 +299,8 @@ static UINT8 device_start_msm5232(const MSM5232_CFG* cfg, DEV_INFO* retDevInf)
     // --- TA7630 external volume defaults: max (0x0F) ---
     chip->ext_vol[0] = 0x0F;
     chip->ext_vol[1] = 0x0F;
-    chip->ext_vol_gain[0] = chip->vol_ctrl[chip->ext_vol[0]];
-    chip->ext_vol_gain[1] = chip->vol_ctrl[chip->ext_vol[1]];
+    chip->ext_vol_gain[0] = vol_ctrl[chip->ext_vol[0]];
+    chip->ext_vol_gain[1] = vol_ctrl[chip->ext_vol[1]];
 
 	// initialize per-output volume (0x80 = 100%)
 	for (i = 0; i < MSM5232_NUM_OUTPUTS; i++)
@@ -681,11 +690,11 @@ static void msm5232_write(void* info, UINT8 reg, UINT8 value)
 		// --- TA7630 external volume for MSM5232 ---
 		case 0x1E: // external volume for group 1 (ch 0..3)
 			chip->ext_vol[0] = value & 0x0F;
-			chip->ext_vol_gain[0] = chip->vol_ctrl[value & 0x0F];
+			chip->ext_vol_gain[0] = vol_ctrl[value & 0x0F];
 			break;
 		case 0x1F: // external volume for group 2 (ch 4..7)
 			chip->ext_vol[1] = value & 0x0F;
-			chip->ext_vol_gain[1] = chip->vol_ctrl[value & 0x0F];
+			chip->ext_vol_gain[1] = vol_ctrl[value & 0x0F];
 			break;
 		case 0x20:	// chip clock, 000000xx
 		case 0x21:	// chip clock, 0000xx00
@@ -46,6 +46,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "multipcm.h"
 
 static void MultiPCM_update(void *info, UINT32 samples, DEV_SMPL **outputs);
@@ -234,7 +235,7 @@ struct _MultiPCM
 };
 
 
-static UINT8 IsInit = 0;
+static OS_ONCE IsInit = OS_ONCE_INIT;
 
 static INT32 left_pan_table[0x800];
 static INT32 right_pan_table[0x800];
@@ -583,25 +584,11 @@ INLINE void lfo_compute_step(MultiPCM *ptChip, lfo_t *lfo, UINT8 lfo_frequency,
 	}
 }
 
-static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+// called once, the tables are shared by all chips
+static void init_tables(void)
 {
-	MultiPCM *ptChip;
-	INT32 i;
-
-	ptChip = (MultiPCM *)calloc(1, sizeof(MultiPCM));
-	if (ptChip == NULL)
-		return 0xFF;
-	
-	ptChip->ROM = NULL;
-	ptChip->ROMSize = 0x00;
-	ptChip->ROMMask = 0x00;
-	ptChip->rate = (float)cfg->clock / MULTIPCM_CLOCKDIV;
-
-	if (! IsInit)
-	{
 	INT32 level;
-
-	IsInit = 1;
+	INT32 i;
 
 	// Volume + pan table
 	for (level = 0; level < 0x80; ++level)
@@ -663,7 +650,25 @@ static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	}
 
 	lfo_init();
-	}
+	
+	return;
+}
+
+static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	MultiPCM *ptChip;
+	INT32 i;
+
+	ptChip = (MultiPCM *)calloc(1, sizeof(MultiPCM));
+	if (ptChip == NULL)
+		return 0xFF;
+	
+	ptChip->ROM = NULL;
+	ptChip->ROMSize = 0x00;
+	ptChip->ROMMask = 0x00;
+	ptChip->rate = (float)cfg->clock / MULTIPCM_CLOCKDIV;
+
+	OSOnce_Run(&IsInit, init_tables);
 
 	// Pitch steps
 	for (i = 0; i < 0x400; ++i)
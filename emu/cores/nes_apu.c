@@ -47,6 +47,7 @@
 #include "../../common_def.h"
 #include "../snddef.h"
 #include "../panning.h"
+#include "../../utils/OSOnce.h"
 #include "nes_apu.h"
 
 /* AN EXPLANATION
@@ -85,7 +86,7 @@ struct _nesapu_state
 
 static DEV_SMPL square_lut[31];       // Non-linear Square wave output LUT
 static DEV_SMPL tnd_lut[16][16][128]; // Non-linear Triangle, Noise, DMC output LUT
-static UINT8 tablesInit = 0;
+static OS_ONCE tablesInit = OS_ONCE_INIT;
 
 static UINT8 DPCMBase0 = 0x01;
 
@@ -111,14 +112,11 @@ static void calculate_rates(nesapu_state *info, UINT32 clock, UINT32 rate)
 		info->sync_times2[i] = (info->samps_per_sync * i) >> 2;
 }
 
+// called once, the tables are shared by all chips
 static void create_mixer_lut(void)
 {
 	int i, t;
 
-	if (tablesInit)
-		return;
-	tablesInit = 0;
-
 	// calculate mixer output
 	/*
 	pulse channel output:
@@ -843,7 +841,7 @@ void* device_start_nesapu(UINT32 clock, UINT32 rate)
 	calculate_rates(info, clock, rate);
 
 	/* Use initializer calls */
-	create_mixer_lut();
+	OSOnce_Run(&tablesInit, create_mixer_lut);
 
 	info->APU.dpcm.memory = NULL;
 
@@ -10,8 +10,11 @@ void* nukedopl3_init(UINT32 clock, UINT32 rate);
 void nukedopl3_shutdown(void *chip);
 void nukedopl3_reset_chip(void *chip);
 void nukedopl3_update(void *chip, UINT32 samples, DEV_SMPL **out);
+void nukedopl3_update_soa(void *chip, UINT32 samples, DEV_SMPL **out);	// nukedopl3_soa.c
 void nukedopl3_set_mute_mask(void *chip, UINT32 MuteMask);
 void nukedopl3_set_volume(void *chip, INT32 volume);
 void nukedopl3_set_vol_lr(void *chip, INT32 volLeft, INT32 volRight);
+UINT32 nukedopl3_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 nukedopl3_load_state(void *chip, UINT32 dataSize, const void* data);
 
 #endif	// __NUKEDOPL3_H__
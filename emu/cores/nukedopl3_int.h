@@ -48,8 +48,15 @@ extern "C" {
 #define OPL_ENABLE_STEREOEXT 0
 #endif
 
+/* Quirk: Some FM channels are output one sample later on the left side than the right. */
+#ifndef OPL_QUIRK_CHANNELSAMPLEDELAY
+#define OPL_QUIRK_CHANNELSAMPLEDELAY (!OPL_ENABLE_STEREOEXT)
+#endif
+
 #define NOPL_ENABLE_WRITEBUF
 
+#define RSM_FRAC    10
+
 #define OPL_WRITEBUF_SIZE   1024
 #define OPL_WRITEBUF_DELAY  2
 
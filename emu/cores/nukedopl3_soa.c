@@ -0,0 +1,627 @@
+// license:LGPL-2.1+
+// copyright-holders:Nuke.YKT
+/*
+ *  Nuked OPL3 emulator - stage-ordered sample engine.
+ *
+ *  This runs the exact same model as nukedopl3.c, on the same opl3_chip state.
+ *  NOPL3_Generate4Ch() processes the 36 slots one after another, each slot
+ *  going through feedback, envelope, phase and operator output before the next
+ *  one starts. Only the operator output depends on other slots (modulation
+ *  input, rhythm phase bits, noise), so here every stage runs for all slots
+ *  before the next stage starts:
+ *    - feedback and envelope: independent per slot, released slots that are
+ *      fully off take a short path,
+ *    - phase: increments are calculated once per channel (with and without
+ *      vibrato), the rhythm slots are patched afterwards in slot order,
+ *    - operator output and mixing: in slot order, including the left/right
+ *      channel delay quirk.
+ *  The chip state after every sample is identical to NOPL3_Generate4Ch().
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../stdtype.h"
+#include "../../common_def.h"
+#include "../snddef.h"
+#include "nukedopl3.h"
+#include "nukedopl3_int.h"
+#include "nukedopl3_tables.h"
+
+INLINE int16_t NOPL3S_EnvelopeCalcExp(uint32_t level)
+{
+    if (level > 0x1fff)
+    {
+        level = 0x1fff;
+    }
+    return (exprom[level & 0xffu] << 1) >> (level >> 8);
+}
+
+/* OPL3_EnvelopeCalcSin0-7 as a single function, so that it can be inlined */
+INLINE int16_t NOPL3S_EnvelopeCalcSin(uint8_t wf, uint16_t phase, uint16_t envelope)
+{
+    uint16_t out = 0;
+    uint16_t neg = 0;
+    phase &= 0x3ff;
+    switch (wf)
+    {
+    case 0:
+        if (phase & 0x200)
+        {
+            neg = 0xffff;
+        }
+        if (phase & 0x100)
+        {
+            out = logsinrom[(phase & 0xffu) ^ 0xffu];
+        }
+        else
+        {
+            out = logsinrom[phase & 0xffu];
+        }
+        break;
+    case 1:
+        if (phase & 0x200)
+        {
+            out = 0x1000;
+        }
+        else if (phase & 0x100)
+        {
+            out = logsinrom[(phase & 0xffu) ^ 0xffu];
+        }
+        else
+        {
+            out = logsinrom[phase & 0xffu];
+        }
+        break;
+    case 2:
+        if (phase & 0x100)
+        {
+            out = logsinrom[(phase & 0xffu) ^ 0xffu];
+        }
+        else
+        {
+            out = logsinrom[phase & 0xffu];
+        }
+        break;
+    case 3:
+        if (phase & 0x100)
+        {
+            out = 0x1000;
+        }
+        else
+        {
+            out = logsinrom[phase & 0xffu];
+        }
+        break;
+    case 4:
+        if ((phase & 0x300) == 0x100)
+        {
+            neg = 0xffff;
+        }
+        if (phase & 0x200)
+        {
+            out = 0x1000;
+        }
+        else if (phase & 0x80)
+        {
+            out = logsinrom[((phase ^ 0xffu) << 1u) & 0xffu];
+        }
+        else
+        {
+            out = logsinrom[(phase << 1u) & 0xffu];
+        }
+        break;
+    case 5:
+        if (phase & 0x200)
+        {
+            out = 0x1000;
+        }
+        else if (phase & 0x80)
+        {
+            out = logsinrom[((phase ^ 0xffu) << 1u) & 0xffu];
+        }
+        else
+        {
+            out = logsinrom[(phase << 1u) & 0xffu];
+        }
+        break;
+    case 6:
+        if (phase & 0x200)
+        {
+            neg = 0xffff;
+        }
+        break;
+    case 7:
+        if (phase & 0x200)
+        {
+            neg = 0xffff;
+            phase = (phase & 0x1ff) ^ 0x1ff;
+        }
+        out = phase << 3;
+        break;
+    }
+    return NOPL3S_EnvelopeCalcExp(out + (envelope << 3)) ^ neg;
+}
+
+INLINE void NOPL3S_SlotCalcFB(opl3_slot *slot)
+{
+    if (slot->channel->fb != 0x00)
+    {
+        slot->fbmod = (slot->prout + slot->out) >> (0x09 - slot->channel->fb);
+    }
+    else
+    {
+        slot->fbmod = 0;
+    }
+    slot->prout = slot->out;
+}
+
+/* OPL3_EnvelopeCalc with the chip-wide EG timer values passed in */
+INLINE void NOPL3S_EnvelopeCalc(opl3_slot *slot, uint8_t eg_add, uint8_t eg_state, uint8_t timer_lo)
+{
+    uint8_t nonzero;
+    uint8_t rate;
+    uint8_t rate_hi;
+    uint8_t rate_lo;
+    uint8_t reg_rate = 0;
+    uint8_t ks;
+    uint8_t eg_shift, shift;
+    uint16_t eg_rout;
+    int16_t eg_inc;
+    uint8_t eg_off;
+    uint8_t reset = 0;
+    slot->eg_out = slot->eg_rout + (slot->reg_tl << 2)
+                 + (slot->eg_ksl >> kslshift[slot->reg_ksl]) + *slot->trem;
+    if (!slot->key && slot->eg_gen == envelope_gen_num_release && slot->eg_rout == 0x1ff)
+    {
+        /* released and off: nothing changes */
+        slot->pg_reset = 0;
+        return;
+    }
+    if (slot->key && slot->eg_gen == envelope_gen_num_release)
+    {
+        reset = 1;
+        reg_rate = slot->reg_ar;
+    }
+    else
+    {
+        switch (slot->eg_gen)
+        {
+        case envelope_gen_num_attack:
+            reg_rate = slot->reg_ar;
+            break;
+        case envelope_gen_num_decay:
+            reg_rate = slot->reg_dr;
+            break;
+        case envelope_gen_num_sustain:
+            if (!slot->reg_type)
+            {
+                reg_rate = slot->reg_rr;
+            }
+            break;
+        case envelope_gen_num_release:
+            reg_rate = slot->reg_rr;
+            break;
+        }
+    }
+    slot->pg_reset = reset;
+    ks = slot->channel->ksv >> ((slot->reg_ksr ^ 1) << 1);
+    nonzero = (reg_rate != 0);
+    rate = ks + (reg_rate << 2);
+    rate_hi = rate >> 2;
+    rate_lo = rate & 0x03;
+    if (rate_hi & 0x10)
+    {
+        rate_hi = 0x0f;
+    }
+    eg_shift = rate_hi + eg_add;
+    shift = 0;
+    if (nonzero)
+    {
+        if (rate_hi < 12)
+        {
+            if (eg_state)
+            {
+                switch (eg_shift)
+                {
+                case 12:
+                    shift = 1;
+                    break;
+                case 13:
+                    shift = (rate_lo >> 1) & 0x01;
+                    break;
+                case 14:
+                    shift = rate_lo & 0x01;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        else
+        {
+            shift = (rate_hi & 0x03) + eg_incstep[rate_lo][timer_lo];
+            if (shift & 0x04)
+            {
+                shift = 0x03;
+            }
+            if (!shift)
+            {
+                shift = eg_state;
+            }
+        }
+    }
+    eg_rout = slot->eg_rout;
+    eg_inc = 0;
+    eg_off = 0;
+    /* Instant attack */
+    if (reset && rate_hi == 0x0f)
+    {
+        eg_rout = 0x00;
+    }
+    /* Envelope off */
+    if ((slot->eg_rout & 0x1f8) == 0x1f8)
+    {
+        eg_off = 1;
+    }
+    if (slot->eg_gen != envelope_gen_num_attack && !reset && eg_off)
+    {
+        eg_rout = 0x1ff;
+    }
+    switch (slot->eg_gen)
+    {
+    case envelope_gen_num_attack:
+        if (!slot->eg_rout)
+        {
+            slot->eg_gen = envelope_gen_num_decay;
+        }
+        else if (slot->key && shift > 0 && rate_hi != 0x0f)
+        {
+            eg_inc = ~slot->eg_rout >> (4 - shift);
+        }
+        break;
+    case envelope_gen_num_decay:
+        if ((slot->eg_rout >> 4) == slot->reg_sl)
+        {
+            slot->eg_gen = envelope_gen_num_sustain;
+        }
+        else if (!eg_off && !reset && shift > 0)
+        {
+            eg_inc = 1 << (shift - 1);
+        }
+        break;
+    case envelope_gen_num_sustain:
+    case envelope_gen_num_release:
+        if (!eg_off && !reset && shift > 0)
+        {
+            eg_inc = 1 << (shift - 1);
+        }
+        break;
+    }
+    slot->eg_rout = (eg_rout + eg_inc) & 0x1ff;
+    /* Key off */
+    if (reset)
+    {
+        slot->eg_gen = envelope_gen_num_attack;
+    }
+    if (!slot->key)
+    {
+        slot->eg_gen = envelope_gen_num_release;
+    }
+}
+
+/* f_num/block base frequency of a channel, with the vibrato offset applied if [vib] is set */
+INLINE uint32_t NOPL3S_PhaseBaseFreq(const opl3_chip *chip, const opl3_channel *channel, uint8_t vib)
+{
+    uint16_t f_num = channel->f_num;
+    if (vib)
+    {
+        int8_t range;
+        uint8_t vibpos;
+
+        range = (f_num >> 7) & 7;
+        vibpos = chip->vibpos;
+
+        if (!(vibpos & 3))
+        {
+            range = 0;
+        }
+        else if (vibpos & 1)
+        {
+            range >>= 1;
+        }
+        range >>= chip->vibshift;
+
+        if (vibpos & 4)
+        {
+            range = -range;
+        }
+        f_num += range;
+    }
+    return (f_num << channel->block) >> 1;
+}
+
+/* rhythm mode phase outputs and noise, in the order OPL3_PhaseGenerate does them */
+static void NOPL3S_PhaseRhythm(opl3_chip *chip, uint32_t noise13, uint32_t noise16)
+{
+    uint16_t phase;
+    uint8_t rm_xor;
+
+    phase = chip->slot[13].pg_phase_out;
+    chip->rm_hh_bit2 = (phase >> 2) & 1;
+    chip->rm_hh_bit3 = (phase >> 3) & 1;
+    chip->rm_hh_bit7 = (phase >> 7) & 1;
+    chip->rm_hh_bit8 = (phase >> 8) & 1;
+    if (!(chip->rhy & 0x20))
+    {
+        return;
+    }
+
+    /* hh, using the tc bits of the previous sample */
+    rm_xor = (chip->rm_hh_bit2 ^ chip->rm_hh_bit7)
+           | (chip->rm_hh_bit3 ^ chip->rm_tc_bit5)
+           | (chip->rm_tc_bit3 ^ chip->rm_tc_bit5);
+    chip->slot[13].pg_phase_out = rm_xor << 9;
+    if (rm_xor ^ (noise13 & 1))
+    {
+        chip->slot[13].pg_phase_out |= 0xd0;
+    }
+    else
+    {
+        chip->slot[13].pg_phase_out |= 0x34;
+    }
+    /* sd */
+    chip->slot[16].pg_phase_out = (chip->rm_hh_bit8 << 9)
+                                | ((chip->rm_hh_bit8 ^ (noise16 & 1)) << 8);
+    /* tc */
+    phase = chip->slot[17].pg_phase_out;
+    chip->rm_tc_bit3 = (phase >> 3) & 1;
+    chip->rm_tc_bit5 = (phase >> 5) & 1;
+    rm_xor = (chip->rm_hh_bit2 ^ chip->rm_hh_bit7)
+           | (chip->rm_hh_bit3 ^ chip->rm_tc_bit5)
+           | (chip->rm_tc_bit3 ^ chip->rm_tc_bit5);
+    chip->slot[17].pg_phase_out = (rm_xor << 9) | 0x80;
+}
+
+INLINE void NOPL3S_SlotGenerate(opl3_slot *slot)
+{
+    slot->out = NOPL3S_EnvelopeCalcSin(slot->reg_wf, slot->pg_phase_out + *slot->mod, slot->eg_out);
+}
+
+static void NOPL3S_Mix(const opl3_chip *chip, int32_t *mix, uint8_t right)
+{
+    const opl3_channel *channel;
+    const int16_t * const *out;
+    uint8_t ii;
+    int16_t accm;
+
+    mix[0] = mix[1] = 0;
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &chip->channel[ii];
+        if (channel->muted)
+            continue;
+        out = channel->out;
+        accm = *out[0] + *out[1] + *out[2] + *out[3];
+#if OPL_ENABLE_STEREOEXT
+        mix[0] += (int16_t)((accm * (right ? channel->rightpan : channel->leftpan)) >> 16);
+#else
+        mix[0] += (int16_t)(accm & (right ? channel->chb : channel->cha));
+#endif
+        mix[1] += (int16_t)(accm & (right ? channel->chd : channel->chc));
+    }
+}
+
+static void NOPL3S_Generate4Ch(opl3_chip *chip, int32_t *buf4)
+{
+    opl3_slot *slot;
+    uint32_t basefreq[18][2];
+    uint32_t noise;
+    uint32_t noise13 = 0;
+    uint32_t noise16 = 0;
+    uint16_t phase;
+    int32_t mix[2];
+    uint8_t ii;
+    uint8_t n_bit;
+    uint8_t shift = 0;
+
+    buf4[1] = chip->mixbuff[1];
+    buf4[3] = chip->mixbuff[3];
+
+    /* Feedback (uses the operator outputs of the previous sample) */
+    for (ii = 0; ii < 36; ii++)
+    {
+        NOPL3S_SlotCalcFB(&chip->slot[ii]);
+    }
+
+    /* Envelope */
+    for (ii = 0; ii < 36; ii++)
+    {
+        NOPL3S_EnvelopeCalc(&chip->slot[ii], chip->eg_add, chip->eg_state, chip->timer & 0x03u);
+    }
+
+    /* Phase */
+    for (ii = 0; ii < 18; ii++)
+    {
+        basefreq[ii][0] = NOPL3S_PhaseBaseFreq(chip, &chip->channel[ii], 0);
+        basefreq[ii][1] = NOPL3S_PhaseBaseFreq(chip, &chip->channel[ii], 1);
+    }
+    for (ii = 0; ii < 36; ii++)
+    {
+        slot = &chip->slot[ii];
+        phase = (uint16_t)(slot->pg_phase >> 9);
+        if (slot->pg_reset)
+        {
+            slot->pg_phase = 0;
+        }
+        slot->pg_phase += (basefreq[slot->channel->ch_num][slot->reg_vib] * mt[slot->reg_mult]) >> 1;
+        slot->pg_phase_out = phase;
+    }
+    /* noise LFSR, clocked once per slot */
+    noise = chip->noise;
+    for (ii = 0; ii < 36; ii++)
+    {
+        if (ii == 13)
+        {
+            noise13 = noise;
+        }
+        else if (ii == 16)
+        {
+            noise16 = noise;
+        }
+        n_bit = ((noise >> 14) ^ noise) & 0x01;
+        noise = (noise >> 1) | (n_bit << 22);
+    }
+    chip->noise = noise;
+    NOPL3S_PhaseRhythm(chip, noise13, noise16);
+
+    /* Operator output, in slot order because of the modulation inputs */
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    for (ii = 0; ii < 15; ii++)
+#else
+    for (ii = 0; ii < 36; ii++)
+#endif
+    {
+        NOPL3S_SlotGenerate(&chip->slot[ii]);
+    }
+
+    NOPL3S_Mix(chip, mix, 0);
+    chip->mixbuff[0] = mix[0];
+    chip->mixbuff[2] = mix[1];
+
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    for (ii = 15; ii < 33; ii++)
+    {
+        NOPL3S_SlotGenerate(&chip->slot[ii]);
+    }
+#endif
+
+    buf4[0] = chip->mixbuff[0];
+    buf4[2] = chip->mixbuff[2];
+
+    NOPL3S_Mix(chip, mix, 1);
+    chip->mixbuff[1] = mix[0];
+    chip->mixbuff[3] = mix[1];
+
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    for (ii = 33; ii < 36; ii++)
+    {
+        NOPL3S_SlotGenerate(&chip->slot[ii]);
+    }
+#endif
+
+    if ((chip->timer & 0x3f) == 0x3f)
+    {
+        chip->tremolopos = (chip->tremolopos + 1) % 210;
+    }
+    if (chip->tremolopos < 105)
+    {
+        chip->tremolo = chip->tremolopos >> chip->tremoloshift;
+    }
+    else
+    {
+        chip->tremolo = (210 - chip->tremolopos) >> chip->tremoloshift;
+    }
+
+    if ((chip->timer & 0x3ff) == 0x3ff)
+    {
+        chip->vibpos = (chip->vibpos + 1) & 7;
+    }
+
+    chip->timer++;
+
+    chip->eg_add = 0;
+    if (chip->eg_timer)
+    {
+        while (shift < 36 && ((chip->eg_timer >> shift) & 1) == 0)
+        {
+            shift++;
+        }
+        if (shift > 12)
+        {
+            chip->eg_add = 0;
+        }
+        else
+        {
+            chip->eg_add = shift + 1;
+        }
+    }
+
+    if (chip->eg_timerrem || chip->eg_state)
+    {
+        if (chip->eg_timer == (uint64_t)0xfffffffff)
+        {
+            chip->eg_timer = 0;
+            chip->eg_timerrem = 1;
+        }
+        else
+        {
+            chip->eg_timer++;
+            chip->eg_timerrem = 0;
+        }
+    }
+
+    chip->eg_state ^= 1;
+
+#ifdef NOPL_ENABLE_WRITEBUF
+    while (chip->writebuf[chip->writebuf_cur].time <= chip->writebuf_samplecnt)
+    {
+        if (!(chip->writebuf[chip->writebuf_cur].reg & 0x200))
+        {
+            break;
+        }
+        chip->writebuf[chip->writebuf_cur].reg &= 0x1ff;
+        NOPL3_WriteReg(chip, chip->writebuf[chip->writebuf_cur].reg,
+                       chip->writebuf[chip->writebuf_cur].data);
+        chip->writebuf_cur = (chip->writebuf_cur + 1) % OPL_WRITEBUF_SIZE;
+    }
+    chip->writebuf_samplecnt++;
+#endif
+}
+
+static void NOPL3S_GenerateResampled(opl3_chip *chip, int32_t *buf)
+{
+    if (chip->rateratio == (1 << RSM_FRAC))
+    {
+        NOPL3S_Generate4Ch(chip, chip->samples);
+        buf[0] = (int32_t)chip->samples[0];
+        buf[1] = (int32_t)chip->samples[1];
+        return;
+    }
+
+    chip->samplecnt += 1 << RSM_FRAC;
+    while (chip->samplecnt >= chip->rateratio)
+    {
+        chip->oldsamples[0] = chip->samples[0];
+        chip->oldsamples[1] = chip->samples[1];
+        chip->oldsamples[2] = chip->samples[2];
+        chip->oldsamples[3] = chip->samples[3];
+        NOPL3S_Generate4Ch(chip, chip->samples);
+        chip->samplecnt -= chip->rateratio;
+    }
+    buf[0] = (int32_t)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
+                     + chip->samples[0] * chip->samplecnt) / chip->rateratio);
+    buf[1] = (int32_t)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
+                     + chip->samples[1] * chip->samplecnt) / chip->rateratio);
+}
+
+void nukedopl3_update_soa(void *chip, UINT32 samples, DEV_SMPL **out)
+{
+	opl3_chip* opl3 = (opl3_chip*)chip;
+	int32_t buffers[2];
+	UINT32 i;
+
+	if (opl3->isDisabled)
+	{
+		// the "unused OPL4 FM part" speed hack is shared with the scalar path
+		nukedopl3_update(chip, samples, out);
+		return;
+	}
+
+	for( i=0; i < samples ; i++ )
+	{
+		NOPL3S_GenerateResampled(opl3, buffers);
+		out[0][i] = (buffers[0] * opl3->masterVolL) >> 12;
+		out[1][i] = (buffers[1] * opl3->masterVolR) >> 12;
+	}
+}
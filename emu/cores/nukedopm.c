@@ -42,12 +42,16 @@ static void nukedopm_shutdown(void *chip);
 static void nukedopm_reset_chip(void *chipptr);
 static void nukedopm_update(void *chipptr, UINT32 samples, DEV_SMPL **out);
 static void nukedopm_set_mute_mask(void *chipptr, UINT32 MuteMask);
+static UINT32 nukedopm_save_state(void *chip, UINT32 bufSize, void* buffer);
+static UINT8 nukedopm_load_state(void *chip, UINT32 dataSize, const void* data);
 
 
 static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, nukedopm_write},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, nukedopm_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, nukedopm_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, nukedopm_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_YM2151_Nuked =
@@ -2215,3 +2219,16 @@ static void nukedopm_set_mute_mask(void *chipptr, UINT32 MuteMask)
     
     return;
 }
+
+static UINT32 nukedopm_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(opm_t), bufSize, buffer);
+}
+
+static UINT8 nukedopm_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(opm_t))
+		return 0xFF;
+	memcpy(chip, data, sizeof(opm_t));
+	return 0x00;
+}
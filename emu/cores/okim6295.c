@@ -81,9 +81,12 @@ static void okim6295_w(void* chip, UINT8 offset, UINT8 data);
 
 static void okim6295_alloc_rom(void* info, UINT32 memsize);
 static void okim6295_write_rom(void* info, UINT32 offset, UINT32 length, const UINT8* data);
+static void okim6295_ref_rom(void* info, UINT32 memsize, const UINT8* data);
 static void okim6295_set_mute_mask(void *info, UINT32 MuteMask);
 static void okim6295_set_srchg_cb(void* chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 static void okim6295_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+static UINT32 okim6295_save_state(void* chip, UINT32 bufSize, void* buffer);
+static UINT8 okim6295_load_state(void* chip, UINT32 dataSize, const void* data);
 
 
 static DEVDEF_RWFUNC devFunc[] =
@@ -92,9 +95,12 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, okim6295_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, okim6295_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, okim6295_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, okim6295_ref_rom},
 	{RWF_CLOCK | RWF_WRITE, DEVRW_VALUE, 0, okim6295_set_clock},
 	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, okim6295_get_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, okim6295_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, okim6295_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, okim6295_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -188,6 +194,7 @@ struct _okim6295_state
 	
 	UINT32  ROMSize;
 	UINT8*  ROM;
+	UINT8   ROMIsRef;   // ROM points to external data (must not be written or freed)
 	
 	DEVCB_SRATE_CHG SmpRateFunc;
 	void* SmpRateData;
@@ -359,6 +366,7 @@ static UINT8 device_start_okim6295(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	memset(info->nmk_bank, 0x00, 4 * sizeof(UINT8));
 	info->ROM = NULL;
 	info->ROMSize = 0x00;
+	info->ROMIsRef = 0;
 
 	info->initial_clock = cfg->clock;
 	info->pin7_initial = cfg->flags;
@@ -380,7 +388,8 @@ static void device_stop_okim6295(void* chipptr)
 {
 	okim6295_state *chip = (okim6295_state *)chipptr;
 	
-	free(chip->ROM);
+	if (! chip->ROMIsRef)
+		free(chip->ROM);
 	free(chip);
 	
 	return;
@@ -622,6 +631,11 @@ static void okim6295_alloc_rom(void* info, UINT32 memsize)
 	if (chip->ROMSize == memsize)
 		return;
 	
+	if (chip->ROMIsRef)
+	{
+		chip->ROM = NULL;	// detach from the external ROM
+		chip->ROMIsRef = 0;
+	}
 	chip->ROM = (UINT8*)realloc(chip->ROM, memsize);
 	chip->ROMSize = memsize;
 	memset(chip->ROM, 0xFF, chip->ROMSize);
@@ -638,11 +652,34 @@ static void okim6295_write_rom(void* info, UINT32 offset, UINT32 length, const U
 	if (offset + length > chip->ROMSize)
 		length = chip->ROMSize - offset;
 	
+	if (chip->ROMIsRef)
+	{
+		// make a private copy of the external ROM before modifying it
+		UINT8* romCopy = (UINT8*)malloc(chip->ROMSize);
+		memcpy(romCopy, chip->ROM, chip->ROMSize);
+		chip->ROM = romCopy;
+		chip->ROMIsRef = 0;
+	}
 	memcpy(&chip->ROM[offset], data, length);
 	
 	return;
 }
 
+static void okim6295_ref_rom(void* info, UINT32 memsize, const UINT8* data)
+{
+	okim6295_state *chip = (okim6295_state *)info;
+	
+	if (! chip->ROMIsRef)
+		free(chip->ROM);
+	if (data == NULL)
+		memsize = 0x00;
+	chip->ROM = (UINT8*)data;	// Note: The data is only read from while ROMIsRef is set.
+	chip->ROMSize = memsize;
+	chip->ROMIsRef = (data != NULL);
+	
+	return;
+}
+
 
 static void okim6295_set_mute_mask(void *info, UINT32 MuteMask)
 {
@@ -672,3 +709,27 @@ static void okim6295_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&info->logger, info, func, param);
 	return;
 }
+
+static UINT32 okim6295_save_state(void* chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(okim6295_state), bufSize, buffer);
+}
+
+static UINT8 okim6295_load_state(void* chip, UINT32 dataSize, const void* data)
+{
+	okim6295_state *info = (okim6295_state *)chip;
+	UINT32 romSize = info->ROMSize;
+	UINT8* rom = info->ROM;
+	UINT8 romIsRef = info->ROMIsRef;
+	UINT32 oldRate = okim6295_get_rate(info);
+	
+	if (dataSize != sizeof(okim6295_state))
+		return 0xFF;
+	memcpy(info, data, sizeof(okim6295_state));
+	info->ROMSize = romSize;	// keep the current ROM
+	info->ROM = rom;
+	info->ROMIsRef = romIsRef;
+	if (info->SmpRateFunc != NULL && okim6295_get_rate(info) != oldRate)
+		info->SmpRateFunc(info->SmpRateData, okim6295_get_rate(info));
+	return 0x00;
+}
@@ -31,6 +31,7 @@ static UINT8 device_start_ym3812_adlibemu(const DEV_GEN_CFG* cfg, DEV_INFO* retD
 static UINT8 device_start_ym3526(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 device_start_y8950(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 device_start_ym3812_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
+static UINT8 device_start_ym3812_nuked_soa(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 
 
 
@@ -40,6 +41,8 @@ static DEVDEF_RWFUNC devFunc3812_MAME[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym3812_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym3812_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, opl_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, opl_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, opl_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef3812_MAME =
@@ -67,6 +70,8 @@ static DEVDEF_RWFUNC devFunc3812_Emu[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, adlib_OPL2_writeIO},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, adlib_OPL2_reg_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, adlib_OPL2_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, adlib_OPL2_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, adlib_OPL2_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef3812_AdLibEmu =
@@ -94,6 +99,8 @@ static DEVDEF_RWFUNC devFunc3812_Nuked[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, nukedopl3_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, nukedopl3_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, nukedopl3_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, nukedopl3_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, nukedopl3_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef3812_Nuked =
@@ -114,6 +121,25 @@ static DEV_DEF devDef3812_Nuked =
 	
 	devFunc3812_Nuked,	// rwFuncs
 };
+// same model and state as devDef3812_Nuked, but running each slot stage for all slots at once
+static DEV_DEF devDef3812_NukedSoA =
+{
+	"YM3812", "Nuked OPL3 (stage-ordered)", FCC_NUKV,
+	
+	device_start_ym3812_nuked_soa,
+	nukedopl3_shutdown,
+	nukedopl3_reset_chip,
+	nukedopl3_update_soa,
+	
+	NULL,	// SetOptionBits
+	nukedopl3_set_mute_mask,
+	NULL,	// SetPanning
+	NULL,	// SetSampleRateChangeCallback
+	NULL,	// SetLoggingCallback
+	NULL,	// LinkDevice
+	
+	devFunc3812_Nuked,	// rwFuncs
+};
 #endif	// EC_YM3812_NUKED
 
 #if defined(SNDDEV_YM3812) || defined(SNDDEV_YM3526)
@@ -161,6 +187,7 @@ const DEV_DECL sndDev_YM3812 =
 #endif
 #ifdef EC_YM3812_NUKED
 		&devDef3812_Nuked,	// note: OPL3 emulator, so some things aren't working (OPL1 mode, OPL2 detection)
+		&devDef3812_NukedSoA,
 #endif
 		NULL
 	}
@@ -174,6 +201,8 @@ static DEVDEF_RWFUNC devFunc3526_MAME[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym3526_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym3526_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, opl_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, opl_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, opl_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef3526_MAME =
@@ -223,6 +252,8 @@ static DEVDEF_RWFUNC devFunc8950_MAME[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, y8950_write_pcmrom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, y8950_alloc_pcmrom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, opl_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, opl_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, opl_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef8950_MAME =
@@ -350,6 +381,28 @@ static UINT8 device_start_ym3812_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	INIT_DEVINF(retDevInf, devData, rate, &devDef3812_Nuked);
 	return 0x00;
 }
+
+static UINT8 device_start_ym3812_nuked_soa(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	void* chip;
+	DEV_DATA* devData;
+	UINT32 rate;
+	
+	rate = cfg->clock / 72;
+	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
+	
+	chip = nukedopl3_init(cfg->clock * 4, rate);
+	if (chip == NULL)
+		return 0xFF;
+	
+	nukedopl3_set_volume(chip, 0x10000);
+	nukedopl3_set_mute_mask(chip, 0x000000);
+	
+	devData = (DEV_DATA*)chip;
+	devData->chipInf = chip;
+	INIT_DEVINF(retDevInf, devData, rate, &devDef3812_NukedSoA);
+	return 0x00;
+}
 #endif	// EC_YM3812_NUKED
 
 
@@ -60,6 +60,8 @@ static DEVDEF_RWFUNC devFunc_MAME_2203[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym2203_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym2203_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2203_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ym2203_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ym2203_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME_2203 =
@@ -119,6 +121,8 @@ static DEVDEF_RWFUNC devFunc_MAME_2608[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 'B', ym2608_write_pcmromb},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 'B', ym2608_alloc_pcmromb},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2608_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ym2608_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ym2608_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME_2608 =
@@ -186,6 +190,8 @@ static DEVDEF_RWFUNC devFunc_MAME_2610[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 'B', ym2610_write_pcmromb},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 'B', ym2610_alloc_pcmromb},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2610_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ym2610_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ym2610_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME_2610 =
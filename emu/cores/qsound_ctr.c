@@ -18,7 +18,9 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../mixkernels.h"
 #include "qsound_ctr.h"
+#include "qsoundintf.h"	// for OPT_QSOUND_*
 
 #define CLAMP(x, low, high)  (((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x)))
 
@@ -50,7 +52,9 @@ struct qsound_fir {
 	int delay_pos;
 	INT16 table_pos;
 	INT16 taps[95];
-	INT16 delay_line[95];
+	// only (tap_count-1) entries are used, followed by a copy of them,
+	// so that the optimized filter can read all of them in one piece
+	INT16 delay_line[94*2];
 };
 
 // Delay line
@@ -79,6 +83,7 @@ struct qsound_chip {
 	UINT8* romData;
 	UINT32 romSize;
 	UINT32 romMask;
+	UINT8 romIsRef;	// romData points to external ROM data (must not be written or freed)
 	UINT32 muteMask;
 	
 	// ==================================================== //
@@ -93,6 +98,7 @@ struct qsound_chip {
 
 	UINT16 voice_pan[16+3];
 	INT16 voice_output[16+3];
+	INT16 voice_gain[2][2][16+3];	// pan_tables entry of each voice, for the optimized mixer
 
 	struct qsound_echo echo;
 
@@ -111,12 +117,16 @@ struct qsound_chip {
 	UINT8 ready_flag;
 
 	UINT8 opt_nowait;
+	UINT8 opt_ref_dsp;	// use the reference mixing/filter loops
+	MIXK_DOTS16_FUNC dot_s16;
 
 	UINT16 *register_map[256];
 };
 
 static void init_pan_tables(struct qsound_chip *chip);
 static void init_register_map(struct qsound_chip *chip);
+static void update_voice_gain(struct qsound_chip *chip, int voice_no);
+static void sync_fir_delay_line(struct qsound_fir *f);
 static void update_sample(struct qsound_chip *chip);
 static void update_flush(struct qsound_chip *chip);
 
@@ -131,6 +141,7 @@ INLINE INT16 pcm_update(struct qsound_chip *chip, int voice_no, INT32 *echo_out)
 INLINE void adpcm_update(struct qsound_chip *chip, int voice_no, int nibble);
 INLINE INT16 echo(struct qsound_echo *r,INT32 input);
 INLINE INT32 fir(struct qsound_fir *f, INT16 input);
+INLINE INT32 fir_fast(struct qsound_chip *chip, struct qsound_fir *f, INT16 input);
 INLINE INT32 delay(struct qsound_delay *d, INT32 input);
 INLINE void delay_update(struct qsound_delay *d);
 
@@ -147,6 +158,7 @@ static void qsoundc_write_data(void* info, UINT8 address, UINT16 data);
 
 static void qsoundc_alloc_rom(void* info, UINT32 memsize);
 static void qsoundc_write_rom(void* info, UINT32 offset, UINT32 length, const UINT8* data);
+static void qsoundc_ref_rom(void* info, UINT32 memsize, const UINT8* data);
 static void qsoundc_set_options(void* info, UINT32 options);
 static void qsoundc_set_mute_mask(void* info, UINT32 MuteMask);
 
@@ -157,6 +169,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D16, 0, qsoundc_write_data},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, qsoundc_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, qsoundc_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, qsoundc_ref_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, qsoundc_set_mute_mask},
 	{0x00, 0x00, 0, NULL}
 };
@@ -190,7 +203,10 @@ static UINT8 device_start_qsound_ctr(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 	chip->romData = NULL;
 	chip->romSize = 0x00;
 	chip->romMask = 0x00;
+	chip->romIsRef = 0;
 	chip->opt_nowait = 0;
+	chip->opt_ref_dsp = 0;
+	chip->dot_s16 = MixK_GetDotS16();
 	
 	qsoundc_set_mute_mask(chip, 0x00000);
 	
@@ -207,7 +223,8 @@ static void device_stop_qsound_ctr(void* info)
 {
 	struct qsound_chip* chip = (struct qsound_chip*)info;
 	
-	free(chip->romData);
+	if (! chip->romIsRef)
+		free(chip->romData);
 	free(chip);
 	
 	return;
@@ -265,6 +282,8 @@ static void qsoundc_write_data(void* info, UINT8 address, UINT16 data)
 	destination = chip->register_map[address];
 	if(destination)
 		*destination = data;
+	if(address >= 0x80 && address < 0x93)
+		update_voice_gain(chip, address - 0x80);	// voice_pan
 	chip->ready_flag = 0;
 
 	return;
@@ -299,6 +318,11 @@ static void qsoundc_alloc_rom(void* info, UINT32 memsize)
 	if (chip->romSize == memsize)
 		return;
 	
+	if (chip->romIsRef)
+	{
+		chip->romData = NULL;	// detach from the external ROM
+		chip->romIsRef = 0;
+	}
 	chip->romData = (UINT8*)realloc(chip->romData, memsize);
 	chip->romSize = memsize;
 	chip->romMask = pow2_mask(memsize);
@@ -316,16 +340,51 @@ static void qsoundc_write_rom(void* info, UINT32 offset, UINT32 length, const UI
 	if (offset + length > chip->romSize)
 		length = chip->romSize - offset;
 	
+	if (chip->romIsRef)
+	{
+		// make a private copy of the external ROM before modifying it
+		UINT8* romCopy = (UINT8*)malloc(chip->romSize);
+		memcpy(romCopy, chip->romData, chip->romSize);
+		chip->romData = romCopy;
+		chip->romIsRef = 0;
+	}
 	memcpy(chip->romData + offset, data, length);
 	
 	return;
 }
 
+static void qsoundc_ref_rom(void* info, UINT32 memsize, const UINT8* data)
+{
+	struct qsound_chip* chip = (struct qsound_chip*)info;
+	
+	if (! chip->romIsRef)
+		free(chip->romData);
+	if (data == NULL)
+		memsize = 0x00;
+	chip->romData = (UINT8*)data;	// Note: The data is only read from while romIsRef is set.
+	chip->romSize = memsize;
+	chip->romMask = pow2_mask(memsize);
+	chip->romIsRef = (data != NULL);
+	
+	return;
+}
+
 static void qsoundc_set_options(void* info, UINT32 options)
 {
 	struct qsound_chip* chip = (struct qsound_chip*)info;
+	int ch;
 
 	chip->opt_nowait = (options >> 0) & 0x01;
+	if (chip->opt_ref_dsp && ! (options & OPT_QSOUND_REF_DSP))
+	{
+		// The reference filter doesn't maintain the copy of the delay line.
+		for (ch = 0; ch < 2; ch ++)
+		{
+			sync_fir_delay_line(&chip->filter[ch]);
+			sync_fir_delay_line(&chip->alt_filter[ch]);
+		}
+	}
+	chip->opt_ref_dsp = (options & OPT_QSOUND_REF_DSP) ? 1 : 0;
 
 	return;
 }
@@ -462,6 +521,21 @@ static void init_pan_tables(struct qsound_chip *chip)
 	}
 }
 
+// cache the pan table entries of a voice for the optimized mixer
+static void update_voice_gain(struct qsound_chip *chip, int voice_no)
+{
+	UINT16 pan_index = chip->voice_pan[voice_no]-0x110;
+	int ch;
+	
+	if(pan_index > 97)
+		pan_index = 97;
+	for(ch=0; ch<2; ch++)
+	{
+		chip->voice_gain[ch][PANTBL_DRY][voice_no] = chip->pan_tables[ch][PANTBL_DRY][pan_index];
+		chip->voice_gain[ch][PANTBL_WET][voice_no] = chip->pan_tables[ch][PANTBL_WET][pan_index];
+	}
+}
+
 static void init_register_map(struct qsound_chip *chip)
 {
 	int i;
@@ -617,6 +691,7 @@ static void state_init(struct qsound_chip *chip)
 	{
 		chip->voice_pan[i] = 0x120;
 		chip->voice_output[i] = 0;
+		update_voice_gain(chip, i);
 	}
 
 	for(i=0;i<16;i++)
@@ -675,6 +750,7 @@ static void state_refresh_filter_1(struct qsound_chip *chip)
 		table = get_filter_table(chip,chip->filter[ch].table_pos);
 		if (table != NULL)
 			memcpy(chip->filter[ch].taps, table, 95 * sizeof(INT16));
+		sync_fir_delay_line(&chip->filter[ch]);
 	}
 	
 	chip->state = chip->next_state = STATE_NORMAL1;
@@ -694,6 +770,7 @@ static void state_refresh_filter_2(struct qsound_chip *chip)
 		table = get_filter_table(chip,chip->filter[ch].table_pos);
 		if (table != NULL)
 			memcpy(chip->filter[ch].taps, table, 45 * sizeof(INT16));
+		sync_fir_delay_line(&chip->filter[ch]);
 		
 		chip->alt_filter[ch].delay_pos = 0;
 		chip->alt_filter[ch].tap_count = 44;
@@ -701,6 +778,7 @@ static void state_refresh_filter_2(struct qsound_chip *chip)
 		table = get_filter_table(chip,chip->alt_filter[ch].table_pos);
 		if (table != NULL)
 			memcpy(chip->alt_filter[ch].taps, table, 44 * sizeof(INT16));
+		sync_fir_delay_line(&chip->alt_filter[ch]);
 	}
 	
 	chip->state = chip->next_state = STATE_NORMAL2;
@@ -852,27 +930,45 @@ static void state_normal_update(struct qsound_chip *chip)
 		INT32 dry = (ch == 0) ? echo_output<<14 : 0;
 		INT32 output = 0;
 		
-		for(v=0; v<19; v++)
+		if(chip->opt_ref_dsp)
 		{
-			UINT16 pan_index = chip->voice_pan[v]-0x110;
-			if(pan_index > 97)
-				pan_index = 97;
-			
-			// Apply different volume tables on the dry and wet inputs.
-			dry -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_DRY][pan_index]);
-			wet -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_WET][pan_index]);
+			for(v=0; v<19; v++)
+			{
+				UINT16 pan_index = chip->voice_pan[v]-0x110;
+				if(pan_index > 97)
+					pan_index = 97;
+				
+				// Apply different volume tables on the dry and wet inputs.
+				dry -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_DRY][pan_index]);
+				wet -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_WET][pan_index]);
+			}
+		}
+		else
+		{
+			// same as above, with the pan table entries cached in voice_gain
+			dry = (INT32)((UINT32)dry - (UINT32)chip->dot_s16(chip->voice_output, chip->voice_gain[ch][PANTBL_DRY], 19));
+			wet = (INT32)((UINT32)wet - (UINT32)chip->dot_s16(chip->voice_output, chip->voice_gain[ch][PANTBL_WET], 19));
 		}
 
 		// Saturate accumulated voices
 		dry = CLAMP(dry, -0x1fffffff, 0x1fffffff) << 2;
 		wet = CLAMP(wet, -0x1fffffff, 0x1fffffff) << 2;
 		
-		// Apply FIR filter on 'wet' input
-		wet = fir(&chip->filter[ch], wet >> 16);
-		
-		// in mode 2, we do this on the 'dry' input too
-		if(chip->state == STATE_NORMAL2)
-			dry = fir(&chip->alt_filter[ch], dry >> 16);
+		if(chip->opt_ref_dsp)
+		{
+			// Apply FIR filter on 'wet' input
+			wet = fir(&chip->filter[ch], wet >> 16);
+			
+			// in mode 2, we do this on the 'dry' input too
+			if(chip->state == STATE_NORMAL2)
+				dry = fir(&chip->alt_filter[ch], dry >> 16);
+		}
+		else
+		{
+			wet = fir_fast(chip, &chip->filter[ch], wet >> 16);
+			if(chip->state == STATE_NORMAL2)
+				dry = fir_fast(chip, &chip->alt_filter[ch], dry >> 16);
+		}
 		
 		// output goes through a delay line and attenuation
 		output = (delay(&chip->wet[ch], wet) + delay(&chip->dry[ch], dry));
@@ -921,6 +1017,37 @@ INLINE INT32 fir(struct qsound_fir *f, INT16 input)
 	return output;
 }
 
+// Same as fir(), but reads the delay line in one piece using a SIMD dot product.
+// The products are summed modulo 2^32 in both versions, so the results are identical.
+INLINE INT32 fir_fast(struct qsound_chip *chip, struct qsound_fir *f, INT16 input)
+{
+	int len = f->tap_count-1;
+	UINT32 output;
+	
+	if(len < 0)
+		return fir(f, input);	// filter wasn't set up yet
+	
+	output = (UINT32)chip->dot_s16(f->taps, &f->delay_line[f->delay_pos], len);
+	output += (UINT32)(f->taps[len] * input);
+	
+	f->delay_line[f->delay_pos] = input;
+	f->delay_line[f->delay_pos+len] = input;
+	f->delay_pos++;
+	if(f->delay_pos >= len)
+		f->delay_pos = 0;
+	
+	return (INT32)(0 - (output<<2));
+}
+
+// refresh the copy of the delay line that follows the used entries
+static void sync_fir_delay_line(struct qsound_fir *f)
+{
+	int len = f->tap_count-1;
+	
+	if(len > 0)
+		memcpy(&f->delay_line[len], f->delay_line, len * sizeof(INT16));
+}
+
 // Apply delay line and component volume
 INLINE INT32 delay(struct qsound_delay *d, INT32 input)
 {
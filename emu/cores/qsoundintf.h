@@ -11,6 +11,7 @@
 
 
 #define OPT_QSOUND_NOWAIT		0x01	// don't require waiting after initialization/filter changes
+#define OPT_QSOUND_REF_DSP		0x02	// [ctr] use the reference (non-SIMD) mixing and filter loops
 
 
 extern const DEV_DECL sndDev_QSound;
@@ -41,6 +41,7 @@
 #include "../snddef.h"
 #include "../EmuHelper.h"
 #include "../logging.h"
+#include "../../utils/OSOnce.h"
 #include "scsp.h"
 #include "scspdsp.h"
 
@@ -313,11 +314,6 @@ struct _scsp_state
 	UINT8 MidiStack[32];
 	UINT8 MidiW, MidiR;
 
-	INT32 EG_TABLE[0x400];
-
-	int LPANTABLE[0x10000];
-	int RPANTABLE[0x10000];
-
 	//int TimPris[3];
 	//int TimCnt[3];
 
@@ -337,8 +333,6 @@ struct _scsp_state
 	UINT16 mcieb;
 	UINT16 mcipd;
 
-	int ARTABLE[64], DRTABLE[64];
-
 	SCSPDSP DSP;
 
 	INT16 *RBUFDST;   //this points to where the sample will be stored in the RingBuf
@@ -355,6 +349,13 @@ struct _scsp_state
 
 static const float SDLT[8]={-1000000.0f,-36.0f,-30.0f,-24.0f,-18.0f,-12.0f,-6.0f,0.0f};
 
+// lookup tables, shared by all chips
+static INT32 EG_TABLE[0x400];
+static int LPANTABLE[0x10000];
+static int RPANTABLE[0x10000];
+static int ARTABLE[64], DRTABLE[64];
+static OS_ONCE tablesInit = OS_ONCE_INIT;
+
 
 static UINT8 BypassDSP = 0x01;
 
@@ -363,7 +364,7 @@ static int Get_AR(scsp_state *scsp,int base,int R)
 	int Rate=base+(R<<1);
 	if(Rate>63) Rate=63;
 	if(Rate<0) Rate=0;
-	return scsp->ARTABLE[Rate];
+	return ARTABLE[Rate];
 }
 
 static int Get_DR(scsp_state *scsp,int base,int R)
@@ -371,7 +372,7 @@ static int Get_DR(scsp_state *scsp,int base,int R)
 	int Rate=base+(R<<1);
 	if(Rate>63) Rate=63;
 	if(Rate<0) Rate=0;
-	return scsp->DRTABLE[Rate];
+	return DRTABLE[Rate];
 }
 
 static void Compute_EG(scsp_state *scsp,SCSP_SLOT *slot)
@@ -505,35 +506,16 @@ static void SCSP_StopSlot(SCSP_SLOT *slot,int keyoff)
 
 #define log_base_2(n) (log((double)(n))/log(2.0))
 
-static void SCSP_Init(scsp_state *scsp, UINT32 clock)
+// called once, the tables are shared by all chips
+static void SCSP_InitTables(void)
 {
 	int i;
 
-	SCSPDSP_Init(&scsp->DSP);
-
-	scsp->clock = clock;
-	scsp->rate = clock / 512;
-
-	//scsp->IrqTimA = scsp->IrqTimBC = scsp->IrqMidi = 0;
-	scsp->MidiR = scsp->MidiW = 0;
-	scsp->MidiOutR = scsp->MidiOutW = 0;
-
-	// get SCSP RAM
-	scsp->SCSPRAM_LENGTH = 0x80000;	// 512 KB
-	scsp->SCSPRAM = (unsigned char*)malloc(scsp->SCSPRAM_LENGTH);
-	scsp->DSP.SCSPRAM_LENGTH = scsp->SCSPRAM_LENGTH / 2;
-	scsp->DSP.SCSPRAM = (UINT16*)scsp->SCSPRAM;
-	//scsp->SCSPRAM += scsp->roffset;
-
-	//scsp->timerA = machine().scheduler().timer_alloc(timer_expired_delegate(FUNC(scsp_device::timerA_cb), this));
-	//scsp->timerB = machine().scheduler().timer_alloc(timer_expired_delegate(FUNC(scsp_device::timerB_cb), this));
-	//scsp->timerC = machine().scheduler().timer_alloc(timer_expired_delegate(FUNC(scsp_device::timerC_cb), this));
-
 	for(i=0;i<0x400;++i)
 	{
 		float envDB=((float)(3*(i-0x3ff)))/32.0f;
 		float scale=(float)(1<<SHIFT);
-		scsp->EG_TABLE[i]=(INT32)(pow(10.0,envDB/20.0)*scale);
+		EG_TABLE[i]=(INT32)(pow(10.0,envDB/20.0)*scale);
 	}
 
 	for(i=0;i<0x10000;++i)
@@ -583,12 +565,12 @@ static void SCSP_Init(scsp_state *scsp, UINT32 clock)
 		else
 			fSDL=0.0;
 
-		scsp->LPANTABLE[i]=FIX((4.0f*LPAN*TL*fSDL));
-		scsp->RPANTABLE[i]=FIX((4.0f*RPAN*TL*fSDL));
+		LPANTABLE[i]=FIX((4.0f*LPAN*TL*fSDL));
+		RPANTABLE[i]=FIX((4.0f*RPAN*TL*fSDL));
 	}
 
-	scsp->ARTABLE[0]=scsp->DRTABLE[0]=0;    //Infinite time
-	scsp->ARTABLE[1]=scsp->DRTABLE[1]=0;    //Infinite time
+	ARTABLE[0]=DRTABLE[0]=0;    //Infinite time
+	ARTABLE[1]=DRTABLE[1]=0;    //Infinite time
 	for(i=2;i<64;++i)
 	{
 		double t,step,scale;
@@ -597,17 +579,46 @@ static void SCSP_Init(scsp_state *scsp, UINT32 clock)
 		{
 			step=(1023*1000.0) / (44100.0*t);
 			scale=(double) (1<<EG_SHIFT);
-			scsp->ARTABLE[i]=(int) (step*scale);
+			ARTABLE[i]=(int) (step*scale);
 		}
 		else
-			scsp->ARTABLE[i]=1024<<EG_SHIFT;
+			ARTABLE[i]=1024<<EG_SHIFT;
 
 		t=DRTimes[i];   //In ms
 		step=(1023*1000.0) / (44100.0*t);
 		scale=(double) (1<<EG_SHIFT);
-		scsp->DRTABLE[i]=(int) (step*scale);
+		DRTABLE[i]=(int) (step*scale);
 	}
 
+	LFO_Init();
+}
+
+static void SCSP_Init(scsp_state *scsp, UINT32 clock)
+{
+	int i;
+
+	SCSPDSP_Init(&scsp->DSP);
+
+	scsp->clock = clock;
+	scsp->rate = clock / 512;
+
+	//scsp->IrqTimA = scsp->IrqTimBC = scsp->IrqMidi = 0;
+	scsp->MidiR = scsp->MidiW = 0;
+	scsp->MidiOutR = scsp->MidiOutW = 0;
+
+	// get SCSP RAM
+	scsp->SCSPRAM_LENGTH = 0x80000;	// 512 KB
+	scsp->SCSPRAM = (unsigned char*)malloc(scsp->SCSPRAM_LENGTH);
+	scsp->DSP.SCSPRAM_LENGTH = scsp->SCSPRAM_LENGTH / 2;
+	scsp->DSP.SCSPRAM = (UINT16*)scsp->SCSPRAM;
+	//scsp->SCSPRAM += scsp->roffset;
+
+	//scsp->timerA = machine().scheduler().timer_alloc(timer_expired_delegate(FUNC(scsp_device::timerA_cb), this));
+	//scsp->timerB = machine().scheduler().timer_alloc(timer_expired_delegate(FUNC(scsp_device::timerB_cb), this));
+	//scsp->timerC = machine().scheduler().timer_alloc(timer_expired_delegate(FUNC(scsp_device::timerC_cb), this));
+
+	OSOnce_Run(&tablesInit, SCSP_InitTables);
+
 	// make sure all the slots are off
 	for(i=0;i<32;++i)
 	{
@@ -617,7 +628,6 @@ static void SCSP_Init(scsp_state *scsp, UINT32 clock)
 		scsp->Slots[i].EG.state=SCSP_RELEASE;
 	}
 
-	LFO_Init();
 	// no "pend"
 	scsp->udata.data[0x20/2] = 0;
 	//scsp->TimCnt[0] = 0xffff;
@@ -857,6 +867,7 @@ static void SCSP_w16(void* info, UINT16 addr, UINT16 val)
 		else if(addr<0xC00)
 		{
 			*((UINT16 *) (scsp->DSP.MPRO+(addr-0x800)/2))=val;
+			scsp->DSP.ProgDirty=1;
 
 			if(addr==0xBF0)
 			{
@@ -1095,7 +1106,7 @@ INLINE INT32 SCSP_UpdateSlot(scsp_state *scsp, SCSP_SLOT *slot)
 		if(slot->EG.state==SCSP_ATTACK)
 			sample=(sample*EG_Update(slot))>>SHIFT;
 		else
-			sample=(sample*scsp->EG_TABLE[EG_Update(slot)>>(SHIFT-10)])>>SHIFT;
+			sample=(sample*EG_TABLE[EG_Update(slot)>>(SHIFT-10)])>>SHIFT;
 	}
 
 	if(!STWINH(slot))
@@ -1103,12 +1114,12 @@ INLINE INT32 SCSP_UpdateSlot(scsp_state *scsp, SCSP_SLOT *slot)
 		if(!SDIR(slot))
 		{
 			unsigned short Enc=((TL(slot))<<0x0)|(0x7<<0xd);
-			*scsp->RBUFDST=(sample*scsp->LPANTABLE[Enc])>>(SHIFT+1);
+			*scsp->RBUFDST=(sample*LPANTABLE[Enc])>>(SHIFT+1);
 		}
 		else
 		{
 			unsigned short Enc=(0<<0x0)|(0x7<<0xd);
-			*scsp->RBUFDST=(sample*scsp->LPANTABLE[Enc])>>(SHIFT+1);
+			*scsp->RBUFDST=(sample*LPANTABLE[Enc])>>(SHIFT+1);
 		}
 	}
 
@@ -1155,12 +1166,12 @@ static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs
 				if (! BypassDSP)
 				{
 					Enc=((TL(slot))<<0x0)|((IMXL(slot))<<0xd);
-					SCSPDSP_SetSample(&scsp->DSP,(sample*scsp->LPANTABLE[Enc])>>(SHIFT-2),ISEL(slot),IMXL(slot));
+					SCSPDSP_SetSample(&scsp->DSP,(sample*LPANTABLE[Enc])>>(SHIFT-2),ISEL(slot),IMXL(slot));
 				}
 				Enc=((TL(slot))<<0x0)|((DIPAN(slot))<<0x8)|((DISDL(slot))<<0xd);
 				{
-					smpl+=(sample*scsp->LPANTABLE[Enc])>>SHIFT;
-					smpr+=(sample*scsp->RPANTABLE[Enc])>>SHIFT;
+					smpl+=(sample*LPANTABLE[Enc])>>SHIFT;
+					smpr+=(sample*RPANTABLE[Enc])>>SHIFT;
 				}
 			}
 
@@ -1185,8 +1196,8 @@ static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs
 				if(EFSDL(slot))
 				{
 					unsigned short Enc=((EFPAN(slot))<<0x8)|((EFSDL(slot))<<0xd);
-					smpl+=(scsp->DSP.EFREG[i]*scsp->LPANTABLE[Enc])>>SHIFT;
-					smpr+=(scsp->DSP.EFREG[i]*scsp->RPANTABLE[Enc])>>SHIFT;
+					smpl+=(scsp->DSP.EFREG[i]*LPANTABLE[Enc])>>SHIFT;
+					smpr+=(scsp->DSP.EFREG[i]*RPANTABLE[Enc])>>SHIFT;
 				}
 			}
 
@@ -1198,8 +1209,8 @@ static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs
 					UINT16 Enc;
 					scsp->DSP.EXTS[i] = 0; //scsp->exts[i][s];
 					Enc=((EFPAN(slot))<<0x8)|((EFSDL(slot))<<0xd);
-					smpl+=(scsp->DSP.EXTS[i]*scsp->LPANTABLE[Enc])>>SHIFT;
-					smpr+=(scsp->DSP.EXTS[i]*scsp->RPANTABLE[Enc])>>SHIFT;
+					smpl+=(scsp->DSP.EXTS[i]*LPANTABLE[Enc])>>SHIFT;
+					smpr+=(scsp->DSP.EXTS[i]*RPANTABLE[Enc])>>SHIFT;
 				}
 			}
 		}
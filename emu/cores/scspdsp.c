@@ -58,38 +58,35 @@ static INT32 UNPACK(UINT16 val)
 	return uval;
 }
 
+//INPUTS sources
+#define DSPIN_MEMS	0
+#define DSPIN_MIXS	1
+#define DSPIN_EXTS	2
+#define DSPIN_NONE	3	//invalid IRA, stops the program
+
+//B operand sources
+#define DSPB_TEMP	0
+#define DSPB_ACC	1
+#define DSPB_ZERO	2
+
 void SCSPDSP_Init(SCSPDSP *DSP)
 {
 	memset(DSP,0,sizeof(SCSPDSP));
 	DSP->RBL=(8*1024); // Initial RBL is 0
 	DSP->Stopped=1;
+	DSP->ProgDirty=1;
 }
 
-void SCSPDSP_Step(SCSPDSP *DSP)
+//split the MPRO words into their fields, so that SCSPDSP_Step doesn't have to do it for every sample
+static void SCSPDSP_Decode(SCSPDSP *DSP)
 {
-	INT32 ACC=0;    //26 bit
-	INT32 SHIFTED=0;    //24 bit
-	INT32 X=0;  //24 bit
-	INT32 Y=0;  //13 bit
-	INT32 B=0;  //26 bit
-	INT32 INPUTS=0; //24 bit
-	INT32 MEMVAL=0;
-	INT32 FRC_REG=0;    //13 bit
-	INT32 Y_REG=0;      //24 bit
-	UINT32 ADDR=0;
-	UINT32 ADRS_REG=0;  //13 bit
 	int step;
 
-	if(DSP->Stopped)
-		return;
-
-	memset(DSP->EFREG,0,2*16);
-	for(step=0;step</*128*/DSP->LastStep;++step)
+	DSP->AbortStep=128;
+	for(step=0;step<128;++step)
 	{
-		UINT16 *IPtr=DSP->MPRO+step*4;
-
-//		if(IPtr[0]==0 && IPtr[1]==0 && IPtr[2]==0 && IPtr[3]==0)
-//			break;
+		const UINT16 *IPtr=DSP->MPRO+step*4;
+		SCSPDSP_OP *op=&DSP->OPS[step];
 
 		UINT32 TRA   = (IPtr[0] >>  8) & 0x7F;
 		UINT32 TWT   = (IPtr[0] >>  7) & 0x01;
@@ -121,187 +118,227 @@ void SCSPDSP_Step(SCSPDSP *DSP)
 		UINT32 ADREB = (IPtr[3] >>  1) & 0x01;
 		UINT32 NXADR = (IPtr[3] >>  0) & 0x01;
 
-		INT64 v;
-
-		//operations are done at 24 bit precision
-#if 0
-		if(MASA)
-			int a=1;
-		if(NOFL)
-			int a=1;
-#endif
-		//INPUTS RW
 // colmns97 hits this
 //		assert(IRA<0x32);
 		if(IRA<=0x1f)
-			INPUTS=DSP->MEMS[IRA];
+		{
+			op->ISRC=DSPIN_MEMS;
+			op->IRA=IRA;
+		}
 		else if(IRA<=0x2F)
-			INPUTS=DSP->MIXS[IRA-0x20]<<4;  //MIXS is 20 bit
+		{
+			op->ISRC=DSPIN_MIXS;
+			op->IRA=IRA-0x20;
+		}
 		else if(IRA<=0x31)
-			INPUTS=DSP->EXTS[IRA-0x30]<<8;  //EXTS is 16 bit
+		{
+			op->ISRC=DSPIN_EXTS;
+			op->IRA=IRA-0x30;
+		}
+		else
+		{
+			op->ISRC=DSPIN_NONE;
+			op->IRA=0;
+			if(DSP->AbortStep>step)
+				DSP->AbortStep=step;
+		}
+		op->IWT=IWT;
+		if(IWT && IRA==IWA)
+			op->IWT|=0x02;
+		op->IWA=IWA;
+
+		op->TRA=TRA;
+		op->TWT=TWT;
+		op->TWA=TWA;
+		op->XSEL=XSEL;
+		op->YSEL=YSEL;
+		if(ZERO)
+			op->BSRC=DSPB_ZERO;
+		else if(BSEL)
+			op->BSRC=DSPB_ACC;
+		else
+			op->BSRC=DSPB_TEMP;
+		op->NEGB=ZERO ? 0 : NEGB;
+		op->SHIFT=SHIFT;
+		op->YRL=YRL;
+		op->FRCL=FRCL;
+		op->ADRL=ADRL;
+		op->EWT=EWT;
+		op->EWA=EWA;
+		op->COEF=COEF;
+
+		//memory only allowed on odd? DoA inserts NOPs on even
+		//The address calculation has no other effects, so even steps can skip it completely.
+		op->MRD=(step&1) ? MRD : 0;
+		op->MWT=(step&1) ? MWT : 0;
+		op->MEM=op->MRD | op->MWT;
+		op->TABLE=TABLE;
+		op->NOFL=NOFL;
+		op->MASA=MASA;
+		op->ADREB=ADREB;
+		op->NXADR=NXADR;
+	}
+	DSP->ProgDirty=0;
+}
+
+void SCSPDSP_Step(SCSPDSP *DSP)
+{
+	INT32 ACC=0;    //26 bit
+	INT32 SHIFTED=0;    //24 bit
+	INT32 X=0;  //24 bit
+	INT32 Y=0;  //13 bit
+	INT32 B=0;  //26 bit
+	INT32 INPUTS=0; //24 bit
+	INT32 MEMVAL=0;
+	INT32 FRC_REG=0;    //13 bit
+	INT32 Y_REG=0;      //24 bit
+	UINT32 ADDR=0;
+	UINT32 ADRS_REG=0;  //13 bit
+	int step;
+	int stepCnt;
+	const SCSPDSP_OP *op;
+
+	if(DSP->Stopped)
+		return;
+	if(DSP->ProgDirty)
+		SCSPDSP_Decode(DSP);
+
+	memset(DSP->EFREG,0,2*16);
+	stepCnt=(DSP->AbortStep<DSP->LastStep) ? DSP->AbortStep : DSP->LastStep;
+	for(step=0,op=DSP->OPS;step<stepCnt;++step,++op)
+	{
+		INT32 TEMPVAL;
+		INT64 v;
+
+		//operations are done at 24 bit precision
+		//INPUTS RW
+		if(op->ISRC==DSPIN_MEMS)
+			INPUTS=DSP->MEMS[op->IRA];
+		else if(op->ISRC==DSPIN_MIXS)
+			INPUTS=DSP->MIXS[op->IRA]<<4;  //MIXS is 20 bit
 		else
-			return;
+			INPUTS=DSP->EXTS[op->IRA]<<8;  //EXTS is 16 bit
 
 		INPUTS<<=8;
 		INPUTS>>=8;
-		//if(INPUTS&0x00800000)
-		//	INPUTS|=0xFF000000;
 
-		if(IWT)
+		if(op->IWT)
 		{
-			DSP->MEMS[IWA]=MEMVAL;  //MEMVAL was selected in previous MRD
-			if(IRA==IWA)
+			DSP->MEMS[op->IWA]=MEMVAL;  //MEMVAL was selected in previous MRD
+			if(op->IWT&0x02)
 				INPUTS=MEMVAL;
 		}
 
+		TEMPVAL=DSP->TEMP[(op->TRA+DSP->DEC)&0x7F];
+		TEMPVAL<<=8;
+		TEMPVAL>>=8;
+
 		//Operand sel
 		//B
-		if(!ZERO)
-		{
-			if(BSEL)
-				B=ACC;
-			else
-			{
-				B=DSP->TEMP[(TRA+DSP->DEC)&0x7F];
-				B<<=8;
-				B>>=8;
-				//if(B&0x00800000)
-				//	B|=0xFF000000;  //Sign extend
-			}
-			if(NEGB)
-				B=0-B;
-		}
+		if(op->BSRC==DSPB_TEMP)
+			B=TEMPVAL;
+		else if(op->BSRC==DSPB_ACC)
+			B=ACC;
 		else
 			B=0;
+		if(op->NEGB)
+			B=0-B;
 
 		//X
-		if(XSEL)
-			X=INPUTS;
-		else
-		{
-			X=DSP->TEMP[(TRA+DSP->DEC)&0x7F];
-			X<<=8;
-			X>>=8;
-			//if(X&0x00800000)
-			//	X|=0xFF000000;
-		}
+		X=op->XSEL ? INPUTS : TEMPVAL;
 
 		//Y
-		if(YSEL==0)
+		if(op->YSEL==0)
 			Y=FRC_REG;
-		else if(YSEL==1)
-			Y=DSP->COEF[COEF]>>3;   //COEF is 16 bits
-		else if(YSEL==2)
+		else if(op->YSEL==1)
+			Y=DSP->COEF[op->COEF]>>3;   //COEF is 16 bits
+		else if(op->YSEL==2)
 			Y=(Y_REG>>11)&0x1FFF;
-		else if(YSEL==3)
+		else
 			Y=(Y_REG>>4)&0x0FFF;
 
-		if(YRL)
+		if(op->YRL)
 			Y_REG=INPUTS;
 
 		//Shifter
-		if(SHIFT==0)
-		{
-			SHIFTED=ACC;
-			if(SHIFTED>0x007FFFFF)
-				SHIFTED=0x007FFFFF;
-			if(SHIFTED<(-0x00800000))
-				SHIFTED=-0x00800000;
-		}
-		else if(SHIFT==1)
+		if(op->SHIFT<2)
 		{
-			SHIFTED=ACC*2;
+			SHIFTED=op->SHIFT ? ACC*2 : ACC;
 			if(SHIFTED>0x007FFFFF)
 				SHIFTED=0x007FFFFF;
 			if(SHIFTED<(-0x00800000))
 				SHIFTED=-0x00800000;
 		}
-		else if(SHIFT==2)
-		{
-			SHIFTED=ACC*2;
-			SHIFTED<<=8;
-			SHIFTED>>=8;
-			//SHIFTED&=0x00FFFFFF;
-			//if(SHIFTED&0x00800000)
-			//	SHIFTED|=0xFF000000;
-		}
-		else if(SHIFT==3)
+		else
 		{
-			SHIFTED=ACC;
+			SHIFTED=(op->SHIFT==2) ? ACC*2 : ACC;
 			SHIFTED<<=8;
 			SHIFTED>>=8;
-			//SHIFTED&=0x00FFFFFF;
-			//if(SHIFTED&0x00800000)
-			//	SHIFTED|=0xFF000000;
 		}
 
 		//ACCUM
 		Y<<=19;
 		Y>>=19;
-		//if(Y&0x1000)
-		//	Y|=0xFFFFF000;
 
 		v=(((INT64) X*(INT64) Y)>>12);
 		ACC=(int) v+B;
 
-		if(TWT)
-			DSP->TEMP[(TWA+DSP->DEC)&0x7F]=SHIFTED;
+		if(op->TWT)
+			DSP->TEMP[(op->TWA+DSP->DEC)&0x7F]=SHIFTED;
 
-		if(FRCL)
+		if(op->FRCL)
 		{
-			if(SHIFT==3)
+			if(op->SHIFT==3)
 				FRC_REG=SHIFTED&0x0FFF;
 			else
 				FRC_REG=(SHIFTED>>11)&0x1FFF;
 		}
 
-		if(MRD || MWT)
-		//if(0)
+		if(op->MEM)
 		{
-			ADDR=DSP->MADRS[MASA];
-			if(!TABLE)
+			ADDR=DSP->MADRS[op->MASA];
+			if(!op->TABLE)
 				ADDR+=DSP->DEC;
-			if(ADREB)
+			if(op->ADREB)
 				ADDR+=ADRS_REG&0x0FFF;
-			if(NXADR)
+			if(op->NXADR)
 				ADDR++;
-			if(!TABLE)
+			if(!op->TABLE)
 				ADDR&=DSP->RBL-1;
 			else
 				ADDR&=0xFFFF;
-			//ADDR<<=1;
-			//ADDR+=DSP->RBP<<13;
-			//MEMVAL=DSP->SCSPRAM[ADDR>>1];
 			ADDR+=DSP->RBP<<12;
 			if (ADDR > 0x7ffff) ADDR = 0;
-			if(MRD && (step&1)) //memory only allowed on odd? DoA inserts NOPs on even
+			if(op->MRD)
 			{
-				if(NOFL)
+				if(op->NOFL)
 					MEMVAL=DSP->SCSPRAM[ADDR]<<8;
 				else
 					MEMVAL=UNPACK(DSP->SCSPRAM[ADDR]);
 			}
-			if(MWT && (step&1))
+			if(op->MWT)
 			{
-				if(NOFL)
+				if(op->NOFL)
 					DSP->SCSPRAM[ADDR]=SHIFTED>>8;
 				else
 					DSP->SCSPRAM[ADDR]=PACK(SHIFTED);
 			}
 		}
 
-		if(ADRL)
+		if(op->ADRL)
 		{
-			if(SHIFT==3)
+			if(op->SHIFT==3)
 				ADRS_REG=(SHIFTED>>12)&0xFFF;
 			else
 				ADRS_REG=(INPUTS>>16);
 		}
 
-		if(EWT)
-			DSP->EFREG[EWA]+=SHIFTED>>8;
+		if(op->EWT)
+			DSP->EFREG[op->EWA]+=SHIFTED>>8;
 
 	}
+	if(stepCnt<DSP->LastStep)
+		return;	//invalid IRA
 	--DSP->DEC;
 	memset(DSP->MIXS,0,4*16);
 }
@@ -326,5 +363,5 @@ void SCSPDSP_Start(SCSPDSP *DSP)
 			break;
 	}
 	DSP->LastStep=i+1;
-
+	SCSPDSP_Decode(DSP);
 }
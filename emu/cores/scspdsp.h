@@ -1,6 +1,37 @@
 #ifndef __SCSPDSP_H__
 #define __SCSPDSP_H__
 
+//a pre-decoded MPRO step
+typedef struct _SCSPDSP_OP
+{
+	UINT8 ISRC;     //INPUTS source (DSPIN_*)
+	UINT8 IRA;      //index into the INPUTS source
+	UINT8 IWT;      //bit 0 - write MEMS, bit 1 - INPUTS reads the MEMS register that is written
+	UINT8 IWA;
+	UINT8 TRA;
+	UINT8 TWT;
+	UINT8 TWA;
+	UINT8 XSEL;
+	UINT8 YSEL;
+	UINT8 BSRC;     //B operand source (DSPB_*)
+	UINT8 NEGB;
+	UINT8 SHIFT;
+	UINT8 YRL;
+	UINT8 FRCL;
+	UINT8 ADRL;
+	UINT8 EWT;
+	UINT8 EWA;
+	UINT8 COEF;
+	UINT8 MEM;      //memory is accessed in this step (MRD/MWT on odd steps only)
+	UINT8 MRD;
+	UINT8 MWT;
+	UINT8 TABLE;
+	UINT8 NOFL;
+	UINT8 MASA;
+	UINT8 ADREB;
+	UINT8 NXADR;
+} SCSPDSP_OP;
+
 //the DSP Context
 typedef struct _SCSPDSP
 {
@@ -28,6 +59,11 @@ typedef struct _SCSPDSP
 
 	int Stopped;
 	int LastStep;
+
+//decoded program
+	SCSPDSP_OP OPS[128];
+	int ProgDirty;  //MPRO was written, OPS need to be decoded again
+	int AbortStep;  //first step with an invalid IRA (stops the program)
 } SCSPDSP;
 
 void SCSPDSP_Init(SCSPDSP *DSP);
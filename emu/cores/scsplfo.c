@@ -44,13 +44,11 @@ static const float ASCALE[8]={0.0f,0.4f,0.8f,1.5f,3.0f,6.0f,12.0f,24.0f};
 static const float PSCALE[8]={0.0f,7.0f,13.5f,27.0f,55.0f,112.0f,230.0f,494.0f};
 static int PSCALES[8][256];
 static int ASCALES[8][256];
-static UINT8 IsInit;
 
+// called once from scsp.c, the tables are shared by all chips
 static void LFO_Init(void)
 {
 	int i,s;
-	if (IsInit)
-		return;
 	for(i=0;i<256;++i)
 	{
 		int a,p;
@@ -115,7 +113,6 @@ static void LFO_Init(void)
 			ASCALES[s][i]=DB(((limit*(float) i)/256.0));
 		}
 	}
-	IsInit = 0x01;
 }
 
 INLINE signed int PLFO_Step(SCSP_LFO_t *LFO)
@@ -26,11 +26,14 @@ static void sega_pcm_w(void *chip, UINT16 offset, UINT8 data);
 static UINT8 sega_pcm_r(void *chip, UINT16 offset);
 static void sega_pcm_alloc_rom(void *chip, UINT32 memsize);
 static void sega_pcm_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8* data);
+static void sega_pcm_ref_rom(void *chip, UINT32 memsize, const UINT8* data);
 #ifdef _DEBUG
 static void sega_pcm_fwrite_romusage(void *chip);
 #endif
 
 static void segapcm_set_mute_mask(void *chip, UINT32 MuteMask);
+static UINT32 segapcm_save_state(void *chip, UINT32 bufSize, void* buffer);
+static UINT8 segapcm_load_state(void *chip, UINT32 dataSize, const void* data);
 
 
 static DEVDEF_RWFUNC devFunc[] =
@@ -39,7 +42,10 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A16D8, 0, sega_pcm_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, sega_pcm_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, sega_pcm_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, sega_pcm_ref_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, segapcm_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, segapcm_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, segapcm_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -104,6 +110,7 @@ struct _segapcm_state
 	UINT8 low[16];
 	UINT32 ROMSize;
 	UINT8 *rom;
+	UINT8 romIsRef;	// rom points to external ROM data (must not be written or freed)
 #ifdef _DEBUG
 	UINT8 *romusage;
 #endif
@@ -212,6 +219,7 @@ static UINT8 device_start_segapcm(const SEGAPCM_CFG* cfg, DEV_INFO* retDevInf)
 	
 	spcm->ROMSize = 0;
 	spcm->rom = NULL;
+	spcm->romIsRef = 0;
 #ifdef _DEBUG
 	spcm->romusage = NULL;
 #endif
@@ -230,7 +238,9 @@ static UINT8 device_start_segapcm(const SEGAPCM_CFG* cfg, DEV_INFO* retDevInf)
 void device_stop_segapcm(void *chip)
 {
 	segapcm_state *spcm = (segapcm_state *)chip;
-	free(spcm->rom);	spcm->rom = NULL;
+	if (! spcm->romIsRef)
+		free(spcm->rom);
+	spcm->rom = NULL;
 #ifdef _DEBUG
 	//sega_pcm_fwrite_romusage(spcm);
 	free(spcm->romusage);
@@ -271,6 +281,11 @@ static void sega_pcm_alloc_rom(void *chip, UINT32 memsize)
 	if (spcm->ROMSize == memsize)
 		return;
 	
+	if (spcm->romIsRef)
+	{
+		spcm->rom = NULL;	// detach from the external ROM
+		spcm->romIsRef = 0;
+	}
 	spcm->rom = (UINT8*)realloc(spcm->rom, memsize);
 #ifndef _DEBUG
 	//memset(spcm->rom, 0xFF, memsize);
@@ -300,6 +315,14 @@ static void sega_pcm_write_rom(void *chip, UINT32 offset, UINT32 length, const U
 	if (offset + length > spcm->ROMSize)
 		length = spcm->ROMSize - offset;
 	
+	if (spcm->romIsRef)
+	{
+		// make a private copy of the external ROM before modifying it
+		UINT8* romCopy = (UINT8*)malloc(spcm->ROMSize);
+		memcpy(romCopy, spcm->rom, spcm->ROMSize);
+		spcm->rom = romCopy;
+		spcm->romIsRef = 0;
+	}
 	memcpy(&spcm->rom[offset], data, length);
 #ifdef _DEBUG
 	memset(&spcm->romusage[offset], 0x00, length);
@@ -308,6 +331,27 @@ static void sega_pcm_write_rom(void *chip, UINT32 offset, UINT32 length, const U
 	return;
 }
 
+static void sega_pcm_ref_rom(void *chip, UINT32 memsize, const UINT8* data)
+{
+	segapcm_state *spcm = (segapcm_state *)chip;
+	
+	if (! spcm->romIsRef)
+		free(spcm->rom);
+	if (data == NULL)
+		memsize = 0x00;
+	spcm->rom = (UINT8*)data;	// Note: The data is only read from while romIsRef is set.
+	spcm->ROMSize = memsize;
+	spcm->romIsRef = (data != NULL);
+#ifdef _DEBUG
+	spcm->romusage = (UINT8*)realloc(spcm->romusage, memsize);
+	memset(spcm->romusage, 0x00, memsize);
+#endif
+	
+	spcm->bankmask = spcm->intf_mask & (0x1fffff >> spcm->bankshift);
+	
+	return;
+}
+
 
 #ifdef _DEBUG
 static void sega_pcm_fwrite_romusage(void *chip)
@@ -336,3 +380,42 @@ static void segapcm_set_mute_mask(void *chip, UINT32 MuteMask)
 	
 	return;
 }
+
+// The state consists of the chip structure, followed by the 0x800 bytes of register RAM.
+static UINT32 segapcm_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	segapcm_state *spcm = (segapcm_state *)chip;
+	UINT32 stateSize = sizeof(segapcm_state) + 0x800;
+	
+	if (buffer != NULL && bufSize >= stateSize)
+	{
+		memcpy(buffer, spcm, sizeof(segapcm_state));
+		memcpy((UINT8*)buffer + sizeof(segapcm_state), spcm->ram, 0x800);
+	}
+	return stateSize;
+}
+
+static UINT8 segapcm_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	segapcm_state *spcm = (segapcm_state *)chip;
+	UINT8* ram = spcm->ram;
+	UINT8* rom = spcm->rom;
+	UINT32 romSize = spcm->ROMSize;
+	UINT8 romIsRef = spcm->romIsRef;
+#ifdef _DEBUG
+	UINT8* romusage = spcm->romusage;
+#endif
+	
+	if (dataSize != sizeof(segapcm_state) + 0x800)
+		return 0xFF;
+	memcpy(spcm, data, sizeof(segapcm_state));
+	spcm->ram = ram;
+	spcm->rom = rom;	// keep the current ROM
+	spcm->ROMSize = romSize;
+	spcm->romIsRef = romIsRef;
+#ifdef _DEBUG
+	spcm->romusage = romusage;
+#endif
+	memcpy(spcm->ram, (const UINT8*)data + sizeof(segapcm_state), 0x800);
+	return 0x00;
+}
@@ -39,6 +39,9 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, sn76496_w_maxim},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, sn76489_mute_maxim},
 	{RWF_CHN_PAN | RWF_WRITE, DEVRW_ALL, 0, sn76489_pan_maxim},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, sn76489_save_state_maxim},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, sn76489_load_state_maxim},
+	{RWF_SILENCE | RWF_READ, DEVRW_VALUE, 0, sn76489_is_silent_maxim},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_SN76489_Maxim =
@@ -438,3 +441,30 @@ static void sn76489_pan_maxim(SN76489_Context* chip, const INT16* PanVals)
 	SN76489_SetPanning(chip, PanVals[0x00], PanVals[0x01], PanVals[0x02], PanVals[0x03]);
 	return;
 }
+
+static UINT32 sn76489_save_state_maxim(SN76489_Context* chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(SN76489_Context), bufSize, buffer);
+}
+
+static UINT8 sn76489_load_state_maxim(SN76489_Context* chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(SN76489_Context))
+		return 0xFF;
+	memcpy(chip, data, sizeof(SN76489_Context));
+	return 0x00;
+}
+
+static UINT8 sn76489_is_silent_maxim(SN76489_Context* chip)
+{
+	/* volume 0xF outputs nothing, T6W28 mixes in the volumes of the other chip */
+	if ((chip->Registers[1] & chip->Registers[3] & chip->Registers[5] & chip->Registers[7]) != 0xF)
+		return 0;
+	if (chip->NgpFlags)
+	{
+		SN76489_Context* chip2 = chip->NgpChip2;
+		if ((chip2->Registers[1] & chip2->Registers[3] & chip2->Registers[5] & chip2->Registers[7]) != 0xF)
+			return 0;
+	}
+	return 1;
+}
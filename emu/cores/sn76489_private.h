@@ -89,5 +89,8 @@ static UINT8 device_start_sn76496_maxim(const SN76496_CFG* cfg, DEV_INFO* retDev
 static void sn76496_w_maxim(SN76489_Context* chip, UINT8 reg, UINT8 data);
 static void sn76489_mute_maxim(SN76489_Context* chip, UINT32 MuteMask);
 static void sn76489_pan_maxim(SN76489_Context* chip, const INT16* PanVals);
+static UINT32 sn76489_save_state_maxim(SN76489_Context* chip, UINT32 bufSize, void* buffer);
+static UINT8 sn76489_load_state_maxim(SN76489_Context* chip, UINT32 dataSize, const void* data);
+static UINT8 sn76489_is_silent_maxim(SN76489_Context* chip);
 
 #endif	// __SN76489_PRIVATE_H__
@@ -160,6 +160,9 @@ static void sn76496_reset(void *chip);
 static void sn76496_freq_limiter(void* chip, UINT32 sample_rate);
 static void sn76496_set_mute_mask(void *chip, UINT32 MuteMask);
 static void sn76496_set_log_cb(void *info, DEVCB_LOG func, void* param);
+static UINT32 sn76496_save_state(void *chip, UINT32 bufSize, void* buffer);
+static UINT8 sn76496_load_state(void *chip, UINT32 dataSize, const void* data);
+static UINT8 sn76496_is_silent(void *chip);
 
 static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevInf);
 static void sn76496_w_mame(void *chip, UINT8 reg, UINT8 data);
@@ -169,6 +172,9 @@ static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, sn76496_w_mame},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, sn76496_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, sn76496_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, sn76496_load_state},
+	{RWF_SILENCE | RWF_READ, DEVRW_VALUE, 0, sn76496_is_silent},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_SN76496_MAME =
@@ -632,6 +638,37 @@ static void sn76496_set_log_cb(void *chip, DEVCB_LOG func, void* param)
 	return;
 }
 
+static UINT32 sn76496_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(sn76496_state), bufSize, buffer);
+}
+
+static UINT8 sn76496_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(sn76496_state))
+		return 0xFF;
+	// Note: NgpChip2 and the logger are the same for the instance, so they can be copied as well.
+	memcpy(chip, data, sizeof(sn76496_state));
+	return 0x00;
+}
+
+// All output is scaled by the channel volumes, so the chip is silent when all of them are 0.
+// (T6W28: the channels also use the volumes of the other chip)
+static UINT8 sn76496_is_silent(void *chip)
+{
+	sn76496_state *R = (sn76496_state *)chip;
+	
+	if (R->volume[0] || R->volume[1] || R->volume[2] || R->volume[3])
+		return 0;
+	if (R->NgpFlags)
+	{
+		sn76496_state *R2 = R->NgpChip2;
+		if (R2->volume[0] || R2->volume[1] || R2->volume[2] || R2->volume[3])
+			return 0;
+	}
+	return 1;
+}
+
 static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevInf)
 {
 	sn76496_state* chip;
@@ -40,6 +40,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "ym2151.h"
 
 #ifdef _MSC_VER
@@ -54,6 +55,9 @@ static void ym2151_shutdown(void *_chip);
 static void ym2151_reset_chip(void *_chip);
 static void ym2151_update_one(void *chip, UINT32 length, DEV_SMPL **buffers);
 static void ym2151_set_mute_mask(void *chip, UINT32 MuteMask);
+static UINT32 ym2151_save_state(void *chip, UINT32 bufSize, void* buffer);
+static UINT8 ym2151_load_state(void *chip, UINT32 dataSize, const void* data);
+static UINT8 ym2151_is_silent(void *chip);
 static UINT8 device_start_ym2151(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 ym2151_r(void *chip, UINT8 offset);
 static void ym2151_w(void *chip, UINT8 offset, UINT8 data);
@@ -65,6 +69,9 @@ static DEVDEF_RWFUNC devFunc_MAME[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym2151_r},
 	{RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D8, 0, ym2151_write_reg},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2151_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, ym2151_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, ym2151_load_state},
+	{RWF_SILENCE | RWF_READ, DEVRW_VALUE, 0, ym2151_is_silent},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_YM2151_MAME =
@@ -527,17 +534,14 @@ static const UINT8 lfo_noise_waveform[256] = {
 
 
 
-static UINT8 tablesInit = 0;
+static OS_ONCE tablesInit = OS_ONCE_INIT;
 
+// called once, the tables are shared by all chips
 static void init_tables(void)
 {
 	signed int i,x,n;
 	double o,m;
 
-	if (tablesInit)
-		return;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		// note: this formula is broken in MAME 0.183
@@ -1233,7 +1237,7 @@ static void * ym2151_init(UINT32 clock, UINT32 rate)
 	PSG->irqhandler = NULL;
 	PSG->portwritehandler = NULL;
 
-	init_tables();
+	OSOnce_Run(&tablesInit, init_tables);
 	init_chip_tables(PSG);
 
 	PSG->tim_A      = 0;
@@ -2081,3 +2085,34 @@ static void ym2151_w(void *chip, UINT8 offset, UINT8 data)
 	else
 		PSG->lastreg = data;
 }
+
+static UINT32 ym2151_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(YM2151), bufSize, buffer);
+}
+
+static UINT8 ym2151_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(YM2151))
+		return 0xFF;
+	memcpy(chip, data, sizeof(YM2151));
+	return 0x00;
+}
+
+/*  The chip is silent when all operators are in EG_OFF (volume at MAX_ATT_INDEX, which
+*   also mutes the noise generator) and CSM mode can't key them on.
+*/
+static UINT8 ym2151_is_silent(void *chip)
+{
+	YM2151 *PSG = (YM2151 *)chip;
+	int i;
+
+	if ((PSG->irq_enable & 0x80) || PSG->csm_req)
+		return 0;
+	for (i = 0; i < 32; i++)
+	{
+		if (PSG->oper[i].state != EG_OFF)
+			return 0;
+	}
+	return 1;
+}
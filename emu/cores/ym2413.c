@@ -49,6 +49,7 @@ to do:
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "ym2413.h"
 
 #ifdef _MSC_VER
@@ -598,7 +599,7 @@ static unsigned char vrc7_instable[(16 + 3) * 8] =
 #define SLOT8_2 (&chip->P_CH[8].SLOT[SLOT2])
 
 
-static UINT8 tablesInit = 0;
+static OS_ONCE tablesInit = OS_ONCE_INIT;
 
 /* advance LFO to next sample */
 INLINE void advance_lfo(YM2413 *chip)
@@ -1115,17 +1116,13 @@ INLINE void rhythm_calc( YM2413 *chip, OPLL_CH *CH, unsigned int noise )
 }
 
 
-/* generic table initialize */
-static int init_tables(void)
+/* generic table initialize (called once, the tables are shared by all chips) */
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1180,7 +1177,7 @@ static int init_tables(void)
 			sin_tab[1*SIN_LEN+i] = sin_tab[i];
 	}
 
-	return 1;
+	return;
 }
 
 
@@ -1779,8 +1776,7 @@ static YM2413 *OPLLCreate(UINT32 clock, UINT32 rate)
 {
 	YM2413 *chip;
 
-	if( !init_tables() )
-		return NULL;
+	OSOnce_Run(&tablesInit, init_tables);
 
 	/* allocate memory block */
 	chip = (YM2413 *)calloc(1, sizeof(YM2413));
@@ -7,10 +7,13 @@
 void nukedopn2_write(void *chip, UINT8 port, UINT8 data);
 UINT8 nukedopn2_read(void *chip, UINT8 port);
 void nukedopn2_update(void *chip, UINT32 numsamples, DEV_SMPL **sndptr);
+void nukedopn2_update_soa(void *chip, UINT32 numsamples, DEV_SMPL **sndptr);	// ym3438_soa.c
 void nukedopn2_set_options(void *chip, UINT32 flags);
 void nukedopn2_set_mute_mask(void *chip, UINT32 mute);
 void* nukedopn2_init(UINT32 clock, UINT32 rate);
 void nukedopn2_shutdown(void *chip);
 void nukedopn2_reset_chip(void *chip);
+UINT32 nukedopn2_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 nukedopn2_load_state(void *chip, UINT32 dataSize, const void* data);
 
 #endif	// __YM3438_H__
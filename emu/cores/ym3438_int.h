@@ -235,6 +235,9 @@ Bit32u NOPN2_ReadTestPin(ym3438_t *chip);
 Bit32u NOPN2_ReadIRQPin(ym3438_t *chip);
 Bit8u NOPN2_Read(ym3438_t *chip, Bit32u port);
 
+// register write stage (shared with ym3438_soa.c)
+void NOPN2_DoRegWrite(ym3438_t *chip);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1474 @@
+// license:LGPL-2.1+
+// copyright-holders:Nuke.YKT
+/*
+ *  Nuked OPN2(Yamaha YM3438) emulator - structure-of-arrays sample engine.
+ *
+ *  This runs the exact same model as ym3438.c, but instead of calling every
+ *  pipeline stage once per internal cycle (24 cycles per output sample), it
+ *  unrolls the pipeline latches (EG rate/increment, TL/SL delay, PG fnum latch,
+ *  ...) into per-slot arrays and evaluates one stage for all slots of a sample
+ *  before moving on to the next stage.
+ *
+ *  Each slot passes through its stages in a fixed order (key on, phase increment,
+ *  SSG-EG, EG prepare @ cycle N; EG output @ N+1; ADSR @ N+2; phase mask @ N+4;
+ *  FM output and phase step @ N+5; channel accumulation @ N+6), so the only
+ *  things that need care are
+ *    - stages of slots 18-23 that wrap into the first cycles of the next sample
+ *      (done first, before the rest of the sample),
+ *    - the operator chain within a channel (done per operator, for all 6
+ *      channels at once) and
+ *    - globals that change within a sample (EG timer locks @ cycle 1, LFO @ cycle 0).
+ *  The chip state after every sample is identical to 24 NOPN2_Clock() calls.
+ *
+ *  The non-slot parts (IO, timers, key on, LFO) still run cycle by cycle while
+ *  bus writes are being latched. Without writes they are evaluated per sample.
+ *
+ *  Samples during which a slot/channel register (0x30-0xB6) gets written or a
+ *  test mode is active fall back to NOPN2_Clock(), so that register changes
+ *  still take effect at the exact cycle.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../stdtype.h"
+#include "../../common_def.h"
+#include "../snddef.h"
+#include "ym3438.h"
+#include "ym3438_int.h"
+#include "ym3438_tables.h"
+
+// superctr's MegaDrive model 1 filter
+#define FILTER_CUTOFF 0.512331301282628 // 5894Hz  single pole IIR low pass
+#define FILTER_CUTOFF_I (1-FILTER_CUTOFF)
+
+#define SIGN_EXTEND(bit_index, value) (((value) & ((1u << (bit_index)) - 1u)) - ((value) & (1u << (bit_index))))
+
+/* pipeline latches of one sample, one entry per slot (or per cycle) */
+typedef struct
+{
+    /* PG fnum latch, per slot */
+    Bit16u fnum[24];
+    Bit8u block[24];
+    Bit8u kcode[24];
+    /* EG prepare latches, per slot */
+    Bit8u rate[24];
+    Bit8u ksv[24];
+    Bit8u lfo_am[24];
+    Bit8u inc[24];
+    Bit8u ratemax[24];
+    /* mode registers as seen by each cycle */
+    Bit8u mode_csm[24];
+    Bit8u mode_ch3[24];
+    Bit8u dacen[24];
+    Bit16s dacdata[24];
+} opn2_soa_latch;
+
+/* channel whose output is locked at cycle 4*n, in output order */
+static const Bit8u out_channel[6] = { 1, 5, 3, 0, 4, 2 };
+
+static Bit32u NOPN2S_IsSlotAddress(Bit32u address)
+{
+    /* registers 0x30-0xB6 are latched per slot/channel by NOPN2_DoRegWrite */
+    address &= 0xff;
+    return address >= 0x30 && address < 0xb8;
+}
+
+/* Returns 1 if the pending FM register write would still change a register.
+   (NOPN2_DoRegWrite keeps rewriting the latched data until the next address write.) */
+static Bit32u NOPN2S_RegWritePending(const ym3438_t *chip)
+{
+    Bit32u i;
+    Bit32u slot;
+    Bit8u data = chip->data;
+    Bit8u multi;
+    Bit8u sl;
+
+    if (!chip->write_fm_data || !NOPN2S_IsSlotAddress(chip->address))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < 12; i++)
+    {
+        if (op_offset[i] != (chip->address & 0x107))
+        {
+            continue;
+        }
+        slot = i + ((chip->address & 0x08) ? 12 : 0);
+        switch (chip->address & 0xf0)
+        {
+        case 0x30: /* DT, MULTI */
+            multi = data & 0x0f;
+            multi = multi ? (multi << 1) : 1;
+            if (chip->multi[slot] != multi || chip->dt[slot] != ((data >> 4) & 0x07))
+            {
+                return 1;
+            }
+            break;
+        case 0x40: /* TL */
+            if (chip->tl[slot] != (data & 0x7f))
+            {
+                return 1;
+            }
+            break;
+        case 0x50: /* KS, AR */
+            if (chip->ar[slot] != (data & 0x1f) || chip->ks[slot] != ((data >> 6) & 0x03))
+            {
+                return 1;
+            }
+            break;
+        case 0x60: /* AM, DR */
+            if (chip->dr[slot] != (data & 0x1f) || chip->am[slot] != ((data >> 7) & 0x01))
+            {
+                return 1;
+            }
+            break;
+        case 0x70: /* SR */
+            if (chip->sr[slot] != (data & 0x1f))
+            {
+                return 1;
+            }
+            break;
+        case 0x80: /* SL, RR */
+            sl = (data >> 4) & 0x0f;
+            sl |= (sl + 1) & 0x10;
+            if (chip->rr[slot] != (data & 0x0f) || chip->sl[slot] != sl)
+            {
+                return 1;
+            }
+            break;
+        case 0x90: /* SSG-EG */
+            if (chip->ssg_eg[slot] != (data & 0x0f))
+            {
+                return 1;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (i = 0; i < 6; i++)
+    {
+        if (ch_offset[i] != (chip->address & 0x103))
+        {
+            continue;
+        }
+        switch (chip->address & 0xfc)
+        {
+        case 0xa0:
+            if (chip->fnum[i] != (data | ((chip->reg_a4 & 0x07) << 8))
+             || chip->block[i] != ((chip->reg_a4 >> 3) & 0x07))
+            {
+                return 1;
+            }
+            break;
+        case 0xa4:
+            if (chip->reg_a4 != data)
+            {
+                return 1;
+            }
+            break;
+        case 0xa8:
+            if (chip->fnum_3ch[i] != (data | ((chip->reg_ac & 0x07) << 8))
+             || chip->block_3ch[i] != ((chip->reg_ac >> 3) & 0x07))
+            {
+                return 1;
+            }
+            break;
+        case 0xac:
+            if (chip->reg_ac != data)
+            {
+                return 1;
+            }
+            break;
+        case 0xb0:
+            if (chip->connect[i] != (data & 0x07) || chip->fb[i] != ((data >> 3) & 0x07))
+            {
+                return 1;
+            }
+            break;
+        case 0xb4:
+            if (chip->pms[i] != (data & 0x07) || chip->ams[i] != ((data >> 4) & 0x03)
+             || chip->pan_l[i] != ((data >> 7) & 0x01) || chip->pan_r[i] != ((data >> 6) & 0x01))
+            {
+                return 1;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+/* Follows the address/data latches through one bus write.
+   Returns 0 if the write can't be handled by the batched path. */
+static Bit32u NOPN2S_CheckWrite(Bit16u *address, Bit16u *mode_a, Bit8u *fm_address,
+                                Bit32u is_data, Bit16u data)
+{
+    if (!is_data)
+    {
+        if ((data & 0xf0) != 0x00)
+        {
+            *address = data;
+            *fm_address = 1;
+        }
+        else
+        {
+            *fm_address = 0;
+        }
+        *mode_a = data & 0x1ff;
+        return 1;
+    }
+
+    /* slot/channel registers have to be written at their exact cycle */
+    if (*fm_address && NOPN2S_IsSlotAddress(*address))
+    {
+        return 0;
+    }
+    /* LSI test registers */
+    if ((data & 0x100) == 0 && (*mode_a == 0x21 || *mode_a == 0x2c))
+    {
+        return 0;
+    }
+    return 1;
+}
+
+/* Returns 1 if the next sample can be generated by NOPN2S_ClockSample. */
+static Bit32u NOPN2S_CanBatch(const ym3438_t *chip)
+{
+    Bit16u address = chip->address;
+    Bit16u mode_a = chip->write_fm_mode_a;
+    Bit8u fm_address = chip->write_fm_address;
+    Bit64u lasttime;
+    Bit32u cur;
+    Bit32u i;
+    const opn2_writebuf *wb;
+
+    if (chip->cycles != 0)
+    {
+        return 0;
+    }
+    if (chip->mode_test_21[1] | chip->mode_test_21[2] | chip->mode_test_21[3]
+      | chip->mode_test_21[4] | chip->mode_test_21[5]
+      | chip->mode_test_2c[5] | chip->mode_test_2c[6] | chip->mode_test_2c[7])
+    {
+        return 0;
+    }
+    if (NOPN2S_RegWritePending(chip))
+    {
+        return 0;
+    }
+
+    /* write sent right before this sample */
+    if ((chip->write_a & 0x01) && (chip->write_d & 0x01))
+    {
+        return 0;
+    }
+    if ((chip->write_a | chip->write_d) & 0x01)
+    {
+        if (!NOPN2S_CheckWrite(&address, &mode_a, &fm_address, chip->write_d & 0x01, chip->write_data))
+        {
+            return 0;
+        }
+    }
+    /* writes sent during this sample */
+    lasttime = chip->writebuf_samplecnt + 23;
+    cur = chip->writebuf_cur;
+    for (i = 0; i < NOPN_WRITEBUF_SIZE; i++)
+    {
+        wb = &chip->writebuf[cur];
+        if (!(wb->port & 0x04) || wb->time > lasttime)
+        {
+            break;
+        }
+        if (!NOPN2S_CheckWrite(&address, &mode_a, &fm_address, wb->port & 0x01,
+                               (((wb->port & 0x03) << 7) & 0x100) | wb->data))
+        {
+            return 0;
+        }
+        cur = (cur + 1) % NOPN_WRITEBUF_SIZE;
+    }
+    return 1;
+}
+
+static void NOPN2S_FlushWriteBuf(ym3438_t *chip)
+{
+    while (chip->writebuf[chip->writebuf_cur].time <= chip->writebuf_samplecnt)
+    {
+        if (!(chip->writebuf[chip->writebuf_cur].port & 0x04))
+        {
+            break;
+        }
+        chip->writebuf[chip->writebuf_cur].port &= 0x03;
+        NOPN2_Write(chip, chip->writebuf[chip->writebuf_cur].port,
+                      chip->writebuf[chip->writebuf_cur].data);
+        chip->writebuf_cur = (chip->writebuf_cur + 1) % NOPN_WRITEBUF_SIZE;
+    }
+    chip->writebuf_samplecnt++;
+}
+
+/* The stages below are copies of their ym3438.c counterparts, minus the LSI test modes
+   (NOPN2S_CanBatch excludes them), so that they can be inlined into the cycle loop. */
+INLINE void NOPN2S_DoIO(ym3438_t *chip)
+{
+    /* Write signal check */
+    chip->write_a_en = (chip->write_a & 0x03) == 0x01;
+    chip->write_d_en = (chip->write_d & 0x03) == 0x01;
+    chip->write_a <<= 1;
+    chip->write_d <<= 1;
+    /* Busy counter */
+    chip->busy = chip->write_busy;
+    chip->write_busy_cnt += chip->write_busy;
+    chip->write_busy = (chip->write_busy && !(chip->write_busy_cnt >> 5)) || chip->write_d_en;
+    chip->write_busy_cnt &= 0x1f;
+}
+
+INLINE void NOPN2S_DoTimerA(ym3438_t *chip, Bit32u cycle)
+{
+    Bit16u time;
+    Bit8u load;
+    load = chip->timer_a_overflow;
+    if (cycle == 2)
+    {
+        /* Lock load value */
+        load |= (!chip->timer_a_load_lock && chip->timer_a_load);
+        chip->timer_a_load_lock = chip->timer_a_load;
+        /* CSM KeyOn */
+        chip->mode_kon_csm = chip->mode_csm ? load : 0;
+    }
+    /* Load counter */
+    time = chip->timer_a_load_latch ? chip->timer_a_reg : chip->timer_a_cnt;
+    chip->timer_a_load_latch = load;
+    /* Increase counter */
+    if (cycle == 1 && chip->timer_a_load_lock)
+    {
+        time++;
+    }
+    /* Set overflow flag */
+    if (chip->timer_a_reset)
+    {
+        chip->timer_a_reset = 0;
+        chip->timer_a_overflow_flag = 0;
+    }
+    else
+    {
+        chip->timer_a_overflow_flag |= chip->timer_a_overflow & chip->timer_a_enable;
+    }
+    chip->timer_a_overflow = (time >> 10);
+    chip->timer_a_cnt = time & 0x3ff;
+}
+
+INLINE void NOPN2S_DoTimerB(ym3438_t *chip, Bit32u cycle)
+{
+    Bit16u time;
+    Bit8u load;
+    load = chip->timer_b_overflow;
+    if (cycle == 2)
+    {
+        /* Lock load value */
+        load |= (!chip->timer_b_load_lock && chip->timer_b_load);
+        chip->timer_b_load_lock = chip->timer_b_load;
+    }
+    /* Load counter */
+    time = chip->timer_b_load_latch ? chip->timer_b_reg : chip->timer_b_cnt;
+    chip->timer_b_load_latch = load;
+    /* Increase counter */
+    if (cycle == 1)
+    {
+        chip->timer_b_subcnt++;
+    }
+    if (chip->timer_b_subcnt == 0x10 && chip->timer_b_load_lock)
+    {
+        time++;
+    }
+    chip->timer_b_subcnt &= 0x0f;
+    /* Set overflow flag */
+    if (chip->timer_b_reset)
+    {
+        chip->timer_b_reset = 0;
+        chip->timer_b_overflow_flag = 0;
+    }
+    else
+    {
+        chip->timer_b_overflow_flag |= chip->timer_b_overflow & chip->timer_b_enable;
+    }
+    chip->timer_b_overflow = (time >> 8);
+    chip->timer_b_cnt = time & 0xff;
+}
+
+INLINE void NOPN2S_KeyOn(ym3438_t *chip, Bit32u cycle)
+{
+    Bit32u chan = cycle % 6;
+    /* Key On */
+    chip->eg_kon_latch[cycle] = chip->mode_kon[cycle];
+    chip->eg_kon_csm[cycle] = 0;
+    if (chan == 2 && chip->mode_kon_csm)
+    {
+        /* CSM Key On */
+        chip->eg_kon_latch[cycle] = 1;
+        chip->eg_kon_csm[cycle] = 1;
+    }
+    if (cycle == chip->mode_kon_channel)
+    {
+        chip->mode_kon[chan] = chip->mode_kon_operator[0];
+        chip->mode_kon[chan + 12] = chip->mode_kon_operator[1];
+        chip->mode_kon[chan + 6] = chip->mode_kon_operator[2];
+        chip->mode_kon[chan + 18] = chip->mode_kon_operator[3];
+    }
+}
+
+INLINE void NOPN2S_UpdateLFO(ym3438_t *chip)
+{
+    if ((chip->lfo_quotient & lfo_cycles[chip->lfo_freq]) == lfo_cycles[chip->lfo_freq])
+    {
+        chip->lfo_quotient = 0;
+        chip->lfo_cnt++;
+    }
+    else
+    {
+        chip->lfo_quotient += chip->lfo_inc;
+    }
+    chip->lfo_cnt &= chip->lfo_en;
+}
+
+INLINE void NOPN2S_EnvelopeTimer(ym3438_t *chip, Bit32u cycle)
+{
+    chip->eg_cycle++;
+    /* Lock envelope generator timer value */
+    if (cycle == 1 && chip->eg_quotient == 2)
+    {
+        if (chip->eg_cycle_stop)
+        {
+            chip->eg_shift_lock = 0;
+        }
+        else
+        {
+            chip->eg_shift_lock = chip->eg_shift + 1;
+        }
+        chip->eg_timer_low_lock = chip->eg_timer & 0x03;
+    }
+    if (cycle == 1)
+    {
+        chip->eg_quotient++;
+        chip->eg_quotient %= 3;
+        chip->eg_cycle = 0;
+        chip->eg_cycle_stop = 1;
+        chip->eg_shift = 0;
+        chip->eg_timer_inc |= chip->eg_quotient >> 1;
+        chip->eg_timer = chip->eg_timer + chip->eg_timer_inc;
+        chip->eg_timer_inc = chip->eg_timer >> 12;
+        chip->eg_timer &= 0xfff;
+    }
+    else if (cycle == 13)
+    {
+        chip->eg_cycle = 0;
+        chip->eg_cycle_stop = 1;
+        chip->eg_shift = 0;
+        chip->eg_timer = chip->eg_timer + chip->eg_timer_inc;
+        chip->eg_timer_inc = chip->eg_timer >> 12;
+        chip->eg_timer &= 0xfff;
+    }
+    if ((chip->eg_timer >> chip->eg_cycle) & chip->eg_cycle_stop)
+    {
+        chip->eg_shift = chip->eg_cycle;
+        chip->eg_cycle_stop = 0;
+    }
+}
+
+/* LFO output latch of cycle 0 */
+INLINE void NOPN2S_LFOOutput(ym3438_t *chip)
+{
+    chip->lfo_pm = chip->lfo_cnt >> 2;
+    if (chip->lfo_cnt & 0x40)
+    {
+        chip->lfo_am = chip->lfo_cnt & 0x3f;
+    }
+    else
+    {
+        chip->lfo_am = chip->lfo_cnt ^ 0x3f;
+    }
+    chip->lfo_am <<= 1;
+}
+
+/* Returns 1 if no bus write gets latched during the next sample. */
+static Bit32u NOPN2S_BusIdle(const ym3438_t *chip)
+{
+    const opn2_writebuf *wb = &chip->writebuf[chip->writebuf_cur];
+
+    if ((chip->write_a | chip->write_d) & 0x01)
+    {
+        return 0;
+    }
+    return !(wb->port & 0x04) || wb->time > chip->writebuf_samplecnt + 23;
+}
+
+/* cycle-exact bus/timer/key on/LFO pass, for samples that have register writes */
+static void NOPN2S_ClockBus(ym3438_t *chip, opn2_soa_latch *lt)
+{
+    Bit32u c;
+
+    for (c = 0; c < 24; c++)
+    {
+        chip->cycles = c;
+        chip->channel = c % 6;
+        chip->lfo_inc = (c == 23);
+        NOPN2S_EnvelopeTimer(chip, c);
+        if (c == 0)
+        {
+            NOPN2S_LFOOutput(chip);
+        }
+
+        lt->mode_csm[c] = chip->mode_csm;
+        lt->mode_ch3[c] = chip->mode_ch3;
+        lt->dacen[c] = chip->dacen;
+        lt->dacdata[c] = chip->dacdata;
+
+        NOPN2S_DoIO(chip);
+        NOPN2S_DoTimerA(chip, c);
+        NOPN2S_DoTimerB(chip, c);
+        NOPN2S_KeyOn(chip, c);
+        NOPN2S_UpdateLFO(chip);
+        if (chip->write_a_en || chip->write_d_en)
+        {
+            NOPN2_DoRegWrite(chip);
+        }
+        else if (chip->write_fm_data)
+        {
+            /* slot/channel rewrites are no-ops here (see NOPN2S_CanBatch) */
+            chip->data = chip->write_data & 0xff;
+        }
+
+        if (chip->status_time)
+            chip->status_time--;
+        if ((chip->writebuf[chip->writebuf_cur].port & 0x04)
+         && chip->writebuf[chip->writebuf_cur].time <= chip->writebuf_samplecnt)
+        {
+            NOPN2S_FlushWriteBuf(chip);
+        }
+        else
+        {
+            chip->writebuf_samplecnt++;
+        }
+    }
+}
+
+/* Same as NOPN2S_ClockBus, for samples without register writes.
+   The mode registers can't change, so every part can run on its own. */
+static void NOPN2S_ClockBusIdle(ym3438_t *chip, opn2_soa_latch *lt)
+{
+    Bit32u c;
+    Bit8u lfo_cycle;
+
+    for (c = 0; c < 24; c++)
+    {
+        NOPN2S_EnvelopeTimer(chip, c);
+        lt->mode_csm[c] = chip->mode_csm;
+        lt->mode_ch3[c] = chip->mode_ch3;
+        lt->dacen[c] = chip->dacen;
+        lt->dacdata[c] = chip->dacdata;
+    }
+
+    /* IO: only the busy counter runs */
+    chip->write_a_en = 0;
+    chip->write_d_en = 0;
+    chip->write_a = 0;
+    chip->write_d = 0;
+    for (c = 0; c < 24; c++)
+    {
+        chip->busy = chip->write_busy;
+        if (!chip->write_busy)
+        {
+            break;
+        }
+        chip->write_busy_cnt++;
+        chip->write_busy = !(chip->write_busy_cnt >> 5);
+        chip->write_busy_cnt &= 0x1f;
+    }
+
+    /* Timers */
+    if (!chip->timer_a_load_lock && !chip->timer_a_load && !chip->timer_a_overflow
+     && !chip->timer_a_load_latch && !chip->timer_a_reset)
+    {
+        /* stopped */
+        chip->mode_kon_csm = 0;
+    }
+    else
+    {
+        for (c = 0; c < 24; c++)
+        {
+            NOPN2S_DoTimerA(chip, c);
+        }
+    }
+    if (!chip->timer_b_load_lock && !chip->timer_b_load && !chip->timer_b_overflow
+     && !chip->timer_b_load_latch && !chip->timer_b_reset)
+    {
+        /* stopped */
+        chip->timer_b_subcnt = (chip->timer_b_subcnt + 1) & 0x0f;
+    }
+    else
+    {
+        for (c = 0; c < 24; c++)
+        {
+            NOPN2S_DoTimerB(chip, c);
+        }
+    }
+
+    for (c = 0; c < 24; c++)
+    {
+        NOPN2S_KeyOn(chip, c);
+    }
+
+    /* LFO: the quotient can only wrap once at cycle 0 and counts at cycle 23 */
+    NOPN2S_LFOOutput(chip);
+    lfo_cycle = lfo_cycles[chip->lfo_freq];
+    if ((chip->lfo_quotient & lfo_cycle) == lfo_cycle)
+    {
+        chip->lfo_quotient = 0;
+        chip->lfo_cnt++;
+    }
+    chip->lfo_cnt &= chip->lfo_en;
+    chip->lfo_inc = 1;
+    chip->lfo_quotient++;
+
+    if (chip->write_fm_data)
+    {
+        chip->data = chip->write_data & 0xff;
+    }
+    chip->status_time = (chip->status_time > 24) ? (chip->status_time - 24) : 0;
+    chip->writebuf_samplecnt += 24;
+}
+
+/* EG increment, as calculated by NOPN2_EnvelopePrepare one cycle after the rate was latched */
+INLINE Bit8u NOPN2S_EnvelopeIncrement(const ym3438_t *chip, Bit8u eg_rate, Bit8u eg_ksv, Bit8u *ratemax)
+{
+    Bit8u rate;
+    Bit8u sum;
+    Bit8u inc = 0;
+
+    rate = (eg_rate << 1) + eg_ksv;
+
+    if (rate > 0x3f)
+    {
+        rate = 0x3f;
+    }
+
+    sum = ((rate >> 2) + chip->eg_shift_lock) & 0x0f;
+    if (eg_rate != 0 && chip->eg_quotient == 2)
+    {
+        if (rate < 48)
+        {
+            switch (sum)
+            {
+            case 12:
+                inc = 1;
+                break;
+            case 13:
+                inc = (rate >> 1) & 0x01;
+                break;
+            case 14:
+                inc = rate & 0x01;
+                break;
+            default:
+                break;
+            }
+        }
+        else
+        {
+            inc = eg_stephi[rate & 0x03][chip->eg_timer_low_lock] + (rate >> 2) - 11;
+            if (inc > 4)
+            {
+                inc = 4;
+            }
+        }
+    }
+    *ratemax = (rate >> 1) == 0x1f;
+    return inc;
+}
+
+INLINE void NOPN2S_EnvelopeSSGEG(ym3438_t *chip, Bit32u slot)
+{
+    Bit8u direction = 0;
+    chip->eg_ssg_pgrst_latch[slot] = 0;
+    chip->eg_ssg_repeat_latch[slot] = 0;
+    chip->eg_ssg_hold_up_latch[slot] = 0;
+    if (chip->ssg_eg[slot] & 0x08)
+    {
+        direction = chip->eg_ssg_dir[slot];
+        if (chip->eg_level[slot] & 0x200)
+        {
+            /* Reset */
+            if ((chip->ssg_eg[slot] & 0x03) == 0x00)
+            {
+                chip->eg_ssg_pgrst_latch[slot] = 1;
+            }
+            /* Repeat */
+            if ((chip->ssg_eg[slot] & 0x01) == 0x00)
+            {
+                chip->eg_ssg_repeat_latch[slot] = 1;
+            }
+            /* Inverse */
+            if ((chip->ssg_eg[slot] & 0x03) == 0x02)
+            {
+                direction ^= 1;
+            }
+            if ((chip->ssg_eg[slot] & 0x03) == 0x03)
+            {
+                direction = 1;
+            }
+        }
+        /* Hold up */
+        if (chip->eg_kon_latch[slot]
+         && ((chip->ssg_eg[slot] & 0x07) == 0x05 || (chip->ssg_eg[slot] & 0x07) == 0x03))
+        {
+            chip->eg_ssg_hold_up_latch[slot] = 1;
+        }
+        direction &= chip->eg_kon[slot];
+    }
+    chip->eg_ssg_dir[slot] = direction;
+    chip->eg_ssg_enable[slot] = (chip->ssg_eg[slot] >> 3) & 0x01;
+    chip->eg_ssg_inv[slot] = (chip->eg_ssg_dir[slot] ^ (((chip->ssg_eg[slot] >> 2) & 0x01) & ((chip->ssg_eg[slot] >> 3) & 0x01)))
+                           & chip->eg_kon[slot];
+}
+
+INLINE void NOPN2S_EnvelopeADSR(ym3438_t *chip, Bit32u slot, Bit8u eg_inc, Bit8u eg_ratemax,
+                                Bit8u eg_sl, Bit8u eg_tl)
+{
+    Bit8u nkon = chip->eg_kon_latch[slot];
+    Bit8u okon = chip->eg_kon[slot];
+    Bit8u kon_event;
+    Bit8u koff_event;
+    Bit8u eg_off;
+    Bit16s level;
+    Bit16s nextlevel = 0;
+    Bit16s ssg_level;
+    Bit8u nextstate = chip->eg_state[slot];
+    Bit16s inc = 0;
+
+    /* Reset phase generator */
+    chip->pg_reset[slot] = (nkon && !okon) || chip->eg_ssg_pgrst_latch[slot];
+
+    /* KeyOn/Off */
+    kon_event = (nkon && !okon) || (okon && chip->eg_ssg_repeat_latch[slot]);
+    koff_event = okon && !nkon;
+
+    ssg_level = level = (Bit16s)chip->eg_level[slot];
+
+    if (chip->eg_ssg_inv[slot])
+    {
+        /* Inverse */
+        ssg_level = 512 - level;
+        ssg_level &= 0x3ff;
+    }
+    if (koff_event)
+    {
+        level = ssg_level;
+    }
+    if (chip->eg_ssg_enable[slot])
+    {
+        eg_off = level >> 9;
+    }
+    else
+    {
+        eg_off = (level & 0x3f0) == 0x3f0;
+    }
+    nextlevel = level;
+    if (kon_event)
+    {
+        nextstate = eg_num_attack;
+        /* Instant attack */
+        if (eg_ratemax)
+        {
+            nextlevel = 0;
+        }
+        else if (chip->eg_state[slot] == eg_num_attack && level != 0 && eg_inc && nkon)
+        {
+            inc = (~level << eg_inc) >> 5;
+        }
+    }
+    else
+    {
+        switch (chip->eg_state[slot])
+        {
+        case eg_num_attack:
+            if (level == 0)
+            {
+                nextstate = eg_num_decay;
+            }
+            else if(eg_inc && !eg_ratemax && nkon)
+            {
+                inc = (~level << eg_inc) >> 5;
+            }
+            break;
+        case eg_num_decay:
+            if ((level >> 4) == (eg_sl << 1))
+            {
+                nextstate = eg_num_sustain;
+            }
+            else if (!eg_off && eg_inc)
+            {
+                inc = 1 << (eg_inc - 1);
+                if (chip->eg_ssg_enable[slot])
+                {
+                    inc <<= 2;
+                }
+            }
+            break;
+        case eg_num_sustain:
+        case eg_num_release:
+            if (!eg_off && eg_inc)
+            {
+                inc = 1 << (eg_inc - 1);
+                if (chip->eg_ssg_enable[slot])
+                {
+                    inc <<= 2;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+        if (!nkon)
+        {
+            nextstate = eg_num_release;
+        }
+    }
+    if (chip->eg_kon_csm[slot])
+    {
+        nextlevel |= eg_tl << 3;
+    }
+
+    /* Envelope off */
+    if (!kon_event && !chip->eg_ssg_hold_up_latch[slot] && chip->eg_state[slot] != eg_num_attack && eg_off)
+    {
+        nextstate = eg_num_release;
+        nextlevel = 0x3ff;
+    }
+
+    nextlevel += inc;
+
+    chip->eg_kon[slot] = chip->eg_kon_latch[slot];
+    chip->eg_level[slot] = (Bit16u)nextlevel & 0x3ff;
+    chip->eg_state[slot] = nextstate;
+}
+
+INLINE void NOPN2S_EnvelopeGenerate(ym3438_t *chip, Bit32u slot, Bit8u eg_lfo_am, Bit8u eg_tl, Bit8u csm)
+{
+    Bit16u level;
+
+    level = chip->eg_level[slot];
+
+    if (chip->eg_ssg_inv[slot])
+    {
+        /* Inverse */
+        level = 512 - level;
+    }
+    level &= 0x3ff;
+
+    /* Apply AM LFO */
+    level += eg_lfo_am;
+
+    /* Apply TL */
+    if (!csm)
+    {
+        level += eg_tl << 3;
+    }
+    if (level > 0x3ff)
+    {
+        level = 0x3ff;
+    }
+    chip->eg_out[slot] = level;
+}
+
+/* LFO modulated base frequency, the same for all slots that latched the same fnum/block */
+INLINE Bit32u NOPN2S_PhaseBaseFreq(const ym3438_t *chip, Bit32u chan, Bit32u fnum, Bit8u pg_block)
+{
+    Bit32u fnum_h = fnum >> 4;
+    Bit32u fm;
+    Bit8u lfo = chip->lfo_pm;
+    Bit8u lfo_l = lfo & 0x0f;
+    Bit8u pms = chip->pms[chan];
+
+    fnum <<= 1;
+    /* Apply LFO */
+    if (lfo_l & 0x08)
+    {
+        lfo_l ^= 0x0f;
+    }
+    fm = (fnum_h >> pg_lfo_sh1[pms][lfo_l]) + (fnum_h >> pg_lfo_sh2[pms][lfo_l]);
+    if (pms > 5)
+    {
+        fm <<= pms - 5;
+    }
+    fm >>= 2;
+    if (lfo & 0x10)
+    {
+        fnum -= fm;
+    }
+    else
+    {
+        fnum += fm;
+    }
+    fnum &= 0xfff;
+
+    return (fnum << pg_block) >> 2;
+}
+
+INLINE void NOPN2S_PhaseCalcIncrement(ym3438_t *chip, Bit32u slot, Bit32u basefreq, Bit8u kcode)
+{
+    Bit8u dt = chip->dt[slot];
+    Bit8u dt_l = dt & 0x03;
+    Bit8u detune = 0;
+    Bit8u block, note;
+    Bit8u sum, sum_h, sum_l;
+
+    /* Apply detune */
+    if (dt_l)
+    {
+        if (kcode > 0x1c)
+        {
+            kcode = 0x1c;
+        }
+        block = kcode >> 2;
+        note = kcode & 0x03;
+        sum = block + 9 + ((dt_l == 3) | (dt_l & 0x02));
+        sum_h = sum >> 1;
+        sum_l = sum & 0x01;
+        detune = pg_detune[(sum_l << 2) | note] >> (9 - sum_h);
+    }
+    if (dt & 0x04)
+    {
+        basefreq -= detune;
+    }
+    else
+    {
+        basefreq += detune;
+    }
+    basefreq &= 0x1ffff;
+    chip->pg_inc[slot] = (basefreq * chip->multi[slot]) >> 1;
+    chip->pg_inc[slot] &= 0xfffff;
+}
+
+/* FM output of one slot, followed by its phase step (same cycle, phase is read first) */
+INLINE void NOPN2S_FMGenerate(ym3438_t *chip, Bit32u slot)
+{
+    /* Calculate phase */
+    Bit16u phase = (chip->fm_mod[slot] + (chip->pg_phase[slot] >> 10)) & 0x3ff;
+    Bit16u quarter;
+    Bit16u level;
+    Bit16s output;
+    if (phase & 0x100)
+    {
+        quarter = (phase ^ 0xff) & 0xff;
+    }
+    else
+    {
+        quarter = phase & 0xff;
+    }
+    level = logsinrom[quarter];
+    /* Apply envelope */
+    level += chip->eg_out[slot] << 2;
+    /* Transform */
+    if (level > 0x1fff)
+    {
+        level = 0x1fff;
+    }
+    output = ((exprom[(level & 0xff) ^ 0xff] | 0x400) << 2) >> (level >> 8);
+    if (phase & 0x200)
+    {
+        output = (~output) + 1;
+    }
+    output = SIGN_EXTEND(13, output);
+    chip->fm_out[slot] = output;
+
+    /* Phase step */
+    if (chip->pg_reset[slot])
+    {
+        chip->pg_phase[slot] = 0;
+    }
+    chip->pg_phase[slot] += chip->pg_inc[slot];
+    chip->pg_phase[slot] &= 0xfffff;
+}
+
+/* modulation input of [slot], prevslot = slot - 12 */
+INLINE void NOPN2S_FMPrepare(ym3438_t *chip, Bit32u channel, Bit32u slot)
+{
+    Bit16s mod, mod1, mod2;
+    Bit32u op = slot / 6;
+    Bit8u connect = chip->connect[channel];
+    Bit32u prevslot = (slot + 12) % 24;
+
+    /* Calculate modulation */
+    mod1 = mod2 = 0;
+
+    if (fm_algorithm[op][0][connect])
+    {
+        mod2 |= chip->fm_op1[channel][0];
+    }
+    if (fm_algorithm[op][1][connect])
+    {
+        mod1 |= chip->fm_op1[channel][1];
+    }
+    if (fm_algorithm[op][2][connect])
+    {
+        mod1 |= chip->fm_op2[channel];
+    }
+    if (fm_algorithm[op][3][connect])
+    {
+        mod2 |= chip->fm_out[prevslot];
+    }
+    if (fm_algorithm[op][4][connect])
+    {
+        mod1 |= chip->fm_out[prevslot];
+    }
+    mod = mod1 + mod2;
+    if (op == 0)
+    {
+        /* Feedback */
+        mod = mod >> (10 - chip->fb[channel]);
+        if (!chip->fb[channel])
+        {
+            mod = 0;
+        }
+    }
+    else
+    {
+        mod >>= 1;
+    }
+    chip->fm_mod[slot] = mod;
+}
+
+INLINE void NOPN2S_ChGenerate(ym3438_t *chip, Bit32u channel, Bit32u slot)
+{
+    Bit32u op = slot / 6;
+    Bit16s acc = chip->ch_acc[channel];
+    Bit16s add = 0;
+    Bit16s sum = 0;
+    if (op == 0)
+    {
+        acc = 0;
+    }
+    if (fm_algorithm[op][5][chip->connect[channel]])
+    {
+        add += chip->fm_out[slot] >> 5;
+    }
+    sum = acc + add;
+    /* Clamp */
+    if (sum > 255)
+    {
+        sum = 255;
+    }
+    else if(sum < -256)
+    {
+        sum = -256;
+    }
+
+    if (op == 0)
+    {
+        chip->ch_out[channel] = chip->ch_acc[channel];
+    }
+    chip->ch_acc[channel] = sum;
+}
+
+/* Generates one sample (24 cycles, starting at cycle 0), summing up the
+   unmuted channel outputs into smpl like NOPN2_GenerateResampled does. */
+static void NOPN2S_ClockSample(ym3438_t *chip, Bit32s *smpl)
+{
+    opn2_soa_latch lt;
+    Bit32u slot;
+    Bit32u ch;
+    Bit32u c;
+    Bit32u grp;
+    Bit8u inc;
+    Bit8u ratemax;
+    Bit8u rate_sel;
+    Bit16s ch_lock[6];
+    Bit32u basefreq[6];
+    Bit16s out;
+    Bit16s sign;
+    Bit32u out_en;
+    Bit32u mute;
+
+    lt.fnum[0] = chip->pg_fnum;
+    lt.block[0] = chip->pg_block;
+    lt.kcode[0] = chip->pg_kcode;
+
+    /* Cycles 0-5: the last stages of slots 18-23 from the previous sample.
+       They use the EG latches of the previous sample, so they go first. */
+    NOPN2S_EnvelopeGenerate(chip, 23, chip->eg_lfo_am, chip->eg_tl[0], 0);
+    inc = NOPN2S_EnvelopeIncrement(chip, chip->eg_rate, chip->eg_ksv, &ratemax);
+    NOPN2S_EnvelopeADSR(chip, 22, chip->eg_inc, chip->eg_ratemax, chip->eg_sl[1], chip->eg_tl[1]);
+    NOPN2S_EnvelopeADSR(chip, 23, inc, ratemax, chip->eg_sl[0], chip->eg_tl[0]);
+    for (slot = 20; slot < 24; slot++)
+    {
+        if (chip->pg_reset[slot])
+        {
+            chip->pg_inc[slot] = 0;
+        }
+    }
+    for (slot = 19; slot < 24; slot++)
+    {
+        NOPN2S_FMGenerate(chip, slot);
+    }
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_ChGenerate(chip, ch, 18 + ch);
+        NOPN2S_FMPrepare(chip, ch, 6 + ch);
+    }
+    /* channels 2, 6, 4 are locked before their OP1 finishes */
+    for (grp = 0; grp < 3; grp++)
+    {
+        ch_lock[grp] = chip->ch_out[out_channel[grp]];
+    }
+
+    /* Cycle-based parts: EG timer, IO, timers, key on, LFO, mode registers */
+    if (NOPN2S_BusIdle(chip))
+    {
+        NOPN2S_ClockBusIdle(chip, &lt);
+    }
+    else
+    {
+        NOPN2S_ClockBus(chip, &lt);
+    }
+    chip->cycles = 0;
+    chip->channel = 0;
+    chip->pg_read = 0;
+    chip->eg_read[1] = 0;
+
+    /* PG fnum latch (done at the end of the previous cycle) */
+    for (slot = 1; slot < 24; slot++)
+    {
+        ch = slot % 6;
+        if (lt.mode_ch3[slot - 1] && slot == 2)
+        {
+            lt.fnum[slot] = chip->fnum_3ch[1];
+            lt.block[slot] = chip->block_3ch[1];
+            lt.kcode[slot] = chip->kcode_3ch[1];
+        }
+        else if (lt.mode_ch3[slot - 1] && slot == 8)
+        {
+            lt.fnum[slot] = chip->fnum_3ch[0];
+            lt.block[slot] = chip->block_3ch[0];
+            lt.kcode[slot] = chip->kcode_3ch[0];
+        }
+        else if (lt.mode_ch3[slot - 1] && slot == 14)
+        {
+            lt.fnum[slot] = chip->fnum_3ch[2];
+            lt.block[slot] = chip->block_3ch[2];
+            lt.kcode[slot] = chip->kcode_3ch[2];
+        }
+        else
+        {
+            lt.fnum[slot] = chip->fnum[ch];
+            lt.block[slot] = chip->block[ch];
+            lt.kcode[slot] = chip->kcode[ch];
+        }
+    }
+
+    /* Cycle N */
+    for (ch = 0; ch < 6; ch++)
+    {
+        basefreq[ch] = NOPN2S_PhaseBaseFreq(chip, ch, chip->fnum[ch], chip->block[ch]);
+    }
+    for (slot = 0; slot < 24; slot++)
+    {
+        ch = slot % 6;
+        if (lt.fnum[slot] == chip->fnum[ch] && lt.block[slot] == chip->block[ch])
+        {
+            NOPN2S_PhaseCalcIncrement(chip, slot, basefreq[ch], lt.kcode[slot]);
+        }
+        else
+        {
+            /* CH3 special mode or slot 0 before an fnum change */
+            NOPN2S_PhaseCalcIncrement(chip, slot, NOPN2S_PhaseBaseFreq(chip, ch, lt.fnum[slot], lt.block[slot]),
+                                      lt.kcode[slot]);
+        }
+    }
+    for (slot = 0; slot < 24; slot++)
+    {
+        NOPN2S_EnvelopeSSGEG(chip, slot);
+    }
+    for (slot = 0; slot < 24; slot++)
+    {
+        /* Prepare rate & ksv */
+        rate_sel = chip->eg_state[slot];
+        if ((chip->eg_kon[slot] && chip->eg_ssg_repeat_latch[slot])
+         || (!chip->eg_kon[slot] && chip->eg_kon_latch[slot]))
+        {
+            rate_sel = eg_num_attack;
+        }
+        switch (rate_sel)
+        {
+        case eg_num_attack:
+            lt.rate[slot] = chip->ar[slot];
+            break;
+        case eg_num_decay:
+            lt.rate[slot] = chip->dr[slot];
+            break;
+        case eg_num_sustain:
+            lt.rate[slot] = chip->sr[slot];
+            break;
+        case eg_num_release:
+        default:
+            lt.rate[slot] = (chip->rr[slot] << 1) | 0x01;
+            break;
+        }
+        lt.ksv[slot] = lt.kcode[slot] >> (chip->ks[slot] ^ 0x03);
+        if (chip->am[slot])
+        {
+            lt.lfo_am[slot] = chip->lfo_am >> eg_am_shift[chip->ams[slot % 6]];
+        }
+        else
+        {
+            lt.lfo_am[slot] = 0;
+        }
+    }
+
+    /* Cycle N+1 (slot 23 is done in the next sample) */
+    for (slot = 0; slot < 23; slot++)
+    {
+        lt.inc[slot] = NOPN2S_EnvelopeIncrement(chip, lt.rate[slot], lt.ksv[slot], &lt.ratemax[slot]);
+    }
+    for (slot = 0; slot < 23; slot++)
+    {
+        NOPN2S_EnvelopeGenerate(chip, slot, lt.lfo_am[slot], chip->tl[slot],
+                                lt.mode_csm[slot + 1] && slot % 6 == 2);
+    }
+    /* Cycle N+2 */
+    for (slot = 0; slot < 22; slot++)
+    {
+        NOPN2S_EnvelopeADSR(chip, slot, lt.inc[slot], lt.ratemax[slot], chip->sl[slot], chip->tl[slot]);
+    }
+    /* Cycle N+4 */
+    for (slot = 0; slot < 20; slot++)
+    {
+        if (chip->pg_reset[slot])
+        {
+            chip->pg_inc[slot] = 0;
+        }
+    }
+
+    /* Operator chain, one operator of all 6 channels at a time */
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_FMGenerate(chip, ch);
+    }
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_ChGenerate(chip, ch, ch);
+        NOPN2S_FMPrepare(chip, ch, 12 + ch);
+        chip->fm_op1[ch][1] = chip->fm_op1[ch][0];
+        chip->fm_op1[ch][0] = chip->fm_out[ch];
+    }
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_FMGenerate(chip, 6 + ch);
+    }
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_ChGenerate(chip, ch, 6 + ch);
+        NOPN2S_FMPrepare(chip, ch, 18 + ch);
+    }
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_FMGenerate(chip, 12 + ch);
+    }
+    for (ch = 0; ch < 6; ch++)
+    {
+        NOPN2S_ChGenerate(chip, ch, 12 + ch);
+        NOPN2S_FMPrepare(chip, ch, ch);
+        chip->fm_op2[ch] = chip->fm_out[12 + ch];
+    }
+    NOPN2S_FMGenerate(chip, 18);
+    for (grp = 3; grp < 6; grp++)
+    {
+        ch_lock[grp] = chip->ch_out[out_channel[grp]];
+    }
+
+    /* EG latches as left by cycle 23 */
+    chip->eg_inc = lt.inc[22];
+    chip->eg_ratemax = lt.ratemax[22];
+    chip->eg_read[0] = lt.inc[20] > 0;
+    chip->eg_read_inc = lt.inc[21] > 0;
+    chip->eg_rate = lt.rate[23];
+    chip->eg_ksv = lt.ksv[23];
+    chip->eg_lfo_am = lt.lfo_am[23];
+    chip->eg_tl[0] = chip->tl[23];
+    chip->eg_tl[1] = chip->tl[22];
+    chip->eg_sl[0] = chip->sl[23];
+    chip->eg_sl[1] = chip->sl[22];
+    chip->pg_fnum = chip->fnum[0];
+    chip->pg_block = chip->block[0];
+    chip->pg_kcode = chip->kcode[0];
+
+    /* Channel output */
+    for (c = 0; c < 24; c++)
+    {
+        grp = c >> 2;
+        chip->ch_read = chip->ch_lock;
+        if ((c & 3) == 0)
+        {
+            chip->ch_lock = ch_lock[grp];
+            chip->ch_lock_l = chip->pan_l[out_channel[grp]];
+            chip->ch_lock_r = chip->pan_r[out_channel[grp]];
+        }
+        /* Ch 6 */
+        if (grp == 1 && lt.dacen[c])
+        {
+            out = (Bit16s)lt.dacdata[c];
+            out = SIGN_EXTEND(8, out);
+            mute = chip->mute[6];
+        }
+        else
+        {
+            out = chip->ch_lock;
+            mute = chip->mute[out_channel[grp]];
+        }
+        chip->mol = 0;
+        chip->mor = 0;
+
+        if (chip->chip_type & ym3438_mode_ym2612)
+        {
+            out_en = ((c & 3) == 3);
+            /* YM2612 DAC emulation(not verified) */
+            sign = out >> 8;
+            if (out >= 0)
+            {
+                out++;
+                sign++;
+            }
+            if (chip->ch_lock_l && out_en)
+            {
+                chip->mol = out;
+            }
+            else
+            {
+                chip->mol = sign;
+            }
+            if (chip->ch_lock_r && out_en)
+            {
+                chip->mor = out;
+            }
+            else
+            {
+                chip->mor = sign;
+            }
+            /* Amplify signal */
+            chip->mol *= 3;
+            chip->mor *= 3;
+        }
+        else
+        {
+            out_en = ((c & 3) != 0);
+            if (chip->ch_lock_l && out_en)
+            {
+                chip->mol = out;
+            }
+            if (chip->ch_lock_r && out_en)
+            {
+                chip->mor = out;
+            }
+        }
+        if (!mute)
+        {
+            smpl[0] += chip->mol;
+            smpl[1] += chip->mor;
+        }
+    }
+}
+
+/* Generates one sample using the cycle-exact reference path. */
+static void NOPN2S_ClockCycles(ym3438_t *chip, Bit32s *smpl)
+{
+    Bit32u i;
+    Bit32s buffer[2];
+    Bit32u mute;
+
+    for (i = 0; i < 24; i++)
+    {
+        switch (chip->cycles >> 2)
+        {
+        case 0: // Ch 2
+            mute = chip->mute[1];
+            break;
+        case 1: // Ch 6, DAC
+            mute = chip->mute[5 + chip->dacen];
+            break;
+        case 2: // Ch 4
+            mute = chip->mute[3];
+            break;
+        case 3: // Ch 1
+            mute = chip->mute[0];
+            break;
+        case 4: // Ch 5
+            mute = chip->mute[4];
+            break;
+        case 5: // Ch 3
+            mute = chip->mute[2];
+            break;
+        default:
+            mute = 0;
+            break;
+        }
+        NOPN2_Clock(chip, buffer);
+        if (!mute)
+        {
+            smpl[0] += buffer[0];
+            smpl[1] += buffer[1];
+        }
+        NOPN2S_FlushWriteBuf(chip);
+    }
+}
+
+static void NOPN2S_GenerateResampled(ym3438_t *chip, Bit32s *buf)
+{
+    while (chip->samplecnt >= chip->rateratio)
+    {
+        chip->oldsamples[0] = chip->samples[0];
+        chip->oldsamples[1] = chip->samples[1];
+        chip->samples[0] = chip->samples[1] = 0;
+        if (NOPN2S_CanBatch(chip))
+        {
+            NOPN2S_ClockSample(chip, chip->samples);
+        }
+        else
+        {
+            NOPN2S_ClockCycles(chip, chip->samples);
+        }
+        if(!chip->use_filter)
+        {
+            chip->samples[0] *= 11;
+            chip->samples[1] *= 11;
+        }
+        else
+        {
+            chip->samples[0] = chip->oldsamples[0] + (Bit32s)(FILTER_CUTOFF_I * (chip->samples[0]*(11+1) - chip->oldsamples[0]));
+            chip->samples[1] = chip->oldsamples[1] + (Bit32s)(FILTER_CUTOFF_I * (chip->samples[1]*(11+1) - chip->oldsamples[1]));
+        }
+        chip->samplecnt -= chip->rateratio;
+    }
+    buf[0] = (Bit32s)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
+                     + chip->samples[0] * chip->samplecnt) / chip->rateratio);
+    buf[1] = (Bit32s)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
+                     + chip->samples[1] * chip->samplecnt) / chip->rateratio);
+    chip->samplecnt += 1 << RSM_FRAC;
+}
+
+void nukedopn2_update_soa(void *chip, UINT32 numsamples, DEV_SMPL **sndptr)
+{
+    ym3438_t* opn2 = (ym3438_t*)chip;
+    Bit32u i;
+    DEV_SMPL *smpl, *smpr;
+    Bit32s buffer[2];
+    smpl = sndptr[0];
+    smpr = sndptr[1];
+
+    for (i = 0; i < numsamples; i++)
+    {
+        NOPN2S_GenerateResampled(opn2, buffer);
+        *smpl++ = buffer[0];
+        *smpr++ = buffer[1];
+    }
+}
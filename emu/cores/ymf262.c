@@ -64,6 +64,7 @@ differences between OPL2 and OPL3 shown in datasheets:
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../../utils/OSOnce.h"
 #include "../logging.h"
 #include "ymf262.h"
 
@@ -572,9 +573,6 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
-static int num_lock = 0;
-
 /* work table */
 #define SLOT7_1 (&chip->P_CH[7].SLOT[SLOT1])
 #define SLOT7_2 (&chip->P_CH[7].SLOT[SLOT2])
@@ -583,7 +581,7 @@ static int num_lock = 0;
 
 
 
-static UINT8 tablesInit = 0;
+static OS_ONCE tablesInit = OS_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void OPL3_STATUS_SET(OPL3 *chip,int flag)
@@ -1116,17 +1114,13 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 }
 
 
-/* generic table initialize */
-static int init_tables(void)
+/* generic table initialize (called once, the tables are shared by all chips) */
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1271,11 +1265,7 @@ static int init_tables(void)
 	}
 	/*logerror("YMF262.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
 
-	return 1;
-}
-
-static void OPLCloseTable( void )
-{
+	return;
 }
 
 
@@ -2188,32 +2178,6 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 	}
 }
 
-/* lock/unlock for common table */
-static int OPL3_LockTable()
-{
-	num_lock++;
-	if(num_lock>1) return 0;
-
-	/* first time */
-
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
-
-	return 0;
-}
-
-static void OPL3_UnLockTable(void)
-{
-	if(num_lock) num_lock--;
-	if(num_lock) return;
-
-	/* last time */
-	OPLCloseTable();
-}
-
 static void OPL3ResetChip(OPL3 *chip)
 {
 	int c,s;
@@ -2265,7 +2229,7 @@ static OPL3 *OPL3Create(UINT32 clock, UINT32 rate, int type)
 {
 	OPL3 *chip;
 
-	if (OPL3_LockTable() == -1) return NULL;
+	OSOnce_Run(&tablesInit, init_tables);
 
 	/* allocate memory block */
 	chip = (OPL3 *)calloc(1, sizeof(OPL3));
@@ -2288,7 +2252,6 @@ static OPL3 *OPL3Create(UINT32 clock, UINT32 rate, int type)
 /* Destroy one of virtual YMF262 */
 static void OPL3Destroy(OPL3 *chip)
 {
-	OPL3_UnLockTable();
 	free(chip);
 }
 
@@ -2615,3 +2578,16 @@ void ymf262_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&opl3->logger, opl3, func, param);
 	return;
 }
+
+UINT32 ymf262_save_state(void *chip, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(chip, sizeof(OPL3), bufSize, buffer);
+}
+
+UINT8 ymf262_load_state(void *chip, UINT32 dataSize, const void* data)
+{
+	if (dataSize != sizeof(OPL3))
+		return 0xFF;
+	memcpy(chip, data, sizeof(OPL3));
+	return 0x00;
+}
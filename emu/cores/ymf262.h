@@ -24,5 +24,7 @@ void ymf262_set_mute_mask(void *chip, UINT32 MuteMask);
 void ymf262_set_volume(void *chip, INT32 volume);
 void ymf262_set_vol_lr(void *chip, INT32 volLeft, INT32 volRight);
 void ymf262_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 ymf262_save_state(void *chip, UINT32 bufSize, void* buffer);
+UINT8 ymf262_load_state(void *chip, UINT32 dataSize, const void* data);
 
 #endif	// __YMF262_H__
@@ -85,6 +85,7 @@
 #include "../snddef.h"
 #include "../EmuHelper.h"
 #include "../logging.h"
+#include "../../utils/OSOnce.h"
 #include "ymf271.h"
 
 #ifdef _MSC_VER
@@ -434,6 +435,16 @@ static const int modulation_level[8] = { 16, 8, 4, 2, 1, 32, 64, 128 };
 static const int fm_tab[16] = { 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 };
 static const int pcm_tab[16] = { 0, 4, 8, -1, 12, 16, 20, -1, 24, 28, 32, -1, 36, 40, 44, -1 };
 
+// lookup tables, shared by all chips
+static INT16 lut_waves[8][SIN_LEN];
+static double lut_plfo[4][8][LFO_LENGTH];
+static int lut_alfo[4][LFO_LENGTH];
+static int lut_attenuation[16];
+static int lut_total_level[128];
+static int lut_env_volume[256];
+static INT32 lut_detune[8][32];	// [detune][keycode] -> frequency offset
+static OS_ONCE tablesInit = OS_ONCE_INIT;
+
 
 typedef struct
 {
@@ -501,17 +512,10 @@ typedef struct
 	DEV_DATA _devData;
 	DEV_LOGGER logger;
 	
-	// lookup tables
-	INT16 *lut_waves[8];
-	double *lut_plfo[4][8];
-	int *lut_alfo[4];
+	// lookup tables (clock-dependent)
 	double lut_ar[64];
 	double lut_dc[64];
 	double lut_lfo[256];
-	int lut_attenuation[16];
-	int lut_total_level[128];
-	int lut_env_volume[256];
-	INT32 lut_detune[8][32];	// [detune][keycode] -> frequency offset
 
 	// internal state
 	YMF271Slot slots[48];
@@ -556,7 +560,8 @@ INLINE UINT8 ymf271_read_memory(YMF271Chip *chip, UINT32 offset);
 INLINE int get_internal_keycode(int block, int fns);
 
 
-INLINE void calculate_step(YMF271Chip *chip, YMF271Slot *slot)
+// phase step before LFO phase modulation, see calculate_step()
+INLINE double calculate_step_base(YMF271Chip *chip, const YMF271Slot *slot)
 {
 	double st;
 
@@ -565,20 +570,12 @@ INLINE void calculate_step(YMF271Chip *chip, YMF271Slot *slot)
 		// external waveform (PCM)
 		st = (double)(2 * (slot->fns | 2048)) * pow_table[slot->block] * fs_frequency[slot->fs];
 		st = st * multiple_table[slot->multiple];
-
-		// LFO phase modulation
-		st *= slot->lfo_phasemod;
-
-		// 524288 / 65536 = 8, but keep as floating-point to avoid integer division
-		st /= (524288.0 / 65536.0); // pre-multiply with 65536
-
-		slot->step = (UINT32)st;
 	}
 	else
 	{
 		// internal waveform (FM)
 		int keycode = get_internal_keycode(slot->block, slot->fns);
-		INT32 detune_offset = chip->lut_detune[slot->detune][keycode];
+		INT32 detune_offset = lut_detune[slot->detune][keycode];
 		
 		// Apply detune offset to fns before calculating step
 		INT32 fns_detuned = (INT32)(slot->fns) + detune_offset;
@@ -586,15 +583,28 @@ INLINE void calculate_step(YMF271Chip *chip, YMF271Slot *slot)
 		
 		st = (double)(2 * fns_detuned) * pow_table[slot->block];
 		st = st * multiple_table[slot->multiple] * (double)(SIN_LEN);
+	}
+	return st;
+}
 
-		// LFO phase modulation
-		st *= slot->lfo_phasemod;
+INLINE double calculate_step_div(const YMF271Slot *slot)
+{
+	if (slot->waveform == 7)
+		return (524288.0 / 65536.0);	// 524288 / 65536 = 8, but keep as floating-point to avoid integer division
+	else
+		return (536870912.0 / 65536.0);	// 536870912 / 65536 = 8192, but keep as floating-point to avoid integer division
+}
+
+INLINE void calculate_step(YMF271Chip *chip, YMF271Slot *slot)
+{
+	double st = calculate_step_base(chip, slot);
 
-		// 536870912 / 65536 = 8192, but keep as floating-point to avoid integer division
-		st /= (536870912.0 / 65536.0); // pre-multiply with 65536
+	// LFO phase modulation
+	st *= slot->lfo_phasemod;
 
-		slot->step = (UINT32)st;
-	}
+	st /= calculate_step_div(slot); // pre-multiply with 65536
+
+	slot->step = (UINT32)st;
 }
 
 INLINE UINT8 check_envelope_end(YMF271Slot *slot)
@@ -648,7 +658,7 @@ INLINE void calculate_status_end(YMF271Chip *chip, int slotnum, UINT8 state)
  * 
  * Volume is stored in 16.16 fixed-point format (ENV_VOLUME_SHIFT = 16).
  */
-static void update_envelope(YMF271Slot *slot)
+INLINE void update_envelope(YMF271Slot *slot)
 {
 	switch (slot->env_state)
 	{
@@ -876,11 +886,11 @@ static void init_envelope(YMF271Chip *chip, YMF271Slot *slot)
 static void init_lfo(YMF271Chip *chip, YMF271Slot *slot)
 {
 	slot->lfo_phase = 0;
-	slot->lfo_amplitude = chip->lut_alfo[slot->lfowave][0];
+	slot->lfo_amplitude = lut_alfo[slot->lfowave][0];
 	// Initialize lfo_phasemod to correct initial value (not 0!)
 	// When lfo_phase=0, use the first entry from the lookup table
 	// This ensures calculate_step() gets a valid multiplier on key-on
-	slot->lfo_phasemod = chip->lut_plfo[slot->lfowave][slot->pms][0];
+	slot->lfo_phasemod = lut_plfo[slot->lfowave][slot->pms][0];
 
 	slot->lfo_step = (int)((((double)LFO_LENGTH * chip->lut_lfo[slot->lfoFreq]) / 44100.0) * 256.0);
 }
@@ -889,8 +899,8 @@ INLINE void update_lfo(YMF271Chip *chip, YMF271Slot *slot)
 {
 	slot->lfo_phase += slot->lfo_step;
 
-	slot->lfo_amplitude = chip->lut_alfo[slot->lfowave][(slot->lfo_phase >> LFO_SHIFT) & (LFO_LENGTH-1)];
-	slot->lfo_phasemod = chip->lut_plfo[slot->lfowave][slot->pms][(slot->lfo_phase >> LFO_SHIFT) & (LFO_LENGTH-1)];
+	slot->lfo_amplitude = lut_alfo[slot->lfowave][(slot->lfo_phase >> LFO_SHIFT) & (LFO_LENGTH-1)];
+	slot->lfo_phasemod = lut_plfo[slot->lfowave][slot->pms][(slot->lfo_phase >> LFO_SHIFT) & (LFO_LENGTH-1)];
 
 	calculate_step(chip, slot);
 }
@@ -911,9 +921,9 @@ INLINE int calculate_slot_volume(YMF271Chip *chip, YMF271Slot *slot)
 		case 3: lfo_volume = 65536 - ((slot->lfo_amplitude * 4277) >> 16); break;   // 23.625dB
 	}
 
-	env_volume = (chip->lut_env_volume[255 - (slot->volume >> ENV_VOLUME_SHIFT)] * lfo_volume) >> 16;
+	env_volume = (lut_env_volume[255 - (slot->volume >> ENV_VOLUME_SHIFT)] * lfo_volume) >> 16;
 
-	volume = (env_volume * chip->lut_total_level[slot->tl]) >> 16;
+	volume = (env_volume * lut_total_level[slot->tl]) >> 16;
 
 	return volume;
 }
@@ -1118,25 +1128,25 @@ static void update_pcm(YMF271Chip *chip, int slotnum, INT32 *mixp, UINT32 length
 				INT64 acc;
 
 				// CH0
-				acc = accp[i*4+0] + ((output * chip->lut_attenuation[slot->ch0_level]) >> 16);
+				acc = accp[i*4+0] + ((output * lut_attenuation[slot->ch0_level]) >> 16);
 				if (acc > ACC_18BIT_MAX) acc = ACC_18BIT_MAX;
 				else if (acc < ACC_18BIT_MIN) acc = ACC_18BIT_MIN;
 				accp[i*4+0] = (INT32)acc;
 
 				// CH1
-				acc = accp[i*4+1] + ((output * chip->lut_attenuation[slot->ch1_level]) >> 16);
+				acc = accp[i*4+1] + ((output * lut_attenuation[slot->ch1_level]) >> 16);
 				if (acc > ACC_18BIT_MAX) acc = ACC_18BIT_MAX;
 				else if (acc < ACC_18BIT_MIN) acc = ACC_18BIT_MIN;
 				accp[i*4+1] = (INT32)acc;
 
 				// CH2
-				acc = accp[i*4+2] + ((output * chip->lut_attenuation[slot->ch2_level]) >> 16);
+				acc = accp[i*4+2] + ((output * lut_attenuation[slot->ch2_level]) >> 16);
 				if (acc > ACC_18BIT_MAX) acc = ACC_18BIT_MAX;
 				else if (acc < ACC_18BIT_MIN) acc = ACC_18BIT_MIN;
 				accp[i*4+2] = (INT32)acc;
 
 				// CH3
-				acc = accp[i*4+3] + ((output * chip->lut_attenuation[slot->ch3_level]) >> 16);
+				acc = accp[i*4+3] + ((output * lut_attenuation[slot->ch3_level]) >> 16);
 				if (acc > ACC_18BIT_MAX) acc = ACC_18BIT_MAX;
 				else if (acc < ACC_18BIT_MIN) acc = ACC_18BIT_MIN;
 				accp[i*4+3] = (INT32)acc;
@@ -1147,10 +1157,10 @@ static void update_pcm(YMF271Chip *chip, int slotnum, INT32 *mixp, UINT32 length
 			// Accon=0: Normal output path
 			final_volume = calculate_slot_volume(chip, slot);
 
-			ch0_vol = (final_volume * chip->lut_attenuation[slot->ch0_level]) >> 16;
-			ch1_vol = (final_volume * chip->lut_attenuation[slot->ch1_level]) >> 16;
-			ch2_vol = (final_volume * chip->lut_attenuation[slot->ch2_level]) >> 16;
-			ch3_vol = (final_volume * chip->lut_attenuation[slot->ch3_level]) >> 16;
+			ch0_vol = (final_volume * lut_attenuation[slot->ch0_level]) >> 16;
+			ch1_vol = (final_volume * lut_attenuation[slot->ch1_level]) >> 16;
+			ch2_vol = (final_volume * lut_attenuation[slot->ch2_level]) >> 16;
+			ch3_vol = (final_volume * lut_attenuation[slot->ch3_level]) >> 16;
 
 			if (ch0_vol > 65536) ch0_vol = 65536;
 			if (ch1_vol > 65536) ch1_vol = 65536;
@@ -1171,6 +1181,36 @@ static void update_pcm(YMF271Chip *chip, int slotnum, INT32 *mixp, UINT32 length
 	}
 }
 
+/*
+ * Operator state used by the FM kernels
+ *
+ * The kernels work on a copy of each slot that is written back after the chunk.
+ * Everything calculate_step() derives from the registers is constant while a chunk
+ * is rendered, so only the LFO phase modulation has to be applied per sample.
+ */
+typedef struct
+{
+	YMF271Slot slot;
+	double step_base;   // calculate_step_base()
+	double step_div;    // calculate_step_div()
+	INT32 ch_att[4];    // channel levels (PAN block), 0 for unused operators
+} YMF271Op;
+
+// update_lfo() with the step base of the chunk
+INLINE void update_op_lfo(YMF271Chip *chip, YMF271Op *op)
+{
+	YMF271Slot *slot = &op->slot;
+	int lfo_pos;
+
+	slot->lfo_phase += slot->lfo_step;
+	lfo_pos = (slot->lfo_phase >> LFO_SHIFT) & (LFO_LENGTH-1);
+
+	slot->lfo_amplitude = lut_alfo[slot->lfowave][lfo_pos];
+	slot->lfo_phasemod = lut_plfo[slot->lfowave][slot->pms][lfo_pos];
+
+	slot->step = (UINT32)(op->step_base * slot->lfo_phasemod / op->step_div);
+}
+
 /*
  * Calculate the output of one FM operator
  * 
@@ -1185,13 +1225,13 @@ static void update_pcm(YMF271Chip *chip, int slotnum, INT32 *mixp, UINT32 length
  * Note: The actual scaling in code differs from raw datasheet values due to
  * how feedback uses /16 in set_feedback() while modulation doesn't divide.
  */
-static INT64 calculate_op(YMF271Chip *chip, int slotnum, INT64 inp)
+INLINE INT64 calculate_op(YMF271Chip *chip, YMF271Op *op, INT64 inp)
 {
-	YMF271Slot *slot = &chip->slots[slotnum];
+	YMF271Slot *slot = &op->slot;
 	INT64 env, slot_output, slot_input = 0;
 
 	update_envelope(slot);
-	update_lfo(chip, slot);
+	update_op_lfo(chip, op);
 	env = calculate_slot_volume(chip, slot);
 
 	if (inp == OP_INPUT_FEEDBACK)
@@ -1207,16 +1247,16 @@ static INT64 calculate_op(YMF271Chip *chip, int slotnum, INT64 inp)
 		slot_input = ((inp << (SIN_BITS-2)) * modulation_level[slot->feedback]);
 	}
 
-	slot_output = chip->lut_waves[slot->waveform][((slot->stepptr + slot_input) >> 16) & SIN_MASK];
+	slot_output = lut_waves[slot->waveform][((slot->stepptr + slot_input) >> 16) & SIN_MASK];
 	slot_output = (slot_output * env) >> 16;
 	slot->stepptr += slot->step;
 
 	return slot_output;
 }
 
-static void set_feedback(YMF271Chip *chip, int slotnum, INT64 inp)
+INLINE void set_feedback(YMF271Op *op, INT64 inp)
 {
-	YMF271Slot *slot = &chip->slots[slotnum];
+	YMF271Slot *slot = &op->slot;
 	/*
 	 * Feedback scaling (empirically tuned for best match with original hardware):
 	 *
@@ -1242,9 +1282,9 @@ static void set_feedback(YMF271Chip *chip, int slotnum, INT64 inp)
 
 // calculates the output of one FM operator in PFM mode (PCM-based FM)
 // In PFM mode, external PCM waveform data is used as the carrier instead of internal sine waveforms
-static INT64 calculate_op_pfm(YMF271Chip *chip, int slotnum, INT64 inp)
+INLINE INT64 calculate_op_pfm(YMF271Chip *chip, YMF271Op *op, INT64 inp)
 {
-	YMF271Slot *slot = &chip->slots[slotnum];
+	YMF271Slot *slot = &op->slot;
 	INT64 env, slot_output, slot_input = 0;
 	INT16 sample;
 	UINT32 sample_offset;
@@ -1252,7 +1292,7 @@ static INT64 calculate_op_pfm(YMF271Chip *chip, int slotnum, INT64 inp)
 	UINT32 sample_length;
 
 	update_envelope(slot);
-	update_lfo(chip, slot);
+	update_op_lfo(chip, op);
 	env = calculate_slot_volume(chip, slot);
 
 	if (inp == OP_INPUT_FEEDBACK)
@@ -1335,6 +1375,496 @@ static INT64 calculate_op_pfm(YMF271Chip *chip, int slotnum, INT64 inp)
 	return slot_output;
 }
 
+/*
+ * FM kernels
+ *
+ * The operator chain of a group depends only on its sync mode, algorithm and PFM flag,
+ * which can't change while a chunk is rendered. ymf271_update() selects one kernel per
+ * group and chunk, so the per-sample loop does no mode dispatch. The kernels are
+ * generated by DEF_FM_KERNELS from the per-sample algorithm functions below.
+ *
+ * Operator indices are the slots of a group: S1 = bank 0, S2 = bank 1, S3 = bank 2, S4 = bank 3.
+ */
+#define S1  0
+#define S2  1
+#define S3  2
+#define S4  3
+
+typedef void (*FM_KERNEL)(YMF271Chip *chip, YMF271Op *op, INT32 *mixp, UINT32 length);
+
+// carrier slot - use PFM if enabled
+INLINE INT64 calculate_carrier(YMF271Chip *chip, YMF271Op *op, INT64 inp, UINT8 pfm)
+{
+	return pfm ? calculate_op_pfm(chip, op, inp) : calculate_op(chip, op, inp);
+}
+
+// FM output to 4 channels
+// Apply channel levels (PAN block) - always applied per datasheet signal flow
+INLINE void mix_fm_output(const YMF271Op *op, const INT64 *out, INT32 *mixp)
+{
+	int ch;
+
+	for (ch = 0; ch < 4; ch++)
+	{
+		mixp[ch] += ((out[S1] * op[S1].ch_att[ch]) >> 16) + ((out[S2] * op[S2].ch_att[ch]) >> 16) +
+		            ((out[S3] * op[S3].ch_att[ch]) >> 16) + ((out[S4] * op[S4].ch_att[ch]) >> 16);
+	}
+}
+
+#define DEF_FM_KERNEL(alg, pfm) \
+static void alg##_pfm##pfm(YMF271Chip *chip, YMF271Op *op, INT32 *mixp, UINT32 length) \
+{ \
+	UINT32 i; \
+	INT64 out[4]; \
+	for (i = 0; i < length; i++, mixp += 4) \
+	{ \
+		out[S1] = out[S2] = out[S3] = out[S4] = 0; \
+		alg(chip, op, out, pfm); \
+		mix_fm_output(op, out, mixp); \
+	} \
+}
+#define DEF_FM_KERNELS(alg)	DEF_FM_KERNEL(alg, 0) DEF_FM_KERNEL(alg, 1)
+
+// ---- 4 operator FM ----
+
+// <--------|
+// +--[S1]--|--+--[S3]--+--[S2]--+--[S4]-->
+INLINE void fm4_alg0(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	phase_mod2 = calculate_op(chip, &op[S2], phase_mod3);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+// <-----------------|
+// +--[S1]--+--[S3]--|--+--[S2]--+--[S4]-->
+INLINE void fm4_alg1(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	phase_mod2 = calculate_op(chip, &op[S2], phase_mod3);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+// <--------|
+// +--[S1]--|
+//          |
+//  --[S3]--+--[S2]--+--[S4]-->
+INLINE void fm4_alg2(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	phase_mod2 = calculate_op(chip, &op[S2], phase_mod1 + phase_mod3);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+//          <--------|
+//          +--[S1]--|
+//                   |
+//  --[S3]--+--[S2]--+--[S4]-->
+INLINE void fm4_alg3(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	phase_mod2 = calculate_op(chip, &op[S2], phase_mod3);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod1 + phase_mod2, pfm);
+}
+
+//              --[S2]--|
+// <--------|           |
+// +--[S1]--|--+--[S3]--+--[S4]-->
+INLINE void fm4_alg4(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	phase_mod2 = calculate_op(chip, &op[S2], OP_INPUT_NONE);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod3 + phase_mod2, pfm);
+}
+
+//           --[S2]-----|
+// <-----------------|  |
+// +--[S1]--+--[S3]--|--+--[S4]-->
+INLINE void fm4_alg5(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	phase_mod2 = calculate_op(chip, &op[S2], OP_INPUT_NONE);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod3 + phase_mod2, pfm);
+}
+
+//  --[S2]-----+--[S4]--|
+//                      |
+// <--------|           |
+// +--[S1]--|--+--[S3]--+-->
+INLINE void fm4_alg6(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+	phase_mod2 = calculate_op(chip, &op[S2], OP_INPUT_NONE);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+//  --[S2]--+--[S4]-----|
+//                      |
+// <-----------------|  |
+// +--[S1]--+--[S3]--|--+-->
+INLINE void fm4_alg7(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	out[S3] = pfm ? calculate_op_pfm(chip, &op[S3], phase_mod1) : phase_mod3;
+	phase_mod2 = calculate_op(chip, &op[S2], OP_INPUT_NONE);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+//  --[S3]--+--[S2]--+--[S4]--|
+//                            |
+// <--------|                 |
+// +--[S1]--|-----------------+-->
+INLINE void fm4_alg8(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	phase_mod2 = calculate_op(chip, &op[S2], phase_mod3);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+//          <--------|
+//          +--[S1]--|
+//                   |
+//  --[S3]--|        |
+//  --[S2]--+--[S4]--+-->
+INLINE void fm4_alg9(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	phase_mod2 = calculate_op(chip, &op[S2], OP_INPUT_NONE);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod3 + phase_mod2, pfm);
+}
+
+//              --[S4]--|
+//              --[S2]--|
+// <--------|           |
+// +--[S1]--|--+--[S3]--+-->
+INLINE void fm4_alg10(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+	out[S4] = calculate_carrier(chip, &op[S4], OP_INPUT_NONE, pfm);
+}
+
+//           --[S4]-----|
+//           --[S2]-----|
+// <-----------------|  |
+// +--[S1]--+--[S3]--|--+-->
+INLINE void fm4_alg11(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	out[S3] = pfm ? calculate_op_pfm(chip, &op[S3], phase_mod1) : phase_mod3;
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+	out[S4] = calculate_carrier(chip, &op[S4], OP_INPUT_NONE, pfm);
+}
+
+//             |--+--[S4]--|
+// <--------|  |--+--[S3]--|
+// +--[S1]--|--|--+--[S2]--+-->
+INLINE void fm4_alg12(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+	out[S2] = calculate_carrier(chip, &op[S2], phase_mod1, pfm);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod1, pfm);
+}
+
+//  --[S3]--+--[S2]--|
+//                   |
+//  --[S4]-----------|
+// <--------|        |
+// +--[S1]--|--------+-->
+INLINE void fm4_alg13(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	out[S2] = calculate_carrier(chip, &op[S2], phase_mod3, pfm);
+	out[S4] = calculate_carrier(chip, &op[S4], OP_INPUT_NONE, pfm);
+}
+
+//  --[S2]-----+--[S4]--|
+//                      |
+// <--------|  +--[S3]--|
+// +--[S1]--|--|--------+-->
+INLINE void fm4_alg14(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod2;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+	phase_mod2 = calculate_op(chip, &op[S2], OP_INPUT_NONE);
+	out[S4] = calculate_carrier(chip, &op[S4], phase_mod2, pfm);
+}
+
+//  --[S4]-----|
+//  --[S2]-----|
+//  --[S3]-----|
+// <--------|  |
+// +--[S1]--|--+-->
+INLINE void fm4_alg15(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	out[S3] = calculate_carrier(chip, &op[S3], OP_INPUT_NONE, pfm);
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+	out[S4] = calculate_carrier(chip, &op[S4], OP_INPUT_NONE, pfm);
+}
+
+// ---- 2x 2 operator FM (S1 and S3 of each pair) ----
+
+// <--------|
+// +--[S1]--|--+--[S3]-->
+INLINE void fm2_alg0(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+}
+
+// <-----------------|
+// +--[S1]--+--[S3]--|-->
+INLINE void fm2_alg1(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	out[S3] = pfm ? calculate_op_pfm(chip, &op[S3], phase_mod1) : phase_mod3;
+}
+
+//  --[S3]-----|
+// <--------|  |
+// +--[S1]--|--+-->
+INLINE void fm2_alg2(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	out[S3] = calculate_carrier(chip, &op[S3], OP_INPUT_NONE, pfm);
+}
+
+//
+// <--------|  +--[S3]--|
+// +--[S1]--|--|--------+-->
+INLINE void fm2_alg3(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+}
+
+// ---- 3 operator FM (+ PCM on S4) ----
+
+// <--------|
+// +--[S1]--|--+--[S3]--+--[S2]-->
+INLINE void fm3_alg0(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	out[S2] = calculate_carrier(chip, &op[S2], phase_mod3, pfm);
+}
+
+// <-----------------|
+// +--[S1]--+--[S3]--|--+--[S2]-->
+INLINE void fm3_alg1(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	out[S2] = calculate_carrier(chip, &op[S2], phase_mod3, pfm);
+}
+
+//  --[S3]-----|
+// <--------|  |
+// +--[S1]--|--+--[S2]-->
+INLINE void fm3_alg2(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	out[S2] = calculate_carrier(chip, &op[S2], phase_mod1 + phase_mod3, pfm);
+}
+
+//  --[S3]--+--[S2]--|
+// <--------|        |
+// +--[S1]--|--------+-->
+INLINE void fm3_alg3(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	phase_mod3 = calculate_op(chip, &op[S3], OP_INPUT_NONE);
+	out[S2] = calculate_carrier(chip, &op[S2], phase_mod3, pfm);
+}
+
+//              --[S2]--|
+// <--------|           |
+// +--[S1]--|--+--[S3]--+-->
+INLINE void fm3_alg4(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+}
+
+//              --[S2]--|
+// <-----------------|  |
+// +--[S1]--+--[S3]--|--+-->
+INLINE void fm3_alg5(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1, phase_mod3;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	phase_mod3 = calculate_op(chip, &op[S3], phase_mod1);
+	set_feedback(&op[S1], phase_mod3);
+	out[S3] = pfm ? calculate_op_pfm(chip, &op[S3], phase_mod1) : phase_mod3;
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+}
+
+//  --[S2]-----|
+//  --[S3]-----|
+// <--------|  |
+// +--[S1]--|--+-->
+INLINE void fm3_alg6(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	out[S3] = calculate_carrier(chip, &op[S3], OP_INPUT_NONE, pfm);
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+}
+
+//              --[S2]--|
+// <--------|  +--[S3]--|
+// +--[S1]--|--|--------+-->
+INLINE void fm3_alg7(YMF271Chip *chip, YMF271Op *op, INT64 *out, UINT8 pfm)
+{
+	INT64 phase_mod1;
+	phase_mod1 = calculate_op(chip, &op[S1], OP_INPUT_FEEDBACK);
+	set_feedback(&op[S1], phase_mod1);
+	out[S1] = pfm ? calculate_op_pfm(chip, &op[S1], OP_INPUT_FEEDBACK) : phase_mod1;
+	out[S3] = calculate_carrier(chip, &op[S3], phase_mod1, pfm);
+	out[S2] = calculate_carrier(chip, &op[S2], OP_INPUT_NONE, pfm);
+}
+
+DEF_FM_KERNELS(fm4_alg0)	DEF_FM_KERNELS(fm4_alg1)	DEF_FM_KERNELS(fm4_alg2)	DEF_FM_KERNELS(fm4_alg3)
+DEF_FM_KERNELS(fm4_alg4)	DEF_FM_KERNELS(fm4_alg5)	DEF_FM_KERNELS(fm4_alg6)	DEF_FM_KERNELS(fm4_alg7)
+DEF_FM_KERNELS(fm4_alg8)	DEF_FM_KERNELS(fm4_alg9)	DEF_FM_KERNELS(fm4_alg10)	DEF_FM_KERNELS(fm4_alg11)
+DEF_FM_KERNELS(fm4_alg12)	DEF_FM_KERNELS(fm4_alg13)	DEF_FM_KERNELS(fm4_alg14)	DEF_FM_KERNELS(fm4_alg15)
+DEF_FM_KERNELS(fm2_alg0)	DEF_FM_KERNELS(fm2_alg1)	DEF_FM_KERNELS(fm2_alg2)	DEF_FM_KERNELS(fm2_alg3)
+DEF_FM_KERNELS(fm3_alg0)	DEF_FM_KERNELS(fm3_alg1)	DEF_FM_KERNELS(fm3_alg2)	DEF_FM_KERNELS(fm3_alg3)
+DEF_FM_KERNELS(fm3_alg4)	DEF_FM_KERNELS(fm3_alg5)	DEF_FM_KERNELS(fm3_alg6)	DEF_FM_KERNELS(fm3_alg7)
+
+// [pfm][algorithm]
+static const FM_KERNEL fm4_kernels[2][16] =
+{
+	{	fm4_alg0_pfm0, fm4_alg1_pfm0, fm4_alg2_pfm0, fm4_alg3_pfm0, fm4_alg4_pfm0, fm4_alg5_pfm0, fm4_alg6_pfm0, fm4_alg7_pfm0,
+		fm4_alg8_pfm0, fm4_alg9_pfm0, fm4_alg10_pfm0, fm4_alg11_pfm0, fm4_alg12_pfm0, fm4_alg13_pfm0, fm4_alg14_pfm0, fm4_alg15_pfm0 },
+	{	fm4_alg0_pfm1, fm4_alg1_pfm1, fm4_alg2_pfm1, fm4_alg3_pfm1, fm4_alg4_pfm1, fm4_alg5_pfm1, fm4_alg6_pfm1, fm4_alg7_pfm1,
+		fm4_alg8_pfm1, fm4_alg9_pfm1, fm4_alg10_pfm1, fm4_alg11_pfm1, fm4_alg12_pfm1, fm4_alg13_pfm1, fm4_alg14_pfm1, fm4_alg15_pfm1 },
+};
+static const FM_KERNEL fm2_kernels[2][4] =
+{
+	{	fm2_alg0_pfm0, fm2_alg1_pfm0, fm2_alg2_pfm0, fm2_alg3_pfm0 },
+	{	fm2_alg0_pfm1, fm2_alg1_pfm1, fm2_alg2_pfm1, fm2_alg3_pfm1 },
+};
+static const FM_KERNEL fm3_kernels[2][8] =
+{
+	{	fm3_alg0_pfm0, fm3_alg1_pfm0, fm3_alg2_pfm0, fm3_alg3_pfm0, fm3_alg4_pfm0, fm3_alg5_pfm0, fm3_alg6_pfm0, fm3_alg7_pfm0 },
+	{	fm3_alg0_pfm1, fm3_alg1_pfm1, fm3_alg2_pfm1, fm3_alg3_pfm1, fm3_alg4_pfm1, fm3_alg5_pfm1, fm3_alg6_pfm1, fm3_alg7_pfm1 },
+};
+
+INLINE void load_fm_op(YMF271Chip *chip, YMF271Op *op, int slotnum)
+{
+	if (slotnum < 0)
+	{
+		// unused operator: no output, no channel level
+		memset(op, 0x00, sizeof(YMF271Op));
+		return;
+	}
+	op->slot = chip->slots[slotnum];
+	op->step_base = calculate_step_base(chip, &op->slot);
+	op->step_div = calculate_step_div(&op->slot);
+	op->ch_att[0] = lut_attenuation[op->slot.ch0_level];
+	op->ch_att[1] = lut_attenuation[op->slot.ch1_level];
+	op->ch_att[2] = lut_attenuation[op->slot.ch2_level];
+	op->ch_att[3] = lut_attenuation[op->slot.ch3_level];
+}
+
+// render one chunk of an FM group (slot number -1 = operator not used by the sync mode)
+static void update_fm(YMF271Chip *chip, FM_KERNEL kernel, int slot1, int slot2, int slot3, int slot4,
+                      INT32 *mixp, UINT32 length)
+{
+	YMF271Op op[4];
+
+	load_fm_op(chip, &op[S1], slot1);
+	load_fm_op(chip, &op[S2], slot2);
+	load_fm_op(chip, &op[S3], slot3);
+	load_fm_op(chip, &op[S4], slot4);
+
+	kernel(chip, op, mixp, length);
+
+	if (slot1 >= 0) chip->slots[slot1] = op[S1].slot;
+	if (slot2 >= 0) chip->slots[slot2] = op[S2].slot;
+	if (slot3 >= 0) chip->slots[slot3] = op[S3].slot;
+	if (slot4 >= 0) chip->slots[slot4] = op[S4].slot;
+}
+
 static void ymf271_update(void *info, UINT32 samples, DEV_SMPL** outputs)
 {
 	UINT32 smpl_ofs;
@@ -1371,277 +1901,13 @@ static void ymf271_update(void *info, UINT32 samples, DEV_SMPL** outputs)
 			// 4 operator FM
 			case 0:
 			{
-				int slot1 = j + (0*12);
-				int slot2 = j + (1*12);
-				int slot3 = j + (2*12);
-				int slot4 = j + (3*12);
 				// PFM is only available for groups 0, 4, 8
 				UINT8 pfm_enabled = (j == 0 || j == 4 || j == 8) ? slot_group->pfm : 0;
 
-				if (chip->slots[slot1].active)
+				if (chip->slots[j].active)
 				{
-					for (i = 0; i < proc_smpls; i++)
-					{
-						INT64 output1 = 0, output2 = 0, output3 = 0, output4 = 0;
-						INT64 phase_mod1 = 0, phase_mod2 = 0, phase_mod3 = 0;
-						switch (chip->slots[slot1].algorithm)
-						{
-							// <--------|
-							// +--[S1]--|--+--[S3]--+--[S2]--+--[S4]-->
-							case 0:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								phase_mod2 = calculate_op(chip, slot2, phase_mod3);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							// <-----------------|
-							// +--[S1]--+--[S3]--|--+--[S2]--+--[S4]-->
-							case 1:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								set_feedback(chip, slot1, phase_mod3);
-								phase_mod2 = calculate_op(chip, slot2, phase_mod3);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							// <--------|
-							// +--[S1]--|
-							//          |
-							//  --[S3]--+--[S2]--+--[S4]-->
-							case 2:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								phase_mod2 = calculate_op(chip, slot2, (phase_mod1 + phase_mod3) / 1);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							//          <--------|
-							//          +--[S1]--|
-							//                   |
-							//  --[S3]--+--[S2]--+--[S4]-->
-							case 3:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								phase_mod2 = calculate_op(chip, slot2, phase_mod3);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, (phase_mod1 + phase_mod2) / 1) : calculate_op(chip, slot4, (phase_mod1 + phase_mod2) / 1);
-								break;
-
-							//              --[S2]--|
-							// <--------|           |
-							// +--[S1]--|--+--[S3]--+--[S4]-->
-							case 4:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								phase_mod2 = calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, (phase_mod3 + phase_mod2) / 1) : calculate_op(chip, slot4, (phase_mod3 + phase_mod2) / 1);
-								break;
-
-							//           --[S2]-----|
-							// <-----------------|  |
-							// +--[S1]--+--[S3]--|--+--[S4]-->
-							case 5:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								set_feedback(chip, slot1, phase_mod3);
-								phase_mod2 = calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, (phase_mod3 + phase_mod2) / 1) : calculate_op(chip, slot4, (phase_mod3 + phase_mod2) / 1);
-								break;
-
-							//  --[S2]-----+--[S4]--|
-							//                      |
-							// <--------|           |
-							// +--[S1]--|--+--[S3]--+-->
-							case 6:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-								phase_mod2 = calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							//  --[S2]--+--[S4]-----|
-							//                      |
-							// <-----------------|  |
-							// +--[S1]--+--[S3]--|--+-->
-							case 7:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								set_feedback(chip, slot1, phase_mod3);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : phase_mod3;
-								phase_mod2 = calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							//  --[S3]--+--[S2]--+--[S4]--|
-							//                            |
-							// <--------|                 |
-							// +--[S1]--|-----------------+-->
-							case 8:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								phase_mod2 = calculate_op(chip, slot2, phase_mod3);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							//          <--------|
-							//          +--[S1]--|
-							//                   |
-							//  --[S3]--|        |
-							//  --[S2]--+--[S4]--+-->
-							case 9:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								phase_mod2 = calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, (phase_mod3 + phase_mod2) / 1) : calculate_op(chip, slot4, (phase_mod3 + phase_mod2) / 1);
-								break;
-
-							//              --[S4]--|
-							//              --[S2]--|
-							// <--------|           |
-							// +--[S1]--|--+--[S3]--+-->
-							case 10:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, OP_INPUT_NONE) : calculate_op(chip, slot4, OP_INPUT_NONE);
-								break;
-
-							//           --[S4]-----|
-							//           --[S2]-----|
-							// <-----------------|  |
-							// +--[S1]--+--[S3]--|--+-->
-							case 11:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								set_feedback(chip, slot1, phase_mod3);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : phase_mod3;
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, OP_INPUT_NONE) : calculate_op(chip, slot4, OP_INPUT_NONE);
-								break;
-
-							//             |--+--[S4]--|
-							// <--------|  |--+--[S3]--|
-							// +--[S1]--|--|--+--[S2]--+-->
-							case 12:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, phase_mod1) : calculate_op(chip, slot2, phase_mod1);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod1) : calculate_op(chip, slot4, phase_mod1);
-								break;
-
-							//  --[S3]--+--[S2]--|
-							//                   |
-							//  --[S4]-----------|
-							// <--------|        |
-							// +--[S1]--|--------+-->
-							case 13:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, phase_mod3) : calculate_op(chip, slot2, phase_mod3);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, OP_INPUT_NONE) : calculate_op(chip, slot4, OP_INPUT_NONE);
-								break;
-
-							//  --[S2]-----+--[S4]--|
-							//                      |
-							// <--------|  +--[S3]--|
-							// +--[S1]--|--|--------+-->
-							case 14:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-								phase_mod2 = calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, phase_mod2) : calculate_op(chip, slot4, phase_mod2);
-								break;
-
-							//  --[S4]-----|
-							//  --[S2]-----|
-							//  --[S3]-----|
-							// <--------|  |
-							// +--[S1]--|--+-->
-							case 15:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, OP_INPUT_NONE) : calculate_op(chip, slot3, OP_INPUT_NONE);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								// slot4 is carrier - use PFM if enabled
-								output4 = pfm_enabled ? calculate_op_pfm(chip, slot4, OP_INPUT_NONE) : calculate_op(chip, slot4, OP_INPUT_NONE);
-								break;
-						}
-
-						// FM output to 4 channels
-						// Apply channel levels (PAN block) - always applied per datasheet signal flow
-						INT64 ch0_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch0_level]) >> 16;
-						INT64 ch0_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch0_level]) >> 16;
-						INT64 ch0_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch0_level]) >> 16;
-						INT64 ch0_out4 = (output4 * chip->lut_attenuation[chip->slots[slot4].ch0_level]) >> 16;
-
-						INT64 ch1_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch1_level]) >> 16;
-						INT64 ch1_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch1_level]) >> 16;
-						INT64 ch1_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch1_level]) >> 16;
-						INT64 ch1_out4 = (output4 * chip->lut_attenuation[chip->slots[slot4].ch1_level]) >> 16;
-
-						INT64 ch2_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch2_level]) >> 16;
-						INT64 ch2_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch2_level]) >> 16;
-						INT64 ch2_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch2_level]) >> 16;
-						INT64 ch2_out4 = (output4 * chip->lut_attenuation[chip->slots[slot4].ch2_level]) >> 16;
-
-						INT64 ch3_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch3_level]) >> 16;
-						INT64 ch3_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch3_level]) >> 16;
-						INT64 ch3_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch3_level]) >> 16;
-						INT64 ch3_out4 = (output4 * chip->lut_attenuation[chip->slots[slot4].ch3_level]) >> 16;
-
-						mixp[i*4+0] += ch0_out1 + ch0_out2 + ch0_out3 + ch0_out4;
-						mixp[i*4+1] += ch1_out1 + ch1_out2 + ch1_out3 + ch1_out4;
-						mixp[i*4+2] += ch2_out1 + ch2_out2 + ch2_out3 + ch2_out4;
-						mixp[i*4+3] += ch3_out1 + ch3_out2 + ch3_out3 + ch3_out4;
-					}
+					FM_KERNEL kernel = fm4_kernels[pfm_enabled][chip->slots[j].algorithm];
+					update_fm(chip, kernel, j + (0*12), j + (1*12), j + (2*12), j + (3*12), mixp, proc_smpls);
 				}
 				break;
 			}
@@ -1658,74 +1924,8 @@ static void ymf271_update(void *info, UINT32 samples, DEV_SMPL** outputs)
 
 					if (chip->slots[slot1].active)
 					{
-						for (i = 0; i < proc_smpls; i++)
-						{
-							INT64 output1 = 0, output3 = 0;
-							INT64 phase_mod1, phase_mod3 = 0;
-							switch (chip->slots[slot1].algorithm & 3)
-							{
-								// <--------|
-								// +--[S1]--|--+--[S3]-->
-								case 0:
-									phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-									set_feedback(chip, slot1, phase_mod1);
-									// slot3 is carrier - use PFM if enabled
-									output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-									break;
-
-								// <-----------------|
-								// +--[S1]--+--[S3]--|-->
-								case 1:
-									phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-									phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-									set_feedback(chip, slot1, phase_mod3);
-									// slot3 is carrier - use PFM if enabled
-									output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : phase_mod3;
-									break;
-
-								//  --[S3]-----|
-								// <--------|  |
-								// +--[S1]--|--+-->
-								case 2:
-									phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-									set_feedback(chip, slot1, phase_mod1);
-									// slot1 is carrier - use PFM if enabled
-									output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-									// slot3 is carrier - use PFM if enabled
-									output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, OP_INPUT_NONE) : calculate_op(chip, slot3, OP_INPUT_NONE);
-									break;
-								//
-								// <--------|  +--[S3]--|
-								// +--[S1]--|--|--------+-->
-								case 3:
-									phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-									set_feedback(chip, slot1, phase_mod1);
-									// slot1 is carrier - use PFM if enabled
-									output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-									// slot3 is carrier - use PFM if enabled
-									output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-									break;
-							}
-
-							// FM output to 4 channels
-							// Apply channel levels (PAN block) - always applied per datasheet signal flow
-							INT64 ch0_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch0_level]) >> 16;
-							INT64 ch0_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch0_level]) >> 16;
-
-							INT64 ch1_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch1_level]) >> 16;
-							INT64 ch1_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch1_level]) >> 16;
-
-							INT64 ch2_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch2_level]) >> 16;
-							INT64 ch2_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch2_level]) >> 16;
-
-							INT64 ch3_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch3_level]) >> 16;
-							INT64 ch3_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch3_level]) >> 16;
-
-							mixp[i*4+0] += ch0_out1 + ch0_out3;
-							mixp[i*4+1] += ch1_out1 + ch1_out3;
-							mixp[i*4+2] += ch2_out1 + ch2_out3;
-							mixp[i*4+3] += ch3_out1 + ch3_out3;
-						}
+						FM_KERNEL kernel = fm2_kernels[pfm_enabled][chip->slots[slot1].algorithm & 3];
+						update_fm(chip, kernel, slot1, -1, slot3, -1, mixp, proc_smpls);
 					}
 				}
 				break;
@@ -1734,142 +1934,13 @@ static void ymf271_update(void *info, UINT32 samples, DEV_SMPL** outputs)
 			// 3 operator FM + PCM
 			case 2:
 			{
-				int slot1 = j + (0*12);
-				int slot2 = j + (1*12);
-				int slot3 = j + (2*12);
 				// PFM is only available for groups 0, 4, 8
 				UINT8 pfm_enabled = (j == 0 || j == 4 || j == 8) ? slot_group->pfm : 0;
 
-				if (chip->slots[slot1].active)
+				if (chip->slots[j].active)
 				{
-					for (i = 0; i < proc_smpls; i++)
-					{
-						INT64 output1 = 0, output2 = 0, output3 = 0;
-						INT64 phase_mod1 = 0, phase_mod3 = 0;
-						switch (chip->slots[slot1].algorithm & 7)
-						{
-							// <--------|
-							// +--[S1]--|--+--[S3]--+--[S2]-->
-							case 0:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, phase_mod3) : calculate_op(chip, slot2, phase_mod3);
-								break;
-
-							// <-----------------|
-							// +--[S1]--+--[S3]--|--+--[S2]-->
-							case 1:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								set_feedback(chip, slot1, phase_mod3);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, phase_mod3) : calculate_op(chip, slot2, phase_mod3);
-								break;
-
-							//  --[S3]-----|
-							// <--------|  |
-							// +--[S1]--|--+--[S2]-->
-							case 2:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, (phase_mod1 + phase_mod3) / 1) : calculate_op(chip, slot2, (phase_mod1 + phase_mod3) / 1);
-								break;
-
-							//  --[S3]--+--[S2]--|
-							// <--------|        |
-							// +--[S1]--|--------+-->
-							case 3:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								phase_mod3 = calculate_op(chip, slot3, OP_INPUT_NONE);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, phase_mod3) : calculate_op(chip, slot2, phase_mod3);
-								break;
-
-							//              --[S2]--|
-							// <--------|           |
-							// +--[S1]--|--+--[S3]--+-->
-							case 4:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								break;
-
-							//              --[S2]--|
-							// <-----------------|  |
-							// +--[S1]--+--[S3]--|--+-->
-							case 5:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								phase_mod3 = calculate_op(chip, slot3, phase_mod1);
-								set_feedback(chip, slot1, phase_mod3);
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : phase_mod3;
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								break;
-
-							//  --[S2]-----|
-							//  --[S3]-----|
-							// <--------|  |
-							// +--[S1]--|--+-->
-							case 6:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, OP_INPUT_NONE) : calculate_op(chip, slot3, OP_INPUT_NONE);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								break;
-
-							//              --[S2]--|
-							// <--------|  +--[S3]--|
-							// +--[S1]--|--|--------+-->
-							case 7:
-								phase_mod1 = calculate_op(chip, slot1, OP_INPUT_FEEDBACK);
-								set_feedback(chip, slot1, phase_mod1);
-								// slot1 is carrier - use PFM if enabled
-								output1 = pfm_enabled ? calculate_op_pfm(chip, slot1, OP_INPUT_FEEDBACK) : phase_mod1;
-								// slot3 is carrier - use PFM if enabled
-								output3 = pfm_enabled ? calculate_op_pfm(chip, slot3, phase_mod1) : calculate_op(chip, slot3, phase_mod1);
-								// slot2 is carrier - use PFM if enabled
-								output2 = pfm_enabled ? calculate_op_pfm(chip, slot2, OP_INPUT_NONE) : calculate_op(chip, slot2, OP_INPUT_NONE);
-								break;
-						}
-
-						// FM output to 4 channels
-						// Apply channel levels (PAN block) - always applied per signal flow
-						INT64 ch0_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch0_level]) >> 16;
-						INT64 ch0_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch0_level]) >> 16;
-						INT64 ch0_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch0_level]) >> 16;
-
-						INT64 ch1_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch1_level]) >> 16;
-						INT64 ch1_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch1_level]) >> 16;
-						INT64 ch1_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch1_level]) >> 16;
-
-						INT64 ch2_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch2_level]) >> 16;
-						INT64 ch2_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch2_level]) >> 16;
-						INT64 ch2_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch2_level]) >> 16;
-
-						INT64 ch3_out1 = (output1 * chip->lut_attenuation[chip->slots[slot1].ch3_level]) >> 16;
-						INT64 ch3_out2 = (output2 * chip->lut_attenuation[chip->slots[slot2].ch3_level]) >> 16;
-						INT64 ch3_out3 = (output3 * chip->lut_attenuation[chip->slots[slot3].ch3_level]) >> 16;
-
-						mixp[i*4+0] += ch0_out1 + ch0_out2 + ch0_out3;
-						mixp[i*4+1] += ch1_out1 + ch1_out2 + ch1_out3;
-						mixp[i*4+2] += ch2_out1 + ch2_out2 + ch2_out3;
-						mixp[i*4+3] += ch3_out1 + ch3_out2 + ch3_out3;
-					}
+					FM_KERNEL kernel = fm3_kernels[pfm_enabled][chip->slots[j].algorithm & 7];
+					update_fm(chip, kernel, j + (0*12), j + (1*12), j + (2*12), -1, mixp, proc_smpls);
 				}
 
 				update_pcm(chip, j + (3*12), chip->mix_buffer, proc_smpls);
@@ -2605,7 +2676,7 @@ static UINT8 ymf271_r(void *info, UINT8 offset)
  * For simplicity, we pre-calculate approximate F-Number offsets for a
  * representative F-Number value in each keycode range.
  */
-static void init_detune_table(YMF271Chip *chip)
+static void init_detune_table(void)
 {
 	int d, k;
 	
@@ -2691,52 +2762,43 @@ static void init_detune_table(YMF271Chip *chip)
 			double ratio = pow(2.0, cents / 1200.0) - 1.0;
 			int offset = (int)(fns * ratio + 0.5);  /* Round to nearest integer */
 			
-			chip->lut_detune[d][k] = offset * sign;
+			lut_detune[d][k] = offset * sign;
 		}
 	}
 }
 
-static void init_tables(YMF271Chip *chip)
+// called once, the tables are shared by all chips
+static void init_tables(void)
 {
 	int i,j;
-	double clock_correction;
-
-	for (i = 0; i < 8; i++)
-		chip->lut_waves[i] = (INT16*)malloc(sizeof(INT16) * SIN_LEN);
 
-	for (i = 0; i < 4*8; i++)
-		chip->lut_plfo[i>>3][i&7] = (double*)malloc(sizeof(double) * LFO_LENGTH);
-
-	for (i = 0; i < 4; i++)
-		chip->lut_alfo[i] = (int*)malloc(sizeof(int) * LFO_LENGTH);
-	
 	for (i=0; i < SIN_LEN; i++)
 	{
 		double m = sin( ((i*2)+1) * M_PI / SIN_LEN );
 		double m2 = sin( ((i*4)+1) * M_PI / SIN_LEN );
 
 		// Waveform 0: sin(wt)    (0 <= wt <= 2PI)
-		chip->lut_waves[0][i] = (INT16)(m * MAXOUT);
+		lut_waves[0][i] = (INT16)(m * MAXOUT);
 
 		// Waveform 1: sin?(wt)   (0 <= wt <= PI)     -sin?(wt)  (PI <= wt <= 2PI)
-		chip->lut_waves[1][i] = (i < (SIN_LEN/2)) ? (INT16)((m * m) * MAXOUT) : (INT16)((m * m) * MINOUT);
+		lut_waves[1][i] = (i < (SIN_LEN/2)) ? (INT16)((m * m) * MAXOUT) : (INT16)((m * m) * MINOUT);
 
 		// Waveform 2: sin(wt)    (0 <= wt <= PI)     -sin(wt)   (PI <= wt <= 2PI)
-		chip->lut_waves[2][i] = (i < (SIN_LEN/2)) ? (INT16)(m * MAXOUT) : (INT16)(-m * MAXOUT);
+		lut_waves[2][i] = (i < (SIN_LEN/2)) ? (INT16)(m * MAXOUT) : (INT16)(-m * MAXOUT);
 
 		// Waveform 3: sin(wt)    (0 <= wt <= PI)     0
-		chip->lut_waves[3][i] = (i < (SIN_LEN/2)) ? (INT16)(m * MAXOUT) : 0;
+		lut_waves[3][i] = (i < (SIN_LEN/2)) ? (INT16)(m * MAXOUT) : 0;
 
 		// Waveform 4: sin(2wt)   (0 <= wt <= PI)     0
-		chip->lut_waves[4][i] = (i < (SIN_LEN/2)) ? (INT16)(m2 * MAXOUT) : 0;
+		lut_waves[4][i] = (i < (SIN_LEN/2)) ? (INT16)(m2 * MAXOUT) : 0;
 
 		// Waveform 5: |sin(2wt)| (0 <= wt <= PI)     0
-		chip->lut_waves[5][i] = (i < (SIN_LEN/2)) ? (INT16)(fabs(m2) * MAXOUT) : 0;
+		lut_waves[5][i] = (i < (SIN_LEN/2)) ? (INT16)(fabs(m2) * MAXOUT) : 0;
 
 		// Waveform 6:     1      (0 <= wt <= 2PI)
-		chip->lut_waves[6][i] = (INT16)(1 * MAXOUT);
+		lut_waves[6][i] = (INT16)(1 * MAXOUT);
 
-		chip->lut_waves[7][i] = 0;
+		lut_waves[7][i] = 0;
 	}
 
 	for (i = 0; i < LFO_LENGTH; i++)
@@ -2765,41 +2827,50 @@ static void init_tables(YMF271Chip *chip)
 
 		for (j = 0; j < 4; j++)
 		{
-			chip->lut_plfo[j][0][i] = pow(2.0, 0.0);
-			chip->lut_plfo[j][1][i] = pow(2.0, (3.378 * plfo[j]) / 1200.0);
-			chip->lut_plfo[j][2][i] = pow(2.0, (5.0646 * plfo[j]) / 1200.0);
-			chip->lut_plfo[j][3][i] = pow(2.0, (6.7495 * plfo[j]) / 1200.0);
-			chip->lut_plfo[j][4][i] = pow(2.0, (10.1143 * plfo[j]) / 1200.0);
-			chip->lut_plfo[j][5][i] = pow(2.0, (20.1699 * plfo[j]) / 1200.0);
-			chip->lut_plfo[j][6][i] = pow(2.0, (40.1076 * plfo[j]) / 1200.0);
-			chip->lut_plfo[j][7][i] = pow(2.0, (79.307 * plfo[j]) / 1200.0);
+			lut_plfo[j][0][i] = pow(2.0, 0.0);
+			lut_plfo[j][1][i] = pow(2.0, (3.378 * plfo[j]) / 1200.0);
+			lut_plfo[j][2][i] = pow(2.0, (5.0646 * plfo[j]) / 1200.0);
+			lut_plfo[j][3][i] = pow(2.0, (6.7495 * plfo[j]) / 1200.0);
+			lut_plfo[j][4][i] = pow(2.0, (10.1143 * plfo[j]) / 1200.0);
+			lut_plfo[j][5][i] = pow(2.0, (20.1699 * plfo[j]) / 1200.0);
+			lut_plfo[j][6][i] = pow(2.0, (40.1076 * plfo[j]) / 1200.0);
+			lut_plfo[j][7][i] = pow(2.0, (79.307 * plfo[j]) / 1200.0);
 		}
 
 		// LFO amplitude modulation
-		chip->lut_alfo[0][i] = 0;
+		lut_alfo[0][i] = 0;
 
-		chip->lut_alfo[1][i] = ALFO_MAX - ((i * ALFO_MAX) / LFO_LENGTH);
+		lut_alfo[1][i] = ALFO_MAX - ((i * ALFO_MAX) / LFO_LENGTH);
 
-		chip->lut_alfo[2][i] = (i < (LFO_LENGTH/2)) ? ALFO_MAX : ALFO_MIN;
+		lut_alfo[2][i] = (i < (LFO_LENGTH/2)) ? ALFO_MAX : ALFO_MIN;
 
 		tri_wave = ((i % (LFO_LENGTH/2)) * ALFO_MAX) / (LFO_LENGTH/2);
-		chip->lut_alfo[3][i] = (i < (LFO_LENGTH/2)) ? ALFO_MAX-tri_wave : tri_wave;
+		lut_alfo[3][i] = (i < (LFO_LENGTH/2)) ? ALFO_MAX-tri_wave : tri_wave;
 	}
 	
 	for (i = 0; i < 256; i++)
 	{
-		chip->lut_env_volume[i] = (int)(65536.0 / pow(10.0, ((double)i / (256.0 / 96.0)) / 20.0));
+		lut_env_volume[i] = (int)(65536.0 / pow(10.0, ((double)i / (256.0 / 96.0)) / 20.0));
 	}
 
 	for (i = 0; i < 16; i++)
 	{
-		chip->lut_attenuation[i] = (int)(65536.0 / pow(10.0, channel_attenuation_table[i] / 20.0));
+		lut_attenuation[i] = (int)(65536.0 / pow(10.0, channel_attenuation_table[i] / 20.0));
 	}
 	for (i = 0; i < 128; i++)
 	{
 		double db = 0.75 * (double)i;
-		chip->lut_total_level[i] = (int)(65536.0 / pow(10.0, db / 20.0));
+		lut_total_level[i] = (int)(65536.0 / pow(10.0, db / 20.0));
 	}
+	
+	// Initialize detune lookup table
+	init_detune_table();
+}
+
+static void init_chip_tables(YMF271Chip *chip)
+{
+	int i;
+	double clock_correction;
 
 	// timing may use a non-standard XTAL
 	clock_correction = (double)(STD_CLOCK) / (double)(chip->clock);
@@ -2818,9 +2889,6 @@ static void init_tables(YMF271Chip *chip)
 		// decay/release rate in number of samples
 		chip->lut_dc[i] = (DCTime[i] * clock_correction * 44100.0) / 1000.0;
 	}
-	
-	// Initialize detune lookup table
-	init_detune_table(chip);
 }
 
 static UINT8 device_start_ymf271(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
@@ -2848,7 +2916,8 @@ static UINT8 device_start_ymf271(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	// Initialize envelope debug/test parameters
 	chip->debug_envelope = 0;
 
-	init_tables(chip);
+	OSOnce_Run(&tablesInit, init_tables);
+	init_chip_tables(chip);
 
 	chip->mixbuf_smpls = rate / 10;
 	chip->mix_buffer = (INT32*)malloc(chip->mixbuf_smpls*4 * sizeof(INT32));
@@ -2864,19 +2933,10 @@ static UINT8 device_start_ymf271(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 
 void device_stop_ymf271(void *info)
 {
-	int i;
 	YMF271Chip *chip = (YMF271Chip *)info;
 	
 	free(chip->mem_base);	chip->mem_base = NULL;
 	
-	for (i=0; i < 8; i++)
-		free(chip->lut_waves[i]);
-	for (i = 0; i < 4*8; i++)
-		free(chip->lut_plfo[i>>3][i&7]);
-	
-	for (i = 0; i < 4; i++)
-		free(chip->lut_alfo[i]);
-	
 	free(chip->mix_buffer);
 	free(chip->acc_buffer);
 	free(chip);
@@ -205,9 +205,12 @@ static void write_to_register(ymz280b_state *chip, UINT8 data);
 /* step size index shift table */
 static const int index_scale[8] = { 0x0e6, 0x0e6, 0x0e6, 0x0e6, 0x133, 0x199, 0x200, 0x266 };
 
-/* lookup table for the precomputed difference */
-static int diff_lookup[16];
-static UINT8 lookup_init = 0x00;	/* lookup-table is initialized */
+/* lookup table for the precomputed difference: (2 * (nib & 7) + 1), negated when bit 3 is set */
+static const int diff_lookup[16] =
+{
+	 1,  3,  5,  7,  9,  11,  13,  15,
+	-1, -3, -5, -7, -9, -11, -13, -15
+};
 
 
 INLINE UINT8 ymz280b_read_memory(ymz280b_state *chip, UINT32 offset)
@@ -299,29 +302,6 @@ static void update_irq_state_timer_common(void *param, int voicenum)
 	voice->irq_schedule = 0;
 }
 
-/**********************************************************************************************
-
-     compute_tables -- compute the difference tables
-
-***********************************************************************************************/
-
-static void compute_tables(void)
-{
-	int nib;
-
-	if (lookup_init)
-		return;
-
-	/* loop over all nibbles and compute the difference */
-	for (nib = 0; nib < 16; nib++)
-	{
-		int value = (nib & 0x07) * 2 + 1;
-		diff_lookup[nib] = (nib & 0x08) ? -value : value;
-	}
-	
-	lookup_init = 0x01;
-}
-
 
 
 /**********************************************************************************************
@@ -740,9 +720,6 @@ static UINT8 device_start_ymz280b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	if (chip == NULL)
 		return 0xFF;
 
-	/* compute ADPCM tables */
-	compute_tables();
-
 	/* initialize the rest of the structure */
 	chip->master_clock = (double)cfg->clock / 384.0;
 	chip->rate = chip->master_clock * 2.0;
@@ -26,6 +26,12 @@
 #include "RatioCntr.h"
 #include "dac_control.h"
 
+static DEVDEF_RWFUNC devFunc_DAC[] =
+{
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, daccontrol_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, daccontrol_load_state},
+	{0x00, 0x00, 0, NULL}
+};
 static DEV_DEF devDef_DAC =
 {
 	NULL, NULL, 0,
@@ -42,7 +48,7 @@ static DEV_DEF devDef_DAC =
 	NULL,	// SetLoggingCallback
 	NULL,	// LinkDevice
 	
-	NULL,	// rwFuncs
+	devFunc_DAC,	// rwFuncs
 };
 
 typedef struct
@@ -76,6 +82,8 @@ typedef struct _dac_control
 	UINT32 Frequency;	// Frequency (Hz) at which the commands are sent
 	UINT32 DataLen;		// to protect from reading beyond End Of Data
 	const UINT8* Data;
+	DAC_READ_FUNC ReadFunc;	// when set, data is read using this function instead of "Data"
+	void* ReadParam;
 	UINT32 DataStart;	// Position where to start
 	UINT8 StepSize;		// usually 1, set to 2 for L/R interleaved data
 	UINT8 StepBase;		// usually 0, set to 0/1 for L/R interleaved data
@@ -103,7 +111,16 @@ INLINE void daccontrol_SendCommand(dac_control* chip)
 	if (chip->DataStart + chip->RealPos >= chip->DataLen)
 		return;
 	
-	ChipData = &chip->Data[chip->DataStart + chip->RealPos];
+	if (chip->ReadFunc != NULL)
+	{
+		ChipData = chip->ReadFunc(chip->ReadParam, chip->DataStart + chip->RealPos, chip->CmdSize);
+		if (ChipData == NULL)
+			return;
+	}
+	else
+	{
+		ChipData = &chip->Data[chip->DataStart + chip->RealPos];
+	}
 	switch(chip->DstChipType)
 	{
 	case DEVID_32X_PWM:	// 4-bit Register, 12-bit Data
@@ -380,6 +397,8 @@ void device_reset_daccontrol(void* info)
 	chip->Frequency = 0;
 	chip->DataLen = 0x00;
 	chip->Data = NULL;
+	chip->ReadFunc = NULL;
+	chip->ReadParam = NULL;
 	chip->DataStart = 0x00;
 	chip->StepSize = 0x00;
 	chip->StepBase = 0x00;
@@ -449,7 +468,7 @@ void daccontrol_set_data(void* info, UINT8* Data, UINT32 DataLen, UINT8 StepSize
 	if (chip->Running & 0x80)
 		return;
 	
-	if (DataLen && Data != NULL)
+	if (DataLen && (Data != NULL || chip->ReadFunc != NULL))
 	{
 		chip->DataLen = DataLen;
 		chip->Data = Data;
@@ -474,7 +493,7 @@ void daccontrol_refresh_data(void* info, UINT8* Data, UINT32 DataLen)
 	if (chip->Running & 0x80)
 		return;
 	
-	if (DataLen && Data != NULL)
+	if (DataLen && (Data != NULL || chip->ReadFunc != NULL))
 	{
 		chip->DataLen = DataLen;
 		chip->Data = Data;
@@ -488,6 +507,18 @@ void daccontrol_refresh_data(void* info, UINT8* Data, UINT32 DataLen)
 	return;
 }
 
+void daccontrol_set_read_callback(void* info, DAC_READ_FUNC func, void* param)
+{
+	// Note: Call this before daccontrol_set_data/daccontrol_refresh_data.
+	//       The data pointer may be NULL when using a read callback.
+	dac_control* chip = (dac_control*)info;
+	
+	chip->ReadFunc = func;
+	chip->ReadParam = param;
+	
+	return;
+}
+
 void daccontrol_set_frequency(void* info, UINT32 Frequency)
 {
 	dac_control* chip = (dac_control*)info;
@@ -565,3 +596,59 @@ void daccontrol_stop(void* info)
 	
 	return;
 }
+
+// Returns the number of samples until the stream sends its next command(s), or (UINT32)-1 if it won't send any.
+// Calling daccontrol_update() with (samples <= return value) will send commands only
+// at the end of the last sample, so chips can be rendered in blocks without losing accuracy.
+UINT32 daccontrol_samples_to_next_cmd(void* info)
+{
+	dac_control* chip = (dac_control*)info;
+	RC_TYPE remVal;
+	RC_TYPE smplCnt;
+	
+	if (chip->Running & 0x80)	// disabled
+		return (UINT32)-1;
+	if (! (chip->Running & 0x01))	// stopped
+		return (UINT32)-1;
+	if (! chip->stepCntr.inc)
+		return (UINT32)-1;
+	
+	if (chip->stepCntr.val >= ((RC_TYPE)1 << RC_SHIFT))
+		return 1;	// command is pending already (happens with Frequency > sampleRate)
+	remVal = ((RC_TYPE)1 << RC_SHIFT) - chip->stepCntr.val;
+	smplCnt = (remVal + chip->stepCntr.inc - 1) / chip->stepCntr.inc;
+	if (smplCnt >= (UINT32)-1)
+		return (UINT32)-1 - 1;
+	return (UINT32)smplCnt;
+}
+
+UINT32 daccontrol_save_state(void* info, UINT32 bufSize, void* buffer)
+{
+	return devstate_save_block(info, sizeof(dac_control), bufSize, buffer);
+}
+
+// Note: The state can be restored into any DAC stream instance.
+//       The data pointer and read callback are kept and should be fixed using daccontrol_set_read_callback()/daccontrol_refresh_data() afterwards.
+UINT8 daccontrol_load_state(void* info, UINT32 dataSize, const void* data)
+{
+	dac_control* chip = (dac_control*)info;
+	const UINT8* dataPtr;
+	UINT32 dataLen;
+	DAC_READ_FUNC readFunc;
+	void* readParam;
+	
+	if (dataSize != sizeof(dac_control))
+		return 0xFF;
+	
+	dataPtr = chip->Data;
+	dataLen = chip->DataLen;
+	readFunc = chip->ReadFunc;
+	readParam = chip->ReadParam;
+	memcpy(chip, data, sizeof(dac_control));
+	chip->Data = dataPtr;
+	chip->DataLen = dataLen;
+	chip->ReadFunc = readFunc;
+	chip->ReadParam = readParam;
+	
+	return 0x00;
+}
@@ -9,6 +9,10 @@ extern "C"
 #include "../stdtype.h"
 #include "EmuStructs.h"
 
+// Reads "len" bytes of stream data at "pos". Returns NULL if the data isn't available.
+// The pointer has to stay valid until the next call.
+typedef const UINT8* (*DAC_READ_FUNC)(void* userParam, UINT32 pos, UINT32 len);
+
 void daccontrol_update(void* info, UINT32 samples, DEV_SMPL** dummy);
 UINT8 device_start_daccontrol(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 void device_stop_daccontrol(void* info);
@@ -17,9 +21,13 @@ void device_reset_daccontrol(void* info);
 void daccontrol_setup_chip(void* info, DEV_INFO* devInf, UINT8 ChType, UINT16 Command);
 void daccontrol_set_data(void* info, UINT8* Data, UINT32 DataLen, UINT8 StepSize, UINT8 StepBase);
 void daccontrol_refresh_data(void* info, UINT8* Data, UINT32 DataLen);
+void daccontrol_set_read_callback(void* info, DAC_READ_FUNC func, void* param);
 void daccontrol_set_frequency(void* info, UINT32 Frequency);
 void daccontrol_start(void* info, UINT32 DataPos, UINT8 LenMode, UINT32 Length);
 void daccontrol_stop(void* info);
+UINT32 daccontrol_samples_to_next_cmd(void* info);
+UINT32 daccontrol_save_state(void* info, UINT32 bufSize, void* buffer);
+UINT8 daccontrol_load_state(void* info, UINT32 dataSize, const void* data);
 
 #define DCTRL_LMODE_IGNORE	0x00
 #define DCTRL_LMODE_CMDS	0x01
@@ -0,0 +1,802 @@
+#include <stddef.h>
+#include <string.h>	// for memcpy
+
+#include "../stdtype.h"
+#include "../common_def.h"
+#include "snddef.h"
+#include "Resampler.h"
+#include "mixkernels.h"
+#include "../utils/OSOnce.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MIXK_X86
+#define MIXK_TARGET_SSE41	__attribute__((target("sse4.1")))
+#define MIXK_TARGET_AVX2	__attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (_MSC_VER >= 1700) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define MIXK_X86
+#define MIXK_TARGET_SSE41
+#define MIXK_TARGET_AVX2
+#endif
+
+typedef void (*MIXK_SCALEACC)(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR, UINT32 length, INT32 volL, INT32 volR);
+typedef void (*MIXK_SCALEACC_MONO)(DEV_SMPL* dst, const DEV_SMPL* src, UINT32 length, INT32 vol);
+typedef void (*MIXK_INTERPACC)(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+								const UINT32* pos, const UINT32* frac, UINT8 fracBits,
+								UINT32 length, INT32 volL, INT32 volR);
+typedef void (*MIXK_VOLRAMP)(WAVE_32BS* buf, const INT32* volume, UINT32 length);
+
+typedef struct _mix_kernel_funcs
+{
+	MIXK_SCALEACC scaleAcc;
+	MIXK_SCALEACC_MONO scaleAccMono;
+	MIXK_INTERPACC interpAcc;
+	MIXK_VOLRAMP volRamp;
+	MIXK_DOTS16_FUNC dotS16;
+	MIXK_PACK_FUNC packS16;
+	MIXK_PACK_FUNC packS24;
+	MIXK_PACK_FUNC packS32;
+	MIXK_PACK_FUNC packF32;
+} MIXK_FUNCS;
+
+static MIXK_FUNCS mixFuncs;
+static OS_ONCE mixFuncsInit = OS_ONCE_INIT;
+
+
+// ---- generic versions ----
+// Note: These are written to be auto-vectorizable. (e.g. for NEON)
+static void ScaleAcc_C(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR, UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		dst[curSmpl].L += srcL[curSmpl] * volL;
+		dst[curSmpl].R += srcR[curSmpl] * volR;
+	}
+	return;
+}
+
+static void ScaleAccMono_C(DEV_SMPL* dst, const DEV_SMPL* src, UINT32 length, INT32 vol)
+{
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+		dst[curSmpl] += src[curSmpl] * vol;
+	return;
+}
+
+static void InterpAcc_C(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+						const UINT32* pos, const UINT32* frac, UINT8 fracBits,
+						UINT32 length, INT32 volL, INT32 volR)
+{
+	INT64 fact = (INT64)1 << fracBits;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		UINT32 idx = pos[curSmpl];
+		INT64 smpFrc = frac[curSmpl];
+		INT64 tempL = (INT64)srcL[idx] * (fact - smpFrc) + (INT64)srcL[idx + 1] * smpFrc;
+		INT64 tempR = (INT64)srcR[idx] * (fact - smpFrc) + (INT64)srcR[idx + 1] * smpFrc;
+		dst[curSmpl].L += (INT32)(tempL * volL / fact);
+		dst[curSmpl].R += (INT32)(tempR * volR / fact);
+	}
+	return;
+}
+
+static void ApplyVolRamp_C(WAVE_32BS* buf, const INT32* volume, UINT32 length)
+{
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		buf[curSmpl].L = (INT32)(((INT64)buf[curSmpl].L * volume[curSmpl]) >> 16);
+		buf[curSmpl].R = (INT32)(((INT64)buf[curSmpl].R * volume[curSmpl]) >> 16);
+	}
+	return;
+}
+
+static INT32 DotS16_C(const INT16* a, const INT16* b, UINT32 length)
+{
+	UINT32 sum = 0;	// unsigned, so that overflows wrap around like in the SIMD versions
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+		sum += (UINT32)(a[curSmpl] * b[curSmpl]);
+	return (INT32)sum;
+}
+
+INLINE void ApplyVolInv(const WAVE_32BS* src, INT32 volume, UINT8 invert, INT32* smplL, INT32* smplR)
+{
+	INT32 valL = (INT32)(((INT64)src->L * volume) >> 16);
+	INT32 valR = (INT32)(((INT64)src->R * volume) >> 16);
+	*smplL = (invert & 0x01) ? -valL : valL;
+	*smplR = (invert & 0x02) ? -valR : valR;
+	return;
+}
+
+INLINE INT32 Clamp24(INT32 value)
+{
+	if (value < -0x800000)
+		return -0x800000;
+	else if (value > +0x7FFFFF)
+		return +0x7FFFFF;
+	return value;
+}
+
+void MixK_Pack_U8(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	INT32 smpl[2];
+	UINT8 curChn;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		ApplyVolInv(&src[curSmpl], volume, invert, &smpl[0], &smpl[1]);
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			INT32 value = smpl[curChn] >> 16;	// 24 bit -> 8 bit
+			if (value < -0x80)
+				value = -0x80;
+			else if (value > +0x7F)
+				value = +0x7F;
+			outData[curSmpl * 2 + curChn] = (UINT8)(0x80 + value);
+		}
+	}
+	return;
+}
+
+static void Pack_S16_C(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	INT32 smpl[2];
+	UINT8 curChn;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		ApplyVolInv(&src[curSmpl], volume, invert, &smpl[0], &smpl[1]);
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			INT32 value = smpl[curChn] >> 8;	// 24 bit -> 16 bit
+			INT16 v;
+			if (value < -0x8000)
+				value = -0x8000;
+			else if (value > +0x7FFF)
+				value = +0x7FFF;
+			v = (INT16)value;
+			memcpy(&outData[(curSmpl * 2 + curChn) * 2], &v, sizeof(v));
+		}
+	}
+	return;
+}
+
+static void Pack_S24_C(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	INT32 smpl[2];
+	UINT8 curChn;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		ApplyVolInv(&src[curSmpl], volume, invert, &smpl[0], &smpl[1]);
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			INT32 value = Clamp24(smpl[curChn]);
+			UINT8* buffer = &outData[(curSmpl * 2 + curChn) * 3];
+#if defined(VGM_LITTLE_ENDIAN)
+			buffer[0] = ( value       ) & 0xFF;
+			buffer[1] = ( value >> 8  ) & 0xFF;
+			buffer[2] = ( value >> 16 ) & 0xFF;
+#elif defined(VGM_BIG_ENDIAN)
+			buffer[0] = ( value >> 16 ) & 0xFF;
+			buffer[1] = ( value >> 8  ) & 0xFF;
+			buffer[2] = ( value       ) & 0xFF;
+#else
+#error unknown endianness
+#endif
+		}
+	}
+	return;
+}
+
+static void Pack_S32_C(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	INT32 smpl[2];
+	UINT8 curChn;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		ApplyVolInv(&src[curSmpl], volume, invert, &smpl[0], &smpl[1]);
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			// internal scale is 24-bit, so limit to that
+			INT32 value = Clamp24(smpl[curChn]) * (1 << 8);	// 24 bit -> 32 bit
+			memcpy(&outData[(curSmpl * 2 + curChn) * 4], &value, sizeof(value));
+		}
+	}
+	return;
+}
+
+static void Pack_F32_C(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	INT32 smpl[2];
+	UINT8 curChn;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		ApplyVolInv(&src[curSmpl], volume, invert, &smpl[0], &smpl[1]);
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			// limiting not required here
+			float v = smpl[curChn] / (float)0x800000;
+			memcpy(&outData[(curSmpl * 2 + curChn) * 4], &v, sizeof(v));
+		}
+	}
+	return;
+}
+
+#ifdef MIXK_X86
+// ---- SSE4.1 versions ----
+MIXK_TARGET_SSE41 static void ScaleAcc_SSE41(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR, UINT32 length, INT32 volL, INT32 volR)
+{
+	__m128i vL = _mm_set1_epi32(volL);
+	__m128i vR = _mm_set1_epi32(volR);
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m128i* dstPtr = (__m128i*)&dst[curSmpl];
+		__m128i smplL = _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)&srcL[curSmpl]), vL);
+		__m128i smplR = _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)&srcR[curSmpl]), vR);
+		_mm_storeu_si128(&dstPtr[0], _mm_add_epi32(_mm_loadu_si128(&dstPtr[0]), _mm_unpacklo_epi32(smplL, smplR)));
+		_mm_storeu_si128(&dstPtr[1], _mm_add_epi32(_mm_loadu_si128(&dstPtr[1]), _mm_unpackhi_epi32(smplL, smplR)));
+	}
+	ScaleAcc_C(&dst[curSmpl], &srcL[curSmpl], &srcR[curSmpl], length - curSmpl, volL, volR);
+	return;
+}
+
+MIXK_TARGET_SSE41 static void ScaleAccMono_SSE41(DEV_SMPL* dst, const DEV_SMPL* src, UINT32 length, INT32 vol)
+{
+	__m128i v = _mm_set1_epi32(vol);
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m128i* dstPtr = (__m128i*)&dst[curSmpl];
+		__m128i smpl = _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)&src[curSmpl]), v);
+		_mm_storeu_si128(dstPtr, _mm_add_epi32(_mm_loadu_si128(dstPtr), smpl));
+	}
+	ScaleAccMono_C(&dst[curSmpl], &src[curSmpl], length - curSmpl, vol);
+	return;
+}
+
+// The interpolation is done using doubles. This is exact, because all intermediate values
+// are smaller than 2^53 as long as the result fits into 32 bits. Converting with truncation
+// gives the same rounding as the integer division.
+MIXK_TARGET_SSE41 static void InterpAcc_SSE41(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+											const UINT32* pos, const UINT32* frac, UINT8 fracBits,
+											UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 fact = (UINT32)1 << fracBits;
+	__m128d vol = _mm_set_pd((double)volR, (double)volL);
+	__m128d scale = _mm_set1_pd(1.0 / fact);
+	UINT32 curSmpl;
+	
+	vol = _mm_mul_pd(vol, scale);	// exact, as scale is a power of 2
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		UINT32 idx = pos[curSmpl];
+		__m128d smpA = _mm_cvtepi32_pd(_mm_set_epi32(0, 0, srcR[idx + 0], srcL[idx + 0]));
+		__m128d smpB = _mm_cvtepi32_pd(_mm_set_epi32(0, 0, srcR[idx + 1], srcL[idx + 1]));
+		__m128d wgtA = _mm_set1_pd((double)(fact - frac[curSmpl]));
+		__m128d wgtB = _mm_set1_pd((double)frac[curSmpl]);
+		__m128d res = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(smpA, wgtA), _mm_mul_pd(smpB, wgtB)), vol);
+		__m128i* dstPtr = (__m128i*)&dst[curSmpl];
+		_mm_storel_epi64(dstPtr, _mm_add_epi32(_mm_loadl_epi64(dstPtr), _mm_cvttpd_epi32(res)));
+	}
+	return;
+}
+
+// returns (INT32)(((INT64)smpl * volume) >> 16) for all 4 values
+MIXK_TARGET_SSE41 static INT32 DotS16_SSE41(const INT16* a, const INT16* b, UINT32 length)
+{
+	__m128i sum = _mm_setzero_si128();
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 8 <= length; curSmpl += 8)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*)&a[curSmpl]);
+		__m128i vb = _mm_loadu_si128((const __m128i*)&b[curSmpl]);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(va, vb));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return (INT32)((UINT32)_mm_cvtsi128_si32(sum) + (UINT32)DotS16_C(&a[curSmpl], &b[curSmpl], length - curSmpl));
+}
+
+MIXK_TARGET_SSE41 static __m128i ApplyVol_SSE41(__m128i smpl, __m128i volume)
+{
+	__m128i prodEven = _mm_mul_epi32(smpl, volume);	// values 0, 2 -> 64 bit
+	__m128i prodOdd = _mm_mul_epi32(_mm_srli_epi64(smpl, 32), volume);	// values 1, 3 -> 64 bit
+	// We only need bits 16..47 of the products, so logical shifts are fine.
+	prodEven = _mm_srli_epi64(prodEven, 16);
+	prodOdd = _mm_slli_epi64(prodOdd, 16);
+	return _mm_blend_epi16(prodEven, prodOdd, 0xCC);
+}
+
+MIXK_TARGET_SSE41 static void Pack_S16_SSE41(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m128i vol = _mm_set1_epi32(volume);
+	__m128i invMask = _mm_set_epi32((invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0,
+									(invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m128i smpl0 = ApplyVol_SSE41(_mm_loadu_si128((const __m128i*)&src[curSmpl + 0]), vol);
+		__m128i smpl1 = ApplyVol_SSE41(_mm_loadu_si128((const __m128i*)&src[curSmpl + 2]), vol);
+		smpl0 = _mm_sub_epi32(_mm_xor_si128(smpl0, invMask), invMask);
+		smpl1 = _mm_sub_epi32(_mm_xor_si128(smpl1, invMask), invMask);
+		smpl0 = _mm_srai_epi32(smpl0, 8);	// 24 bit -> 16 bit
+		smpl1 = _mm_srai_epi32(smpl1, 8);
+		_mm_storeu_si128((__m128i*)&outData[curSmpl * 4], _mm_packs_epi32(smpl0, smpl1));
+	}
+	Pack_S16_C(&outData[curSmpl * 4], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_SSE41 static void Pack_S32_SSE41(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m128i vol = _mm_set1_epi32(volume);
+	__m128i invMask = _mm_set_epi32((invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0,
+									(invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0);
+	__m128i minVal = _mm_set1_epi32(-0x800000);
+	__m128i maxVal = _mm_set1_epi32(+0x7FFFFF);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		__m128i smpl = ApplyVol_SSE41(_mm_loadu_si128((const __m128i*)&src[curSmpl]), vol);
+		smpl = _mm_sub_epi32(_mm_xor_si128(smpl, invMask), invMask);
+		smpl = _mm_min_epi32(_mm_max_epi32(smpl, minVal), maxVal);
+		_mm_storeu_si128((__m128i*)&outData[curSmpl * 8], _mm_slli_epi32(smpl, 8));
+	}
+	Pack_S32_C(&outData[curSmpl * 8], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_SSE41 static void Pack_S24_SSE41(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m128i vol = _mm_set1_epi32(volume);
+	__m128i invMask = _mm_set_epi32((invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0,
+									(invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0);
+	__m128i minVal = _mm_set1_epi32(-0x800000);
+	__m128i maxVal = _mm_set1_epi32(+0x7FFFFF);
+	// take the lower 3 bytes of each 32-bit value (little endian)
+	__m128i packMask = _mm_set_epi8(-1, -1, -1, -1, 14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m128i smpl0 = ApplyVol_SSE41(_mm_loadu_si128((const __m128i*)&src[curSmpl + 0]), vol);
+		__m128i smpl1 = ApplyVol_SSE41(_mm_loadu_si128((const __m128i*)&src[curSmpl + 2]), vol);
+		smpl0 = _mm_sub_epi32(_mm_xor_si128(smpl0, invMask), invMask);
+		smpl1 = _mm_sub_epi32(_mm_xor_si128(smpl1, invMask), invMask);
+		smpl0 = _mm_shuffle_epi8(_mm_min_epi32(_mm_max_epi32(smpl0, minVal), maxVal), packMask);
+		smpl1 = _mm_shuffle_epi8(_mm_min_epi32(_mm_max_epi32(smpl1, minVal), maxVal), packMask);
+		// 12 + 12 bytes -> write 16 + 8 bytes
+		_mm_storeu_si128((__m128i*)&outData[curSmpl * 6 + 0], _mm_or_si128(smpl0, _mm_slli_si128(smpl1, 12)));
+		_mm_storel_epi64((__m128i*)&outData[curSmpl * 6 + 16], _mm_srli_si128(smpl1, 4));
+	}
+	Pack_S24_C(&outData[curSmpl * 6], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_SSE41 static void Pack_F32_SSE41(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m128i vol = _mm_set1_epi32(volume);
+	__m128i invMask = _mm_set_epi32((invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0,
+									(invert & 0x02) ? -1 : 0, (invert & 0x01) ? -1 : 0);
+	// multiplying with the reciprocal is exact, as it is a power of 2
+	__m128 scale = _mm_set1_ps(1.0f / 0x800000);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		__m128i smpl = ApplyVol_SSE41(_mm_loadu_si128((const __m128i*)&src[curSmpl]), vol);
+		smpl = _mm_sub_epi32(_mm_xor_si128(smpl, invMask), invMask);
+		_mm_storeu_ps((float*)&outData[curSmpl * 8], _mm_mul_ps(_mm_cvtepi32_ps(smpl), scale));
+	}
+	Pack_F32_C(&outData[curSmpl * 8], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_SSE41 static void ApplyVolRamp_SSE41(WAVE_32BS* buf, const INT32* volume, UINT32 length)
+{
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		__m128i* bufPtr = (__m128i*)&buf[curSmpl];
+		// ApplyVol_SSE41 uses the volume values 0 and 2 -> (vol0, x, vol1, x)
+		__m128i vol = _mm_cvtepu32_epi64(_mm_loadl_epi64((const __m128i*)&volume[curSmpl]));
+		_mm_storeu_si128(bufPtr, ApplyVol_SSE41(_mm_loadu_si128(bufPtr), vol));
+	}
+	ApplyVolRamp_C(&buf[curSmpl], &volume[curSmpl], length - curSmpl);
+	return;
+}
+
+// ---- AVX2 versions ----
+MIXK_TARGET_AVX2 static void ScaleAcc_AVX2(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR, UINT32 length, INT32 volL, INT32 volR)
+{
+	__m256i vL = _mm256_set1_epi32(volL);
+	__m256i vR = _mm256_set1_epi32(volR);
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 8 <= length; curSmpl += 8)
+	{
+		__m256i* dstPtr = (__m256i*)&dst[curSmpl];
+		__m256i smplL = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&srcL[curSmpl]), vL);
+		__m256i smplR = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&srcR[curSmpl]), vR);
+		__m256i lrLo = _mm256_unpacklo_epi32(smplL, smplR);	// samples 0, 1 | 4, 5
+		__m256i lrHi = _mm256_unpackhi_epi32(smplL, smplR);	// samples 2, 3 | 6, 7
+		_mm256_storeu_si256(&dstPtr[0], _mm256_add_epi32(_mm256_loadu_si256(&dstPtr[0]),
+							_mm256_permute2x128_si256(lrLo, lrHi, 0x20)));
+		_mm256_storeu_si256(&dstPtr[1], _mm256_add_epi32(_mm256_loadu_si256(&dstPtr[1]),
+							_mm256_permute2x128_si256(lrLo, lrHi, 0x31)));
+	}
+	ScaleAcc_C(&dst[curSmpl], &srcL[curSmpl], &srcR[curSmpl], length - curSmpl, volL, volR);
+	return;
+}
+
+MIXK_TARGET_AVX2 static void ScaleAccMono_AVX2(DEV_SMPL* dst, const DEV_SMPL* src, UINT32 length, INT32 vol)
+{
+	__m256i v = _mm256_set1_epi32(vol);
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 8 <= length; curSmpl += 8)
+	{
+		__m256i* dstPtr = (__m256i*)&dst[curSmpl];
+		__m256i smpl = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&src[curSmpl]), v);
+		_mm256_storeu_si256(dstPtr, _mm256_add_epi32(_mm256_loadu_si256(dstPtr), smpl));
+	}
+	ScaleAccMono_C(&dst[curSmpl], &src[curSmpl], length - curSmpl, vol);
+	return;
+}
+
+// see InterpAcc_SSE41 for notes, this version processes 2 samples at once
+MIXK_TARGET_AVX2 static void InterpAcc_AVX2(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+											const UINT32* pos, const UINT32* frac, UINT8 fracBits,
+											UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 fact = (UINT32)1 << fracBits;
+	__m256d vol = _mm256_set_pd((double)volR, (double)volL, (double)volR, (double)volL);
+	UINT32 curSmpl;
+	
+	vol = _mm256_mul_pd(vol, _mm256_set1_pd(1.0 / fact));
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		UINT32 idx0 = pos[curSmpl + 0];
+		UINT32 idx1 = pos[curSmpl + 1];
+		__m256d smpA = _mm256_cvtepi32_pd(_mm_set_epi32(srcR[idx1 + 0], srcL[idx1 + 0], srcR[idx0 + 0], srcL[idx0 + 0]));
+		__m256d smpB = _mm256_cvtepi32_pd(_mm_set_epi32(srcR[idx1 + 1], srcL[idx1 + 1], srcR[idx0 + 1], srcL[idx0 + 1]));
+		double frc0 = (double)frac[curSmpl + 0];
+		double frc1 = (double)frac[curSmpl + 1];
+		__m256d wgtA = _mm256_set_pd(fact - frc1, fact - frc1, fact - frc0, fact - frc0);
+		__m256d wgtB = _mm256_set_pd(frc1, frc1, frc0, frc0);
+		__m256d res = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(smpA, wgtA), _mm256_mul_pd(smpB, wgtB)), vol);
+		__m128i* dstPtr = (__m128i*)&dst[curSmpl];
+		_mm_storeu_si128(dstPtr, _mm_add_epi32(_mm_loadu_si128(dstPtr), _mm256_cvttpd_epi32(res)));
+	}
+	InterpAcc_C(&dst[curSmpl], srcL, srcR, &pos[curSmpl], &frac[curSmpl], fracBits, length - curSmpl, volL, volR);
+	return;
+}
+
+MIXK_TARGET_AVX2 static INT32 DotS16_AVX2(const INT16* a, const INT16* b, UINT32 length)
+{
+	__m256i sum = _mm256_setzero_si256();
+	__m128i sum128;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 16 <= length; curSmpl += 16)
+	{
+		__m256i va = _mm256_loadu_si256((const __m256i*)&a[curSmpl]);
+		__m256i vb = _mm256_loadu_si256((const __m256i*)&b[curSmpl]);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(va, vb));
+	}
+	if (curSmpl + 8 <= length)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*)&a[curSmpl]);
+		__m128i vb = _mm_loadu_si128((const __m128i*)&b[curSmpl]);
+		sum = _mm256_add_epi32(sum, _mm256_castsi128_si256(_mm_madd_epi16(va, vb)));
+		curSmpl += 8;
+	}
+	sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+	return (INT32)((UINT32)_mm_cvtsi128_si32(sum128) + (UINT32)DotS16_C(&a[curSmpl], &b[curSmpl], length - curSmpl));
+}
+
+MIXK_TARGET_AVX2 static __m256i ApplyVol_AVX2(__m256i smpl, __m256i volume)
+{
+	__m256i prodEven = _mm256_mul_epi32(smpl, volume);
+	__m256i prodOdd = _mm256_mul_epi32(_mm256_srli_epi64(smpl, 32), volume);
+	prodEven = _mm256_srli_epi64(prodEven, 16);
+	prodOdd = _mm256_slli_epi64(prodOdd, 16);
+	return _mm256_blend_epi32(prodEven, prodOdd, 0xAA);
+}
+
+MIXK_TARGET_AVX2 static void Pack_S16_AVX2(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m256i vol = _mm256_set1_epi32(volume);
+	INT32 invL = (invert & 0x01) ? -1 : 0;
+	INT32 invR = (invert & 0x02) ? -1 : 0;
+	__m256i invMask = _mm256_set_epi32(invR, invL, invR, invL, invR, invL, invR, invL);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 8 <= length; curSmpl += 8)
+	{
+		__m256i smpl0 = ApplyVol_AVX2(_mm256_loadu_si256((const __m256i*)&src[curSmpl + 0]), vol);
+		__m256i smpl1 = ApplyVol_AVX2(_mm256_loadu_si256((const __m256i*)&src[curSmpl + 4]), vol);
+		smpl0 = _mm256_sub_epi32(_mm256_xor_si256(smpl0, invMask), invMask);
+		smpl1 = _mm256_sub_epi32(_mm256_xor_si256(smpl1, invMask), invMask);
+		smpl0 = _mm256_srai_epi32(smpl0, 8);	// 24 bit -> 16 bit
+		smpl1 = _mm256_srai_epi32(smpl1, 8);
+		// packs works on 128-bit lanes: (0-1, 4-5 | 2-3, 6-7) -> reorder 64-bit blocks
+		_mm256_storeu_si256((__m256i*)&outData[curSmpl * 4],
+			_mm256_permute4x64_epi64(_mm256_packs_epi32(smpl0, smpl1), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	Pack_S16_SSE41(&outData[curSmpl * 4], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_AVX2 static void Pack_S32_AVX2(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m256i vol = _mm256_set1_epi32(volume);
+	INT32 invL = (invert & 0x01) ? -1 : 0;
+	INT32 invR = (invert & 0x02) ? -1 : 0;
+	__m256i invMask = _mm256_set_epi32(invR, invL, invR, invL, invR, invL, invR, invL);
+	__m256i minVal = _mm256_set1_epi32(-0x800000);
+	__m256i maxVal = _mm256_set1_epi32(+0x7FFFFF);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m256i smpl = ApplyVol_AVX2(_mm256_loadu_si256((const __m256i*)&src[curSmpl]), vol);
+		smpl = _mm256_sub_epi32(_mm256_xor_si256(smpl, invMask), invMask);
+		smpl = _mm256_min_epi32(_mm256_max_epi32(smpl, minVal), maxVal);
+		_mm256_storeu_si256((__m256i*)&outData[curSmpl * 8], _mm256_slli_epi32(smpl, 8));
+	}
+	Pack_S32_C(&outData[curSmpl * 8], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_AVX2 static void Pack_S24_AVX2(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m256i vol = _mm256_set1_epi32(volume);
+	INT32 invL = (invert & 0x01) ? -1 : 0;
+	INT32 invR = (invert & 0x02) ? -1 : 0;
+	__m256i invMask = _mm256_set_epi32(invR, invL, invR, invL, invR, invL, invR, invL);
+	__m256i minVal = _mm256_set1_epi32(-0x800000);
+	__m256i maxVal = _mm256_set1_epi32(+0x7FFFFF);
+	__m256i packMask = _mm256_set_epi8(-1, -1, -1, -1, 14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0,
+										-1, -1, -1, -1, 14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0);
+	__m256i laneMerge = _mm256_set_epi32(7, 7, 6, 5, 4, 2, 1, 0);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m256i smpl = ApplyVol_AVX2(_mm256_loadu_si256((const __m256i*)&src[curSmpl]), vol);
+		smpl = _mm256_sub_epi32(_mm256_xor_si256(smpl, invMask), invMask);
+		smpl = _mm256_min_epi32(_mm256_max_epi32(smpl, minVal), maxVal);
+		// 12 bytes per lane -> 24 contiguous bytes
+		smpl = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(smpl, packMask), laneMerge);
+		_mm_storeu_si128((__m128i*)&outData[curSmpl * 6 + 0], _mm256_castsi256_si128(smpl));
+		_mm_storel_epi64((__m128i*)&outData[curSmpl * 6 + 16], _mm256_extracti128_si256(smpl, 1));
+	}
+	Pack_S24_SSE41(&outData[curSmpl * 6], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_AVX2 static void Pack_F32_AVX2(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	__m256i vol = _mm256_set1_epi32(volume);
+	INT32 invL = (invert & 0x01) ? -1 : 0;
+	INT32 invR = (invert & 0x02) ? -1 : 0;
+	__m256i invMask = _mm256_set_epi32(invR, invL, invR, invL, invR, invL, invR, invL);
+	__m256 scale = _mm256_set1_ps(1.0f / 0x800000);
+	UINT8* outData = (UINT8*)dst;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m256i smpl = ApplyVol_AVX2(_mm256_loadu_si256((const __m256i*)&src[curSmpl]), vol);
+		smpl = _mm256_sub_epi32(_mm256_xor_si256(smpl, invMask), invMask);
+		_mm256_storeu_ps((float*)&outData[curSmpl * 8], _mm256_mul_ps(_mm256_cvtepi32_ps(smpl), scale));
+	}
+	Pack_F32_C(&outData[curSmpl * 8], &src[curSmpl], length - curSmpl, volume, invert);
+	return;
+}
+
+MIXK_TARGET_AVX2 static void ApplyVolRamp_AVX2(WAVE_32BS* buf, const INT32* volume, UINT32 length)
+{
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m256i* bufPtr = (__m256i*)&buf[curSmpl];
+		__m256i vol = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*)&volume[curSmpl]));
+		_mm256_storeu_si256(bufPtr, ApplyVol_AVX2(_mm256_loadu_si256(bufPtr), vol));
+	}
+	ApplyVolRamp_C(&buf[curSmpl], &volume[curSmpl], length - curSmpl);
+	return;
+}
+#endif	// MIXK_X86
+
+UINT8 MixK_GetCPUFeatures(void)
+{
+#if defined(MIXK_X86) && defined(__GNUC__)
+	UINT8 features = 0x00;
+	
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1"))
+		features |= MIXK_CPU_SSE41;
+	if (__builtin_cpu_supports("avx2"))
+		features |= MIXK_CPU_AVX2;
+	return features;
+#elif defined(MIXK_X86)
+	UINT8 features = 0x00;
+	int cpuInfo[4];
+	int maxLeaf;
+	
+	__cpuid(cpuInfo, 0);
+	maxLeaf = cpuInfo[0];
+	if (maxLeaf < 1)
+		return 0x00;
+	__cpuid(cpuInfo, 1);
+	if (cpuInfo[2] & (1 << 19))
+		features |= MIXK_CPU_SSE41;
+	if ((cpuInfo[2] & (1 << 27)) == 0 || (cpuInfo[2] & (1 << 28)) == 0)
+		return features;	// no OSXSAVE or no AVX
+	if ((_xgetbv(0) & 0x06) != 0x06)
+		return features;	// OS doesn't save YMM registers
+	if (maxLeaf < 7)
+		return features;
+	__cpuidex(cpuInfo, 7, 0);
+	if (cpuInfo[1] & (1 << 5))
+		features |= MIXK_CPU_AVX2;
+	return features;
+#else
+	return 0x00;
+#endif
+}
+
+static void MixK_InitFuncs(void)
+{
+	MIXK_FUNCS funcs;
+#ifdef MIXK_X86
+	UINT8 cpuFeat = MixK_GetCPUFeatures();
+#endif
+	
+	funcs.scaleAcc = ScaleAcc_C;
+	funcs.scaleAccMono = ScaleAccMono_C;
+	funcs.interpAcc = InterpAcc_C;
+	funcs.volRamp = ApplyVolRamp_C;
+	funcs.dotS16 = DotS16_C;
+	funcs.packS16 = Pack_S16_C;
+	funcs.packS24 = Pack_S24_C;
+	funcs.packS32 = Pack_S32_C;
+	funcs.packF32 = Pack_F32_C;
+#ifdef MIXK_X86
+	if (cpuFeat & MIXK_CPU_SSE41)
+	{
+		funcs.scaleAcc = ScaleAcc_SSE41;
+		funcs.scaleAccMono = ScaleAccMono_SSE41;
+		funcs.interpAcc = InterpAcc_SSE41;
+		funcs.volRamp = ApplyVolRamp_SSE41;
+		funcs.dotS16 = DotS16_SSE41;
+		funcs.packS16 = Pack_S16_SSE41;
+		funcs.packS24 = Pack_S24_SSE41;
+		funcs.packS32 = Pack_S32_SSE41;
+		funcs.packF32 = Pack_F32_SSE41;
+	}
+	if ((cpuFeat & MIXK_CPU_AVX2) && (cpuFeat & MIXK_CPU_SSE41))
+	{
+		funcs.scaleAcc = ScaleAcc_AVX2;
+		funcs.scaleAccMono = ScaleAccMono_AVX2;
+		funcs.interpAcc = InterpAcc_AVX2;
+		funcs.volRamp = ApplyVolRamp_AVX2;
+		funcs.dotS16 = DotS16_AVX2;
+		funcs.packS16 = Pack_S16_AVX2;
+		funcs.packS24 = Pack_S24_AVX2;
+		funcs.packS32 = Pack_S32_AVX2;
+		funcs.packF32 = Pack_F32_AVX2;
+	}
+#endif
+	mixFuncs = funcs;
+	return;
+}
+
+static const MIXK_FUNCS* MixK_GetFuncs(void)
+{
+	// The render threads of all players share the table, so it is set up exactly once.
+	OSOnce_Run(&mixFuncsInit, MixK_InitFuncs);
+	return &mixFuncs;
+}
+
+void MixK_ScaleAcc(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR, UINT32 length, INT32 volL, INT32 volR)
+{
+	MixK_GetFuncs()->scaleAcc(dst, srcL, srcR, length, volL, volR);
+	return;
+}
+
+void MixK_ScaleAccMono(DEV_SMPL* dst, const DEV_SMPL* src, UINT32 length, INT32 vol)
+{
+	MixK_GetFuncs()->scaleAccMono(dst, src, length, vol);
+	return;
+}
+
+void MixK_InterpAcc(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+					const UINT32* pos, const UINT32* frac, UINT8 fracBits,
+					UINT32 length, INT32 volL, INT32 volR)
+{
+	MixK_GetFuncs()->interpAcc(dst, srcL, srcR, pos, frac, fracBits, length, volL, volR);
+	return;
+}
+
+void MixK_ApplyVolRamp(WAVE_32BS* buf, const INT32* volume, UINT32 length)
+{
+	MixK_GetFuncs()->volRamp(buf, volume, length);
+	return;
+}
+
+INT32 MixK_DotS16(const INT16* a, const INT16* b, UINT32 length)
+{
+	return MixK_GetFuncs()->dotS16(a, b, length);
+}
+
+MIXK_DOTS16_FUNC MixK_GetDotS16(void)
+{
+	return MixK_GetFuncs()->dotS16;
+}
+
+void MixK_Pack_S16(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	MixK_GetFuncs()->packS16(dst, src, length, volume, invert);
+	return;
+}
+
+void MixK_Pack_S24(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	MixK_GetFuncs()->packS24(dst, src, length, volume, invert);
+	return;
+}
+
+void MixK_Pack_S32(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	MixK_GetFuncs()->packS32(dst, src, length, volume, invert);
+	return;
+}
+
+void MixK_Pack_F32(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert)
+{
+	MixK_GetFuncs()->packF32(dst, src, length, volume, invert);
+	return;
+}
@@ -0,0 +1,112 @@
+#ifndef __MIXKERNELS_H__
+#define __MIXKERNELS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "snddef.h"	// for DEV_SMPL
+#include "Resampler.h"	// for WAVE_32BS
+
+// Sample mixing/conversion kernels.
+// SIMD versions (SSE4.1/AVX2) are selected at runtime, all versions return exactly the same results.
+
+// CPU features used by the kernels
+#define MIXK_CPU_SSE41	0x01
+#define MIXK_CPU_AVX2	0x02
+
+/**
+ * @brief Returns the SIMD extensions supported by the CPU (and the OS).
+ *
+ * @return combination of MIXK_CPU_ flags
+ */
+UINT8 MixK_GetCPUFeatures(void);
+
+/**
+ * @brief Scales planar stereo samples and adds them to an interleaved buffer.
+ *        dst[i].L += srcL[i] * volL, dst[i].R += srcR[i] * volR
+ *
+ * @param dst output buffer
+ * @param srcL input samples, left channel
+ * @param srcR input samples, right channel
+ * @param length number of samples
+ * @param volL volume factor for the left channel
+ * @param volR volume factor for the right channel
+ */
+void MixK_ScaleAcc(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR, UINT32 length, INT32 volL, INT32 volR);
+/**
+ * @brief Scales samples of a single channel and adds them to a buffer. (dst[i] += src[i] * vol)
+ *
+ * @param dst output buffer
+ * @param src input samples
+ * @param length number of samples
+ * @param vol volume factor
+ */
+void MixK_ScaleAccMono(DEV_SMPL* dst, const DEV_SMPL* src, UINT32 length, INT32 vol);
+/**
+ * @brief Interpolates linearly between src[pos[i]] and src[pos[i] + 1], scales the result and
+ *        adds it to an interleaved buffer. The division by (1 << fracBits) rounds towards zero.
+ *        dst[i].L += ((INT64)srcL[pos[i]] * (FACT - frac[i]) + (INT64)srcL[pos[i] + 1] * frac[i]) * volL / FACT
+ * Note: src[pos[i] + 1] is read even when frac[i] is 0.
+ *
+ * @param dst output buffer
+ * @param srcL input samples, left channel
+ * @param srcR input samples, right channel
+ * @param pos input sample index for each output sample
+ * @param frac interpolation factor for each output sample, fixed point with fracBits fractional bits
+ * @param fracBits number of fractional bits, must not be larger than 20
+ * @param length number of output samples
+ * @param volL volume factor for the left channel
+ * @param volR volume factor for the right channel
+ */
+void MixK_InterpAcc(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+					const UINT32* pos, const UINT32* frac, UINT8 fracBits,
+					UINT32 length, INT32 volL, INT32 volR);
+/**
+ * @brief Applies a separate 16.16 fixed point volume to each sample, in place.
+ *        buf[i].L = (INT32)(((INT64)buf[i].L * volume[i]) >> 16), same for .R
+ * Note: Packing the result with volume 0x10000 gives the same output as packing
+ *       the original samples with volume[i].
+ *
+ * @param buf sample buffer
+ * @param volume volume for each sample
+ * @param length number of samples
+ */
+void MixK_ApplyVolRamp(WAVE_32BS* buf, const INT32* volume, UINT32 length);
+
+/**
+ * @brief Calculates the dot product of two 16-bit vectors. (sum of a[i] * b[i])
+ *        The sum is calculated modulo 2^32, i.e. it wraps around like 32-bit integer math.
+ *
+ * @param a first vector
+ * @param b second vector
+ * @param length number of elements
+ * @return the sum of all products
+ */
+INT32 MixK_DotS16(const INT16* a, const INT16* b, UINT32 length);
+/**
+ * @brief Returns the MixK_DotS16 implementation selected for this CPU.
+ *        Useful for callers that calculate many short dot products.
+ */
+typedef INT32 (*MIXK_DOTS16_FUNC)(const INT16* a, const INT16* b, UINT32 length);
+MIXK_DOTS16_FUNC MixK_GetDotS16(void);
+
+// ---- output conversion ----
+// The MixK_Pack functions apply a 16.16 fixed point volume ((INT64)smpl * volume >> 16),
+// invert the phase of the channels selected by "invert" (bit 0 - left, bit 1 - right)
+// and convert the 24-bit result into the respective output format with saturation.
+// The output buffer doesn't need to be aligned.
+typedef void (*MIXK_PACK_FUNC)(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert);
+void MixK_Pack_U8(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert);
+void MixK_Pack_S16(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert);
+void MixK_Pack_S24(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert);
+void MixK_Pack_S32(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert);
+void MixK_Pack_F32(void* dst, const WAVE_32BS* src, UINT32 length, INT32 volume, UINT8 invert);	// IEEE float, 1.0 = 24-bit full scale, not limited
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __MIXKERNELS_H__
@@ -0,0 +1,162 @@
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_def.h"
+#include "emu/EmuStructs.h"
+#include "emu/SoundEmu.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+#include "emu/cores/msm5232.h"
+
+// ---- Sound Core Startup Benchmark ----
+// Starts many instances of the cores that generate lookup tables and reports
+//	- the time of the first start (includes generating the shared tables)
+//	- the average time of all further starts
+//	- the memory each additional instance adds to the resident set (Linux only)
+// Usage: emu_startup_bench [number of instances per core]
+//
+// Cores are started in the order of the list below. Cores that share tables
+// (e.g. YM2203/YM2608/YM2610) only pay for table generation on the first one.
+
+typedef struct
+{
+	DEV_ID devID;
+	UINT32 coreID;
+	UINT32 clock;
+	const char* name;
+} BENCH_DEV;
+
+static const BENCH_DEV benchDevs[] =
+{
+	{DEVID_YM2413,	FCC_MAME,	3579545,	"YM2413 (MAME)"},
+	{DEVID_YM2413,	FCC_EMU_,	3579545,	"YM2413 (EMU2413)"},
+	{DEVID_YM2151,	FCC_MAME,	3579545,	"YM2151 (MAME)"},
+	{DEVID_YM2203,	FCC_MAME,	3993600,	"YM2203 (MAME)"},
+	{DEVID_YM2610,	FCC_MAME,	8000000,	"YM2610 (MAME)"},
+	{DEVID_YM3812,	FCC_MAME,	3579545,	"YM3812 (MAME)"},
+	{DEVID_YMF262,	FCC_MAME,	14318180,	"YMF262 (MAME)"},
+	{DEVID_YMF278B,	FCC_OMSX,	33868800,	"YMF278B"},
+	{DEVID_YMF271,	FCC_MAME,	16934400,	"YMF271"},
+	{DEVID_YMZ280B,	FCC_MAME,	16934400,	"YMZ280B"},
+	{DEVID_NES_APU,	FCC_MAME,	1789772,	"NES APU (MAME)"},
+	{DEVID_YMW258,	FCC_MAME,	9878400,	"MultiPCM"},
+	{DEVID_SCSP,	FCC_MAME,	22579200,	"SCSP"},
+	{DEVID_MSM5232,	FCC_MAME,	2119040,	"MSM5232"},
+};
+#define BENCH_DEV_COUNT	(sizeof(benchDevs) / sizeof(benchDevs[0]))
+
+INLINE UINT64 GetSysTimeUS(void);
+static long GetResidentKB(void);
+
+
+int main(int argc, char* argv[])
+{
+	UINT32 instCnt;
+	UINT32 curDev;
+	UINT32 curInst;
+	DEV_INFO* devInfs;
+	MSM5232_CFG devCfg;	// large enough for all devices in the list
+
+	instCnt = (argc > 1) ? (UINT32)strtoul(argv[1], NULL, 0) : 100;
+	if (instCnt < 2)
+		instCnt = 2;
+	devInfs = (DEV_INFO*)calloc(instCnt, sizeof(DEV_INFO));
+
+	memset(&devCfg, 0x00, sizeof(devCfg));
+	devCfg._genCfg.srMode = DEVRI_SRMODE_NATIVE;
+	devCfg._genCfg.flags = 0x00;
+	devCfg._genCfg.smplRate = 44100;
+	for (curInst = 0; curInst < 8; curInst ++)
+		devCfg.capacitors[curInst] = 1.0e-6;
+
+	printf("%u instances per core\n", instCnt);
+	printf("%-18s %12s %12s %14s\n", "Core", "first [us]", "avg [us]", "KB/instance");
+	for (curDev = 0; curDev < BENCH_DEV_COUNT; curDev ++)
+	{
+		const BENCH_DEV* bDev = &benchDevs[curDev];
+		UINT64 startTime;
+		UINT64 firstTime;
+		UINT64 restTime;
+		long memBefore;
+		long memAfter;
+		UINT32 started;
+
+		devCfg._genCfg.emuCore = bDev->coreID;
+		devCfg._genCfg.clock = bDev->clock;
+
+		startTime = GetSysTimeUS();
+		if (SndEmu_Start(bDev->devID, &devCfg._genCfg, &devInfs[0]))
+		{
+			printf("%-18s start failed\n", bDev->name);
+			continue;
+		}
+		firstTime = GetSysTimeUS() - startTime;
+
+		memBefore = GetResidentKB();
+		startTime = GetSysTimeUS();
+		for (started = 1; started < instCnt; started ++)
+		{
+			if (SndEmu_Start(bDev->devID, &devCfg._genCfg, &devInfs[started]))
+				break;
+		}
+		restTime = GetSysTimeUS() - startTime;
+		memAfter = GetResidentKB();
+
+		if (started > 1)
+			restTime /= (started - 1);
+		printf("%-18s %12u %12u", bDev->name, (UINT32)firstTime, (UINT32)restTime);
+		if (memBefore >= 0 && memAfter >= 0 && started > 1)
+			printf(" %14.1f\n", (double)(memAfter - memBefore) / (started - 1));
+		else
+			printf(" %14s\n", "n/a");
+
+		for (curInst = 0; curInst < started; curInst ++)
+			SndEmu_Stop(&devInfs[curInst]);
+	}
+
+	free(devInfs);
+	return 0;
+}
+
+INLINE UINT64 GetSysTimeUS(void)
+{
+#ifdef WIN32
+	LARGE_INTEGER freq;
+	LARGE_INTEGER cntr;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&cntr);
+	return (UINT64)cntr.QuadPart * 1000000 / (UINT64)freq.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT64)ts.tv_sec * 1000000 + (UINT64)(ts.tv_nsec / 1000);
+#endif
+}
+
+// returns the resident set size in KB or -1 if unknown
+static long GetResidentKB(void)
+{
+#ifdef __linux__
+	FILE* hFile;
+	long pages;
+	long resident;
+
+	hFile = fopen("/proc/self/statm", "r");
+	if (hFile == NULL)
+		return -1;
+	if (fscanf(hFile, "%ld %ld", &pages, &resident) != 2)
+		resident = -1;
+	fclose(hFile);
+	return (resident < 0) ? -1 : resident * 4;	// assumes 4 KB pages
+#else
+	return -1;
+#endif
+}
@@ -2,8 +2,24 @@
 #include <string.h>
 
 #include "../common_def.h"
+#include "../utils/OSOnce.h"
 #include "dblk_compr.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DBLK_X86
+#define DBLK_TARGET_SSE41	__attribute__((target("sse4.1")))
+#define DBLK_TARGET_AVX2	__attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (_MSC_VER >= 1700) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#define DBLK_X86
+#define DBLK_TARGET_SSE41
+#define DBLK_TARGET_AVX2
+#endif
+#ifdef DBLK_X86
+#include "../emu/mixkernels.h"	// for MixK_GetCPUFeatures()
+#endif
+
 // integer types for fast integer calculation
 // The bit number defines how many bits are required, but the types can be larger for increased speed.
 typedef UINT16	FUINT8;
@@ -114,6 +130,326 @@ INLINE void WriteLE32(UINT8* Buffer, UINT32 Value)
 	}	\
 }
 
+// ---- fast bit unpacking ----
+// The kernels below extract values the same way READ_BITS does, but process a whole buffer at once.
+// Values are read from a MSB-first bit stream. For values with more than 8 bits, the first 8 bits
+// of the stream end up in the low byte and the remaining bits in the upper bits (see READ_BITS).
+#define DBLK_CHUNK	1024	// values per processing step, must be a multiple of 16
+
+typedef struct _dblk_unpack_info
+{
+	UINT8 bits;		// bits per value (1..16)
+	UINT8 hiOfs;	// byte offset of value 4 of a group of 8 values
+	UINT8 shufMask[2][16];	// gather the bytes of values 0..3 / 4..7 into big-endian 32-bit words
+	UINT32 bitOfs[8];	// bit offset of each value inside its 32-bit word
+	UINT32 bitMul[8];	// 1 << bitOfs
+} DBLK_UNPACK_INF;
+
+typedef const UINT8* (*DBLK_UNPACK_FUNC)(UINT32 count, UINT16* outVals, const UINT8* inPos, const UINT8* inEnd, const DBLK_UNPACK_INF* upInf);
+typedef UINT16 (*DBLK_PREFIXSUM_FUNC)(UINT32 count, UINT16* data, UINT16 start);
+
+static DBLK_UNPACK_FUNC unpackBits = NULL;
+static DBLK_PREFIXSUM_FUNC prefixSum16 = NULL;
+static OS_ONCE kernelsInit = OS_ONCE_INIT;
+
+static void InitUnpackInfo(DBLK_UNPACK_INF* upInf, UINT8 bits)
+{
+	UINT8 curVal;
+	UINT8 curByte;
+	
+	upInf->bits = bits;
+	upInf->hiOfs = (4 * bits) >> 3;
+	for (curVal = 0; curVal < 8; curVal ++)
+	{
+		UINT32 bitPos = curVal * bits;
+		UINT8 byteOfs = (UINT8)(bitPos >> 3);
+		UINT8* shufMask = upInf->shufMask[curVal >> 2];
+		
+		if (curVal >= 4)
+			byteOfs -= upInf->hiOfs;
+		for (curByte = 0; curByte < 4; curByte ++)
+			shufMask[(curVal & 3) * 4 + curByte] = byteOfs + (3 - curByte);
+		upInf->bitOfs[curVal] = bitPos & 7;
+		upInf->bitMul[curVal] = 1 << (bitPos & 7);
+	}
+	
+	return;
+}
+
+// Note: Must start at a byte boundary. Reads only the bytes that are required for "count" values.
+static const UINT8* UnpackBits_C(UINT32 count, UINT16* outVals, const UINT8* inPos, const UINT8* inEnd, const DBLK_UNPACK_INF* upInf)
+{
+	UINT8 bits = upInf->bits;
+	UINT32 valMask = (1 << bits) - 1;
+	UINT32 bitBuf;
+	UINT8 bufBits;
+	UINT32 curVal;
+	
+	bitBuf = 0;
+	bufBits = 0;
+	for (curVal = 0; curVal < count; curVal ++)
+	{
+		UINT32 val;
+		
+		while(bufBits < bits)
+		{
+			bitBuf = (bitBuf << 8) | *inPos;
+			inPos ++;
+			bufBits += 8;
+		}
+		bufBits -= bits;
+		val = (bitBuf >> bufBits) & valMask;
+		if (bits > 8)
+			val = (val >> (bits - 8)) | ((val & (valMask >> 8)) << 8);
+		outVals[curVal] = (UINT16)val;
+	}
+	
+	return inPos;
+}
+
+static UINT16 PrefixSum16_C(UINT32 count, UINT16* data, UINT16 start)
+{
+	UINT32 curVal;
+	
+	for (curVal = 0; curVal < count; curVal ++)
+	{
+		start += data[curVal];
+		data[curVal] = start;
+	}
+	return start;
+}
+
+#ifdef DBLK_X86
+// Each group of 8 values takes exactly "bits" bytes, so all groups share the same byte/bit layout.
+DBLK_TARGET_SSE41 static const UINT8* UnpackBits_SSE41(UINT32 count, UINT16* outVals, const UINT8* inPos, const UINT8* inEnd, const DBLK_UNPACK_INF* upInf)
+{
+	UINT8 bits = upInf->bits;
+	__m128i shufLo = _mm_loadu_si128((const __m128i*)upInf->shufMask[0]);
+	__m128i shufHi = _mm_loadu_si128((const __m128i*)upInf->shufMask[1]);
+	__m128i mulLo = _mm_loadu_si128((const __m128i*)&upInf->bitMul[0]);
+	__m128i mulHi = _mm_loadu_si128((const __m128i*)&upInf->bitMul[4]);
+	__m128i valShift = _mm_cvtsi32_si128(32 - bits);
+	__m128i hiShift = _mm_cvtsi32_si128((bits > 8) ? (bits - 8) : 0);
+	__m128i hiMask = _mm_set1_epi32(((1 << bits) - 1) >> 8);
+	UINT32 curVal;
+	
+	// The loads read up to 24 bytes from the start of the group.
+	for (curVal = 0; curVal + 8 <= count && inEnd - inPos >= 24; curVal += 8)
+	{
+		__m128i valLo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)inPos), shufLo);
+		__m128i valHi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(inPos + upInf->hiOfs)), shufHi);
+		valLo = _mm_srl_epi32(_mm_mullo_epi32(valLo, mulLo), valShift);
+		valHi = _mm_srl_epi32(_mm_mullo_epi32(valHi, mulHi), valShift);
+		if (bits > 8)
+		{
+			valLo = _mm_or_si128(_mm_srl_epi32(valLo, hiShift), _mm_slli_epi32(_mm_and_si128(valLo, hiMask), 8));
+			valHi = _mm_or_si128(_mm_srl_epi32(valHi, hiShift), _mm_slli_epi32(_mm_and_si128(valHi, hiMask), 8));
+		}
+		_mm_storeu_si128((__m128i*)&outVals[curVal], _mm_packus_epi32(valLo, valHi));
+		inPos += bits;
+	}
+	
+	return UnpackBits_C(count - curVal, &outVals[curVal], inPos, inEnd, upInf);
+}
+
+DBLK_TARGET_SSE41 static UINT16 PrefixSum16_SSE41(UINT32 count, UINT16* data, UINT16 start)
+{
+	__m128i carry = _mm_set1_epi16((short)start);
+	UINT32 curVal;
+	
+	for (curVal = 0; curVal + 8 <= count; curVal += 8)
+	{
+		__m128i val = _mm_loadu_si128((const __m128i*)&data[curVal]);
+		val = _mm_add_epi16(val, _mm_slli_si128(val, 2));
+		val = _mm_add_epi16(val, _mm_slli_si128(val, 4));
+		val = _mm_add_epi16(val, _mm_slli_si128(val, 8));
+		val = _mm_add_epi16(val, carry);
+		_mm_storeu_si128((__m128i*)&data[curVal], val);
+		carry = _mm_shufflehi_epi16(val, 0xFF);	// broadcast the last value
+		carry = _mm_unpackhi_epi64(carry, carry);
+	}
+	start = (UINT16)_mm_extract_epi16(carry, 0);
+	
+	return PrefixSum16_C(count - curVal, &data[curVal], start);
+}
+
+DBLK_TARGET_AVX2 static const UINT8* UnpackBits_AVX2(UINT32 count, UINT16* outVals, const UINT8* inPos, const UINT8* inEnd, const DBLK_UNPACK_INF* upInf)
+{
+	UINT8 bits = upInf->bits;
+	__m256i shufMask = _mm256_inserti128_si256(_mm256_castsi128_si256(
+		_mm_loadu_si128((const __m128i*)upInf->shufMask[0])), _mm_loadu_si128((const __m128i*)upInf->shufMask[1]), 1);
+	__m256i bitOfs = _mm256_loadu_si256((const __m256i*)upInf->bitOfs);
+	__m128i valShift = _mm_cvtsi32_si128(32 - bits);
+	__m128i hiShift = _mm_cvtsi32_si128((bits > 8) ? (bits - 8) : 0);
+	__m256i hiMask = _mm256_set1_epi32(((1 << bits) - 1) >> 8);
+	UINT32 curVal;
+	
+	// 2 groups of 8 values per loop, the loads read up to (bits + 24) bytes
+	for (curVal = 0; curVal + 16 <= count && inEnd - inPos >= bits + 24; curVal += 16)
+	{
+		const UINT8* inPos2 = inPos + bits;
+		__m256i val1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)inPos)),
+			_mm_loadu_si128((const __m128i*)(inPos + upInf->hiOfs)), 1);
+		__m256i val2 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)inPos2)),
+			_mm_loadu_si128((const __m128i*)(inPos2 + upInf->hiOfs)), 1);
+		val1 = _mm256_srl_epi32(_mm256_sllv_epi32(_mm256_shuffle_epi8(val1, shufMask), bitOfs), valShift);
+		val2 = _mm256_srl_epi32(_mm256_sllv_epi32(_mm256_shuffle_epi8(val2, shufMask), bitOfs), valShift);
+		if (bits > 8)
+		{
+			val1 = _mm256_or_si256(_mm256_srl_epi32(val1, hiShift), _mm256_slli_epi32(_mm256_and_si256(val1, hiMask), 8));
+			val2 = _mm256_or_si256(_mm256_srl_epi32(val2, hiShift), _mm256_slli_epi32(_mm256_and_si256(val2, hiMask), 8));
+		}
+		// packus works on 128-bit lanes: [1: 0..3, 2: 0..3, 1: 4..7, 2: 4..7] -> reorder 64-bit blocks
+		val1 = _mm256_permute4x64_epi64(_mm256_packus_epi32(val1, val2), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)&outVals[curVal], val1);
+		inPos += 2 * bits;
+	}
+	
+	return UnpackBits_SSE41(count - curVal, &outVals[curVal], inPos, inEnd, upInf);
+}
+#endif	// DBLK_X86
+
+static void InitKernels(void)
+{
+	DBLK_UNPACK_FUNC unpackFunc = UnpackBits_C;
+	DBLK_PREFIXSUM_FUNC prefixSumFunc = PrefixSum16_C;
+#ifdef DBLK_X86
+	UINT8 cpuFeat = MixK_GetCPUFeatures();
+	
+	if (cpuFeat & MIXK_CPU_SSE41)
+	{
+		unpackFunc = UnpackBits_SSE41;
+		prefixSumFunc = PrefixSum16_SSE41;
+	}
+	if ((cpuFeat & MIXK_CPU_AVX2) && (cpuFeat & MIXK_CPU_SSE41))
+		unpackFunc = UnpackBits_AVX2;
+#endif
+	prefixSum16 = prefixSumFunc;
+	unpackBits = unpackFunc;
+	
+	return;
+}
+
+INLINE void StoreLE16(UINT8* outPos, const UINT16* vals, UINT32 count)
+{
+#ifdef VGM_LITTLE_ENDIAN
+	memcpy(outPos, vals, count * 0x02);
+#else
+	UINT32 curVal;
+	
+	for (curVal = 0; curVal < count; curVal ++, outPos += 0x02)
+		WriteLE16(outPos, vals[curVal]);
+#endif
+	
+	return;
+}
+
+// decompress Bit Packing/DPCM data using the unpack kernels (bitsCmp = 1..16)
+static void Decompress_Fast(UINT32 outLen, UINT8* outData, const UINT8* inData, UINT32 inLen, const PCM_CMP_INF* cmpParams, UINT8 valSize)
+{
+	DBLK_UNPACK_INF upInf;
+	UINT16 vals[DBLK_CHUNK];
+	const UINT8* inPos;
+	const UINT8* inEnd;
+	UINT8* outPos;
+	UINT32 valCount;
+	UINT32 curVal;
+	UINT32 chunkLen;
+	UINT32 curSmpl;
+	UINT8 outShift;
+	UINT16 addVal;
+	UINT16 outMask;
+	UINT16 dpcmVal;
+	
+	OSOnce_Run(&kernelsInit, InitKernels);	// players may decompress from multiple threads
+	InitUnpackInfo(&upInf, cmpParams->bitsCmp);
+	outShift = cmpParams->bitsDec - cmpParams->bitsCmp;
+	addVal = cmpParams->baseVal;
+	outMask = (UINT16)((1 << cmpParams->bitsDec) - 1);
+	dpcmVal = cmpParams->baseVal;
+	
+	inPos = inData;
+	inEnd = inData + inLen;
+	outPos = outData;
+	valCount = (outLen + valSize - 1) / valSize;
+	for (curVal = 0; curVal < valCount; curVal += chunkLen)
+	{
+		chunkLen = valCount - curVal;
+		if (chunkLen > DBLK_CHUNK)
+			chunkLen = DBLK_CHUNK;
+		inPos = unpackBits(chunkLen, vals, inPos, inEnd, &upInf);
+		
+		if (cmpParams->comprType == 0x01)	// Delta-PCM
+		{
+			if (valSize == 0x01)
+			{
+				for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+					vals[curSmpl] = cmpParams->comprTbl->values.d8[vals[curSmpl]];
+			}
+			else
+			{
+				for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+					vals[curSmpl] = cmpParams->comprTbl->values.d16[vals[curSmpl]];
+			}
+			// outVal[i] = (baseVal + delta[0] + ... + delta[i]) & outMask
+			dpcmVal = prefixSum16(chunkLen, vals, dpcmVal);
+			for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+				vals[curSmpl] &= outMask;
+		}
+		else
+		{
+			switch(cmpParams->subType)
+			{
+			case 0x00:	// Copy
+				for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+					vals[curSmpl] = vals[curSmpl] + addVal;
+				break;
+			case 0x01:	// Shift Left
+				for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+					vals[curSmpl] = (vals[curSmpl] << outShift) + addVal;
+				break;
+			case 0x02:	// Table
+				if (valSize == 0x01)
+				{
+					for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+						vals[curSmpl] = cmpParams->comprTbl->values.d8[vals[curSmpl]];
+				}
+				else
+				{
+					for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+						vals[curSmpl] = cmpParams->comprTbl->values.d16[vals[curSmpl]];
+				}
+				break;
+			default:
+				outPos += chunkLen * valSize;	// unknown sub-type: leave the output untouched
+				continue;
+			}
+		}
+		
+		if (valSize == 0x01)
+		{
+			for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++)
+				outPos[curSmpl] = (UINT8)vals[curSmpl];
+			outPos += chunkLen;
+		}
+		else
+		{
+			UINT32 storeLen = chunkLen;
+			
+			if (curVal + chunkLen == valCount && (outLen & 0x01))
+			{
+				// odd output size: write only the low byte of the last value
+				storeLen --;
+				outPos[storeLen * 0x02] = (UINT8)vals[storeLen];
+			}
+			StoreLE16(outPos, vals, storeLen);
+			outPos += storeLen * 0x02;
+		}
+	}
+	
+	return;
+}
+
 static UINT8 Decompress_BitPacking_8(UINT32 outLen, UINT8* outData, UINT32 inLen, const UINT8* inData, const PCM_CMP_INF* cmpParams)
 {
 	FUINT8 bitsCmp;
@@ -160,6 +496,12 @@ static UINT8 Decompress_BitPacking_8(UINT32 outLen, UINT8* outData, UINT32 inLen
 		outLen = outLenMax;
 	outDataEnd = outData + outLen;
 	
+	if (bitsCmp <= 16)
+	{
+		Decompress_Fast(outLen, outData, inData, inLen, cmpParams, 0x01);
+		return 0x00;
+	}
+	
 	switch(cmpParams->subType)
 	{
 	case 0x00:	// Copy
@@ -241,6 +583,12 @@ static UINT8 Decompress_BitPacking_16(UINT32 outLen, UINT8* outData, UINT32 inLe
 		outLen = outLenMax;
 	outDataEnd = outData + outLen;
 	
+	if (bitsCmp <= 16)
+	{
+		Decompress_Fast(outLen, outData, inData, inLen, cmpParams, 0x02);
+		return 0x00;
+	}
+	
 	switch(cmpParams->subType)
 	{
 	case 0x00:	// Copy
@@ -322,6 +670,12 @@ static UINT8 Decompress_DPCM_8(UINT32 outLen, UINT8* outData, UINT32 inLen, cons
 		outLen = outLenMax;
 	outDataEnd = outData + outLen;
 	
+	if (bitsCmp <= 16)
+	{
+		Decompress_Fast(outLen, outData, inData, inLen, cmpParams, 0x01);
+		return 0x00;
+	}
+	
 	outVal = (FUINT8)cmpParams->baseVal;
 	for (inPos = inData, outPos = outData; outPos < outDataEnd; outPos += 0x01)
 	{
@@ -379,6 +733,12 @@ static UINT8 Decompress_DPCM_16(UINT32 outLen, UINT8* outData, UINT32 inLen, con
 		outLen = outLenMax;
 	outDataEnd = outData + outLen;
 	
+	if (bitsCmp <= 16)
+	{
+		Decompress_Fast(outLen, outData, inData, inLen, cmpParams, 0x02);
+		return 0x00;
+	}
+	
 	outVal = cmpParams->baseVal;
 	for (inPos = inData, outPos = outData; outPos < outDataEnd; outPos += 0x02)
 	{
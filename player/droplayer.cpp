@@ -54,10 +54,15 @@ DROPlayer::DROPlayer() :
 	dev_logger_set(&_logger, this, DROPlayer::PlayerLogCB, NULL);
 	
 	_playOpts.genOpts.pbSpeed = 0x10000;
+	_playOpts.genOpts.skipSilentDevs = 0;
 	_playOpts.v2opl3Mode = DRO_V2OPL3_DETECT;
+	_playOpts.keyframeInterval = 0;
+	_playOpts.keyframeMemLimit = 32 * 1024 * 1024;	// 32 MB
 	
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
+	_kfMemSize = 0;
+	_kfInterval = 0;
 	
 	for (curDev = 0; curDev < 3; curDev ++)
 		InitDeviceOptions(_devOpts[curDev]);
@@ -417,6 +422,98 @@ UINT8 DROPlayer::GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const
 		return 0x00;	// returned data based on file header
 }
 
+UINT8 DROPlayer::AnalyzeSong(PLR_ANALYSIS& result) const
+{
+	if (_dLoad == NULL)
+		return 0xFF;
+	
+	std::vector<PLR_DEV_INFO> devInfList;
+	UINT32 fileSize = DataLoader_GetSize(_dLoad);
+	UINT32 filePos = _fileHdr.dataOfs;
+	UINT32 fileTick = 0;
+	UINT8 selPort = 0;
+	UINT8 curCmd;
+	UINT8 port;
+	UINT8 devID;
+	
+	GetSongDeviceInfo(devInfList);
+	InitAnalysis(result, devInfList);
+	
+	// Note: The command decoding is the same as in DoCommand_v1/DoCommand_v2.
+	while(filePos < fileSize)
+	{
+		result.cmdCount ++;
+		curCmd = _fileData[filePos];
+		if (_fileHdr.verMajor < 2)
+		{
+			filePos ++;
+			port = selPort;
+			switch(curCmd)
+			{
+			case 0x00:	// 1-byte delay
+				fileTick += 1 + _fileData[filePos];
+				filePos ++;
+				continue;
+			case 0x01:	// 2-byte delay
+				if (filePos < _initBlkEndOfs)
+					break;
+				if (! (_fileData[filePos + 0x00] & ~0x20) &&
+					(_fileData[filePos + 0x01] == 0x08 || _fileData[filePos + 0x01] >= 0x20))
+					break;
+				fileTick += 1 + ReadLE16(&_fileData[filePos]);
+				filePos += 0x02;
+				continue;
+			case 0x02:	// use 1st OPL2 chip / 1st OPL3 port
+			case 0x03:	// use 2nd OPL2 chip / 2nd OPL3 port
+				selPort = curCmd & 0x01;
+				continue;
+			case 0x04:	// escape command
+				if (_fileData[filePos] >= 0x08)
+					break;
+				if (filePos < _initBlkEndOfs)
+					break;
+				curCmd = _fileData[filePos];
+				filePos ++;
+				break;
+			}
+			filePos ++;
+		}
+		else
+		{
+			UINT8 data = _fileData[filePos + 0x01];
+			filePos += 0x02;
+			if (curCmd == _fileHdr.cmdDlyShort)
+			{
+				fileTick += (1 + data);
+				continue;
+			}
+			else if (curCmd == _fileHdr.cmdDlyLong)
+			{
+				fileTick += (1 + data) << 8;
+				continue;
+			}
+			port = (curCmd & 0x80) >> 7;
+			curCmd &= 0x7F;
+			if (curCmd >= _fileHdr.regCmdCnt)
+				continue;	// invalid register
+			curCmd = _fileHdr.regCmdMap[curCmd];
+		}
+		
+		devID = port >> _portShift;
+		if (devID < result.devices.size())
+			AnalysisWrite(result.devices[devID], ((port & _portMask) << 8) | curCmd);
+		else
+			result.strayWrites ++;
+	}
+	if (filePos > fileSize)
+		result.flags |= PLRANA_BAD_CMD;	// the last command was truncated
+	result.songLen = fileTick;
+	if (result.songLen != _fileHdr.lengthMS)
+		result.flags |= PLRANA_LEN_MISMATCH;
+	
+	return 0x00;
+}
+
 size_t DROPlayer::DeviceID2OptionID(UINT32 id) const
 {
 	DEV_ID type;
@@ -761,6 +858,10 @@ UINT8 DROPlayer::Start(void)
 		}
 	}
 	
+	_keyframes.clear();
+	_kfMemSize = 0;
+	_kfInterval = _playOpts.keyframeInterval * _tickFreq;	// seconds -> ticks
+	
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
 	if (_eventCbFunc != NULL)
@@ -781,6 +882,8 @@ UINT8 DROPlayer::Stop(void)
 		FreeDeviceTree(&cDev->base, 0);
 	}
 	_devices.clear();
+	_keyframes.clear();
+	_kfMemSize = 0;
 	if (_eventCbFunc != NULL)
 		_eventCbFunc(this, _eventCbParam, PLREVT_STOP, NULL);
 	
@@ -858,7 +961,10 @@ UINT8 DROPlayer::Seek(UINT8 unit, UINT32 pos)
 	case PLAYPOS_FILEOFS:
 		_playState |= PLAYSTATE_SEEK;
 		if (pos < _filePos)
-			Reset();
+		{
+			if (LoadKeyframe(unit, pos))
+				Reset();
+		}
 		return SeekToFilePos(pos);
 	case PLAYPOS_SAMPLE:
 		pos = Sample2Tick(pos);
@@ -866,7 +972,10 @@ UINT8 DROPlayer::Seek(UINT8 unit, UINT32 pos)
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
 		if (pos < _playTick)
-			Reset();
+		{
+			if (LoadKeyframe(PLAYPOS_TICK, pos))
+				Reset();
+		}
 		return SeekToTick(pos);
 	case PLAYPOS_COMMAND:
 	default:
@@ -904,6 +1013,122 @@ UINT8 DROPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+void DROPlayer::SaveKeyframe(UINT32 playTick)
+{
+	KEYFRAME kf;
+	size_t curDev;
+	UINT32 stateSize;
+	
+	kf.filePos = _filePos;
+	kf.fileTick = _fileTick;
+	kf.playTick = playTick;	// Note: all sound devices are rendered up to this point, but it isn't parsed yet.
+	kf.selPort = _selPort;
+	
+	kf.stateOfs.resize(_devices.size() + 1);
+	kf.stateOfs[0] = 0;
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		stateSize = SaveDeviceTreeState(&_devices[curDev].base, 0, NULL);
+		if (! stateSize && _devices[curDev].base.defInf.dataPtr != NULL)
+		{
+			// The device doesn't support saving its state - disable keyframes.
+			emu_logf(&_logger, PLRLOG_DEBUG, "Device %s doesn't support state saving, keyframes disabled.\n",
+				_devNames[curDev].c_str());
+			_keyframes.clear();
+			_kfMemSize = 0;
+			_kfInterval = 0;
+			return;
+		}
+		kf.stateOfs[1 + curDev] = kf.stateOfs[curDev] + stateSize;
+	}
+	kf.stateData.resize(kf.stateOfs.back());
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		stateSize = (UINT32)(kf.stateOfs[1 + curDev] - kf.stateOfs[curDev]);
+		if (stateSize)
+			SaveDeviceTreeState(&_devices[curDev].base, stateSize, &kf.stateData[kf.stateOfs[curDev]]);
+	}
+	
+	kf.memSize = sizeof(KEYFRAME) + kf.stateData.size() + kf.stateOfs.size() * sizeof(size_t);
+	_kfMemSize += kf.memSize;
+	_keyframes.push_back(kf);
+	
+	// When exceeding the memory limit, drop every 2nd keyframe and double the interval.
+	while(_kfMemSize > _playOpts.keyframeMemLimit && _keyframes.size() > 1)
+	{
+		size_t curKF;
+		size_t dstKF;
+		
+		_kfMemSize = 0;
+		for (curKF = 0, dstKF = 0; curKF < _keyframes.size(); curKF += 2, dstKF ++)
+		{
+			if (dstKF != curKF)
+				std::swap(_keyframes[dstKF], _keyframes[curKF]);
+			_kfMemSize += _keyframes[dstKF].memSize;
+		}
+		_keyframes.resize(dstKF);
+		_kfInterval *= 2;
+	}
+	if (_kfMemSize > _playOpts.keyframeMemLimit)
+	{
+		emu_logf(&_logger, PLRLOG_DEBUG, "Keyframe size exceeds memory limit, keyframes disabled.\n");
+		_keyframes.clear();
+		_kfMemSize = 0;
+		_kfInterval = 0;
+	}
+	
+	return;
+}
+
+UINT8 DROPlayer::LoadKeyframe(UINT8 unit, UINT32 pos)
+{
+	const KEYFRAME* kf;
+	size_t curKF;
+	size_t curDev;
+	UINT8 retVal;
+	
+	// search for the last keyframe before the seek position
+	// (DROs don't loop, so file offsets are unambiguous)
+	kf = NULL;
+	for (curKF = 0; curKF < _keyframes.size(); curKF ++)
+	{
+		const KEYFRAME& curKf = _keyframes[curKF];
+		if (unit == PLAYPOS_FILEOFS)
+		{
+			if (curKf.filePos > pos)
+				break;
+		}
+		else
+		{
+			if (curKf.playTick > pos)
+				break;
+		}
+		kf = &curKf;
+	}
+	if (kf == NULL)
+		return 0xFF;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		UINT32 stateSize = (UINT32)(kf->stateOfs[1 + curDev] - kf->stateOfs[curDev]);
+		if (! stateSize)
+			continue;
+		retVal = LoadDeviceTreeState(&_devices[curDev].base, stateSize, &kf->stateData[kf->stateOfs[curDev]]);
+		if (retVal)
+			return retVal;	// Note: the caller has to call Reset() in this case
+	}
+	
+	_filePos = kf->filePos;
+	_fileTick = kf->fileTick;
+	_playTick = kf->playTick;
+	_playSmpl = Tick2Sample(_playTick);
+	_playState &= ~PLAYSTATE_END;
+	_psTrigger = 0x00;
+	_selPort = kf->selPort;
+	
+	return 0x00;
+}
+
 UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -917,6 +1142,11 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	do
 	{
 		smplFileTick = Sample2Tick(_playSmpl);
+		if (_kfInterval && ! (_playState & PLAYSTATE_END))
+		{
+			if (_keyframes.empty() || smplFileTick >= _keyframes.back().playTick + _kfInterval)
+				SaveKeyframe(smplFileTick);
+		}
 		ParseFile(smplFileTick - _playTick);
 		
 		// render as many samples at once as possible (for better performance)
@@ -936,7 +1166,7 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
+					ResampleDeviceOutput(clDev, smplStep, &data[curSmpl], _playOpts.genOpts.skipSilentDevs);
 			}
 		}
 		curSmpl += smplStep;
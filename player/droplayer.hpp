@@ -70,6 +70,9 @@ struct DRO_PLAY_OPTIONS
 {
 	PLR_GEN_OPTS genOpts;
 	UINT8 v2opl3Mode;	// DRO v2 DualOPL2 -> OPL3 fixes
+	UINT32 keyframeInterval;	// store the playback state every N seconds for fast backward seeking (0 = disabled)
+	UINT32 keyframeMemLimit;	// memory limit for keyframes (in bytes), the interval is increased when exceeding it
+							// Note: takes effect when calling Start().
 };
 
 
@@ -88,6 +91,16 @@ private:
 		DEVFUNC_WRITE_A8D8 write;
 		DEVLOG_CB_DATA logCbData;
 	};
+	struct KEYFRAME	// playback state, used for seeking backwards without parsing from the beginning
+	{
+		UINT32 filePos;
+		UINT32 fileTick;
+		UINT32 playTick;
+		UINT8 selPort;
+		std::vector<size_t> stateOfs;	// offsets of device states in stateData
+		std::vector<UINT8> stateData;
+		size_t memSize;	// memory used by the keyframe
+	};
 	
 public:
 	DROPlayer();
@@ -104,6 +117,7 @@ public:
 	const char* const* GetTags(void);
 	UINT8 GetSongInfo(PLR_SONG_INFO& songInf);
 	UINT8 GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const;
+	UINT8 AnalyzeSong(PLR_ANALYSIS& result) const;
 	UINT8 SetDeviceOptions(UINT32 id, const PLR_DEV_OPTS& devOpts);
 	UINT8 GetDeviceOptions(UINT32 id, PLR_DEV_OPTS& devOpts) const;
 	UINT8 SetDeviceMuting(UINT32 id, const PLR_MUTE_OPTS& muteOpts);
@@ -149,6 +163,8 @@ private:
 	void GenerateDeviceConfig(void);
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void SaveKeyframe(UINT32 playTick);
+	UINT8 LoadKeyframe(UINT8 unit, UINT32 pos);
 	void ParseFile(UINT32 ticks);
 	void DoCommand_v1(void);
 	void DoCommand_v2(void);
@@ -194,6 +210,10 @@ private:
 	UINT32 _playTick;
 	UINT32 _playSmpl;
 	
+	std::vector<KEYFRAME> _keyframes;	// sorted by playTick
+	size_t _kfMemSize;		// memory used by all keyframes
+	UINT32 _kfInterval;		// keyframe interval in ticks (0 = don't store keyframes)
+	
 	UINT8 _playState;
 	UINT8 _psTrigger;	// used to temporarily trigger special commands
 	UINT8 _selPort;		// currently selected OPL chip (for DRO v1)
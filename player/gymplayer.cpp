@@ -48,6 +48,7 @@ GYMPlayer::GYMPlayer() :
 	dev_logger_set(&_logger, this, GYMPlayer::PlayerLogCB, NULL);
 
 	_playOpts.genOpts.pbSpeed = 0x10000;
+	_playOpts.genOpts.skipSilentDevs = 0;
 
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
@@ -440,6 +441,56 @@ UINT8 GYMPlayer::GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const
 		return 0x00;	// returned data based on file header
 }
 
+UINT8 GYMPlayer::AnalyzeSong(PLR_ANALYSIS& result) const
+{
+	if (_dLoad == NULL)
+		return 0xFF;
+	
+	std::vector<PLR_DEV_INFO> devInfList;
+	UINT32 filePos = _fileHdr.dataOfs;
+	UINT32 fileTick = 0;
+	UINT8 curCmd;
+	
+	GetSongDeviceInfo(devInfList);
+	InitAnalysis(result, devInfList);
+	
+	while(filePos < _fileLen)
+	{
+		if (fileTick == _fileHdr.loopFrame && _fileHdr.loopFrame != 0 && result.loopTick == (UINT32)-1)
+			result.loopTick = fileTick;
+		
+		result.cmdCount ++;
+		curCmd = _fileData[filePos];
+		filePos ++;
+		switch(curCmd)
+		{
+		case 0x00:	// wait 1 frame
+			fileTick ++;
+			break;
+		case 0x01:	// write to YM2612 port 0
+		case 0x02:	// write to YM2612 port 1
+			if (filePos + 0x02 <= _fileLen)
+				AnalysisWrite(result.devices[0], ((curCmd - 0x01) << 8) | _fileData[filePos]);
+			filePos += 0x02;
+			break;
+		case 0x03:	// write to PSG
+			AnalysisWrite(result.devices[1], SN76496_W_REG);
+			filePos += 0x01;
+			break;
+		default:
+			result.flags |= PLRANA_BAD_CMD;	// ignored by DoCommand
+			break;
+		}
+	}
+	if (filePos > _fileLen)
+		result.flags |= PLRANA_BAD_CMD;	// the last command was truncated
+	result.songLen = fileTick;
+	if (_fileHdr.loopFrame != 0 && result.loopTick == (UINT32)-1)
+		result.flags |= PLRANA_LOOP_INVALID;	// the loop frame is beyond the end of the song
+	
+	return 0x00;
+}
+
 size_t GYMPlayer::DeviceID2OptionID(UINT32 id) const
 {
 	DEV_ID type;
@@ -943,7 +994,7 @@ UINT32 GYMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
+					ResampleDeviceOutput(clDev, smplStep, &data[curSmpl], _playOpts.genOpts.skipSilentDevs);
 			}
 		}
 		curSmpl += smplStep;
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>	// for ptrdiff_t
 
 #include "../stdtype.h"
 #include "../emu/EmuStructs.h"
@@ -74,3 +75,122 @@ void FreeDeviceTree(VGM_BASEDEV* cBaseDev, UINT8 freeBase)
 	
 	return;
 }
+
+UINT32 SaveDeviceTreeState(const VGM_BASEDEV* cBaseDev, UINT32 bufSize, void* buffer)
+{
+	const VGM_BASEDEV* cDevCur;
+	UINT32 stateSize;
+	UINT8* bufPtr;
+	
+	// Each device is saved as: [UINT32 state size] [device state] [RESMPL_STATE] [resampler history]
+	stateSize = 0;
+	for (cDevCur = cBaseDev; cDevCur != NULL; cDevCur = cDevCur->linkDev)
+	{
+		DEVFUNC_READ_STATE funcSave = NULL;
+		UINT8 retVal;
+		
+		if (cDevCur->defInf.dataPtr == NULL)
+			continue;
+		retVal = SndEmu_GetDeviceFunc(cDevCur->defInf.devDef, RWF_STATE | RWF_READ, DEVRW_ALL, 0, (void**)&funcSave);
+		if (retVal || funcSave == NULL)
+			return 0;
+		stateSize += sizeof(UINT32) + funcSave(cDevCur->defInf.dataPtr, 0, NULL) + sizeof(RESMPL_STATE);
+		stateSize += Resmpl_GetHistorySize(&cDevCur->resmpl);
+	}
+	if (buffer == NULL || bufSize < stateSize)
+		return stateSize;
+	
+	bufPtr = (UINT8*)buffer;
+	for (cDevCur = cBaseDev; cDevCur != NULL; cDevCur = cDevCur->linkDev)
+	{
+		DEVFUNC_READ_STATE funcSave = NULL;
+		UINT32 devSize;
+		
+		if (cDevCur->defInf.dataPtr == NULL)
+			continue;
+		SndEmu_GetDeviceFunc(cDevCur->defInf.devDef, RWF_STATE | RWF_READ, DEVRW_ALL, 0, (void**)&funcSave);
+		devSize = funcSave(cDevCur->defInf.dataPtr, 0, NULL);
+		memcpy(bufPtr, &devSize, sizeof(UINT32));	bufPtr += sizeof(UINT32);
+		funcSave(cDevCur->defInf.dataPtr, devSize, bufPtr);	bufPtr += devSize;
+		memcpy(bufPtr, &cDevCur->resmpl, sizeof(RESMPL_STATE));	bufPtr += sizeof(RESMPL_STATE);
+		Resmpl_SaveHistory(&cDevCur->resmpl, bufPtr);	bufPtr += Resmpl_GetHistorySize(&cDevCur->resmpl);
+	}
+	
+	return stateSize;
+}
+
+UINT8 LoadDeviceTreeState(VGM_BASEDEV* cBaseDev, UINT32 dataSize, const void* data)
+{
+	VGM_BASEDEV* cDevCur;
+	const UINT8* dataPtr;
+	const UINT8* dataEnd;
+	
+	dataPtr = (const UINT8*)data;
+	dataEnd = dataPtr + dataSize;
+	for (cDevCur = cBaseDev; cDevCur != NULL; cDevCur = cDevCur->linkDev)
+	{
+		DEVFUNC_WRITE_STATE funcLoad = NULL;
+		RESMPL_STATE* resmpl;
+		RESMPL_STATE rsState;
+		UINT32 devSize;
+		const UINT8* histData;
+		UINT32 histSize;
+		UINT8 retVal;
+		
+		if (cDevCur->defInf.dataPtr == NULL)
+			continue;
+		if (dataEnd - dataPtr < (ptrdiff_t)sizeof(UINT32))
+			return 0xFF;
+		memcpy(&devSize, dataPtr, sizeof(UINT32));	dataPtr += sizeof(UINT32);
+		if ((size_t)(dataEnd - dataPtr) < devSize + sizeof(RESMPL_STATE))
+			return 0xFF;
+		
+		retVal = SndEmu_GetDeviceFunc(cDevCur->defInf.devDef, RWF_STATE | RWF_WRITE, DEVRW_ALL, 0, (void**)&funcLoad);
+		if (retVal || funcLoad == NULL)
+			return 0xFF;
+		retVal = funcLoad(cDevCur->defInf.dataPtr, devSize, dataPtr);	dataPtr += devSize;
+		if (retVal)
+			return retVal;
+		
+		// restore the resampling position and filter history (buffers and callbacks belong to the current instance)
+		resmpl = &cDevCur->resmpl;
+		memcpy(&rsState, dataPtr, sizeof(RESMPL_STATE));	dataPtr += sizeof(RESMPL_STATE);
+		histSize = Resmpl_GetHistorySize(&rsState);
+		if ((size_t)(dataEnd - dataPtr) < histSize)
+			return 0xFF;
+		histData = dataPtr;	dataPtr += histSize;
+		if (resmpl->resampler == NULL)
+			continue;
+		if (resmpl->smpRateSrc != rsState.smpRateSrc)
+			Resmpl_ChangeRate(resmpl, rsState.smpRateSrc);
+		resmpl->smpP = rsState.smpP;
+		resmpl->smpLast = rsState.smpLast;
+		resmpl->smpNext = rsState.smpNext;
+		resmpl->lSmpl = rsState.lSmpl;
+		resmpl->nSmpl = rsState.nSmpl;
+		Resmpl_LoadHistory(resmpl, histSize, histData);
+	}
+	
+	return (dataPtr == dataEnd) ? 0x00 : 0xFF;
+}
+
+UINT8 IsDeviceSilent(const VGM_BASEDEV* cDev)
+{
+	DEVFUNC_READ_SILENCE funcSilent = NULL;
+	UINT8 retVal;
+	
+	retVal = SndEmu_GetDeviceFunc(cDev->defInf.devDef, RWF_SILENCE | RWF_READ, DEVRW_VALUE, 0, (void**)&funcSilent);
+	if (retVal || funcSilent == NULL)
+		return 0;
+	return funcSilent(cDev->defInf.dataPtr);
+}
+
+void ResampleDeviceOutput(VGM_BASEDEV* cDev, UINT32 smplCnt, WAVE_32BS* data, UINT8 skipSilent)
+{
+	if (skipSilent && IsDeviceSilent(cDev))
+		Resmpl_ExecuteSilent(&cDev->resmpl, smplCnt, data);
+	else
+		Resmpl_Execute(&cDev->resmpl, smplCnt, data);
+	
+	return;
+}
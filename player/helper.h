@@ -24,6 +24,17 @@ typedef void (*SETUPLINKDEV_CB)(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO
 
 void SetupLinkedDevices(VGM_BASEDEV* cBaseDev, SETUPLINKDEV_CB devCfgCB, void* cbUserParam);
 void FreeDeviceTree(VGM_BASEDEV* cBaseDev, UINT8 freeBase);
+// save/restore the state of a device, its linked devices and their resamplers
+// SaveDeviceTreeState returns the size of the state data (buffer == NULL: only return the size)
+// or 0 if one of the devices doesn't support saving its state.
+UINT32 SaveDeviceTreeState(const VGM_BASEDEV* cBaseDev, UINT32 bufSize, void* buffer);
+UINT8 LoadDeviceTreeState(VGM_BASEDEV* cBaseDev, UINT32 dataSize, const void* data);
+// returns 1 if the device reports silent output until its next write (see RWF_SILENCE)
+UINT8 IsDeviceSilent(const VGM_BASEDEV* cDev);
+// render a device via its resampler and add the result to "data"
+// With skipSilent set, silent devices aren't updated, only the remaining tail of their previous
+// output is resampled. (not sample-exact, see PLR_GEN_OPTS::skipSilentDevs)
+void ResampleDeviceOutput(VGM_BASEDEV* cDev, UINT32 smplCnt, WAVE_32BS* data, UINT8 skipSilent);
 
 #ifdef __cplusplus
 }
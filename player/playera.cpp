@@ -6,85 +6,27 @@
 #include "../utils/DataLoader.h"
 #include "playerbase.hpp"
 #include "../emu/Resampler.h"
+#include "../emu/mixkernels.h"
 
 #include "playera.hpp"
 
-static void SampleConv_toU8(void* buffer, INT32 value)
-{
-	value >>= 16;	// 24 bit -> 8 bit
-	if (value < -0x80)
-		value = -0x80;
-	else if (value > +0x7F)
-		value = +0x7F;
-	*(UINT8*)buffer = (UINT8)(0x80 + value);
-	return;
-}
-
-static void SampleConv_toS16(void* buffer, INT32 value)
-{
-	INT16 v;
-	value >>= 8;	// 24 bit -> 16 bit
-	if (value < -0x8000)
-		value = -0x8000;
-	else if (value > +0x7FFF)
-		value = +0x7FFF;
-	v = (INT16)value;
-	memcpy(buffer,&v,sizeof(v));
-	return;
-}
-
-static void SampleConv_toS24(void* buffer, INT32 value)
-{
-	UINT8 tmp[3];
-	if (value < -0x800000)
-		value = -0x800000;
-	else if (value > +0x7FFFFF)
-		value = +0x7FFFFF;
-#if defined(VGM_LITTLE_ENDIAN)
-	tmp[0] = ( value       ) & 0xFF;
-	tmp[1] = ( value >> 8  ) & 0xFF;
-	tmp[2] = ( value >> 16 ) & 0xFF;
-#elif defined(VGM_BIG_ENDIAN)
-	tmp[0] = ( value >> 16 ) & 0xFF;
-	tmp[1] = ( value >> 8  ) & 0xFF;
-	tmp[2] = ( value       ) & 0xFF;
-#else
-#error unknown endianness
-#endif
-	memcpy(buffer,tmp,sizeof(tmp));
-	return;
-}
+#define FADE_BLKSIZE	0x100	// number of samples per block while fading
 
-static void SampleConv_toS32(void* buffer, INT32 value)
-{
-	// internal scale is 24-bit, so limit to that
-	if (value < -0x800000)
-		value = -0x800000;
-	else if (value > +0x7FFFFF)
-		value = +0x7FFFFF;
-	value *= (1 << 8);	// 24 bit -> 32 bit
-	memcpy(buffer,&value,sizeof(value));
-	return;
-}
-
-static void SampleConv_toF32(void* buffer, INT32 value)
-{
-	// limiting not required here
-	float v = value / (float)0x800000;
-	memcpy(buffer,&v,sizeof(v));
-	return;
-}
-
-static PlayerA::PLR_SMPL_PACK GetSampleConvFunc(UINT8 bits)
+static PlayerA::PLR_SMPL_BLKPACK GetSampleConvFunc(UINT8 bits, UINT8 format)
 {
+	if (format == PLAYSMPL_FLOAT)
+		return (bits == 32) ? MixK_Pack_F32 : NULL;
+	else if (format != PLAYSMPL_INT)
+		return NULL;
+	
 	if (bits == 8)
-		return SampleConv_toU8;
+		return MixK_Pack_U8;
 	else if (bits == 16)
-		return SampleConv_toS16;
+		return MixK_Pack_S16;
 	else if (bits == 24)
-		return SampleConv_toS24;
+		return MixK_Pack_S24;
 	else if (bits == 32)
-		return SampleConv_toS32;
+		return MixK_Pack_S32;
 	else
 		return NULL;
 }
@@ -101,7 +43,8 @@ PlayerA::PlayerA()
 	
 	_outSmplChns = 2;
 	_outSmplBits = 16;
-	_outSmplPack = GetSampleConvFunc(_outSmplBits);
+	_outSmplFmt = PLAYSMPL_INT;
+	_outSmplPack = GetSampleConvFunc(_outSmplBits, _outSmplFmt);
 	_smplRate = 44100;
 	_outSmplSize1 = _outSmplBits / 8;
 	_outSmplSizeA = _outSmplSize1 * _outSmplChns;
@@ -149,16 +92,17 @@ const std::vector<PlayerBase*>& PlayerA::GetRegisteredPlayers(void) const
 	return _avbPlrs;
 }
 
-UINT8 PlayerA::SetOutputSettings(UINT32 smplRate, UINT8 channels, UINT8 smplBits, UINT32 smplBufferLen)
+UINT8 PlayerA::SetOutputSettings(UINT32 smplRate, UINT8 channels, UINT8 smplBits, UINT32 smplBufferLen, UINT8 smplFmt)
 {
 	if (channels != 2)
 		return 0xF0;	// TODO: support channels = 1
-	PLR_SMPL_PACK smplPackFunc = GetSampleConvFunc(smplBits);
+	PLR_SMPL_BLKPACK smplPackFunc = GetSampleConvFunc(smplBits, smplFmt);
 	if (smplPackFunc == NULL)
 		return 0xF1;	// unsupported sample format
 	
 	_outSmplChns = channels;
 	_outSmplBits = smplBits;
+	_outSmplFmt = smplFmt;
 	_outSmplPack = smplPackFunc;
 	SetSampleRate(smplRate);
 	_outSmplSize1 = _outSmplBits / 8;
@@ -484,21 +428,6 @@ UINT8 PlayerA::Seek(UINT8 unit, UINT32 pos)
 	return retVal;
 }
 
-#if 1
-#define VOLCALC64
-#define VOL_BITS	16	// use .X fixed point for working volume
-#else
-#define VOL_BITS	8	// use .X fixed point for working volume
-#endif
-#define VOL_SHIFT	(16 - VOL_BITS)	// shift for master volume -> working volume
-
-// Pre- and post-shifts are used to make the calculations as accurate as possible
-// without causing the sample data (likely 24 bits) to overflow while applying the volume gain.
-// Smaller values for VOL_PRESH are more accurate, but have a higher risk of overflows during calculations.
-// (24 + VOL_POSTSH) must NOT be larger than 31
-#define VOL_PRESH	4	// sample data pre-shift
-#define VOL_POSTSH	(VOL_BITS - VOL_PRESH)	// post-shift after volume multiplication
-
 // 16.16 fixed point multiplication
 #define MUL16X16_FIXED(a, b)	(INT32)(((INT64)a * b) >> 16)
 
@@ -543,6 +472,36 @@ INT32 PlayerA::CalcCurrentVolume(UINT32 playbackSmpl)
 	return curVol;
 }
 
+// Calculates the same values as CalcCurrentVolume() for the samples
+// playbackSmpl .. playbackSmpl+smplCount-1, which must all be within the fade time.
+// The fade factor is stepped incrementally, so there is no division per sample.
+void PlayerA::CalcFadeVolumes(UINT32 playbackSmpl, UINT32 smplCount, INT32* volumes)
+{
+	UINT32 fadeLen = _config.fadeSmpls;
+	UINT64 fadeNum = (UINT64)(playbackSmpl - _fadeSmplStart) * 0x10000;
+	UINT64 fadeQuot = fadeNum / fadeLen;	// = fadeSmpls * 0x10000 / fadeLen
+	UINT32 fadeRem = (UINT32)(fadeNum % fadeLen);
+	UINT32 stepQuot = 0x10000 / fadeLen;
+	UINT32 stepRem = 0x10000 % fadeLen;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < smplCount; curSmpl ++)
+	{
+		UINT64 fadeVol = 0x10000 - fadeQuot;
+		fadeVol = fadeVol * fadeVol;
+		volumes[curSmpl] = (INT32)(((INT64)fadeVol * _songVolume) >> 32);
+		
+		fadeQuot += stepQuot;
+		fadeRem += stepRem;
+		if (fadeRem >= fadeLen)
+		{
+			fadeQuot ++;
+			fadeRem -= fadeLen;
+		}
+	}
+	return;
+}
+
 UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 {
 	UINT8* bData = (UINT8*)data;
@@ -550,8 +509,8 @@ UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 	UINT32 smplCount;
 	UINT32 smplRendered;
 	UINT32 curSmpl;
-	WAVE_32BS fnlSmpl;	// final sample value
-	INT32 curVolume;
+	INT32 curVolume;	// 16.16 fixed point
+	INT32 fadeVols[FADE_BLKSIZE];
 	
 	smplCount = bufSize / _outSmplSizeA;
 	if (_player == NULL)
@@ -579,9 +538,16 @@ UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 	smplRendered = _player->Render(smplCount, &_smplBuf[0]);
 	smplCount = smplRendered;
 	
-	curVolume = CalcCurrentVolume(basePbSmpl) >> VOL_SHIFT;
-	for (curSmpl = 0; curSmpl < smplCount; curSmpl ++, basePbSmpl ++)
+	// The volume is applied while converting the samples into the output format.
+	// Blocks are split at the fade/end silence boundaries, so that the volume is constant within a block.
+	// While fading, the per-sample volume ramp is applied to the block in place before converting it.
+	curVolume = CalcCurrentVolume(basePbSmpl);
+	curSmpl = 0;
+	while(curSmpl < smplCount)
 	{
+		UINT32 blkSmpls = smplCount - curSmpl;
+		UINT8 isFading = 0;
+		
 		if (basePbSmpl >= _fadeSmplStart)
 		{
 			UINT32 fadeSmpls = basePbSmpl - _fadeSmplStart;
@@ -592,7 +558,19 @@ UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 				_myPlayState |= PLAYSTATE_END;
 			}
 			
-			curVolume = CalcCurrentVolume(basePbSmpl) >> VOL_SHIFT;
+			curVolume = CalcCurrentVolume(basePbSmpl);
+			if (fadeSmpls < _config.fadeSmpls)
+			{
+				isFading = 1;
+				if (blkSmpls > _config.fadeSmpls - fadeSmpls)
+					blkSmpls = _config.fadeSmpls - fadeSmpls;
+				if (blkSmpls > FADE_BLKSIZE)
+					blkSmpls = FADE_BLKSIZE;
+			}
+		}
+		else if (blkSmpls > _fadeSmplStart - basePbSmpl)
+		{
+			blkSmpls = _fadeSmplStart - basePbSmpl;
 		}
 		if (basePbSmpl >= _endSilenceStart)
 		{
@@ -607,26 +585,25 @@ UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 				// stop playback at this point, but we shouldn't really do this.
 				break;
 			}
+			if (silenceSmpls < _config.endSilenceSmpls && blkSmpls > _config.endSilenceSmpls - silenceSmpls)
+				blkSmpls = _config.endSilenceSmpls - silenceSmpls;
+		}
+		else if (blkSmpls > _endSilenceStart - basePbSmpl)
+		{
+			blkSmpls = _endSilenceStart - basePbSmpl;
 		}
 		
-		// Input is about 24 bits (some cores might output a bit more)
-		fnlSmpl = _smplBuf[curSmpl];
-		
-#ifdef VOLCALC64
-		fnlSmpl.L = (INT32)( ((INT64)fnlSmpl.L * curVolume) >> VOL_BITS );
-		fnlSmpl.R = (INT32)( ((INT64)fnlSmpl.R * curVolume) >> VOL_BITS );
-#else
-		fnlSmpl.L = ((fnlSmpl.L >> VOL_PRESH) * curVolume) >> VOL_POSTSH;
-		fnlSmpl.R = ((fnlSmpl.R >> VOL_PRESH) * curVolume) >> VOL_POSTSH;
-#endif
-		
-		if (_config.chnInvert & 0x01)
-			fnlSmpl.L = -fnlSmpl.L;
-		if (_config.chnInvert & 0x02)
-			fnlSmpl.R = -fnlSmpl.R;
+		if (isFading)
+		{
+			CalcFadeVolumes(basePbSmpl, blkSmpls, fadeVols);
+			MixK_ApplyVolRamp(&_smplBuf[curSmpl], fadeVols, blkSmpls);
+			curVolume = 0x10000;	// volume was applied already
+		}
 		
-		_outSmplPack(&bData[(curSmpl * 2 + 0) * _outSmplSize1], fnlSmpl.L);
-		_outSmplPack(&bData[(curSmpl * 2 + 1) * _outSmplSize1], fnlSmpl.R);
+		// Input is about 24 bits (some cores might output a bit more)
+		_outSmplPack(&bData[curSmpl * _outSmplSizeA], &_smplBuf[curSmpl], blkSmpls, curVolume, _config.chnInvert);
+		curSmpl += blkSmpls;
+		basePbSmpl += blkSmpls;
 	}
 	
 	return curSmpl * _outSmplSizeA;
@@ -17,6 +17,9 @@
 #define PLAYTIME_WITH_FADE	0x10	// include fade out time (looping songs only)
 #define PLAYTIME_WITH_SLNC	0x20	// include silence after songs
 
+#define PLAYSMPL_INT	0x00	// integer samples (8 bit unsigned, 16/24/32 bit signed)
+#define PLAYSMPL_FLOAT	0x01	// IEEE float samples (32 bit only, 1.0 = 24-bit full scale)
+
 // TODO: find a proper name for this class
 class PlayerA
 {
@@ -32,6 +35,7 @@ public:
 		double pbSpeed;
 	};
 	typedef void (*PLR_SMPL_PACK)(void* buffer, INT32 value);
+	typedef void (*PLR_SMPL_BLKPACK)(void* buffer, const WAVE_32BS* smpls, UINT32 count, INT32 volume, UINT8 invert);	// converts a block of samples, applying volume and phase inversion
 
 	PlayerA();
 	~PlayerA();
@@ -39,7 +43,7 @@ public:
 	void UnregisterAllPlayers(void);
 	const std::vector<PlayerBase*>& GetRegisteredPlayers(void) const;
 	
-	UINT8 SetOutputSettings(UINT32 smplRate, UINT8 channels, UINT8 smplBits, UINT32 smplBufferLen);
+	UINT8 SetOutputSettings(UINT32 smplRate, UINT8 channels, UINT8 smplBits, UINT32 smplBufferLen, UINT8 smplFmt = PLAYSMPL_INT);
 	UINT32 GetSampleRate(void) const;
 	void SetSampleRate(UINT32 sampleRate);
 	double GetPlaybackSpeed(void) const;
@@ -81,6 +85,7 @@ private:
 	void FindPlayerEngine(void);
 	INT32 CalcSongVolume(void);
 	INT32 CalcCurrentVolume(UINT32 playbackSmpl);
+	void CalcFadeVolumes(UINT32 playbackSmpl, UINT32 smplCount, INT32* volumes);
 	static UINT8 PlayCallbackS(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam);
 	UINT8 PlayCallback(PlayerBase* player, UINT8 evtType, void* evtParam);
 	
@@ -93,9 +98,10 @@ private:
 	
 	UINT8 _outSmplChns;
 	UINT8 _outSmplBits;
+	UINT8 _outSmplFmt;
 	UINT32 _outSmplSize1;	// for 1 channel
 	UINT32 _outSmplSizeA;	// for all channels
-	PLR_SMPL_PACK _outSmplPack;
+	PLR_SMPL_BLKPACK _outSmplPack;
 	std::vector<WAVE_32BS> _smplBuf;
 	PlayerBase* _player;
 	DATA_LOADER* _dLoad;
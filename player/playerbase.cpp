@@ -12,7 +12,8 @@ PlayerBase::PlayerBase() :
 	_fileReqCbFunc(NULL),
 	_fileReqCbParam(NULL),
 	_logCbFunc(NULL),
-	_logCbParam(NULL)
+	_logCbParam(NULL),
+	_romCache(NULL)
 {
 }
 
@@ -108,6 +109,58 @@ void PlayerBase::SetLogCallback(PLAYER_LOG_CB cbFunc, void* cbParam)
 	return;
 }
 
+UINT8 PlayerBase::SetRomCache(RomCache* cache)
+{
+	if (GetState() & PLAYSTATE_PLAY)
+		return 0xFF;
+	_romCache = cache;
+	
+	return 0x00;
+}
+
+UINT8 PlayerBase::AnalyzeSong(PLR_ANALYSIS& result) const
+{
+	return 0xFF;	// not implemented
+}
+
+/*static*/ void PlayerBase::InitAnalysis(PLR_ANALYSIS& result, const std::vector<PLR_DEV_INFO>& devInfList)
+{
+	size_t curDev;
+	
+	result.songLen = 0;
+	result.loopTick = (UINT32)-1;
+	result.flags = 0x00;
+	result.cmdCount = 0;
+	result.dblkCount = 0;
+	result.dblkBytes = 0;
+	result.dacStrmMax = 0;
+	result.strayWrites = 0;
+	result.devices.clear();
+	result.devices.resize(devInfList.size());
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		PLR_ANALYSIS_DEV& aDev = result.devices[curDev];
+		aDev.id = devInfList[curDev].id;
+		if (aDev.id == (UINT32)-1)	// the device isn't running yet
+			aDev.id = PLR_DEV_ID(devInfList[curDev].type, devInfList[curDev].instance);
+		aDev.type = devInfList[curDev].type;
+		aDev.instance = devInfList[curDev].instance;
+		aDev.writeCnt = 0;
+	}
+	
+	return;
+}
+
+/*static*/ void PlayerBase::AnalysisWrite(PLR_ANALYSIS_DEV& aDev, UINT32 reg)
+{
+	aDev.writeCnt ++;
+	if (reg >= aDev.regWrites.size())
+		aDev.regWrites.resize(reg + 1, 0);
+	aDev.regWrites[reg] ++;
+	
+	return;
+}
+
 double PlayerBase::Sample2Second(UINT32 samples) const
 {
 	if (samples == (UINT32)-1)
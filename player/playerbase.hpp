@@ -71,6 +71,35 @@ struct PLR_DEV_INFO
 	std::vector<PLR_DEV_INFO> devLink;
 };
 
+// PLR_ANALYSIS flags
+#define PLRANA_LEN_MISMATCH		0x01	// measured song length differs from the one in the file header
+#define PLRANA_LOOP_MISMATCH	0x02	// measured loop position/length differs from the one in the file header
+#define PLRANA_LOOP_INVALID		0x04	// loop offset doesn't point to the start of a command
+#define PLRANA_EARLY_END		0x08	// command data ends without an "end of data" command
+#define PLRANA_BAD_CMD			0x10	// found an unknown/truncated command
+
+struct PLR_ANALYSIS_DEV
+{
+	UINT32 id;		// device ID (same as PLR_DEV_INFO::id, PLR_DEV_ID(type, instance) if that isn't set)
+	DEV_ID type;	// device type
+	UINT8 instance;	// instance ID of this device type (0xFF -> N/A for this format)
+	UINT32 writeCnt;	// total number of register/memory writes
+	std::vector<UINT32> regWrites;	// number of writes per register, index: (port << 8) | register (or memory offset)
+};
+
+struct PLR_ANALYSIS
+{
+	UINT32 songLen;		// measured song length in ticks
+	UINT32 loopTick;	// measured tick position of the loop point (-1 = no loop)
+	UINT8 flags;		// see PLRANA_* constants
+	UINT32 cmdCount;	// number of processed commands
+	UINT32 dblkCount;	// number of data blocks
+	UINT32 dblkBytes;	// total size of all data blocks (decompressed)
+	UINT32 dacStrmMax;	// maximum number of DAC streams playing at the same time
+	UINT32 strayWrites;	// writes to devices that are not present in the song's device list
+	std::vector<PLR_ANALYSIS_DEV> devices;	// one entry per device from GetSongDeviceInfo()
+};
+
 struct PLR_MUTE_OPTS
 {
 	UINT8 disable;		// suspend emulation (0x01 = main device, 0x02 = linked, 0xFF = all)
@@ -87,7 +116,7 @@ struct PLR_DEV_OPTS
 {
 	UINT32 emuCore[2];	// enforce a certain sound core (0 = use default, [1] is used for linked devices)
 	UINT8 srMode;		// sample rate mode (see DEVRI_SRMODE)
-	UINT8 resmplMode;	// resampling mode (0 - high quality, 1 - low quality, 2 - LQ down, HQ up)
+	UINT8 resmplMode;	// resampling mode (0 - high quality, 1 - low quality, 2 - LQ down, HQ up, 3 - windowed sinc)
 	UINT32 smplRate;	// emulaiton sample rate
 	UINT32 coreOpts;
 	PLR_MUTE_OPTS muteOpts;
@@ -97,6 +126,9 @@ struct PLR_DEV_OPTS
 struct PLR_GEN_OPTS
 {
 	UINT32 pbSpeed; // playback speed (16.16 fixed point scale, 0x10000 = 100%)
+	UINT8 skipSilentDevs;	// don't update devices while they report silence (see RWF_SILENCE)
+							// Note: Not sample-exact. Free-running chip state (tone/noise counters,
+							// LFO, envelope clock) pauses, so later notes can start at a different phase.
 };
 
 
@@ -104,6 +136,8 @@ struct PLR_GEN_OPTS
 //	- Player class does file rendering at fixed volume (but changeable speed)
 //	- host program handles master volume + fading + stopping after X loops (notified via callback)
 
+class RomCache;
+
 // TODO: rename to "PlayerEngine"
 class PlayerBase
 {
@@ -121,6 +155,9 @@ public:
 	virtual const char* const* GetTags(void) = 0;
 	virtual UINT8 GetSongInfo(PLR_SONG_INFO& songInf) = 0;
 	virtual UINT8 GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const = 0;
+	// Parse the whole song without emulating any sound devices and measure length/loop and device usage.
+	// This doesn't depend on the playback state and doesn't use the song length from the file header.
+	virtual UINT8 AnalyzeSong(PLR_ANALYSIS& result) const;
 	static UINT8 InitDeviceOptions(PLR_DEV_OPTS& devOpts);
 	virtual UINT8 SetDeviceOptions(UINT32 id, const PLR_DEV_OPTS& devOpts) = 0;
 	virtual UINT8 GetDeviceOptions(UINT32 id, PLR_DEV_OPTS& devOpts) const = 0;
@@ -138,6 +175,8 @@ public:
 	virtual void SetEventCallback(PLAYER_EVENT_CB cbFunc, void* cbParam);
 	virtual void SetFileReqCallback(PLAYER_FILEREQ_CB cbFunc, void* cbParam);
 	virtual void SetLogCallback(PLAYER_LOG_CB cbFunc, void* cbParam);
+	// share ROM/PCM data with other players (NULL = disable), can't be changed while playing
+	virtual UINT8 SetRomCache(RomCache* cache);
 	virtual UINT32 Tick2Sample(UINT32 ticks) const = 0;
 	virtual UINT32 Sample2Tick(UINT32 samples) const = 0;
 	virtual double Tick2Second(UINT32 ticks) const = 0;
@@ -157,6 +196,9 @@ public:
 	virtual UINT32 Render(UINT32 smplCnt, WAVE_32BS* data) = 0;
 	
 protected:
+	static void InitAnalysis(PLR_ANALYSIS& result, const std::vector<PLR_DEV_INFO>& devInfList);
+	static void AnalysisWrite(PLR_ANALYSIS_DEV& aDev, UINT32 reg);
+	
 	UINT32 _outSmplRate;
 	const DEV_DECL** _userDevList;
 	UINT8 _devStartOpts;
@@ -166,6 +208,7 @@ protected:
 	void* _fileReqCbParam;
 	PLAYER_LOG_CB _logCbFunc;
 	void* _logCbParam;
+	RomCache* _romCache;
 };
 
 #endif	// __PLAYERBASE_HPP__
@@ -0,0 +1,172 @@
+#include <string.h>	// for memcpy()
+#include <vector>
+#include <map>
+
+#include "../stdtype.h"
+#include "romcache.hpp"
+#include "../utils/OSMutex.h"
+
+RomCache::RomCache() :
+	_mutex(NULL),
+	_memUsage(0)
+{
+	OSMutex_Init(&_mutex, 0);
+}
+
+RomCache::~RomCache()
+{
+	std::map<HASH, ITEM*>::iterator itmIt;
+	
+	for (itmIt = _items.begin(); itmIt != _items.end(); ++itmIt)
+		delete itmIt->second;
+	_items.clear();
+	OSMutex_Deinit(_mutex);
+}
+
+/*static*/ RomCache::HASH RomCache::CalcHash(size_t length, const void* data, HASH seed)
+{
+	// simple 64-bit multiply/xorshift hash, processing 8 bytes at once
+	static const UINT64 HMUL = 0x9E3779B97F4A7C15ULL;
+	const UINT8* ptr = (const UINT8*)data;
+	size_t remLen = length;
+	UINT64 h = seed ^ 0xCBF29CE484222325ULL;
+	UINT64 w;
+	
+	while(remLen >= 8)
+	{
+		memcpy(&w, ptr, 8);	// Note: byte order is irrelevant, as long as it is consistent
+		h = (h ^ w) * HMUL;
+		h ^= h >> 29;
+		ptr += 8;	remLen -= 8;
+	}
+	if (remLen > 0)
+	{
+		w = 0;
+		memcpy(&w, ptr, remLen);
+		h = (h ^ w) * HMUL;
+		h ^= h >> 29;
+	}
+	
+	// include the length and do a final mix
+	h ^= (UINT64)length;
+	h ^= h >> 33;	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/*static*/ bool RomCache::ItemMatches(const ITEM* item, const std::vector<UINT8>& srcData, size_t dataLen)
+{
+	if (dataLen > 0 && item->data.size() != dataLen)
+		return false;
+	if (item->srcData.size() != srcData.size())
+		return false;
+	return srcData.empty() || ! memcmp(&item->srcData[0], &srcData[0], srcData.size());
+}
+
+const RomCache::ITEM* RomCache::Acquire(HASH key, const std::vector<UINT8>& srcData, size_t dataLen)
+{
+	std::map<HASH, ITEM*>::iterator itmIt;
+	ITEM* item = NULL;
+	
+	OSMutex_Lock(_mutex);
+	itmIt = _items.find(key);
+	if (itmIt != _items.end() && ItemMatches(itmIt->second, srcData, dataLen))
+	{
+		item = itmIt->second;
+		item->refCnt ++;
+	}
+	OSMutex_Unlock(_mutex);
+	
+	return item;
+}
+
+const RomCache::ITEM* RomCache::Insert(HASH key, std::vector<UINT8>& srcData, std::vector<UINT8>& data)
+{
+	std::map<HASH, ITEM*>::iterator itmIt;
+	ITEM* item;
+	
+	OSMutex_Lock(_mutex);
+	itmIt = _items.find(key);
+	if (itmIt != _items.end())
+	{
+		item = itmIt->second;	// another player was faster
+		if (! ItemMatches(item, srcData, data.size()))
+		{
+			OSMutex_Unlock(_mutex);
+			return NULL;	// hash collision - the caller has to keep its own copy
+		}
+	}
+	else
+	{
+		item = new ITEM;
+		item->key = key;
+		item->srcData.swap(srcData);
+		item->data.swap(data);
+		item->refCnt = 0;
+		_items[key] = item;
+		_memUsage += item->srcData.size() + item->data.size();
+	}
+	item->refCnt ++;
+	OSMutex_Unlock(_mutex);
+	
+	return item;
+}
+
+void RomCache::Release(const ITEM* item)
+{
+	if (item == NULL)
+		return;
+	
+	OSMutex_Lock(_mutex);
+	std::map<HASH, ITEM*>::iterator itmIt = _items.find(item->key);
+	if (itmIt != _items.end() && itmIt->second->refCnt > 0)
+		itmIt->second->refCnt --;
+	OSMutex_Unlock(_mutex);
+	
+	return;
+}
+
+void RomCache::Purge(void)
+{
+	std::map<HASH, ITEM*>::iterator itmIt;
+	
+	OSMutex_Lock(_mutex);
+	for (itmIt = _items.begin(); itmIt != _items.end(); )
+	{
+		ITEM* item = itmIt->second;
+		if (item->refCnt > 0)
+		{
+			++itmIt;
+			continue;
+		}
+		_memUsage -= item->srcData.size() + item->data.size();
+		delete item;
+		_items.erase(itmIt++);
+	}
+	OSMutex_Unlock(_mutex);
+	
+	return;
+}
+
+size_t RomCache::GetItemCount(void) const
+{
+	size_t count;
+	
+	OSMutex_Lock(_mutex);
+	count = _items.size();
+	OSMutex_Unlock(_mutex);
+	
+	return count;
+}
+
+size_t RomCache::GetMemoryUsage(void) const
+{
+	size_t memUse;
+	
+	OSMutex_Lock(_mutex);
+	memUse = _memUsage;
+	OSMutex_Unlock(_mutex);
+	
+	return memUse;
+}
@@ -0,0 +1,59 @@
+#ifndef __ROMCACHE_HPP__
+#define __ROMCACHE_HPP__
+
+#include "../stdtype.h"
+#include "../utils/OSMutex.h"
+#include <vector>
+#include <map>
+
+// Process-wide store for ROM/PCM data that can be shared by multiple player instances.
+// Items are addressed by a hash of the data they were generated from (see CalcHash)
+// and are reference-counted. All functions are thread-safe.
+// The source data is stored along with the item and compared on every lookup,
+// so items are never shared because of a hash collision.
+// Unreferenced items are kept (for the next song using the same data) until Purge() is called.
+// The cache must outlive all players that use it.
+class RomCache
+{
+public:
+	typedef UINT64 HASH;
+	struct ITEM
+	{
+		HASH key;
+		std::vector<UINT8> srcData;	// data the item was generated from (identifies the item)
+		std::vector<UINT8> data;	// read-only while the item is in the cache
+		UINT32 refCnt;
+	};
+	
+	RomCache();
+	~RomCache();
+	
+	// calculate a hash of a block of data, "seed" can be used to chain multiple blocks
+	static HASH CalcHash(size_t length, const void* data, HASH seed = 0);
+	
+	// Get the item with the specified key and source data and take a reference to it.
+	// Returns NULL if it isn't cached or when the item's data size differs from "dataLen" (0 = any size).
+	const ITEM* Acquire(HASH key, const std::vector<UINT8>& srcData, size_t dataLen);
+	// Add data to the cache and take a reference to it.
+	// The contents of "srcData" and "data" are moved into the item (both are empty afterwards).
+	// If an item with the same key and source data exists already, it is returned instead and
+	// "srcData"/"data" stay untouched.
+	// Returns NULL (leaving "srcData"/"data" untouched) when the key is used by an item with
+	// different contents. (i.e. a hash collision)
+	const ITEM* Insert(HASH key, std::vector<UINT8>& srcData, std::vector<UINT8>& data);
+	// release a reference taken by Acquire/Insert
+	void Release(const ITEM* item);
+	// free all unreferenced items
+	void Purge(void);
+	
+	size_t GetItemCount(void) const;
+	size_t GetMemoryUsage(void) const;	// size of the data (including source data) of all items
+private:
+	static bool ItemMatches(const ITEM* item, const std::vector<UINT8>& srcData, size_t dataLen);
+	
+	OS_MUTEX* _mutex;
+	std::map<HASH, ITEM*> _items;
+	size_t _memUsage;
+};
+
+#endif	// __ROMCACHE_HPP__
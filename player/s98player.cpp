@@ -106,9 +106,14 @@ S98Player::S98Player() :
 	UINT8 chipID;
 
 	_playOpts.genOpts.pbSpeed = 0x10000;
+	_playOpts.genOpts.skipSilentDevs = 0;
+	_playOpts.keyframeInterval = 0;
+	_playOpts.keyframeMemLimit = 32 * 1024 * 1024;	// 32 MB
 
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
+	_kfMemSize = 0;
+	_kfInterval = 0;
 	
 	dev_logger_set(&_logger, this, S98Player::PlayerLogCB, NULL);
 	
@@ -646,6 +651,77 @@ UINT8 S98Player::GetDeviceInstance(size_t id) const
 	return instance;
 }
 
+UINT8 S98Player::AnalyzeSong(PLR_ANALYSIS& result) const
+{
+	if (_dLoad == NULL)
+		return 0xFF;
+	
+	std::vector<PLR_DEV_INFO> devInfList;
+	UINT32 fileSize = DataLoader_GetSize(_dLoad);
+	UINT32 hdrLoopOfs = ReadLE32(&_fileData[0x18]);	// _fileHdr.loopOfs is cleared when invalid
+	UINT32 filePos = _fileHdr.dataOfs;
+	UINT32 fileTick = 0;
+	bool fileEnd = false;
+	UINT8 curCmd;
+	
+	GetSongDeviceInfo(devInfList);
+	InitAnalysis(result, devInfList);
+	
+	while(! fileEnd && filePos < fileSize)
+	{
+		if (filePos == hdrLoopOfs)
+			result.loopTick = fileTick;
+		
+		result.cmdCount ++;
+		curCmd = _fileData[filePos];
+		filePos ++;
+		switch(curCmd)
+		{
+		case 0xFF:	// advance 1 tick
+			fileTick ++;
+			break;
+		case 0xFE:	// advance multiple ticks
+			fileTick += 2 + ReadVarInt(filePos);
+			break;
+		case 0xFD:
+			fileEnd = true;
+			break;
+		default:
+			{
+				UINT8 devID = curCmd >> 1;
+				UINT8 reg;
+				if (filePos + 0x02 > fileSize)
+				{
+					result.flags |= PLRANA_BAD_CMD;	// the last command was truncated
+					filePos = fileSize;
+					break;
+				}
+				reg = _fileData[filePos + 0x00];
+				filePos += 0x02;
+				if (devID >= result.devices.size())
+				{
+					result.strayWrites ++;
+					break;
+				}
+				if (_devHdrs[devID].devType == S98DEV_DCSG)
+					AnalysisWrite(result.devices[devID], (reg == 1) ? SN76496_W_GGST : SN76496_W_REG);
+				else
+					AnalysisWrite(result.devices[devID], ((curCmd & 0x01) << 8) | reg);
+			}
+			break;
+		}
+	}
+	if (! fileEnd)
+		result.flags |= PLRANA_EARLY_END;
+	if (filePos > fileSize)
+		result.flags |= PLRANA_BAD_CMD;	// the last command was truncated
+	result.songLen = fileTick;
+	if (hdrLoopOfs && result.loopTick == (UINT32)-1)
+		result.flags |= PLRANA_LOOP_INVALID;
+	
+	return 0x00;
+}
+
 size_t S98Player::DeviceID2OptionID(UINT32 id) const
 {
 	DEV_ID type;
@@ -1090,6 +1166,12 @@ UINT8 S98Player::Start(void)
 		}
 	}
 	
+	_keyframes.clear();
+	_kfMemSize = 0;
+	_kfInterval = (UINT32)((UINT64)_playOpts.keyframeInterval * _fileHdr.tickDiv / _fileHdr.tickMult);	// seconds -> ticks
+	if (_playOpts.keyframeInterval && ! _kfInterval)
+		_kfInterval = 1;
+	
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
 	if (_eventCbFunc != NULL)
@@ -1110,6 +1192,8 @@ UINT8 S98Player::Stop(void)
 		FreeDeviceTree(&cDev->base, 0);
 	}
 	_devices.clear();
+	_keyframes.clear();
+	_kfMemSize = 0;
 	if (_eventCbFunc != NULL)
 		_eventCbFunc(this, _eventCbParam, PLREVT_STOP, NULL);
 	
@@ -1177,7 +1261,10 @@ UINT8 S98Player::Seek(UINT8 unit, UINT32 pos)
 	case PLAYPOS_FILEOFS:
 		_playState |= PLAYSTATE_SEEK;
 		if (pos < _filePos)
-			Reset();
+		{
+			if (LoadKeyframe(unit, pos))
+				Reset();
+		}
 		return SeekToFilePos(pos);
 	case PLAYPOS_SAMPLE:
 		pos = Sample2Tick(pos);
@@ -1185,7 +1272,10 @@ UINT8 S98Player::Seek(UINT8 unit, UINT32 pos)
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
 		if (pos < _playTick)
-			Reset();
+		{
+			if (LoadKeyframe(PLAYPOS_TICK, pos))
+				Reset();
+		}
 		return SeekToTick(pos);
 	case PLAYPOS_COMMAND:
 	default:
@@ -1215,6 +1305,126 @@ UINT8 S98Player::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+void S98Player::SaveKeyframe(UINT32 playTick)
+{
+	KEYFRAME kf;
+	size_t curDev;
+	UINT32 stateSize;
+	
+	kf.filePos = _filePos;
+	kf.fileTick = _fileTick;
+	kf.playTick = playTick;	// Note: all sound devices are rendered up to this point, but it isn't parsed yet.
+	kf.curLoop = _curLoop;
+	kf.lastLoopTick = _lastLoopTick;
+	
+	kf.stateOfs.resize(_devices.size() + 1);
+	kf.stateOfs[0] = 0;
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		stateSize = SaveDeviceTreeState(&_devices[curDev].base, 0, NULL);
+		if (! stateSize && _devices[curDev].base.defInf.dataPtr != NULL)
+		{
+			// The device doesn't support saving its state - disable keyframes.
+			emu_logf(&_logger, PLRLOG_DEBUG, "Device %s doesn't support state saving, keyframes disabled.\n",
+				_devNames[curDev].c_str());
+			_keyframes.clear();
+			_kfMemSize = 0;
+			_kfInterval = 0;
+			return;
+		}
+		kf.stateOfs[1 + curDev] = kf.stateOfs[curDev] + stateSize;
+	}
+	kf.stateData.resize(kf.stateOfs.back());
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		stateSize = (UINT32)(kf.stateOfs[1 + curDev] - kf.stateOfs[curDev]);
+		if (stateSize)
+			SaveDeviceTreeState(&_devices[curDev].base, stateSize, &kf.stateData[kf.stateOfs[curDev]]);
+	}
+	
+	kf.memSize = sizeof(KEYFRAME) + kf.stateData.size() + kf.stateOfs.size() * sizeof(size_t);
+	_kfMemSize += kf.memSize;
+	_keyframes.push_back(kf);
+	
+	// When exceeding the memory limit, drop every 2nd keyframe and double the interval.
+	while(_kfMemSize > _playOpts.keyframeMemLimit && _keyframes.size() > 1)
+	{
+		size_t curKF;
+		size_t dstKF;
+		
+		_kfMemSize = 0;
+		for (curKF = 0, dstKF = 0; curKF < _keyframes.size(); curKF += 2, dstKF ++)
+		{
+			if (dstKF != curKF)
+				std::swap(_keyframes[dstKF], _keyframes[curKF]);
+			_kfMemSize += _keyframes[dstKF].memSize;
+		}
+		_keyframes.resize(dstKF);
+		_kfInterval *= 2;
+	}
+	if (_kfMemSize > _playOpts.keyframeMemLimit)
+	{
+		emu_logf(&_logger, PLRLOG_DEBUG, "Keyframe size exceeds memory limit, keyframes disabled.\n");
+		_keyframes.clear();
+		_kfMemSize = 0;
+		_kfInterval = 0;
+	}
+	
+	return;
+}
+
+UINT8 S98Player::LoadKeyframe(UINT8 unit, UINT32 pos)
+{
+	const KEYFRAME* kf;
+	size_t curKF;
+	size_t curDev;
+	UINT8 retVal;
+	
+	// search for the last keyframe before the seek position
+	kf = NULL;
+	for (curKF = 0; curKF < _keyframes.size(); curKF ++)
+	{
+		const KEYFRAME& curKf = _keyframes[curKF];
+		if (unit == PLAYPOS_FILEOFS)
+		{
+			// file offsets are ambiguous once looping, so only use the first playthrough
+			if (curKf.curLoop > 0)
+				break;
+			if (curKf.filePos > pos)
+				break;
+		}
+		else
+		{
+			if (curKf.playTick > pos)
+				break;
+		}
+		kf = &curKf;
+	}
+	if (kf == NULL)
+		return 0xFF;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		UINT32 stateSize = (UINT32)(kf->stateOfs[1 + curDev] - kf->stateOfs[curDev]);
+		if (! stateSize)
+			continue;
+		retVal = LoadDeviceTreeState(&_devices[curDev].base, stateSize, &kf->stateData[kf->stateOfs[curDev]]);
+		if (retVal)
+			return retVal;	// Note: the caller has to call Reset() in this case
+	}
+	
+	_filePos = kf->filePos;
+	_fileTick = kf->fileTick;
+	_playTick = kf->playTick;
+	_playSmpl = Tick2Sample(_playTick);
+	_playState &= ~PLAYSTATE_END;
+	_psTrigger = 0x00;
+	_curLoop = kf->curLoop;
+	_lastLoopTick = kf->lastLoopTick;
+	
+	return 0x00;
+}
+
 UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -1228,6 +1438,11 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 	do
 	{
 		smplFileTick = Sample2Tick(_playSmpl);
+		if (_kfInterval && ! (_playState & PLAYSTATE_END))
+		{
+			if (_keyframes.empty() || smplFileTick >= _keyframes.back().playTick + _kfInterval)
+				SaveKeyframe(smplFileTick);
+		}
 		ParseFile(smplFileTick - _playTick);
 		
 		// render as many samples at once as possible (for better performance)
@@ -1247,7 +1462,7 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
+					ResampleDeviceOutput(clDev, smplStep, &data[curSmpl], _playOpts.genOpts.skipSilentDevs);
 			}
 		}
 		curSmpl += smplStep;
@@ -1385,7 +1600,7 @@ void S98Player::DoRegWrite(UINT8 deviceID, UINT8 port, UINT8 reg, UINT8 data)
 	return;
 }
 
-UINT32 S98Player::ReadVarInt(UINT32& filePos)
+UINT32 S98Player::ReadVarInt(UINT32& filePos) const
 {
 	UINT32 tickVal = 0;
 	UINT8 tickShift = 0;
@@ -36,6 +36,9 @@ struct S98_DEVICE
 struct S98_PLAY_OPTIONS
 {
 	PLR_GEN_OPTS genOpts;
+	UINT32 keyframeInterval;	// store the playback state every N seconds for fast backward seeking (0 = disabled)
+	UINT32 keyframeMemLimit;	// memory limit for keyframes (in bytes), the interval is increased when exceeding it
+							// Note: takes effect when calling Start().
 };
 
 
@@ -64,6 +67,17 @@ private:
 		S98Player* player;
 		S98_CHIPDEV* chipDev;
 	};
+	struct KEYFRAME	// playback state, used for seeking backwards without parsing from the beginning
+	{
+		UINT32 filePos;
+		UINT32 fileTick;
+		UINT32 playTick;
+		UINT32 curLoop;
+		UINT32 lastLoopTick;
+		std::vector<size_t> stateOfs;	// offsets of device states in stateData
+		std::vector<UINT8> stateData;
+		size_t memSize;	// memory used by the keyframe
+	};
 	
 public:
 	S98Player();
@@ -80,6 +94,7 @@ public:
 	const char* const* GetTags(void);
 	UINT8 GetSongInfo(PLR_SONG_INFO& songInf);
 	UINT8 GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const;
+	UINT8 AnalyzeSong(PLR_ANALYSIS& result) const;
 	UINT8 SetDeviceOptions(UINT32 id, const PLR_DEV_OPTS& devOpts);
 	UINT8 GetDeviceOptions(UINT32 id, PLR_DEV_OPTS& devOpts) const;
 	UINT8 SetDeviceMuting(UINT32 id, const PLR_MUTE_OPTS& muteOpts);
@@ -120,7 +135,7 @@ private:
 	UINT8 LoadTags(void);
 	std::string GetUTF8String(const char* startPtr, const char* endPtr);
 	UINT8 ParsePSFTags(const std::string& tagData);
-	UINT32 ReadVarInt(UINT32& filePos);
+	UINT32 ReadVarInt(UINT32& filePos) const;
 	
 	void RefreshTSRates(void);
 	
@@ -131,6 +146,8 @@ private:
 	static void DeviceLinkCallback(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO* dLink);
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void SaveKeyframe(UINT32 playTick);
+	UINT8 LoadKeyframe(UINT8 unit, UINT32 pos);
 	void ParseFile(UINT32 ticks);
 	void HandleEOF(void);
 	void DoCommand(void);
@@ -179,6 +196,10 @@ private:
 	UINT32 _curLoop;
 	UINT32 _lastLoopTick;
 	
+	std::vector<KEYFRAME> _keyframes;	// sorted by playTick
+	size_t _kfMemSize;		// memory used by all keyframes
+	UINT32 _kfInterval;		// keyframe interval in ticks (0 = don't store keyframes)
+	
 	UINT8 _playState;
 	UINT8 _psTrigger;	// used to temporarily trigger special commands
 	//PLAYER_EVENT_CB _eventCbFunc;
@@ -3,6 +3,7 @@
 #include <stdio.h>	// for snprintf()
 #include <math.h>	// for pow()
 #include <vector>
+#include <algorithm>	// for std::swap()
 #include <string>
 
 #define INLINE	static inline
@@ -12,8 +13,10 @@
 #include "../emu/EmuStructs.h"
 #include "../emu/SoundEmu.h"
 #include "../emu/Resampler.h"
+#include "../emu/mixkernels.h"
 #include "../emu/SoundDevs.h"
 #include "../emu/EmuCores.h"
+#include "../emu/dac_control.h"
 #include "../emu/cores/sn764intf.h"	// for SN76496_CFG
 #include "../emu/cores/2612intf.h"
 #include "../emu/cores/segapcm.h"		// for SEGAPCM_CFG
@@ -157,7 +160,21 @@ VGMPlayer::VGMPlayer() :
 	
 	_playOpts.playbackHz = 0;
 	_playOpts.hardStopOld = 0;
+	_playOpts.renderThreads = 0;
+	_playOpts.keyframeInterval = 0;
+	_playOpts.keyframeMemLimit = 32 * 1024 * 1024;	// 32 MB
+	_playOpts.preDecodeCmds = 0;
+	_playOpts.lazyPcmDecode = 0;
+	_playOpts.lazyPcmMemLimit = 64 * 1024 * 1024;	// 64 MB
+	_playOpts.groupResamplers = 0;
 	_playOpts.genOpts.pbSpeed = 0x10000;
+	_playOpts.genOpts.skipSilentDevs = 0;
+	
+	_rndJobMtx = NULL;
+	_rndQuit = 0;
+	_kfMemSize = 0;
+	_kfInterval = 0;
+	_cmdOpPos = 0;
 
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
@@ -199,6 +216,30 @@ VGMPlayer::VGMPlayer() :
 	if (retVal)
 		_cpcUTF16 = NULL;
 	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	_pcmComprTblOfs = (UINT32)-1;
+	memset(&_lazyComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	_lazyTblOfs = (UINT32)-1;
+	_lazyMemSize = 0;
+	_lazyUseCntr = 0;
+	for (size_t curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		PCM_BANK* pcmBnk = &_pcmBank[curBank];
+		pcmBnk->dataPtr = NULL;
+		pcmBnk->dataSize = 0;
+		pcmBnk->dataLen = 0;
+		pcmBnk->validLen = 0;
+		pcmBnk->cacheKey = 0;
+		pcmBnk->cacheItem = NULL;
+		pcmBnk->lazy = 0;
+		pcmBnk->lazyCurPtr = NULL;
+		pcmBnk->lazyCurOfs = 0;
+		pcmBnk->lazyCurLen = 0;
+		_pcmBankCbData[curBank].player = this;
+		_pcmBankCbData[curBank].bankID = (UINT8)curBank;
+	}
+	memset(_pcmBankTotal, 0x00, sizeof(_pcmBankTotal));
+	_dblkScanDone = 0;
+	_yrwRomItem = NULL;
 	_tagList[0] = NULL;
 	return;
 }
@@ -210,6 +251,8 @@ VGMPlayer::~VGMPlayer()
 	if (_playState & PLAYSTATE_PLAY)
 		Stop();
 	UnloadFile();
+	if (_romCache != NULL)
+		_romCache->Release(_yrwRomItem);
 	
 	if (_cpcUTF16 != NULL)
 		CPConv_Deinit(_cpcUTF16);
@@ -266,6 +309,8 @@ UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
 	// parse tags
 	LoadTags();
 	
+	ScanDataBlocks();
+	
 	RefreshTSRates();	// make Tick2Sample etc. work
 	
 	return 0x00;
@@ -504,6 +549,9 @@ UINT8 VGMPlayer::UnloadFile(void)
 	_devNames.clear();
 	_devices.clear();
 	_devCfgs.clear();
+	_dataBlocks.clear();
+	memset(_pcmBankTotal, 0x00, sizeof(_pcmBankTotal));
+	_dblkScanDone = 0;
 	for (size_t curTag = 0; curTag < _TAG_COUNT; curTag ++)
 		_tagData[curTag] = std::string();
 	_tagList[0] = NULL;
@@ -629,6 +677,291 @@ UINT8 VGMPlayer::GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const
 		return 0x00;	// returned data based on file header
 }
 
+UINT8 VGMPlayer::AnalyzeSong(PLR_ANALYSIS& result) const
+{
+	if (_dLoad == NULL)
+		return 0xFF;
+	
+	std::vector<PLR_DEV_INFO> devInfList;
+	size_t devMap[_CHIP_COUNT][2];	// VGM chip type/ID -> result.devices index
+	std::vector<UINT32> bankBlkEnd[_PCM_BANK_COUNT];	// end offsets of the data blocks in each PCM bank
+	ANA_DACSTRM dacStrms[0x100];
+	UINT32 hdrLoopOfs = ReadRelOfs(_hdrBuffer, 0x1C);
+	UINT32 filePos = _fileHdr.dataOfs;
+	UINT32 fileTick = 0;
+	size_t curDev;
+	
+	GetSongDeviceInfo(devInfList);
+	InitAnalysis(result, devInfList);
+	for (curDev = 0; curDev < _CHIP_COUNT; curDev ++)
+		devMap[curDev][0] = devMap[curDev][1] = (size_t)-1;
+	for (curDev = 0; curDev < _devCfgs.size(); curDev ++)
+	{
+		const SONG_DEV_CFG& sdCfg = _devCfgs[curDev];
+		if (sdCfg.vgmChipType < _CHIP_COUNT && sdCfg.instance < 2)
+			devMap[sdCfg.vgmChipType][sdCfg.instance] = curDev;
+	}
+	memset(dacStrms, 0x00, sizeof(dacStrms));
+	
+	while(true)
+	{
+		if (filePos >= _fileHdr.dataEnd)
+		{
+			result.flags |= PLRANA_EARLY_END;
+			break;
+		}
+		if (filePos == hdrLoopOfs)
+			result.loopTick = fileTick;
+		
+		const UINT8* cmdData = &_fileData[filePos];
+		UINT8 curCmd = cmdData[0x00];
+		UINT32 cmdLen = _CMD_INFO[curCmd].cmdLen;
+		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+		UINT8 chipType = _CMD_INFO[curCmd].chipType;
+		UINT8 chipID;
+		UINT32 reg;
+		ANA_DACSTRM* dacStrm = NULL;	// set when a DAC stream is started
+		CMD_OP op;
+		
+		if (curCmd == 0x66)	// end of command data
+		{
+			result.cmdCount ++;
+			break;
+		}
+		if (curCmd == 0x67)	// data block
+		{
+			if (filePos + 0x07 > _fileHdr.dataEnd)
+				cmdLen = 0;
+			else
+				cmdLen = 0x07 + (ReadLE32(&cmdData[0x03]) & 0x7FFFFFFF);
+		}
+		if (cmdLen == 0 || cmdLen > _fileHdr.dataEnd - filePos)
+		{
+			result.flags |= PLRANA_BAD_CMD;
+			break;
+		}
+		result.cmdCount ++;
+		
+		chipID = DecodeCmdWrite(filePos, &op);
+		reg = (UINT32)-1;	// -1 = not a device write
+		switch(op.type)
+		{
+		case CMDOP_DELAY:
+			fileTick += op.data;
+			break;
+		case CMDOP_YM2612PCM:
+			fileTick += op.data;
+			reg = 0x2A;
+			break;
+		case CMDOP_YM:
+			reg = (op.port << 8) | op.ofs;
+			break;
+		case CMDOP_A8D8:
+		case CMDOP_A16D8:
+		case CMDOP_A8D16:
+		case CMDOP_A16D16:
+			reg = op.ofs;
+			break;
+		case CMDOP_CALL:
+		default:
+			if (curCmd == 0x67)
+			{
+				UINT8 dblkType = cmdData[0x02];
+				UINT32 dblkLen = cmdLen - 0x07;
+				
+				if (dblkType < 0x7F)	// PCM data (uncompressed/compressed)
+				{
+					if (dblkType & 0x40)
+					{
+						PCM_CDB_INF dbCI;
+						ReadComprDataBlkHdr(dblkLen, &cmdData[0x07], &dbCI);
+						dblkLen = dbCI.decmpLen;
+					}
+					std::vector<UINT32>& blkEnd = bankBlkEnd[dblkType & 0x3F];
+					blkEnd.push_back((blkEnd.empty() ? 0 : blkEnd.back()) + dblkLen);
+				}
+				result.dblkCount ++;
+				result.dblkBytes += dblkLen;
+			}
+			else if (func == &VGMPlayer::Cmd_PcmRamWrite)
+			{
+				UINT8 dbType = cmdData[0x02] & 0x7F;
+				if (dbType < _PCM_BANK_COUNT && _VGM_BANK_CHIPS[dbType] != 0xFF)
+				{
+					chipType = _VGM_BANK_CHIPS[dbType];
+					chipID = (cmdData[0x02] & 0x80) >> 7;
+					curDev = devMap[chipType][chipID];
+					if (curDev != (size_t)-1)
+						result.devices[curDev].writeCnt ++;
+					else
+						result.strayWrites ++;
+				}
+			}
+			else if (func == &VGMPlayer::Cmd_DACCtrl_Setup)
+			{
+				if (cmdData[0x01] == 0xFF)
+					break;
+				ANA_DACSTRM* aStrm = &dacStrms[cmdData[0x01]];
+				UINT8 dstChip = cmdData[0x02] & 0x7F;
+				DEV_ID dstType = (dstChip < _CHIP_COUNT) ? _DEV_LIST[dstChip] : 0xFF;
+				
+				if (! aStrm->used)
+				{
+					aStrm->used = 1;
+					aStrm->bankID = 0xFF;
+				}
+				// same as daccontrol_setup_chip()
+				if (dstType == DEVID_SN76496)
+					aStrm->cmdSize = (cmdData[0x04] & 0x10) ? 0x01 : 0x02;
+				else if (dstType == DEVID_32X_PWM || dstType == DEVID_QSOUND ||
+						dstType == DEVID_K005289 || dstType == DEVID_BSMT2000)
+					aStrm->cmdSize = 0x02;
+				else
+					aStrm->cmdSize = 0x01;
+				aStrm->running = 0;
+			}
+			else if (func == &VGMPlayer::Cmd_DACCtrl_SetData)
+			{
+				ANA_DACSTRM* aStrm = &dacStrms[cmdData[0x01]];
+				aStrm->bankID = cmdData[0x02];
+				aStrm->stepSize = cmdData[0x03];
+			}
+			else if (func == &VGMPlayer::Cmd_DACCtrl_SetFrequency)
+			{
+				dacStrms[cmdData[0x01]].freq = ReadLE32(&cmdData[0x02]);
+			}
+			else if (func == &VGMPlayer::Cmd_DACCtrl_PlayData_Loc || func == &VGMPlayer::Cmd_DACCtrl_PlayData_Blk)
+			{
+				ANA_DACSTRM* aStrm = &dacStrms[cmdData[0x01]];
+				UINT32 dataStep = aStrm->cmdSize * aStrm->stepSize;
+				UINT32 bankLen = 0;
+				UINT32 startOfs;
+				UINT32 sndLen;
+				UINT8 lenMode;
+				
+				if (! aStrm->used)
+					break;
+				if (aStrm->bankID < _PCM_BANK_COUNT && ! bankBlkEnd[aStrm->bankID].empty())
+					bankLen = bankBlkEnd[aStrm->bankID].back();
+				if (func == &VGMPlayer::Cmd_DACCtrl_PlayData_Loc)
+				{
+					startOfs = ReadLE32(&cmdData[0x02]);
+					lenMode = cmdData[0x06];
+					sndLen = ReadLE32(&cmdData[0x07]);
+				}
+				else
+				{
+					UINT16 sndID = ReadLE16(&cmdData[0x02]);
+					if (aStrm->bankID >= _PCM_BANK_COUNT || sndID >= bankBlkEnd[aStrm->bankID].size())
+						break;
+					startOfs = sndID ? bankBlkEnd[aStrm->bankID][sndID - 1] : 0;
+					sndLen = bankBlkEnd[aStrm->bankID][sndID] - startOfs;
+					lenMode = DCTRL_LMODE_BYTES | ((cmdData[0x04] & 0x01) << 7);
+				}
+				
+				// calculate the number of commands the same way daccontrol_start() does
+				switch(lenMode & 0x0F)
+				{
+				case DCTRL_LMODE_IGNORE:
+					break;
+				case DCTRL_LMODE_CMDS:
+					aStrm->cmdCnt = sndLen;
+					break;
+				case DCTRL_LMODE_MSEC:
+					aStrm->cmdCnt = aStrm->freq ? (1000 * sndLen / aStrm->freq) : 0;
+					break;
+				case DCTRL_LMODE_TOEND:
+					if (startOfs > bankLen)
+						startOfs = bankLen;
+					aStrm->cmdCnt = dataStep ? ((bankLen - startOfs) / dataStep) : 0;
+					break;
+				case DCTRL_LMODE_BYTES:
+					aStrm->cmdCnt = dataStep ? (sndLen / dataStep) : 0;
+					break;
+				default:
+					aStrm->cmdCnt = 0;
+					break;
+				}
+				aStrm->running = 1;
+				if (lenMode & 0x80)	// looping
+					aStrm->endTick = (UINT32)-1;
+				else if (! aStrm->freq)
+					aStrm->endTick = fileTick;	// never sends anything
+				else
+					aStrm->endTick = fileTick + (UINT32)(((UINT64)aStrm->cmdCnt * 44100 + aStrm->freq - 1) / aStrm->freq);
+				dacStrm = aStrm;
+			}
+			else if (func == &VGMPlayer::Cmd_DACCtrl_Stop)
+			{
+				if (cmdData[0x01] == 0xFF)
+				{
+					for (curDev = 0; curDev < 0x100; curDev ++)
+						dacStrms[curDev].running = 0;
+				}
+				else
+				{
+					dacStrms[cmdData[0x01]].running = 0;
+				}
+			}
+			else if (chipType != 0xFF && func != &VGMPlayer::Cmd_AY_Stereo)
+			{
+				// device writes that need special handling when playing
+				if (func == &VGMPlayer::Cmd_RF5C_Mem)
+				{
+					chipID = 0;
+					reg = ReadLE16(&cmdData[0x01]);
+				}
+				else if (func == &VGMPlayer::Cmd_QSound_Reg)
+				{
+					chipID = 0;
+					reg = cmdData[0x03];
+				}
+				else
+				{
+					chipID = (cmdData[0x01] & 0x80) >> 7;
+					reg = cmdData[0x01] & 0x7F;
+				}
+			}
+			break;
+		}
+		if (reg != (UINT32)-1)
+		{
+			curDev = (chipType < _CHIP_COUNT) ? devMap[chipType][chipID] : (size_t)-1;
+			if (curDev != (size_t)-1)
+				AnalysisWrite(result.devices[curDev], reg);
+			else
+				result.strayWrites ++;
+		}
+		if (dacStrm != NULL)
+		{
+			UINT32 playCnt = 0;
+			
+			for (curDev = 0; curDev < 0x100; curDev ++)
+			{
+				const ANA_DACSTRM* aStrm = &dacStrms[curDev];
+				if (aStrm->running && (aStrm->endTick == (UINT32)-1 || aStrm->endTick > fileTick))
+					playCnt ++;
+			}
+			if (result.dacStrmMax < playCnt)
+				result.dacStrmMax = playCnt;
+		}
+		filePos += cmdLen;
+	}
+	result.songLen = fileTick;
+	
+	if (result.songLen != _fileHdr.numTicks)
+		result.flags |= PLRANA_LEN_MISMATCH;
+	if (hdrLoopOfs)
+	{
+		if (result.loopTick == (UINT32)-1)
+			result.flags |= PLRANA_LOOP_INVALID;
+		else if (result.songLen - result.loopTick != _fileHdr.loopTicks)
+			result.flags |= PLRANA_LOOP_MISMATCH;
+	}
+	
+	return 0x00;
+}
+
 size_t VGMPlayer::DeviceID2OptionID(UINT32 id) const
 {
 	DEV_ID type;
@@ -932,7 +1265,76 @@ const std::vector<VGMPlayer::DACSTRM_DEV>& VGMPlayer::GetStreamDevInfo(void) con
 
 UINT8 VGMPlayer::Start(void)
 {
+	size_t curBank;
+	
 	InitDevices();
+	StartRenderThreads();
+	if (_playOpts.groupResamplers)
+		BuildResamplerGroups();	// Note: depends on the render jobs
+	
+	_keyframes.clear();
+	_kfMemSize = 0;
+	_kfInterval = _playOpts.keyframeInterval * 44100;	// seconds -> ticks
+	if (_playOpts.preDecodeCmds)
+		PreDecodeCommands();	// Note: depends on the devices
+	
+	// In lazy mode, banks with compressed data blocks get no memory. Their data is decompressed when accessed.
+	_lazyMemSize = 0;
+	_lazyUseCntr = 0;
+	if (_playOpts.lazyPcmDecode)
+	{
+		size_t curBlk;
+		for (curBlk = 0; curBlk < _dataBlocks.size(); curBlk ++)
+		{
+			const DATA_BLOCK_INFO& dbInfo = _dataBlocks[curBlk];
+			if (dbInfo.type != 0x7F && (dbInfo.type & 0x40))
+				_pcmBank[dbInfo.type & 0x3F].lazy = 1;
+		}
+	}
+	
+	// allocate all PCM banks once, so that the data blocks just fill them and pointers stay valid
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		PCM_BANK* pcmBnk = &_pcmBank[curBank];
+		pcmBnk->dataSize = _pcmBankTotal[curBank];
+		pcmBnk->dataLen = 0;
+		pcmBnk->validLen = 0;
+		pcmBnk->cacheItem = NULL;
+		pcmBnk->lazyCurPtr = NULL;
+		pcmBnk->lazyCurLen = 0;
+		if (pcmBnk->lazy)
+		{
+			size_t curBlk;
+			size_t blkCount = 0;
+			for (curBlk = 0; curBlk < _dataBlocks.size(); curBlk ++)
+			{
+				if (_dataBlocks[curBlk].type != 0x7F && (_dataBlocks[curBlk].type & 0x3F) == curBank)
+					blkCount ++;
+			}
+			pcmBnk->lazyBlks.reserve(blkCount);	// prevent copying decompressed data when adding blocks
+			pcmBnk->dataSize = 0;
+			pcmBnk->dataPtr = NULL;
+			continue;
+		}
+		if (_romCache != NULL && _dblkScanDone && pcmBnk->dataSize > 0)
+		{
+			// use the bank data of another player/song with the same data blocks
+			pcmBnk->cacheKey = GetPCMBankSource((UINT8)curBank, pcmBnk->cacheSrc);
+			pcmBnk->cacheItem = _romCache->Acquire(pcmBnk->cacheKey, pcmBnk->cacheSrc, pcmBnk->dataSize);
+			if (pcmBnk->cacheItem != NULL)
+				std::vector<UINT8>().swap(pcmBnk->cacheSrc);	// not needed anymore
+		}
+		if (pcmBnk->cacheItem != NULL)
+		{
+			pcmBnk->dataPtr = const_cast<UINT8*>(&pcmBnk->cacheItem->data[0]);
+			pcmBnk->validLen = pcmBnk->dataSize;	// all data blocks are loaded already
+		}
+		else
+		{
+			pcmBnk->data.resize(pcmBnk->dataSize);
+			pcmBnk->dataPtr = pcmBnk->dataSize ? &pcmBnk->data[0] : NULL;
+		}
+	}
 	
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
@@ -948,6 +1350,12 @@ UINT8 VGMPlayer::Stop(void)
 	size_t curBank;
 	
 	_playState &= ~PLAYSTATE_PLAY;
+	StopRenderThreads();
+	
+	_keyframes.clear();
+	_kfMemSize = 0;
+	std::vector<CMD_OP>().swap(_cmdOps);
+	_cmdOpPos = 0;
 	
 	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 	{
@@ -961,10 +1369,14 @@ UINT8 VGMPlayer::Stop(void)
 		PCM_BANK* pcmBnk = &_pcmBank[curBank];
 		pcmBnk->bankOfs.clear();
 		pcmBnk->bankSize.clear();
-		pcmBnk->data.clear();
+		ReleasePCMBank(pcmBnk);
 	}
 	free(_pcmComprTbl.values.d8);	_pcmComprTbl.values.d8 = NULL;
+	free(_lazyComprTbl.values.d8);	_lazyComprTbl.values.d8 = NULL;
+	_lazyTblOfs = (UINT32)-1;
+	_lazyMemSize = 0;
 	
+	FreeResamplerGroups();
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
 		FreeDeviceTree(&_devices[curDev].base, 0);
 	_devNames.clear();
@@ -984,6 +1396,7 @@ UINT8 VGMPlayer::Reset(void)
 	size_t curBank;
 	
 	_filePos = _fileHdr.dataOfs;
+	_cmdOpPos = 0;
 	_fileTick = 0;
 	_playTick = 0;
 	_playSmpl = 0;
@@ -1004,16 +1417,17 @@ UINT8 VGMPlayer::Reset(void)
 	for (curStrm = 0; curStrm < 0x100; curStrm ++)
 		_dacStrmMap[curStrm] = (size_t)-1;
 	
-	// TODO (optimization): don't reset _pcmBank and instead skip data that was already loaded
+	// The bank memory and its decoded data is kept. (Data blocks that were already loaded aren't decoded again.)
 	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank++)
 	{
 		PCM_BANK* pcmBnk = &_pcmBank[curBank];
 		pcmBnk->bankOfs.clear();
 		pcmBnk->bankSize.clear();
-		pcmBnk->data.clear();
+		pcmBnk->dataLen = 0;
 	}
 	free(_pcmComprTbl.values.d8);	_pcmComprTbl.values.d8 = NULL;
 	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	_pcmComprTblOfs = (UINT32)-1;
 	
 	_ym2612pcm_bnkPos = 0x00;
 	memset(_rf5cBank, 0x00, sizeof(_rf5cBank));
@@ -1507,6 +1921,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&chipDev.write8);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0x524F, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0x524F, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0x524F, (void**)&chipDev.romRef);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0x5241, (void**)&chipDev.romSizeB);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0x5241, (void**)&chipDev.romWriteB);
 			LoadOPL4ROM(&chipDev);
@@ -1533,6 +1948,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A16D16, 0, (void**)&chipDev.writeM16);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, (void**)&chipDev.romRef);
 			break;
 		case DEVID_QSOUND:
 			chipDev.flags = 0x00;
@@ -1550,6 +1966,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D16, 0, (void**)&chipDev.writeD16);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, (void**)&chipDev.romRef);
 			
 			memset(&_qsWork[chipID], 0x00, sizeof(QSOUND_WORK));
 			if (devInf->devDef->coreID == FCC_MAME)
@@ -1614,6 +2031,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A16D8, 0, (void**)&chipDev.writeM8);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_ROMREF, 0, (void**)&chipDev.romRef);
 			break;
 		}
 		if (retVal)
@@ -1768,6 +2186,51 @@ void VGMPlayer::LoadOPL4ROM(CHIP_DEVICE* chipDev)
 	if (chipDev->romWrite == NULL)
 		return;
 	
+	if (_romCache != NULL && _yrwRom.empty())
+	{
+		if (_yrwRomItem == NULL)
+		{
+			// The ROM file is identified by its name, so that it has to be loaded only once per process.
+			std::vector<UINT8> romName(romFile, romFile + strlen(romFile));
+			RomCache::HASH key = RomCache::CalcHash(romName.size(), &romName[0], FCC_VGM);
+			_yrwRomItem = _romCache->Acquire(key, romName, 0);
+			if (_yrwRomItem == NULL)
+			{
+				std::vector<UINT8> yrwRom;
+				if (_fileReqCbFunc == NULL)
+					return;
+				DATA_LOADER* romDLoad = _fileReqCbFunc(_fileReqCbParam, this, romFile);
+				if (romDLoad == NULL)
+					return;
+				DataLoader_ReadAll(romDLoad);
+				
+				UINT32 yrwSize = DataLoader_GetSize(romDLoad);
+				const UINT8* yrwData = DataLoader_GetData(romDLoad);
+				if (yrwSize > 0 && yrwData != NULL)
+					yrwRom.assign(yrwData, yrwData + yrwSize);
+				DataLoader_Deinit(romDLoad);
+				if (yrwRom.empty())
+					return;
+				_yrwRomItem = _romCache->Insert(key, romName, yrwRom);
+				if (_yrwRomItem == NULL)
+					_yrwRom.swap(yrwRom);	// key collision - use a private copy
+			}
+		}
+		if (_yrwRomItem != NULL)
+		{
+			const std::vector<UINT8>& romData = _yrwRomItem->data;
+			if (chipDev->romRef != NULL)
+			{
+				chipDev->romRef(chipDev->base.defInf.dataPtr, (UINT32)romData.size(), &romData[0]);
+				return;
+			}
+			if (chipDev->romSize != NULL)
+				chipDev->romSize(chipDev->base.defInf.dataPtr, (UINT32)romData.size());
+			chipDev->romWrite(chipDev->base.defInf.dataPtr, 0x00, (UINT32)romData.size(), &romData[0]);
+			return;
+		}
+	}
+	
 	if (_yrwRom.empty())
 	{
 		if (_fileReqCbFunc == NULL)
@@ -1786,6 +2249,12 @@ void VGMPlayer::LoadOPL4ROM(CHIP_DEVICE* chipDev)
 	if (_yrwRom.empty())
 		return;
 	
+	if (chipDev->romRef != NULL)
+	{
+		// _yrwRom stays unchanged for the lifetime of the player, so the device can use it directly.
+		chipDev->romRef(chipDev->base.defInf.dataPtr, (UINT32)_yrwRom.size(), &_yrwRom[0]);
+		return;
+	}
 	if (chipDev->romSize != NULL)
 		chipDev->romSize(chipDev->base.defInf.dataPtr, (UINT32)_yrwRom.size());
 	chipDev->romWrite(chipDev->base.defInf.dataPtr, 0x00, (UINT32)_yrwRom.size(), &_yrwRom[0]);
@@ -1800,7 +2269,10 @@ UINT8 VGMPlayer::Seek(UINT8 unit, UINT32 pos)
 	case PLAYPOS_FILEOFS:
 		_playState |= PLAYSTATE_SEEK;
 		if (pos < _filePos)
-			Reset();
+		{
+			if (LoadKeyframe(unit, pos))
+				Reset();
+		}
 		return SeekToFilePos(pos);
 	case PLAYPOS_SAMPLE:
 		pos = Sample2Tick(pos);
@@ -1808,7 +2280,10 @@ UINT8 VGMPlayer::Seek(UINT8 unit, UINT32 pos)
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
 		if (pos < _playTick)
-			Reset();
+		{
+			if (LoadKeyframe(PLAYPOS_TICK, pos))
+				Reset();
+		}
 		return SeekToTick(pos);
 	case PLAYPOS_COMMAND:
 	default:
@@ -1829,6 +2304,8 @@ UINT8 VGMPlayer::SeekToTick(UINT32 tick)
 UINT8 VGMPlayer::SeekToFilePos(UINT32 pos)
 {
 	_playState |= PLAYSTATE_SEEK;
+	if (! _cmdOps.empty() && ! (_playState & PLAYSTATE_END))
+		ExecCmdOps((UINT32)-1, pos);
 	while(_filePos < _fileHdr.dataEnd && _filePos <= pos && ! (_playState & PLAYSTATE_END))
 	{
 		UINT8 curCmd = _fileData[_filePos];
@@ -1852,111 +2329,902 @@ UINT8 VGMPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
-UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
+void VGMPlayer::SaveKeyframe(UINT32 playTick)
 {
-	UINT32 curSmpl;
-	UINT32 smplFileTick;
-	UINT32 maxSmpl;
-	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
+	KEYFRAME kf;
 	size_t curDev;
-	
-	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
-	curSmpl = 0;
-	do
+	size_t curBank;
+	UINT32 stateSize;
+	
+	kf.filePos = _filePos;
+	kf.fileTick = _fileTick;
+	kf.playTick = playTick;	// Note: all sound devices are rendered up to this point, but it isn't parsed yet.
+	kf.curLoop = _curLoop;
+	kf.lastLoopTick = _lastLoopTick;
+	kf.p2612Fix = _p2612Fix;
+	kf.ym2612pcm_bnkPos = _ym2612pcm_bnkPos;
+	memcpy(kf.rf5cBank, _rf5cBank, sizeof(_rf5cBank));
+	memcpy(kf.qsWork, _qsWork, sizeof(_qsWork));
+	kf.pcmBankSize.resize(_PCM_BANK_COUNT);
+	kf.pcmBankCount.resize(_PCM_BANK_COUNT);
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
 	{
-		smplFileTick = Sample2Tick(_playSmpl);
-		ParseFile(smplFileTick - _playTick);
-		
-		// render as many samples at once as possible (for better performance)
-		maxSmpl = Tick2Sample(_fileTick);
-		smplStep = maxSmpl - _playSmpl;
-		// When DAC streams are active, limit step size to 1, so that DAC streams and sound chip emulation are in sync.
-		if (smplStep < 1 || ! _dacStreams.empty())
-			smplStep = 1;	// must render at least 1 sample in order to advance
-		if ((UINT32)smplStep > smplCnt - curSmpl)
-			smplStep = smplCnt - curSmpl;
-		
-		for (curDev = 0; curDev < _devices.size(); curDev ++)
-		{
-			CHIP_DEVICE* cDev = &_devices[curDev];
-			UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
-			VGM_BASEDEV* clDev;
-			
-			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
-			{
-				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
-			}
-		}
-		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
-		{
-			DEV_INFO* dacDInf = &_dacStreams[curDev].defInf;
-			dacDInf->devDef->Update(dacDInf->dataPtr, smplStep, NULL);
-		}
+		kf.pcmBankSize[curBank] = _pcmBank[curBank].dataLen;
+		kf.pcmBankCount[curBank] = (UINT32)_pcmBank[curBank].bankOfs.size();
+	}
+	kf.dacStreams = _dacStreams;
+	for (curDev = 0; curDev < _rsGroups.size(); curDev ++)
+	{
+		const RESMPL_STATE* resmpl = &_rsGroups[curDev].resmpl;
+		size_t histPos = kf.rsgHistory.size();
 		
-		curSmpl += smplStep;
-		_playSmpl += smplStep;
-		if (_psTrigger & PLAYSTATE_END)
+		kf.rsgStates.push_back(*resmpl);
+		kf.rsgHistory.resize(histPos + Resmpl_GetHistorySize(resmpl));
+		if (histPos < kf.rsgHistory.size())
+			Resmpl_SaveHistory(resmpl, &kf.rsgHistory[histPos]);
+	}
+	
+	kf.stateOfs.resize(_devices.size() + _dacStreams.size() + 1);
+	kf.stateOfs[0] = 0;
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		stateSize = SaveDeviceTreeState(&_devices[curDev].base, 0, NULL);
+		if (! stateSize)
 		{
-			_psTrigger &= ~PLAYSTATE_END;
-			break;
+			// The device doesn't support saving its state - disable keyframes.
+			emu_logf(&_logger, PLRLOG_DEBUG, "Device %s doesn't support state saving, keyframes disabled.\n",
+				_devNames[curDev].c_str());
+			_keyframes.clear();
+			_kfMemSize = 0;
+			_kfInterval = 0;
+			return;
 		}
-	} while(curSmpl < smplCnt);
-	
-	return curSmpl;
-}
-
-void VGMPlayer::ParseFile(UINT32 ticks)
-{
-	_playTick += ticks;
-	if (_playState & PLAYSTATE_END)
-		return;
-	
-	while(_filePos < _fileHdr.dataEnd && _fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
+		kf.stateOfs[1 + curDev] = kf.stateOfs[curDev] + stateSize;
+	}
+	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 	{
-		UINT8 curCmd = _fileData[_filePos];
-		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
-		(this->*func)();
-		_filePos += _CMD_INFO[curCmd].cmdLen;
+		size_t stID = _devices.size() + curDev;
+		stateSize = daccontrol_save_state(_dacStreams[curDev].defInf.dataPtr, 0, NULL);
+		kf.stateOfs[1 + stID] = kf.stateOfs[stID] + stateSize;
+	}
+	kf.stateData.resize(kf.stateOfs.back());
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		stateSize = (UINT32)(kf.stateOfs[1 + curDev] - kf.stateOfs[curDev]);
+		SaveDeviceTreeState(&_devices[curDev].base, stateSize, &kf.stateData[kf.stateOfs[curDev]]);
+	}
+	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+	{
+		size_t stID = _devices.size() + curDev;
+		stateSize = (UINT32)(kf.stateOfs[1 + stID] - kf.stateOfs[stID]);
+		daccontrol_save_state(_dacStreams[curDev].defInf.dataPtr, stateSize, &kf.stateData[kf.stateOfs[stID]]);
 	}
 	
-	if (_p2612Fix & P2612FIX_ACTIVE)
+	kf.memSize = sizeof(KEYFRAME) + kf.stateData.size() +
+		kf.dacStreams.size() * sizeof(DACSTRM_DEV) + kf.stateOfs.size() * sizeof(size_t) +
+		kf.rsgStates.size() * sizeof(RESMPL_STATE) + kf.rsgHistory.size() +
+		_PCM_BANK_COUNT * 2 * sizeof(UINT32);
+	_kfMemSize += kf.memSize;
+	_keyframes.push_back(kf);
+	
+	// When exceeding the memory limit, drop every 2nd keyframe and double the interval.
+	while(_kfMemSize > _playOpts.keyframeMemLimit && _keyframes.size() > 1)
 	{
-		_p2612Fix &= ~P2612FIX_ACTIVE;	// disable Project2612 fix
-		// Note: Due to the way the Legacy Mode is implemented in YM2612 GPGX right now,
-		//       it should be no problem to keep it enabled during the whole song.
-		//       But let's just turn it off for safety.
+		size_t curKF;
+		size_t dstKF;
 		
-		size_t optID = _devOptMap[DEVID_YM2612][0];
-		size_t devID = (optID == (size_t)-1) ? (size_t)-1 : _optDevMap[optID];
-		// refresh options, removing OPT_YM2612_LEGACY_MODE
-		if (devID < _devices.size())
-			RefreshDevOptions(_devices[devID], _devOpts[optID]);
+		_kfMemSize = 0;
+		for (curKF = 0, dstKF = 0; curKF < _keyframes.size(); curKF += 2, dstKF ++)
+		{
+			if (dstKF != curKF)
+				std::swap(_keyframes[dstKF], _keyframes[curKF]);
+			_kfMemSize += _keyframes[dstKF].memSize;
+		}
+		_keyframes.resize(dstKF);
+		_kfInterval *= 2;
 	}
-	
-	if (_filePos >= _fileHdr.dataEnd)
+	if (_kfMemSize > _playOpts.keyframeMemLimit)
 	{
-		if (_playState & PLAYSTATE_SEEK)	// recalculate playSmpl to fix state when triggering callbacks
-			_playSmpl = Tick2Sample(_fileTick);	// Note: fileTick results in more accurate position
-		_playState |= PLAYSTATE_END;
-		_psTrigger |= PLAYSTATE_END;
-		if (_eventCbFunc != NULL)
-			_eventCbFunc(this, _eventCbParam, PLREVT_END, NULL);
-		emu_logf(&_logger, PLRLOG_WARN, "VGM file ends early! (filePos 0x%06X, end at 0x%06X)\n", _filePos, _fileHdr.dataEnd);
+		emu_logf(&_logger, PLRLOG_DEBUG, "Keyframe size exceeds memory limit, keyframes disabled.\n");
+		_keyframes.clear();
+		_kfMemSize = 0;
+		_kfInterval = 0;
 	}
 	
 	return;
 }
 
-void VGMPlayer::ParseFileForFMClocks()
+UINT8 VGMPlayer::LoadKeyframe(UINT8 unit, UINT32 pos)
 {
-	UINT32 filePos = _fileHdr.dataOfs;
-
-	_v101ym2413clock = GetHeaderChipClock(0x01);
-	_v101ym2612clock = 0;
-	_v101ym2151clock = 0;
-
-	while(filePos < _fileHdr.dataEnd)
+	const KEYFRAME* kf;
+	size_t curKF;
+	size_t curDev;
+	size_t curBank;
+	size_t curStrm;
+	UINT8 retVal;
+	
+	// search for the last keyframe before the seek position
+	kf = NULL;
+	for (curKF = 0; curKF < _keyframes.size(); curKF ++)
+	{
+		const KEYFRAME& curKf = _keyframes[curKF];
+		if (unit == PLAYPOS_FILEOFS)
+		{
+			// file offsets are ambiguous once looping, so only use the first playthrough
+			if (curKf.curLoop > 0)
+				break;
+			if (curKf.filePos > pos)
+				break;
+		}
+		else
+		{
+			if (curKf.playTick > pos)
+				break;
+		}
+		kf = &curKf;
+	}
+	if (kf == NULL)
+		return 0xFF;
+	// PCM data is not restored, so the banks must contain at least the data of the keyframe
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		if (kf->pcmBankSize[curBank] > _pcmBank[curBank].dataLen ||
+			kf->pcmBankCount[curBank] > _pcmBank[curBank].bankOfs.size())
+			return 0xFF;
+	}
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		const UINT8* stateData = &kf->stateData[kf->stateOfs[curDev]];
+		UINT32 stateSize = (UINT32)(kf->stateOfs[1 + curDev] - kf->stateOfs[curDev]);
+		retVal = LoadDeviceTreeState(&_devices[curDev].base, stateSize, stateData);
+		if (retVal)
+			return retVal;	// Note: the caller has to call Reset() in this case
+	}
+	// If the device sample rates changed since then, the groups are rebuilt before rendering anyway.
+	if (kf->rsgStates.size() == _rsGroups.size())
+	{
+		size_t histPos = 0;
+		for (curDev = 0; curDev < _rsGroups.size(); curDev ++)
+		{
+			const RESMPL_STATE* rsState = &kf->rsgStates[curDev];
+			RESMPL_STATE* resmpl = &_rsGroups[curDev].resmpl;
+			UINT32 histSize = Resmpl_GetHistorySize(rsState);
+			const UINT8* histData = histSize ? &kf->rsgHistory[histPos] : NULL;
+			
+			histPos += histSize;
+			if (resmpl->smpRateSrc != rsState->smpRateSrc)
+				continue;
+			resmpl->smpP = rsState->smpP;
+			resmpl->smpLast = rsState->smpLast;
+			resmpl->smpNext = rsState->smpNext;
+			resmpl->lSmpl = rsState->lSmpl;
+			resmpl->nSmpl = rsState->nSmpl;
+			Resmpl_LoadHistory(resmpl, histSize, histData);
+		}
+	}
+	
+	_filePos = kf->filePos;
+	_fileTick = kf->fileTick;
+	_playTick = kf->playTick;
+	_playSmpl = Tick2Sample(_playTick);
+	_playState &= ~PLAYSTATE_END;
+	_psTrigger = 0x00;
+	_curLoop = kf->curLoop;
+	_lastLoopTick = kf->lastLoopTick;
+	_p2612Fix = kf->p2612Fix;
+	_ym2612pcm_bnkPos = kf->ym2612pcm_bnkPos;
+	memcpy(_rf5cBank, kf->rf5cBank, sizeof(_rf5cBank));
+	memcpy(_qsWork, kf->qsWork, sizeof(_qsWork));
+	
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		PCM_BANK* pcmBnk = &_pcmBank[curBank];
+		pcmBnk->dataLen = kf->pcmBankSize[curBank];
+		pcmBnk->bankOfs.resize(kf->pcmBankCount[curBank]);
+		pcmBnk->bankSize.resize(kf->pcmBankCount[curBank]);
+	}
+	
+	// DAC streams are created in the same order every time, so the existing devices can be reused.
+	while(_dacStreams.size() > kf->dacStreams.size())
+	{
+		DEV_INFO* devInf = &_dacStreams.back().defInf;
+		devInf->devDef->Stop(devInf->dataPtr);
+		_dacStreams.pop_back();
+	}
+	for (curStrm = 0; curStrm < 0x100; curStrm ++)
+		_dacStrmMap[curStrm] = (size_t)-1;
+	for (curStrm = 0; curStrm < kf->dacStreams.size(); curStrm ++)
+	{
+		const DACSTRM_DEV& kfStrm = kf->dacStreams[curStrm];
+		size_t stID = _devices.size() + curStrm;
+		DACSTRM_DEV* dacStrm;
+		
+		if (curStrm >= _dacStreams.size())
+		{
+			DACSTRM_DEV newStrm;
+			retVal = InitDACStream(&newStrm, kfStrm.streamID);
+			if (retVal)
+				break;
+			_dacStreams.push_back(newStrm);
+		}
+		dacStrm = &_dacStreams[curStrm];
+		daccontrol_load_state(dacStrm->defInf.dataPtr,
+			(UINT32)(kf->stateOfs[1 + stID] - kf->stateOfs[stID]), &kf->stateData[kf->stateOfs[stID]]);
+		dacStrm->streamID = kfStrm.streamID;
+		dacStrm->bankID = kfStrm.bankID;
+		dacStrm->pbMode = kfStrm.pbMode;
+		dacStrm->freq = kfStrm.freq;
+		dacStrm->lastItem = kfStrm.lastItem;
+		dacStrm->maxItems = kfStrm.maxItems;
+		_dacStrmMap[dacStrm->streamID] = curStrm;
+		
+		SetDACStreamReader(dacStrm);
+		if (dacStrm->bankID < _PCM_BANK_COUNT && _pcmBank[dacStrm->bankID].dataLen > 0)
+		{
+			PCM_BANK* pcmBnk = &_pcmBank[dacStrm->bankID];
+			daccontrol_refresh_data(dacStrm->defInf.dataPtr, pcmBnk->dataPtr, pcmBnk->dataLen);
+		}
+		else
+		{
+			daccontrol_refresh_data(dacStrm->defInf.dataPtr, NULL, 0);
+		}
+	}
+	
+	// The device states include the option/muting/panning settings that were active when saving.
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		CHIP_DEVICE& chipDev = _devices[curDev];
+		if (chipDev.optID == (size_t)-1)
+			continue;
+		RefreshDevOptions(chipDev, _devOpts[chipDev.optID]);
+		RefreshMuting(chipDev, _devOpts[chipDev.optID].muteOpts);
+		RefreshPanning(chipDev, _devOpts[chipDev.optID].panOpts);
+	}
+	
+	return 0x00;
+}
+
+UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
+{
+	UINT32 curSmpl;
+	UINT32 smplFileTick;
+	UINT32 maxSmpl;
+	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
+	size_t curDev;
+	
+	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
+	curSmpl = 0;
+	do
+	{
+		smplFileTick = Sample2Tick(_playSmpl);
+		if (_kfInterval && ! (_playState & PLAYSTATE_END))
+		{
+			if (_keyframes.empty() || smplFileTick >= _keyframes.back().playTick + _kfInterval)
+				SaveKeyframe(smplFileTick);
+		}
+		ParseFile(smplFileTick - _playTick);
+		
+		// render as many samples at once as possible (for better performance)
+		maxSmpl = Tick2Sample(_fileTick);
+		smplStep = maxSmpl - _playSmpl;
+		if (smplStep < 1)
+			smplStep = 1;	// must render at least 1 sample in order to advance
+		if ((UINT32)smplStep > smplCnt - curSmpl)
+			smplStep = smplCnt - curSmpl;
+		// sample rate changes move devices between resampler groups
+		if (_playOpts.groupResamplers && ResamplerGroupsChanged())
+			BuildResamplerGroups();
+		// When DAC streams are active, split the step at the next DAC stream write,
+		// so that DAC streams and sound chip emulation are in sync.
+		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+		{
+			UINT32 dacSmpls = daccontrol_samples_to_next_cmd(_dacStreams[curDev].defInf.dataPtr);
+			if ((UINT32)smplStep > dacSmpls)
+				smplStep = dacSmpls;
+		}
+		
+		if (! _rndThreads.empty() && smplStep >= _PR_MIN_SMPLS)
+		{
+			RenderDevicesParallel(smplStep, &data[curSmpl]);
+		}
+		else
+		{
+			for (curDev = 0; curDev < _devices.size(); curDev ++)
+				RenderDevice(&_devices[curDev], smplStep, &data[curSmpl]);
+		}
+		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+		{
+			DEV_INFO* dacDInf = &_dacStreams[curDev].defInf;
+			dacDInf->devDef->Update(dacDInf->dataPtr, smplStep, NULL);
+		}
+		
+		curSmpl += smplStep;
+		_playSmpl += smplStep;
+		if (_psTrigger & PLAYSTATE_END)
+		{
+			_psTrigger &= ~PLAYSTATE_END;
+			break;
+		}
+	} while(curSmpl < smplCnt);
+	
+	return curSmpl;
+}
+
+void VGMPlayer::RenderDevice(CHIP_DEVICE* cDev, UINT32 smplCnt, WAVE_32BS* data)
+{
+	UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
+	UINT8 rsgMask = cDev->rsgMask;
+	VGM_BASEDEV* clDev;
+	
+	for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1, rsgMask >>= 1)
+	{
+		if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01) && ! (rsgMask & 0x01))
+			ResampleDeviceOutput(clDev, smplCnt, data, _playOpts.genOpts.skipSilentDevs);
+	}
+	if (cDev->rsgMask)
+	{
+		size_t devID = cDev - &_devices[0];
+		size_t curGrp;
+		for (curGrp = 0; curGrp < _rsGroups.size(); curGrp ++)
+		{
+			RESMPL_GROUP& rsGrp = _rsGroups[curGrp];
+			if (rsGrp.leadDev != devID)
+				continue;
+			if (_playOpts.genOpts.skipSilentDevs && ResamplerGroupSilent(rsGrp))
+				Resmpl_ExecuteSilent(&rsGrp.resmpl, smplCnt, data);
+			else
+				Resmpl_Execute(&rsGrp.resmpl, smplCnt, data);
+		}
+	}
+	
+	return;
+}
+
+// Devices that run at the same sample rate are mixed at that rate and then resampled only once.
+// When rendering in parallel, only devices within the same render job are grouped.
+// (only used with VGM_PLAY_OPTIONS::groupResamplers)
+void VGMPlayer::BuildResamplerGroups(void)
+{
+	std::vector<size_t> devJobMap;	// _devices index -> _rndJobs index
+	std::vector<size_t> grpMap;	// _rsgDevs index -> _rsGroups index
+	size_t grpCount;
+	size_t curDev;
+	size_t curGrp;
+	size_t curJob;
+	size_t otherDev;
+	
+	FreeResamplerGroups();
+	
+	devJobMap.resize(_devices.size(), (size_t)-1);
+	for (curJob = 0; curJob < _rndJobs.size(); curJob ++)
+	{
+		const std::vector<size_t>& devIDs = _rndJobs[curJob].devIDs;
+		for (curDev = 0; curDev < devIDs.size(); curDev ++)
+			devJobMap[devIDs[curDev]] = curJob;
+	}
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		VGM_BASEDEV* clDev;
+		UINT8 linkID;
+		for (clDev = &_devices[curDev].base, linkID = 0; clDev != NULL; clDev = clDev->linkDev, linkID ++)
+		{
+			RESMPL_GRP_DEV gDev;
+			if (clDev->defInf.dataPtr == NULL || clDev->resmpl.resampler == NULL || linkID >= 8)
+				continue;
+			gDev.base = clDev;
+			gDev.devID = curDev;
+			gDev.linkID = linkID;
+			gDev.smpRate = clDev->resmpl.smpRateSrc;
+			_rsgDevs.push_back(gDev);
+		}
+	}
+	
+	grpCount = 0;
+	grpMap.resize(_rsgDevs.size(), (size_t)-1);
+	for (curDev = 0; curDev < _rsgDevs.size(); curDev ++)
+	{
+		const RESMPL_GRP_DEV& gDev = _rsgDevs[curDev];
+		if (grpMap[curDev] != (size_t)-1)
+			continue;
+		for (otherDev = curDev + 1; otherDev < _rsgDevs.size(); otherDev ++)
+		{
+			const RESMPL_GRP_DEV& gOther = _rsgDevs[otherDev];
+			if (grpMap[otherDev] != (size_t)-1 || gOther.smpRate != gDev.smpRate ||
+				gOther.base->resmpl.resampleMode != gDev.base->resmpl.resampleMode ||
+				devJobMap[gOther.devID] != devJobMap[gDev.devID])
+				continue;
+			grpMap[curDev] = grpCount;
+			grpMap[otherDev] = grpCount;
+		}
+		if (grpMap[curDev] != (size_t)-1)
+			grpCount ++;
+	}
+	if (! grpCount)
+		return;
+	
+	_rsGroups.resize(grpCount);
+	for (curDev = 0; curDev < _rsgDevs.size(); curDev ++)
+	{
+		const RESMPL_GRP_DEV& gDev = _rsgDevs[curDev];
+		if (grpMap[curDev] == (size_t)-1)
+			continue;
+		RESMPL_GROUP& rsGrp = _rsGroups[grpMap[curDev]];
+		if (rsGrp.members.empty())
+			rsGrp.leadDev = gDev.devID;
+		rsGrp.members.push_back(curDev);
+		_devices[gDev.devID].rsgMask |= (1 << gDev.linkID);
+	}
+	for (curGrp = 0; curGrp < _rsGroups.size(); curGrp ++)
+	{
+		RESMPL_GROUP& rsGrp = _rsGroups[curGrp];
+		const RESMPL_STATE* devRs = &_rsgDevs[rsGrp.members[0]].base->resmpl;
+		
+		rsGrp.player = this;
+		// the device volumes are applied while mixing, so the group itself uses a factor of 1
+		Resmpl_SetVals(&rsGrp.resmpl, devRs->resampleMode, 1, _outSmplRate);
+		rsGrp.resmpl.smpRateSrc = devRs->smpRateSrc;
+		rsGrp.resmpl.StreamUpdate = VGMPlayer::RenderResamplerGroup;
+		rsGrp.resmpl.su_DataPtr = &rsGrp;
+		Resmpl_Init(&rsGrp.resmpl);
+	}
+	
+	return;
+}
+
+void VGMPlayer::FreeResamplerGroups(void)
+{
+	size_t curDev;
+	size_t curGrp;
+	
+	for (curGrp = 0; curGrp < _rsGroups.size(); curGrp ++)
+		Resmpl_Deinit(&_rsGroups[curGrp].resmpl);
+	_rsGroups.clear();
+	_rsgDevs.clear();
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		_devices[curDev].rsgMask = 0x00;
+	
+	return;
+}
+
+UINT8 VGMPlayer::ResamplerGroupsChanged(void) const
+{
+	size_t curDev;
+	
+	for (curDev = 0; curDev < _rsgDevs.size(); curDev ++)
+	{
+		const RESMPL_GRP_DEV& gDev = _rsgDevs[curDev];
+		if (gDev.base->resmpl.smpRateSrc != gDev.smpRate)
+			return 1;
+	}
+	return 0;
+}
+
+UINT8 VGMPlayer::ResamplerGroupSilent(const RESMPL_GROUP& rsGrp) const
+{
+	size_t curMbr;
+	
+	for (curMbr = 0; curMbr < rsGrp.members.size(); curMbr ++)
+	{
+		const RESMPL_GRP_DEV& gDev = _rsgDevs[rsGrp.members[curMbr]];
+		const CHIP_DEVICE& chipDev = _devices[gDev.devID];
+		
+		if (chipDev.optID != (size_t)-1 && (_devOpts[chipDev.optID].muteOpts.disable >> gDev.linkID) & 0x01)
+			continue;
+		if (! IsDeviceSilent(gDev.base))
+			return 0;
+	}
+	return 1;
+}
+
+/*static*/ void VGMPlayer::RenderResamplerGroup(void* info, UINT32 smpls, DEV_SMPL** outputs)
+{
+	RESMPL_GROUP* rsGrp = (RESMPL_GROUP*)info;
+	VGMPlayer* oThis = rsGrp->player;
+	DEV_SMPL* devBufs[2];
+	size_t curMbr;
+	
+	memset(outputs[0], 0x00, smpls * sizeof(DEV_SMPL));
+	memset(outputs[1], 0x00, smpls * sizeof(DEV_SMPL));
+	if (rsGrp->smplBuf.size() < smpls * 2)
+		rsGrp->smplBuf.resize(smpls * 2);
+	devBufs[0] = &rsGrp->smplBuf[0];
+	devBufs[1] = &rsGrp->smplBuf[smpls];
+	for (curMbr = 0; curMbr < rsGrp->members.size(); curMbr ++)
+	{
+		const RESMPL_GRP_DEV& gDev = oThis->_rsgDevs[rsGrp->members[curMbr]];
+		const CHIP_DEVICE& chipDev = oThis->_devices[gDev.devID];
+		const RESMPL_STATE* devRs = &gDev.base->resmpl;
+		
+		if (chipDev.optID != (size_t)-1 && (oThis->_devOpts[chipDev.optID].muteOpts.disable >> gDev.linkID) & 0x01)
+			continue;
+		if (oThis->_playOpts.genOpts.skipSilentDevs && IsDeviceSilent(gDev.base))
+			continue;	// adds nothing to the mix
+		devRs->StreamUpdate(devRs->su_DataPtr, smpls, devBufs);
+		MixK_ScaleAccMono(outputs[0], devBufs[0], smpls, devRs->volumeL);
+		MixK_ScaleAccMono(outputs[1], devBufs[1], smpls, devRs->volumeR);
+	}
+	
+	return;
+}
+
+void VGMPlayer::StartRenderThreads(void)
+{
+	std::vector<size_t> devJobMap;	// _devices index -> _rndJobs index
+	size_t curDev;
+	size_t curThr;
+	size_t thrCount;
+	UINT8 retVal;
+	
+	StopRenderThreads();
+	if (_playOpts.renderThreads <= 1 || _devices.size() <= 1)
+		return;
+	
+	// group devices into jobs
+	// Devices that access each other's state during Update() must be rendered by the same thread.
+	devJobMap.resize(_devices.size());
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		const CHIP_DEVICE& chipDev = _devices[curDev];
+		const DEV_GEN_CFG* devCfg = (const DEV_GEN_CFG*)&_devCfgs[chipDev.cfgID].cfgData[0];
+		size_t jobID = (size_t)-1;
+		
+		if (chipDev.chipType == DEVID_SN76496 && (chipDev.chipID & 0x01) && devCfg->flags)
+		{
+			// T6W28 mode: both SN76496 instances are connected to each other
+			size_t otherID = _vdDevMap[chipDev.vgmChipType][chipDev.chipID ^ 0x01];
+			if (otherID < curDev)
+				jobID = devJobMap[otherID];
+		}
+		if (jobID == (size_t)-1)
+		{
+			jobID = _rndJobs.size();
+			_rndJobs.push_back(RENDER_JOB());
+		}
+		devJobMap[curDev] = jobID;
+		_rndJobs[jobID].devIDs.push_back(curDev);
+	}
+	
+	thrCount = _playOpts.renderThreads;
+	if (thrCount > _rndJobs.size())
+		thrCount = _rndJobs.size();
+	if (thrCount <= 1)
+	{
+		_rndJobs.clear();
+		return;
+	}
+	
+	retVal = OSMutex_Init(&_rndJobMtx, 0);
+	if (retVal)
+	{
+		_rndJobMtx = NULL;
+		_rndJobs.clear();
+		return;
+	}
+	_rndQuit = 0;
+	// The main thread renders as well, so it needs one worker thread less.
+	// Note: The vector must not be resized while the threads are running.
+	_rndThreads.resize(thrCount - 1);
+	for (curThr = 0; curThr < _rndThreads.size(); curThr ++)
+	{
+		RENDER_THREAD& rThr = _rndThreads[curThr];
+		rThr.player = this;
+		rThr.hThread = NULL;
+		rThr.sigStart = NULL;
+		rThr.sigDone = NULL;
+		retVal  = OSSignal_Init(&rThr.sigStart, 0);
+		retVal |= OSSignal_Init(&rThr.sigDone, 0);
+		if (! retVal)
+			retVal = OSThread_Init(&rThr.hThread, &VGMPlayer::RenderThreadMain, &rThr);
+		if (retVal)
+		{
+			emu_logf(&_logger, PLRLOG_WARN, "Unable to create render thread. Using serial rendering.\n");
+			_rndThreads.resize(curThr + 1);	// make StopRenderThreads() clean up the partially initialized thread
+			StopRenderThreads();
+			return;
+		}
+	}
+	
+	return;
+}
+
+void VGMPlayer::StopRenderThreads(void)
+{
+	size_t curThr;
+	
+	_rndQuit = 1;
+	for (curThr = 0; curThr < _rndThreads.size(); curThr ++)
+	{
+		RENDER_THREAD& rThr = _rndThreads[curThr];
+		if (rThr.hThread != NULL)
+		{
+			OSSignal_Signal(rThr.sigStart);
+			OSThread_Join(rThr.hThread);
+			OSThread_Deinit(rThr.hThread);
+		}
+		if (rThr.sigStart != NULL)
+			OSSignal_Deinit(rThr.sigStart);
+		if (rThr.sigDone != NULL)
+			OSSignal_Deinit(rThr.sigDone);
+	}
+	_rndThreads.clear();
+	_rndJobs.clear();
+	if (_rndJobMtx != NULL)
+	{
+		OSMutex_Deinit(_rndJobMtx);
+		_rndJobMtx = NULL;
+	}
+	
+	return;
+}
+
+/*static*/ void VGMPlayer::RenderThreadMain(void* args)
+{
+	RENDER_THREAD* rThr = (RENDER_THREAD*)args;
+	VGMPlayer* player = rThr->player;
+	
+	while(true)
+	{
+		OSSignal_Wait(rThr->sigStart);
+		if (player->_rndQuit)
+			break;
+		player->ProcessRenderJobs();
+		OSSignal_Signal(rThr->sigDone);
+	}
+	
+	return;
+}
+
+void VGMPlayer::ProcessRenderJobs(void)
+{
+	while(true)
+	{
+		size_t jobID;
+		size_t curDev;
+		
+		OSMutex_Lock(_rndJobMtx);
+		jobID = _rndJobNext;
+		if (jobID < _rndJobs.size())
+			_rndJobNext ++;
+		OSMutex_Unlock(_rndJobMtx);
+		if (jobID >= _rndJobs.size())
+			break;
+		
+		RENDER_JOB& rJob = _rndJobs[jobID];
+		if (rJob.smplBuf.size() < _rndSmplCnt)
+			rJob.smplBuf.resize(_rndSmplCnt);
+		memset(&rJob.smplBuf[0], 0x00, _rndSmplCnt * sizeof(WAVE_32BS));
+		for (curDev = 0; curDev < rJob.devIDs.size(); curDev ++)
+			RenderDevice(&_devices[rJob.devIDs[curDev]], _rndSmplCnt, &rJob.smplBuf[0]);
+	}
+	
+	return;
+}
+
+void VGMPlayer::RenderDevicesParallel(UINT32 smplCnt, WAVE_32BS* data)
+{
+	size_t curThr;
+	size_t curJob;
+	UINT32 curSmpl;
+	
+	_rndSmplCnt = smplCnt;
+	_rndJobNext = 0;
+	for (curThr = 0; curThr < _rndThreads.size(); curThr ++)
+		OSSignal_Signal(_rndThreads[curThr].sigStart);
+	ProcessRenderJobs();
+	for (curThr = 0; curThr < _rndThreads.size(); curThr ++)
+		OSSignal_Wait(_rndThreads[curThr].sigDone);
+	
+	// Mixing is done in a fixed order, so the result is the same as with serial rendering.
+	for (curJob = 0; curJob < _rndJobs.size(); curJob ++)
+	{
+		const WAVE_32BS* jobBuf = &_rndJobs[curJob].smplBuf[0];
+		for (curSmpl = 0; curSmpl < smplCnt; curSmpl ++)
+		{
+			data[curSmpl].L += jobBuf[curSmpl].L;
+			data[curSmpl].R += jobBuf[curSmpl].R;
+		}
+	}
+	
+	return;
+}
+
+void VGMPlayer::ParseFile(UINT32 ticks)
+{
+	_playTick += ticks;
+	if (_playState & PLAYSTATE_END)
+		return;
+	
+	if (! _cmdOps.empty())
+		ExecCmdOps(_playTick, (UINT32)-1);
+	// The interpreter handles everything that isn't covered by the pre-decoded commands.
+	while(_filePos < _fileHdr.dataEnd && _fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
+	{
+		UINT8 curCmd = _fileData[_filePos];
+		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+		(this->*func)();
+		_filePos += _CMD_INFO[curCmd].cmdLen;
+	}
+	
+	if (_p2612Fix & P2612FIX_ACTIVE)
+	{
+		_p2612Fix &= ~P2612FIX_ACTIVE;	// disable Project2612 fix
+		// Note: Due to the way the Legacy Mode is implemented in YM2612 GPGX right now,
+		//       it should be no problem to keep it enabled during the whole song.
+		//       But let's just turn it off for safety.
+		
+		size_t optID = _devOptMap[DEVID_YM2612][0];
+		size_t devID = (optID == (size_t)-1) ? (size_t)-1 : _optDevMap[optID];
+		// refresh options, removing OPT_YM2612_LEGACY_MODE
+		if (devID < _devices.size())
+			RefreshDevOptions(_devices[devID], _devOpts[optID]);
+	}
+	
+	if (_filePos >= _fileHdr.dataEnd)
+	{
+		if (_playState & PLAYSTATE_SEEK)	// recalculate playSmpl to fix state when triggering callbacks
+			_playSmpl = Tick2Sample(_fileTick);	// Note: fileTick results in more accurate position
+		_playState |= PLAYSTATE_END;
+		_psTrigger |= PLAYSTATE_END;
+		if (_eventCbFunc != NULL)
+			_eventCbFunc(this, _eventCbParam, PLREVT_END, NULL);
+		emu_logf(&_logger, PLRLOG_WARN, "VGM file ends early! (filePos 0x%06X, end at 0x%06X)\n", _filePos, _fileHdr.dataEnd);
+	}
+	
+	return;
+}
+
+void VGMPlayer::PreDecodeCommands(void)
+{
+	UINT32 filePos = _fileHdr.dataOfs;
+	CMD_OP op;
+	
+	_cmdOps.clear();
+	_cmdOps.reserve((_fileHdr.dataEnd - filePos) / 3);	// most commands are 1..3 bytes long
+	while(filePos < _fileHdr.dataEnd)
+	{
+		UINT8 curCmd = _fileData[filePos];
+		UINT32 cmdLen = _CMD_INFO[curCmd].cmdLen;
+		
+		if (curCmd == 0x66)	// end of command data
+		{
+			DecodeCmdOp(filePos, &op);
+			_cmdOps.push_back(op);
+			filePos ++;	// Note: Cmd_EndOfData either stops or jumps to the loop offset.
+			break;
+		}
+		if (curCmd == 0x67)	// data block
+		{
+			if (filePos + 0x07 > _fileHdr.dataEnd)
+				break;
+			cmdLen = 0x07 + (ReadLE32(&_fileData[filePos + 0x03]) & 0x7FFFFFFF);
+		}
+		if (cmdLen == 0 || cmdLen > _fileHdr.dataEnd - filePos)
+			break;	// invalid/truncated command - leave it to the interpreter
+		DecodeCmdOp(filePos, &op);
+		_cmdOps.push_back(op);
+		filePos += cmdLen;
+	}
+	
+	memset(&op, 0x00, sizeof(CMD_OP));
+	op.filePos = filePos;
+	op.type = CMDOP_END;
+	_cmdOps.push_back(op);
+	_cmdOpPos = 0;
+	
+	return;
+}
+
+size_t VGMPlayer::FindCmdOp(UINT32 filePos) const
+{
+	// binary search, the commands are sorted by file offset
+	size_t posStart = 0;
+	size_t posEnd = _cmdOps.size();
+	while(posStart < posEnd)
+	{
+		size_t posMid = (posStart + posEnd) / 2;
+		if (_cmdOps[posMid].filePos < filePos)
+			posStart = posMid + 1;
+		else
+			posEnd = posMid;
+	}
+	if (posStart < _cmdOps.size() && _cmdOps[posStart].filePos == filePos)
+		return posStart;
+	return (size_t)-1;	// not the start of a pre-decoded command
+}
+
+void VGMPlayer::ExecCmdOps(UINT32 maxTick, UINT32 maxPos)
+{
+	const CMD_OP* op;
+	
+	// resync after Reset(), keyframe loading and jumps done by command functions
+	if (_cmdOpPos >= _cmdOps.size() || _cmdOps[_cmdOpPos].filePos != _filePos)
+	{
+		_cmdOpPos = FindCmdOp(_filePos);
+		if (_cmdOpPos == (size_t)-1)
+		{
+			_cmdOpPos = 0;
+			return;
+		}
+	}
+	
+	op = &_cmdOps[_cmdOpPos];
+	while(op->type != CMDOP_END && _fileTick <= maxTick && op->filePos <= maxPos)
+	{
+		switch(op->type)
+		{
+		case CMDOP_DELAY:
+			_fileTick += op->data;
+			break;
+		case CMDOP_A8D8:
+			op->write.a8d8(op->dataPtr, (UINT8)op->ofs, (UINT8)op->data);
+			break;
+		case CMDOP_YM:
+			op->write.a8d8(op->dataPtr, (op->port << 1) | 0, (UINT8)op->ofs);
+			op->write.a8d8(op->dataPtr, (op->port << 1) | 1, (UINT8)op->data);
+			break;
+		case CMDOP_A16D8:
+			op->write.a16d8(op->dataPtr, op->ofs, (UINT8)op->data);
+			break;
+		case CMDOP_A8D16:
+			op->write.a8d16(op->dataPtr, (UINT8)op->ofs, op->data);
+			break;
+		case CMDOP_A16D16:
+			op->write.a16d16(op->dataPtr, op->ofs, op->data);
+			break;
+		case CMDOP_YM2612PCM:
+			_fileTick += op->data;
+			if (_ym2612pcm_bnkPos < _pcmBank[0].dataLen)
+			{
+				op->write.a8d8(op->dataPtr, 0x00, 0x2A);
+				op->write.a8d8(op->dataPtr, 0x01, GetPCMBankByte(&_pcmBank[0], _ym2612pcm_bnkPos));
+				_ym2612pcm_bnkPos ++;
+			}
+			break;
+		case CMDOP_CALL:
+		default:
+			{
+				UINT8 curCmd = _fileData[op->filePos];
+				_filePos = op->filePos;
+				(this->*_CMD_INFO[curCmd].func)();
+				_filePos += _CMD_INFO[curCmd].cmdLen;
+			}
+			if (_playState & PLAYSTATE_END)
+			{
+				_cmdOpPos = op - &_cmdOps[0];
+				return;	// Note: _filePos is already correct
+			}
+			if (_filePos != op[1].filePos)
+			{
+				// the command function jumped somewhere else (loop)
+				_cmdOpPos = FindCmdOp(_filePos);
+				if (_cmdOpPos == (size_t)-1)
+				{
+					_cmdOpPos = 0;
+					return;
+				}
+				op = &_cmdOps[_cmdOpPos];
+				continue;
+			}
+			break;
+		}
+		op ++;
+	}
+	_cmdOpPos = op - &_cmdOps[0];
+	_filePos = op->filePos;
+	
+	return;
+}
+
+void VGMPlayer::ParseFileForFMClocks()
+{
+	UINT32 filePos = _fileHdr.dataOfs;
+
+	_v101ym2413clock = GetHeaderChipClock(0x01);
+	_v101ym2612clock = 0;
+	_v101ym2151clock = 0;
+
+	while(filePos < _fileHdr.dataEnd)
 	{
 		UINT8 curCmd = _fileData[filePos];
 
@@ -1991,3 +3259,372 @@ void VGMPlayer::ParseFileForFMClocks()
 		}
 	}
 }
+
+void VGMPlayer::ScanDataBlocks(void)
+{
+	// collect all PCM data blocks in order to know the final size of the PCM banks
+	UINT32 filePos = _fileHdr.dataOfs;
+	
+	_dataBlocks.clear();
+	memset(_pcmBankTotal, 0x00, sizeof(_pcmBankTotal));
+	_dblkScanDone = 0;
+	while(filePos < _fileHdr.dataEnd)
+	{
+		UINT8 curCmd = _fileData[filePos];
+		
+		if (curCmd == 0x66)	// end of command data
+			break;
+		if (curCmd == 0x67)	// data block
+		{
+			if (filePos + 0x07 > _fileHdr.dataEnd)
+				return;
+			UINT8 dblkType = _fileData[filePos + 0x02];
+			UINT32 dblkLen = ReadLE32(&_fileData[filePos + 0x03]) & 0x7FFFFFFF;
+			if (dblkLen > _fileHdr.dataEnd - (filePos + 0x07))
+				return;	// truncated data block
+			
+			if (dblkType < 0x80)	// PCM data/decompression table
+			{
+				DATA_BLOCK_INFO dbInfo;
+				dbInfo.type = dblkType;
+				dbInfo.fileOfs = filePos;
+				dbInfo.dataLen = dblkLen;
+				if (dblkType == 0x7F)
+				{
+					_dataBlocks.push_back(dbInfo);	// needed by GetPCMBankSource
+				}
+				else
+				{
+					if (dblkType & 0x40)
+					{
+						PCM_CDB_INF dbCI;
+						ReadComprDataBlkHdr(dblkLen, &_fileData[filePos + 0x07], &dbCI);
+						dbInfo.dataLen = dbCI.decmpLen;
+					}
+					_dataBlocks.push_back(dbInfo);
+					_pcmBankTotal[dblkType & 0x3F] += dbInfo.dataLen;
+				}
+			}
+			filePos += 0x07 + dblkLen;
+			continue;
+		}
+		if (_CMD_INFO[curCmd].cmdLen == 0)
+			return;	// unknown command - Cmd_DataBlock will grow the banks as needed
+		filePos += _CMD_INFO[curCmd].cmdLen;
+	}
+	_dblkScanDone = 1;
+	
+	return;
+}
+
+RomCache::HASH VGMPlayer::GetPCMBankSource(UINT8 bankID, std::vector<UINT8>& srcData) const
+{
+	// The bank contents are defined by its data blocks and the decompression table used for them.
+	// All of them are concatenated into srcData, which is compared by the ROM cache, and hashed.
+	const DATA_BLOCK_INFO* comprTbl = NULL;
+	size_t curBlk;
+	
+	srcData.assign(1, bankID);
+	
+	for (curBlk = 0; curBlk < _dataBlocks.size(); curBlk ++)
+	{
+		const DATA_BLOCK_INFO& dbInfo = _dataBlocks[curBlk];
+		if (dbInfo.type == 0x7F)
+		{
+			comprTbl = &dbInfo;
+			continue;
+		}
+		if ((dbInfo.type & 0x3F) != bankID)
+			continue;
+		
+		// add block type, length and data (and the table, including its length)
+		UINT32 dblkLen = ReadLE32(&_fileData[dbInfo.fileOfs + 0x03]) & 0x7FFFFFFF;
+		const UINT8* dblkPtr = &_fileData[dbInfo.fileOfs + 0x02];
+		srcData.insert(srcData.end(), dblkPtr, dblkPtr + 0x05 + dblkLen);
+		if ((dbInfo.type & 0x40) && comprTbl != NULL)
+		{
+			const UINT8* tblPtr = &_fileData[comprTbl->fileOfs + 0x03];
+			srcData.insert(srcData.end(), tblPtr, tblPtr + 0x04 + comprTbl->dataLen);
+		}
+	}
+	
+	return RomCache::CalcHash(srcData.size(), &srcData[0], FCC_VGM);
+}
+
+void VGMPlayer::ReleasePCMBank(PCM_BANK* pcmBnk)
+{
+	if (pcmBnk->cacheItem != NULL)
+	{
+		_romCache->Release(pcmBnk->cacheItem);
+		pcmBnk->cacheItem = NULL;
+	}
+	std::vector<UINT8>().swap(pcmBnk->cacheSrc);
+	std::vector<UINT8>().swap(pcmBnk->data);	// free the memory
+	pcmBnk->dataPtr = NULL;
+	pcmBnk->dataSize = 0;
+	pcmBnk->dataLen = 0;
+	pcmBnk->validLen = 0;
+	std::vector<PCM_LAZY_BLK>().swap(pcmBnk->lazyBlks);
+	pcmBnk->lazy = 0;
+	pcmBnk->lazyCurPtr = NULL;
+	pcmBnk->lazyCurLen = 0;
+	
+	return;
+}
+
+void VGMPlayer::RefreshDACStreamData(UINT8 bankID)
+{
+	PCM_BANK* pcmBnk = &_pcmBank[bankID];
+	size_t curStrm;
+	
+	for (curStrm = 0; curStrm < _dacStreams.size(); curStrm ++)
+	{
+		DACSTRM_DEV* dacStrm = &_dacStreams[curStrm];
+		if (dacStrm->bankID != bankID)
+			continue;
+		SetDACStreamReader(dacStrm);
+		if (pcmBnk->dataLen > 0)
+			daccontrol_refresh_data(dacStrm->defInf.dataPtr, pcmBnk->dataPtr, pcmBnk->dataLen);
+		else
+			daccontrol_refresh_data(dacStrm->defInf.dataPtr, NULL, 0);
+	}
+	
+	return;
+}
+
+void VGMPlayer::SetDACStreamReader(DACSTRM_DEV* dacStrm)
+{
+	// DAC streams that play from lazy banks read the data via GetPCMBankData().
+	if (dacStrm->bankID < _PCM_BANK_COUNT && _pcmBank[dacStrm->bankID].lazy)
+		daccontrol_set_read_callback(dacStrm->defInf.dataPtr, VGMPlayer::DACStreamReadCB, &_pcmBankCbData[dacStrm->bankID]);
+	else
+		daccontrol_set_read_callback(dacStrm->defInf.dataPtr, NULL, NULL);
+	
+	return;
+}
+
+/*static*/ const UINT8* VGMPlayer::DACStreamReadCB(void* userParam, UINT32 pos, UINT32 len)
+{
+	PCMBANK_CB_DATA* cbData = (PCMBANK_CB_DATA*)userParam;
+	VGMPlayer* player = cbData->player;
+	PCM_BANK* pcmBnk = &player->_pcmBank[cbData->bankID];
+	const UINT8* data;
+	UINT32 dataLen;
+	UINT32 curByte;
+	
+	data = player->GetPCMBankData(pcmBnk, pos, &dataLen);
+	if (data == NULL || dataLen >= len)
+		return data;
+	
+	// The command crosses the end of a block/chunk - copy the bytes to a temporary buffer.
+	if (len > sizeof(player->_dacReadBuf))
+		len = sizeof(player->_dacReadBuf);
+	for (curByte = 0; curByte < len; curByte ++)
+		player->_dacReadBuf[curByte] = (pos + curByte < pcmBnk->dataLen) ? player->GetPCMBankByte(pcmBnk, pos + curByte) : 0x00;
+	return player->_dacReadBuf;
+}
+
+const UINT8* VGMPlayer::GetPCMBankData(PCM_BANK* pcmBnk, UINT32 ofs, UINT32* retLen)
+{
+	// returns the bank data at offset "ofs" and the number of bytes that can be read from there
+	// Note: For lazy banks, the pointer is valid until the next call.
+	if (! pcmBnk->lazy)
+	{
+		if (ofs >= pcmBnk->dataLen)
+			return NULL;
+		*retLen = pcmBnk->dataLen - ofs;
+		return &pcmBnk->dataPtr[ofs];
+	}
+	if (ofs >= pcmBnk->dataLen)
+		return NULL;
+	if (ofs - pcmBnk->lazyCurOfs < pcmBnk->lazyCurLen)
+	{
+		*retLen = pcmBnk->lazyCurLen - (ofs - pcmBnk->lazyCurOfs);
+		return &pcmBnk->lazyCurPtr[ofs - pcmBnk->lazyCurOfs];
+	}
+	
+	// find the data block (binary search, blocks are sorted by bank offset)
+	size_t blkStart = 0;
+	size_t blkEnd = pcmBnk->lazyBlks.size();
+	while(blkEnd - blkStart > 1)
+	{
+		size_t blkMid = (blkStart + blkEnd) / 2;
+		if (pcmBnk->lazyBlks[blkMid].bankOfs <= ofs)
+			blkStart = blkMid;
+		else
+			blkEnd = blkMid;
+	}
+	if (blkStart >= pcmBnk->lazyBlks.size())
+		return NULL;
+	PCM_LAZY_BLK* lzBlk = &pcmBnk->lazyBlks[blkStart];
+	if (ofs - lzBlk->bankOfs >= lzBlk->dataLen)
+		return NULL;
+	
+	if (! lzBlk->compressed)
+	{
+		pcmBnk->lazyCurPtr = &_fileData[lzBlk->fileOfs];
+		pcmBnk->lazyCurOfs = lzBlk->bankOfs;
+		pcmBnk->lazyCurLen = lzBlk->dataLen;
+	}
+	else
+	{
+		size_t chunkID = (ofs - lzBlk->bankOfs) >> _LAZY_CHUNK_SHIFT;
+		PCM_LAZY_CHUNK* lzChunk = &lzBlk->chunks[chunkID];
+		if (lzChunk->data.empty())
+			DecompressLazyChunk(lzBlk, chunkID);
+		lzChunk->lastUse = ++_lazyUseCntr;
+		pcmBnk->lazyCurPtr = &lzChunk->data[0];
+		pcmBnk->lazyCurOfs = lzBlk->bankOfs + ((UINT32)chunkID << _LAZY_CHUNK_SHIFT);
+		pcmBnk->lazyCurLen = (UINT32)lzChunk->data.size();
+	}
+	*retLen = pcmBnk->lazyCurLen - (ofs - pcmBnk->lazyCurOfs);
+	return &pcmBnk->lazyCurPtr[ofs - pcmBnk->lazyCurOfs];
+}
+
+UINT8 VGMPlayer::GetPCMBankByte(PCM_BANK* pcmBnk, UINT32 ofs)
+{
+	// Note: The caller has to check that ofs < dataLen.
+	if (! pcmBnk->lazy)
+		return pcmBnk->dataPtr[ofs];
+	
+	UINT32 dataLen;
+	const UINT8* data = GetPCMBankData(pcmBnk, ofs, &dataLen);
+	return (data != NULL) ? data[0] : 0x00;
+}
+
+void VGMPlayer::DecompressLazyChunk(PCM_LAZY_BLK* lzBlk, size_t chunkID)
+{
+	PCM_LAZY_CHUNK* lzChunk = &lzBlk->chunks[chunkID];
+	PCM_CMP_INF cmprInfo = lzBlk->cmprInfo;
+	UINT8 valSize = (cmprInfo.bitsDec + 7) / 8;
+	UINT32 outOfs = (UINT32)chunkID << _LAZY_CHUNK_SHIFT;
+	UINT32 outLen = lzBlk->dataLen - outOfs;
+	UINT32 inOfs;
+	UINT8 retVal;
+	
+	if (outLen > (1 << _LAZY_CHUNK_SHIFT))
+		outLen = (1 << _LAZY_CHUNK_SHIFT);
+	if (cmprInfo.comprType == 0x01)
+	{
+		if (! lzChunk->dpcmValid)
+		{
+			// DPCM data depends on all previous values, so the chunks since the last known
+			// start value have to be decompressed first. (Decompressing a chunk sets the start of the next one.)
+			size_t prevChunk = chunkID;
+			while(! lzBlk->chunks[prevChunk].dpcmValid)
+				prevChunk --;	// Note: chunk 0 is always valid
+			for (; prevChunk < chunkID; prevChunk ++)
+				DecompressLazyChunk(lzBlk, prevChunk);
+		}
+		cmprInfo.baseVal = lzChunk->dpcmStart;
+	}
+	
+	if (lzBlk->tblOfs != (UINT32)-1)
+	{
+		if (_lazyTblOfs != lzBlk->tblOfs)
+		{
+			UINT32 tblLen = ReadLE32(&_fileData[lzBlk->tblOfs + 0x03]) & 0x7FFFFFFF;
+			ReadPCMComprTable(tblLen, &_fileData[lzBlk->tblOfs + 0x07], &_lazyComprTbl);
+			_lazyTblOfs = lzBlk->tblOfs;
+		}
+		cmprInfo.comprTbl = &_lazyComprTbl;
+	}
+	else
+	{
+		static const PCM_COMPR_TBL noTable = {0x00, 0x00, 0, 0, 0, {NULL}};
+		cmprInfo.comprTbl = &noTable;
+	}
+	
+	EvictLazyChunks(outLen);
+	lzChunk->data.resize(outLen);
+	_lazyMemSize += outLen;
+	// Chunks contain a multiple of 16 values, so they start at a byte boundary of the compressed data.
+	inOfs = (UINT32)(((UINT64)(outOfs / valSize) * cmprInfo.bitsCmp) / 8);
+	if (inOfs > lzBlk->fileLen)
+		inOfs = lzBlk->fileLen;
+	retVal = DecompressDataBlk(outLen, &lzChunk->data[0],
+		lzBlk->fileLen - inOfs, &_fileData[lzBlk->fileOfs + inOfs], &cmprInfo);
+	if (retVal == 0x10)
+		emu_logf(&_logger, PLRLOG_ERROR, "Error loading table-compressed data block! No table loaded!\n");
+	else if (retVal == 0x11)
+		emu_logf(&_logger, PLRLOG_ERROR, "Data block and loaded value table incompatible!\n");
+	else if (retVal == 0x80)
+		emu_logf(&_logger, PLRLOG_ERROR, "Unknown data block compression!\n");
+	
+	if (cmprInfo.comprType == 0x01 && chunkID + 1 < lzBlk->chunks.size())
+	{
+		PCM_LAZY_CHUNK* nextChunk = &lzBlk->chunks[chunkID + 1];
+		// the DPCM state equals the last output value (full chunks have an even size)
+		if (valSize == 0x01)
+			nextChunk->dpcmStart = lzChunk->data[outLen - 1];
+		else
+			nextChunk->dpcmStart = (lzChunk->data[outLen - 2] << 0) | (lzChunk->data[outLen - 1] << 8);
+		nextChunk->dpcmValid = 1;
+	}
+	
+	return;
+}
+
+void VGMPlayer::EvictLazyChunks(size_t memNeeded)
+{
+	// free the least recently used chunks until there is enough memory for "memNeeded" additional bytes
+	if (! _playOpts.lazyPcmMemLimit)
+		return;
+	while(_lazyMemSize > 0 && _lazyMemSize + memNeeded > _playOpts.lazyPcmMemLimit)
+	{
+		PCM_BANK* lruBank = NULL;
+		PCM_LAZY_CHUNK* lruChunk = NULL;
+		size_t curBank;
+		size_t curBlk;
+		size_t curChunk;
+		
+		for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+		{
+			PCM_BANK* pcmBnk = &_pcmBank[curBank];
+			for (curBlk = 0; curBlk < pcmBnk->lazyBlks.size(); curBlk ++)
+			{
+				PCM_LAZY_BLK* lzBlk = &pcmBnk->lazyBlks[curBlk];
+				for (curChunk = 0; curChunk < lzBlk->chunks.size(); curChunk ++)
+				{
+					PCM_LAZY_CHUNK* lzChunk = &lzBlk->chunks[curChunk];
+					if (lzChunk->data.empty())
+						continue;
+					if (lruChunk == NULL || (INT32)(lzChunk->lastUse - lruChunk->lastUse) < 0)
+					{
+						lruBank = pcmBnk;
+						lruChunk = lzChunk;
+					}
+				}
+			}
+		}
+		if (lruChunk == NULL)
+			break;
+		
+		if (lruBank->lazyCurPtr == &lruChunk->data[0])
+		{
+			lruBank->lazyCurPtr = NULL;
+			lruBank->lazyCurLen = 0;
+		}
+		_lazyMemSize -= lruChunk->data.size();
+		std::vector<UINT8>().swap(lruChunk->data);
+	}
+	
+	return;
+}
+
+UINT8 VGMPlayer::SetRomCache(RomCache* cache)
+{
+	if (_playState & PLAYSTATE_PLAY)
+		return 0xFF;
+	if (cache == _romCache)
+		return 0x00;
+	
+	if (_romCache != NULL)
+	{
+		_romCache->Release(_yrwRomItem);
+		_yrwRomItem = NULL;
+	}
+	_romCache = cache;
+	
+	return 0x00;
+}
@@ -8,8 +8,12 @@
 #include "helper.h"
 #include "playerbase.hpp"
 #include "../utils/DataLoader.h"
+#include "../utils/OSThread.h"
+#include "../utils/OSSignal.h"
+#include "../utils/OSMutex.h"
 #include "../emu/logging.h"
 #include "dblk_compr.h"
+#include "romcache.hpp"
 #include <vector>
 #include <string>
 
@@ -46,6 +50,19 @@ struct VGM_PLAY_OPTIONS
 	UINT32 playbackHz;	// set to 60 (NTSC) or 50 (PAL) for region-specific song speed adjustment
 						// Note: requires VGM_HEADER.recordHz to be non-zero to work.
 	UINT8 hardStopOld;	// enforce silence at end of old VGMs (<1.50), fixes Key Off events being trimmed off
+	UINT8 renderThreads;	// number of threads for rendering sound devices in parallel (0/1 = render serially)
+							// Note: takes effect when calling Start().
+	UINT32 keyframeInterval;	// store the playback state every N seconds for fast backward seeking (0 = disabled)
+	UINT32 keyframeMemLimit;	// memory limit for keyframes (in bytes), the interval is increased when exceeding it
+							// Note: takes effect when calling Start().
+	UINT8 preDecodeCmds;	// decode the command stream into a list of device writes when starting playback
+							// (faster parsing/seeking, needs 32 bytes per command)
+	UINT8 lazyPcmDecode;	// decompress compressed PCM data blocks when their data is accessed instead of when loading them
+	UINT32 lazyPcmMemLimit;	// memory limit for decompressed PCM data in lazy mode (in bytes, 0 = unlimited)
+							// Note: takes effect when calling Start().
+	UINT8 groupResamplers;	// mix devices with the same sample rate first and resample them together
+							// (faster with many devices, but not sample-exact compared to resampling each device)
+							// Note: takes effect when calling Start().
 };
 
 
@@ -75,7 +92,9 @@ public:
 		DEVFUNC_WRITE_BLOCK romWrite;
 		DEVFUNC_WRITE_MEMSIZE romSizeB;
 		DEVFUNC_WRITE_BLOCK romWriteB;
+		DEVFUNC_WRITE_ROMREF romRef;	// use ROM data from the file without copying it (memory type 0 only)
 		DEVLOG_CB_DATA logCbData;
+		UINT8 rsgMask;	// linked devices that are resampled by a RESMPL_GROUP (bit 0 = base device)
 	};
 	struct DACSTRM_DEV
 	{
@@ -110,11 +129,65 @@ protected:
 		std::vector<UINT8> cfgData;
 	};
 	
+	struct PCM_LAZY_CHUNK
+	{
+		std::vector<UINT8> data;	// decompressed data (empty = not decompressed yet/evicted)
+		UINT32 lastUse;		// for LRU eviction
+		UINT16 dpcmStart;	// DPCM: output value before the first sample of the chunk
+		UINT8 dpcmValid;	// DPCM: dpcmStart is known
+	};
+	struct PCM_LAZY_BLK
+	{
+		UINT32 bankOfs;		// offset of the block data in the PCM bank
+		UINT32 dataLen;		// size of the (decompressed) data
+		UINT32 fileOfs;		// file offset of the (compressed) data
+		UINT32 fileLen;
+		UINT32 tblOfs;		// file offset of the decompression table's data block command (-1 = none)
+		UINT8 compressed;	// 0 - uncompressed, the data is read from the file directly
+		PCM_CMP_INF cmprInfo;	// comprTbl is set when decompressing
+		std::vector<PCM_LAZY_CHUNK> chunks;
+	};
 	struct PCM_BANK
 	{
-		std::vector<UINT8> data;
+		std::vector<UINT8> data;	// bank memory, preallocated to the size of all data blocks of the file
+		UINT8* dataPtr;		// bank data (points to "data" or to the data of cacheItem)
+		UINT32 dataSize;	// size of the bank memory
+		UINT32 dataLen;		// number of bytes loaded by the data blocks processed so far
+		UINT32 validLen;	// number of bytes that contain decoded data (kept over Reset(), >= dataLen)
+		RomCache::HASH cacheKey;
+		std::vector<UINT8> cacheSrc;	// source data of the bank (all its data blocks), identifies the cache item
+		const RomCache::ITEM* cacheItem;	// bank data shared via the ROM cache (read-only)
 		std::vector<UINT32> bankOfs;
 		std::vector<UINT32> bankSize;
+		
+		// lazy decompression mode (the bank has no memory, data is accessed using GetPCMBankData)
+		UINT8 lazy;
+		std::vector<PCM_LAZY_BLK> lazyBlks;	// all data blocks loaded so far (kept over Reset())
+		const UINT8* lazyCurPtr;	// last accessed piece of data
+		UINT32 lazyCurOfs;
+		UINT32 lazyCurLen;
+	};
+	struct PCMBANK_CB_DATA
+	{
+		VGMPlayer* player;
+		UINT8 bankID;
+	};
+	struct DATA_BLOCK_INFO
+	{
+		UINT8 type;
+		UINT32 fileOfs;	// file offset of the data block command
+		UINT32 dataLen;	// size of the (decompressed) data
+	};
+	struct ANA_DACSTRM	// DAC stream state for AnalyzeSong
+	{
+		UINT8 used;
+		UINT8 bankID;
+		UINT8 cmdSize;	// bytes per sent command (depends on the destination chip)
+		UINT8 stepSize;
+		UINT32 freq;
+		UINT32 cmdCnt;	// number of commands to send
+		UINT8 running;
+		UINT32 endTick;	// tick when the stream finishes playing (-1 = plays until stopped)
 	};
 	
 	typedef void (VGMPlayer::*COMMAND_FUNC)(void);	// VGM command member function callback
@@ -130,6 +203,63 @@ protected:
 		UINT32 cmdLen;
 		COMMAND_FUNC func;
 	};
+	enum
+	{
+		CMDOP_END,		// end of the pre-decoded data
+		CMDOP_CALL,		// call the command function (commands that aren't simple writes)
+		CMDOP_DELAY,	// wait [data] ticks
+		CMDOP_A8D8,		// write8(ofs, data)
+		CMDOP_YM,		// write8(port*2+0, ofs), write8(port*2+1, data)
+		CMDOP_A16D8,	// writeM8(ofs, data)
+		CMDOP_A8D16,	// writeD16(ofs, data)
+		CMDOP_A16D16,	// writeM16(ofs, data)
+		CMDOP_YM2612PCM,	// write YM2612 PCM data from data block 0, then wait [data] ticks
+	};
+	struct CMD_OP	// pre-decoded VGM command
+	{
+		void* dataPtr;	// device data pointer
+		union
+		{
+			DEVFUNC_WRITE_A8D8 a8d8;
+			DEVFUNC_WRITE_A16D8 a16d8;
+			DEVFUNC_WRITE_A8D16 a8d16;
+			DEVFUNC_WRITE_A16D16 a16d16;
+		} write;
+		UINT32 filePos;	// file offset of the command
+		UINT8 type;		// CMDOP_* constant
+		UINT8 port;		// port for YM register writes
+		UINT16 ofs;		// register/offset
+		UINT16 data;	// data to write or number of ticks to wait
+	};
+	
+	struct RENDER_THREAD
+	{
+		VGMPlayer* player;
+		OS_THREAD* hThread;
+		OS_SIGNAL* sigStart;	// main thread -> worker: render jobs
+		OS_SIGNAL* sigDone;		// worker -> main thread: all jobs taken are finished
+	};
+	struct RENDER_JOB
+	{
+		std::vector<size_t> devIDs;	// devices (_devices index) that have to be rendered by the same thread
+		std::vector<WAVE_32BS> smplBuf;	// private buffer, mixed into the output by the main thread
+	};
+	
+	struct RESMPL_GRP_DEV
+	{
+		VGM_BASEDEV* base;
+		size_t devID;	// _devices index
+		UINT8 linkID;	// position in the device's link chain (for muting)
+		UINT32 smpRate;	// sample rate at the time the groups were built
+	};
+	struct RESMPL_GROUP	// devices with the same sample rate, mixed at that rate and resampled together
+	{
+		VGMPlayer* player;
+		RESMPL_STATE resmpl;
+		size_t leadDev;	// _devices index of the device that renders the group
+		std::vector<size_t> members;	// _rsgDevs indices
+		std::vector<DEV_SMPL> smplBuf;
+	};
 	
 	struct QSOUND_WORK
 	{
@@ -137,6 +267,26 @@ protected:
 		UINT16 startAddrCache[16];	// QSound register 0x01
 		UINT16 pitchCache[16];		// QSound register 0x02
 	};
+	struct KEYFRAME	// playback state, used for seeking backwards without parsing from the beginning
+	{
+		UINT32 filePos;
+		UINT32 fileTick;
+		UINT32 playTick;
+		UINT32 curLoop;
+		UINT32 lastLoopTick;
+		UINT8 p2612Fix;
+		UINT32 ym2612pcm_bnkPos;
+		UINT8 rf5cBank[2][2];
+		QSOUND_WORK qsWork[2];
+		std::vector<UINT32> pcmBankSize;	// size of PCM bank data
+		std::vector<UINT32> pcmBankCount;	// number of data blocks in PCM bank
+		std::vector<DACSTRM_DEV> dacStreams;	// Note: defInf is unused
+		std::vector<RESMPL_STATE> rsgStates;	// resampler group positions (buffers are not owned)
+		std::vector<UINT8> rsgHistory;	// resampler group filter histories (see Resmpl_SaveHistory)
+		std::vector<size_t> stateOfs;	// offsets of device/DAC stream states in stateData
+		std::vector<UINT8> stateData;
+		size_t memSize;	// memory used by the keyframe
+	};
 	
 public:
 	VGMPlayer();
@@ -153,6 +303,7 @@ public:
 	const char* const* GetTags(void);
 	UINT8 GetSongInfo(PLR_SONG_INFO& songInf);
 	UINT8 GetSongDeviceInfo(std::vector<PLR_DEV_INFO>& devInfList) const;
+	UINT8 AnalyzeSong(PLR_ANALYSIS& result) const;
 	UINT8 SetDeviceOptions(UINT32 id, const PLR_DEV_OPTS& devOpts);
 	UINT8 GetDeviceOptions(UINT32 id, PLR_DEV_OPTS& devOpts) const;
 	UINT8 SetDeviceMuting(UINT32 id, const PLR_MUTE_OPTS& muteOpts);
@@ -167,6 +318,7 @@ public:
 	UINT8 SetPlaybackSpeed(double speed);
 	//void SetEventCallback(PLAYER_EVENT_CB cbFunc, void* cbParam);
 	//void SetFileReqCallback(PLAYER_FILEREQ_CB cbFunc, void* cbParam);
+	UINT8 SetRomCache(RomCache* cache);
 	UINT32 Tick2Sample(UINT32 ticks) const;
 	UINT32 Sample2Tick(UINT32 samples) const;
 	double Tick2Second(UINT32 ticks) const;
@@ -221,9 +373,36 @@ protected:
 	
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void SaveKeyframe(UINT32 playTick);
+	UINT8 LoadKeyframe(UINT8 unit, UINT32 pos);
 	void ParseFile(UINT32 ticks);
+	void PreDecodeCommands(void);
+	size_t FindCmdOp(UINT32 filePos) const;
+	void ExecCmdOps(UINT32 maxTick, UINT32 maxPos);
+	
+	void RenderDevice(CHIP_DEVICE* cDev, UINT32 smplCnt, WAVE_32BS* data);
+	void BuildResamplerGroups(void);
+	void FreeResamplerGroups(void);
+	UINT8 ResamplerGroupsChanged(void) const;
+	UINT8 ResamplerGroupSilent(const RESMPL_GROUP& rsGrp) const;
+	static void RenderResamplerGroup(void* info, UINT32 smpls, DEV_SMPL** outputs);
+	void StartRenderThreads(void);
+	void StopRenderThreads(void);
+	static void RenderThreadMain(void* args);
+	void ProcessRenderJobs(void);
+	void RenderDevicesParallel(UINT32 smplCnt, WAVE_32BS* data);
 
 	void ParseFileForFMClocks();
+	void ScanDataBlocks(void);
+	RomCache::HASH GetPCMBankSource(UINT8 bankID, std::vector<UINT8>& srcData) const;
+	void ReleasePCMBank(PCM_BANK* pcmBnk);
+	void RefreshDACStreamData(UINT8 bankID);
+	void SetDACStreamReader(DACSTRM_DEV* dacStrm);
+	const UINT8* GetPCMBankData(PCM_BANK* pcmBnk, UINT32 ofs, UINT32* retLen);
+	UINT8 GetPCMBankByte(PCM_BANK* pcmBnk, UINT32 ofs);
+	void DecompressLazyChunk(PCM_LAZY_BLK* lzBlk, size_t chunkID);
+	void EvictLazyChunks(size_t memNeeded);
+	static const UINT8* DACStreamReadCB(void* userParam, UINT32 pos, UINT32 len);
 	
 	// --- VGM command functions ---
 	void Cmd_invalid(void);
@@ -235,15 +414,19 @@ protected:
 	void Cmd_DelaySamplesN1(void);			// command 70..7F - wait (N+1) samples
 	void DoRAMOfsPatches(UINT8 chipType, UINT8 chipID, UINT32& dataOfs, UINT32& dataLen);
 	void Cmd_DataBlock(void);				// command 67
+	void AddLazyDataBlock(UINT8 dblkType, UINT32 dblkLen);	// Cmd_DataBlock for lazy PCM banks
 	void Cmd_PcmRamWrite(void);				// command 68
 	void Cmd_YM2612PCM_Delay(void);			// command 80..8F - write YM2612 PCM from data block + delay by N samples
 	void Cmd_YM2612PCM_Seek(void);			// command E0 - set YM2612 PCM data offset
+	UINT8 InitDACStream(DACSTRM_DEV* dacStrm, UINT8 streamID);
 	void Cmd_DACCtrl_Setup(void);			// command 90
 	void Cmd_DACCtrl_SetData(void);			// command 91
 	void Cmd_DACCtrl_SetFrequency(void);	// command 92
 	void Cmd_DACCtrl_PlayData_Loc(void);	// command 93
 	void Cmd_DACCtrl_Stop(void);			// command 94
 	void Cmd_DACCtrl_PlayData_Blk(void);	// command 95
+	UINT8 DecodeCmdWrite(UINT32 filePos, CMD_OP* op) const;	// decode a simple device write, returns chip ID
+	void DecodeCmdOp(UINT32 filePos, CMD_OP* op);	// turn a command into an op for ExecCmdOps
 	
 	void Cmd_GGStereo(void);				// command 4F - set GameGear Stereo mask
 	void Cmd_SN76489(void);					// command 50 - SN76489 register write
@@ -279,6 +462,7 @@ protected:
 	DATA_LOADER *_dLoad;
 	const UINT8* _fileData;	// data pointer for quick access, equals _dLoad->GetFileData().data()
 	std::vector<UINT8> _yrwRom;	// cache for OPL4 sample ROM (yrw801.rom)
+	const RomCache::ITEM* _yrwRomItem;	// OPL4 sample ROM from the ROM cache (used instead of _yrwRom)
 	UINT8 _shownCmdWarnings[0x100];
 	
 	enum
@@ -286,7 +470,9 @@ protected:
 		_HDR_BUF_SIZE = 0x100,
 		_OPT_DEV_COUNT = 0x30,
 		_CHIP_COUNT = 0x30,
-		_PCM_BANK_COUNT = 0x40
+		_PCM_BANK_COUNT = 0x40,
+		_PR_MIN_SMPLS = 32,	// minimum render step size for dispatching to the render threads
+		_LAZY_CHUNK_SHIFT = 16	// lazy PCM banks are decompressed in chunks of 64 KB (must be a multiple of 16 values)
 	};
 	
 	VGM_HEADER _fileHdr;
@@ -331,6 +517,9 @@ protected:
 	UINT32 _curLoop;	// current repetition, 0 = first playthrough, 1 = repeating 1st time
 	UINT32 _lastLoopTick;	// tick time of last loop, used for "0-sample-loop" detection
 	
+	std::vector<CMD_OP> _cmdOps;	// pre-decoded commands, terminated by a CMDOP_END entry (empty = disabled)
+	size_t _cmdOpPos;	// _cmdOps index of the command at _filePos
+	
 	UINT8 _playState;
 	UINT8 _psTrigger;	// used to temporarily trigger special commands
 	//PLAYER_EVENT_CB _eventCbFunc;
@@ -359,11 +548,35 @@ protected:
 	std::vector<CHIP_DEVICE> _devices;
 	std::vector<std::string> _devNames;
 	
+	std::vector<RENDER_THREAD> _rndThreads;	// worker threads for parallel rendering (the main thread renders as well)
+	std::vector<RENDER_JOB> _rndJobs;
+	OS_MUTEX* _rndJobMtx;
+	size_t _rndJobNext;		// next job to be taken by a thread
+	UINT32 _rndSmplCnt;		// number of samples to render for the current batch of jobs
+	UINT8 _rndQuit;
+	
+	std::vector<RESMPL_GRP_DEV> _rsgDevs;	// all devices with an active resampler
+	std::vector<RESMPL_GROUP> _rsGroups;	// Note: must not be resized while in use, the resamplers point to it.
+	
 	size_t _dacStrmMap[0x100];	// maps VGM DAC stream ID -> _dacStreams vector
 	std::vector<DACSTRM_DEV> _dacStreams;
 	
 	PCM_BANK _pcmBank[_PCM_BANK_COUNT];
+	std::vector<DATA_BLOCK_INFO> _dataBlocks;	// all PCM data blocks of the file (collected by ScanDataBlocks)
+	UINT32 _pcmBankTotal[_PCM_BANK_COUNT];	// final size of each PCM bank
+	UINT8 _dblkScanDone;	// ScanDataBlocks() reached the end of the command data
 	PCM_COMPR_TBL _pcmComprTbl;
+	UINT32 _pcmComprTblOfs;	// file offset of the current decompression table's data block command (-1 = none)
+	PCMBANK_CB_DATA _pcmBankCbData[_PCM_BANK_COUNT];	// for DAC streams that read from lazy PCM banks
+	PCM_COMPR_TBL _lazyComprTbl;	// decompression table used by DecompressLazyChunk
+	UINT32 _lazyTblOfs;		// file offset of the table in _lazyComprTbl
+	size_t _lazyMemSize;	// memory used by all decompressed chunks
+	UINT32 _lazyUseCntr;
+	UINT8 _dacReadBuf[0x04];	// for DAC stream reads that cross data blocks/chunks
+	
+	std::vector<KEYFRAME> _keyframes;	// sorted by playTick
+	size_t _kfMemSize;		// memory used by all keyframes
+	UINT32 _kfInterval;		// keyframe interval in ticks (0 = don't store keyframes)
 	
 	UINT8 _p2612Fix;	// enable hack/fix for Project2612 VGMs
 	UINT32 _ym2612pcm_bnkPos;
@@ -706,12 +706,18 @@ void VGMPlayer::Cmd_DataBlock(void)
 		if (dblkType == 0x7F)
 		{
 			ReadPCMComprTable(dblkLen, &fData[0x00], &_pcmComprTbl);
+			_pcmComprTblOfs = _filePos - 0x07;
+		}
+		else if (_pcmBank[dblkType & 0x3F].lazy)
+		{
+			AddLazyDataBlock(dblkType, dblkLen);
+			RefreshDACStreamData(dblkType & 0x3F);
 		}
 		else
 		{
 			PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
 			PCM_CDB_INF dbCI;
-			UINT32 oldLen = (UINT32)pcmBnk->data.size();
+			UINT32 oldLen = pcmBnk->dataLen;
 			dataLen = dblkLen;
 			dataPtr = &fData[0x00];
 			
@@ -725,24 +731,51 @@ void VGMPlayer::Cmd_DataBlock(void)
 			pcmBnk->bankOfs.push_back(oldLen);
 			pcmBnk->bankSize.push_back(dataLen);
 			
-			pcmBnk->data.resize(oldLen + dataLen);
-			if (dblkType & 0x40)
+			pcmBnk->dataLen = oldLen + dataLen;
+			if (pcmBnk->dataLen > pcmBnk->dataSize)
 			{
-				UINT8 retVal = DecompressDataBlk(dataLen, &pcmBnk->data[oldLen],
-					dblkLen - dbCI.hdrSize, &dataPtr[dbCI.hdrSize], &dbCI.cmprInfo);
-				if (retVal == 0x10)
-					emu_logf(&_logger, PLRLOG_ERROR, "Error loading table-compressed data block! No table loaded!\n");
-				else if (retVal == 0x11)
-					emu_logf(&_logger, PLRLOG_ERROR, "Data block and loaded value table incompatible!\n");
-				else if (retVal == 0x80)
-					emu_logf(&_logger, PLRLOG_ERROR, "Unknown data block compression!\n");
+				// The bank was sized by ScanDataBlocks(), so this happens only when the scan stopped early.
+				// (Banks from the ROM cache are always complete.)
+				pcmBnk->data.resize(pcmBnk->dataLen);
+				pcmBnk->dataPtr = &pcmBnk->data[0];
+				pcmBnk->dataSize = pcmBnk->dataLen;
 			}
-			else
+			// Data that was decoded before (i.e. before Reset() or seeking back) is still valid.
+			if (pcmBnk->dataLen > pcmBnk->validLen)
 			{
-				memcpy(&pcmBnk->data[oldLen], dataPtr, dataLen);
+				if (dblkType & 0x40)
+				{
+					UINT8 retVal = DecompressDataBlk(dataLen, &pcmBnk->dataPtr[oldLen],
+						dblkLen - dbCI.hdrSize, &dataPtr[dbCI.hdrSize], &dbCI.cmprInfo);
+					if (retVal == 0x10)
+						emu_logf(&_logger, PLRLOG_ERROR, "Error loading table-compressed data block! No table loaded!\n");
+					else if (retVal == 0x11)
+						emu_logf(&_logger, PLRLOG_ERROR, "Data block and loaded value table incompatible!\n");
+					else if (retVal == 0x80)
+						emu_logf(&_logger, PLRLOG_ERROR, "Unknown data block compression!\n");
+				}
+				else
+				{
+					memcpy(&pcmBnk->dataPtr[oldLen], dataPtr, dataLen);
+				}
+				pcmBnk->validLen = pcmBnk->dataLen;
+				
+				if (_romCache != NULL && _dblkScanDone && pcmBnk->validLen == pcmBnk->dataSize)
+				{
+					// The bank is complete now - move it into the ROM cache, so that other players can use it.
+					// (If another player added it in the meantime, that copy is used and ours is freed.
+					// If the cache refuses it due to a key collision, we keep our own copy.)
+					pcmBnk->cacheItem = _romCache->Insert(pcmBnk->cacheKey, pcmBnk->cacheSrc, pcmBnk->data);
+					if (pcmBnk->cacheItem != NULL)
+					{
+						pcmBnk->dataPtr = const_cast<UINT8*>(&pcmBnk->cacheItem->data[0]);
+						std::vector<UINT8>().swap(pcmBnk->data);
+					}
+					std::vector<UINT8>().swap(pcmBnk->cacheSrc);
+				}
 			}
 			
-			// TODO: refresh DAC Stream pointers (call daccontrol_refresh_data)
+			RefreshDACStreamData(dblkType & 0x3F);
 		}
 		break;
 	case 0x80:	// ROM/RAM write
@@ -767,6 +800,13 @@ void VGMPlayer::Cmd_DataBlock(void)
 			}
 			WriteChipROM(cDev, _VGM_ROM_CHIPS[dblkType & 0x3F][1], memSize, dataOfs, dataLen, &swpData[0x00]);
 		}
+		else if (cDev->romRef != NULL && _VGM_ROM_CHIPS[dblkType & 0x3F][1] == 0 &&
+				memSize > 0 && dataOfs == 0x00 && dataLen >= memSize)
+		{
+			// The block contains the whole ROM, so the device can use it in-place.
+			// (The file data stays valid until the devices are stopped.)
+			cDev->romRef(cDev->base.defInf.dataPtr, memSize, dataPtr);
+		}
 		else
 		{
 			WriteChipROM(cDev, _VGM_ROM_CHIPS[dblkType & 0x3F][1], memSize, dataOfs, dataLen, dataPtr);
@@ -801,6 +841,62 @@ void VGMPlayer::Cmd_DataBlock(void)
 	return;
 }
 
+void VGMPlayer::AddLazyDataBlock(UINT8 dblkType, UINT32 dblkLen)
+{
+	PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
+	PCM_LAZY_BLK lzBlk;
+	PCM_CDB_INF dbCI;
+	UINT32 dataLen = dblkLen;
+	size_t curChunk;
+	
+	if (dblkType & 0x40)
+	{
+		ReadComprDataBlkHdr(dblkLen, &fData[0x00], &dbCI);
+		dataLen = dbCI.decmpLen;
+	}
+	pcmBnk->bankOfs.push_back(pcmBnk->dataLen);
+	pcmBnk->bankSize.push_back(dataLen);
+	pcmBnk->dataLen += dataLen;
+	if (pcmBnk->bankOfs.size() <= pcmBnk->lazyBlks.size())
+		return;	// The block is known already. (i.e. before Reset() or seeking back)
+	
+	// Only the location of the data is stored. The data is decompressed by GetPCMBankData() when needed.
+	lzBlk.bankOfs = pcmBnk->bankOfs.back();
+	lzBlk.dataLen = dataLen;
+	lzBlk.tblOfs = (UINT32)-1;
+	lzBlk.compressed = (dblkType & 0x40) ? 1 : 0;
+	if (! lzBlk.compressed)
+	{
+		lzBlk.fileOfs = _filePos;
+		lzBlk.fileLen = dblkLen;
+	}
+	else
+	{
+		lzBlk.fileOfs = _filePos + dbCI.hdrSize;
+		lzBlk.fileLen = dblkLen - dbCI.hdrSize;
+		lzBlk.tblOfs = _pcmComprTblOfs;
+		lzBlk.cmprInfo = dbCI.cmprInfo;
+		lzBlk.cmprInfo.comprTbl = NULL;
+		lzBlk.chunks.resize((dataLen + (1 << _LAZY_CHUNK_SHIFT) - 1) >> _LAZY_CHUNK_SHIFT);
+		for (curChunk = 0; curChunk < lzBlk.chunks.size(); curChunk ++)
+		{
+			lzBlk.chunks[curChunk].lastUse = 0;
+			lzBlk.chunks[curChunk].dpcmStart = 0;
+			lzBlk.chunks[curChunk].dpcmValid = 0;
+		}
+		if (! lzBlk.chunks.empty())
+		{
+			lzBlk.chunks[0].dpcmStart = lzBlk.cmprInfo.baseVal;
+			lzBlk.chunks[0].dpcmValid = 1;
+		}
+	}
+	pcmBnk->lazyBlks.push_back(lzBlk);
+	pcmBnk->lazyCurPtr = NULL;	// the vector may have been reallocated
+	pcmBnk->lazyCurLen = 0;
+	
+	return;
+}
+
 void VGMPlayer::Cmd_PcmRamWrite(void)
 {
 	UINT8 dbType = fData[0x02] & 0x7F;
@@ -816,22 +912,32 @@ void VGMPlayer::Cmd_PcmRamWrite(void)
 	UINT32 dbPos = ReadLE24(&fData[0x03]);
 	UINT32 wrtAddr = ReadLE24(&fData[0x06]);
 	UINT32 dataLen = ReadLE24(&fData[0x09]);
-	if (dbPos >= _pcmBank[dbType].data.size())
+	if (dbPos >= _pcmBank[dbType].dataLen)
 		return;
-	const UINT8* ROMData = &_pcmBank[dbType].data[dbPos];
 	if (! dataLen)
 		dataLen += 0x01000000;
-	if (_pcmBank[dbType].data.size() - dbPos < dataLen)
+	if (_pcmBank[dbType].dataLen - dbPos < dataLen)
 		return;	// just outright ignore writes that would go out-of-bounds
 	
 	if (chipType == 0x14)	// NES APU
 	{
 		//Last95Drum = dbPos / dataLen - 1;
-		//Last95Max = _pcmBank[dbType].data.size() / dataLen;
+		//Last95Max = _pcmBank[dbType].dataLen / dataLen;
 	}
 	
 	DoRAMOfsPatches(chipType, chipID, wrtAddr, dataLen);
-	cDev->romWrite(cDev->base.defInf.dataPtr, wrtAddr, dataLen, ROMData);
+	while(dataLen > 0)
+	{
+		// lazy banks return the data in pieces (one per block/chunk)
+		UINT32 pieceLen;
+		const UINT8* ROMData = GetPCMBankData(&_pcmBank[dbType], dbPos, &pieceLen);
+		if (ROMData == NULL)
+			break;
+		if (pieceLen > dataLen)
+			pieceLen = dataLen;
+		cDev->romWrite(cDev->base.defInf.dataPtr, wrtAddr, pieceLen, ROMData);
+		dbPos += pieceLen;	wrtAddr += pieceLen;	dataLen -= pieceLen;
+	}
 	
 	return;
 }
@@ -843,10 +949,10 @@ void VGMPlayer::Cmd_YM2612PCM_Delay(void)
 	
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
-	if (_ym2612pcm_bnkPos >= _pcmBank[0].data.size())
+	if (_ym2612pcm_bnkPos >= _pcmBank[0].dataLen)
 		return;
 	
-	UINT8 data = _pcmBank[0].data[_ym2612pcm_bnkPos];
+	UINT8 data = GetPCMBankByte(&_pcmBank[0], _ym2612pcm_bnkPos);
 	SendYMCommand(cDev, 0x00, 0x2A, data);
 	_ym2612pcm_bnkPos ++;
 	// TODO: clip when exceeding pcmBank size
@@ -860,6 +966,29 @@ void VGMPlayer::Cmd_YM2612PCM_Seek(void)
 	return;
 }
 
+UINT8 VGMPlayer::InitDACStream(DACSTRM_DEV* dacStrm, UINT8 streamID)
+{
+	DEV_GEN_CFG devCfg;
+	UINT8 retVal;
+	
+	devCfg.emuCore = 0x00;
+	devCfg.srMode = DEVRI_SRMODE_NATIVE;
+	devCfg.flags = 0x00;
+	devCfg.clock = 0;
+	devCfg.smplRate = _outSmplRate;
+	retVal = device_start_daccontrol(&devCfg, &dacStrm->defInf);
+	if (retVal)
+		return retVal;
+	dacStrm->defInf.devDef->Reset(dacStrm->defInf.dataPtr);
+	dacStrm->streamID = streamID;
+	dacStrm->bankID = 0xFF;
+	dacStrm->pbMode = 0x00;
+	dacStrm->freq = 0;
+	dacStrm->lastItem = (UINT32)-1;
+	dacStrm->maxItems = 0;
+	return 0x00;
+}
+
 void VGMPlayer::Cmd_DACCtrl_Setup(void)	// DAC Stream Control: Setup Chip
 {
 	size_t dsID = _dacStrmMap[fData[0x01]];
@@ -868,25 +997,12 @@ void VGMPlayer::Cmd_DACCtrl_Setup(void)	// DAC Stream Control: Setup Chip
 		if (fData[0x01] == 0xFF)
 			return;
 		
-		DEV_GEN_CFG devCfg;
 		DACSTRM_DEV dacStrm;
 		UINT8 retVal;
 		
-		devCfg.emuCore = 0x00;
-		devCfg.srMode = DEVRI_SRMODE_NATIVE;
-		devCfg.flags = 0x00;
-		devCfg.clock = 0;
-		devCfg.smplRate = _outSmplRate;
-		retVal = device_start_daccontrol(&devCfg, &dacStrm.defInf);
+		retVal = InitDACStream(&dacStrm, fData[0x01]);
 		if (retVal)
 			return;
-		dacStrm.defInf.devDef->Reset(dacStrm.defInf.dataPtr);
-		dacStrm.streamID = fData[0x01];
-		dacStrm.bankID = 0xFF;
-		dacStrm.pbMode = 0x00;
-		dacStrm.freq = 0;
-		dacStrm.lastItem = (UINT32)-1;
-		dacStrm.maxItems = 0;
 		
 		_dacStrmMap[dacStrm.streamID] = _dacStreams.size();
 		_dacStreams.push_back(dacStrm);
@@ -919,10 +1035,11 @@ void VGMPlayer::Cmd_DACCtrl_SetData(void)	// DAC Stream Control: Set Data Bank
 	PCM_BANK* pcmBnk = &_pcmBank[dacStrm->bankID];
 	
 	dacStrm->maxItems = (UINT32)pcmBnk->bankOfs.size();
-	if (pcmBnk->data.empty())
+	SetDACStreamReader(dacStrm);
+	if (! pcmBnk->dataLen)
 		daccontrol_set_data(dacStrm->defInf.dataPtr, NULL, 0, fData[0x03], fData[0x04]);
 	else
-		daccontrol_set_data(dacStrm->defInf.dataPtr, &pcmBnk->data[0], (UINT32)pcmBnk->data.size(), fData[0x03], fData[0x04]);
+		daccontrol_set_data(dacStrm->defInf.dataPtr, pcmBnk->dataPtr, pcmBnk->dataLen, fData[0x03], fData[0x04]);
 	return;
 }
 
@@ -1420,3 +1537,203 @@ void VGMPlayer::Cmd_BSMT2000_Reg(void)
 		WriteQSound_B(cDev, ofs, ReadBE16(&fData[0x02]));
 	return;
 }
+
+UINT8 VGMPlayer::DecodeCmdWrite(UINT32 filePos, CMD_OP* op) const
+{
+	// Decode simple device writes the same way their command functions do.
+	// Everything else is left to the command function (CMDOP_CALL).
+	// Returns the chip ID, device pointers are not set.
+	const UINT8* cmdData = &_fileData[filePos];
+	UINT8 curCmd = cmdData[0x00];
+	COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+	UINT8 chipID = 0;
+	
+	op->dataPtr = NULL;
+	op->write.a8d8 = NULL;
+	op->filePos = filePos;
+	op->type = CMDOP_CALL;
+	op->port = 0x00;
+	op->ofs = 0x0000;
+	op->data = 0x0000;
+	
+	if (func == &VGMPlayer::Cmd_DelaySamples2B)
+	{
+		op->type = CMDOP_DELAY;
+		op->data = ReadLE16(&cmdData[0x01]);
+		return 0;
+	}
+	else if (func == &VGMPlayer::Cmd_Delay60Hz)
+	{
+		op->type = CMDOP_DELAY;
+		op->data = 735;
+		return 0;
+	}
+	else if (func == &VGMPlayer::Cmd_Delay50Hz)
+	{
+		op->type = CMDOP_DELAY;
+		op->data = 882;
+		return 0;
+	}
+	else if (func == &VGMPlayer::Cmd_DelaySamplesN1)
+	{
+		op->type = CMDOP_DELAY;
+		op->data = 1 + (curCmd & 0x0F);
+		return 0;
+	}
+	else if (func == &VGMPlayer::Cmd_YM2612PCM_Delay)
+	{
+		op->type = CMDOP_YM2612PCM;
+		op->data = curCmd & 0x0F;
+		return 0;
+	}
+	else if (func == &VGMPlayer::Cmd_GGStereo || func == &VGMPlayer::Cmd_SN76489)
+	{
+		op->type = CMDOP_A8D8;
+		chipID = (curCmd == 0x30 || curCmd == 0x3F) ? 1 : 0;
+		op->ofs = (func == &VGMPlayer::Cmd_GGStereo) ? SN76496_W_GGST : SN76496_W_REG;
+		op->data = cmdData[0x01];
+	}
+	else if (func == &VGMPlayer::Cmd_Reg8_Data8 || func == &VGMPlayer::Cmd_CPort_Reg8_Data8)
+	{
+		op->type = CMDOP_YM;
+		chipID = (curCmd >= 0xA0) ? 1 : 0;
+		op->port = (func == &VGMPlayer::Cmd_CPort_Reg8_Data8) ? (curCmd & 0x01) : 0x00;
+		op->ofs = cmdData[0x01];
+		op->data = cmdData[0x02];
+	}
+	else if (func == &VGMPlayer::Cmd_Port_Reg8_Data8)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_YM;
+		op->port = cmdData[0x01] & 0x7F;
+		op->ofs = cmdData[0x02];
+		op->data = cmdData[0x03];
+	}
+	else if (func == &VGMPlayer::Cmd_DReg8_Data8)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_YM;
+		op->ofs = cmdData[0x01] & 0x7F;
+		op->data = cmdData[0x02];
+	}
+	else if (func == &VGMPlayer::Cmd_MSM5205_Reg)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A8D8;
+		op->ofs = (cmdData[0x01] >> 4) & 0x7;
+		op->data = cmdData[0x01] & 0xF;
+	}
+	else if (func == &VGMPlayer::Cmd_Ofs8_Data8)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A8D8;
+		op->ofs = cmdData[0x01] & 0x7F;
+		op->data = cmdData[0x02];
+	}
+	else if (func == &VGMPlayer::Cmd_Port_Ofs8_Data8)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A8D8;
+		op->ofs = cmdData[0x02];
+		op->data = cmdData[0x03];
+	}
+	else if (func == &VGMPlayer::Cmd_Ofs16_Data8)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A16D8;
+		op->ofs = ReadBE16(&cmdData[0x01]) & 0x7FFF;
+		op->data = cmdData[0x03];
+	}
+	else if (func == &VGMPlayer::Cmd_SegaPCM_Mem)
+	{
+		op->type = CMDOP_A16D8;
+		chipID = (cmdData[0x02] & 0x80) >> 7;
+		op->ofs = ReadLE16(&cmdData[0x01]) & 0x7FFF;
+		op->data = cmdData[0x03];
+	}
+	else if (func == &VGMPlayer::Cmd_Ofs8_Data16)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A8D16;
+		op->ofs = cmdData[0x01] & 0x7F;
+		op->data = ReadLE16(&cmdData[0x02]);
+	}
+	else if (func == &VGMPlayer::Cmd_Ofs4_Data12)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A8D16;
+		op->ofs = (cmdData[0x01] >> 4) & 0x07;
+		op->data = ReadBE16(&cmdData[0x01]) & 0x0FFF;
+	}
+	else if (func == &VGMPlayer::Cmd_Ofs16_Data16)
+	{
+		chipID = (cmdData[0x01] & 0x80) >> 7;
+		op->type = CMDOP_A16D16;
+		op->ofs = ReadBE16(&cmdData[0x01]) & 0x7FFF;
+		op->data = ReadBE16(&cmdData[0x03]);
+	}
+	else
+	{
+		return 0;
+	}
+	
+	return chipID;
+}
+
+void VGMPlayer::DecodeCmdOp(UINT32 filePos, CMD_OP* op)
+{
+	UINT8 chipType = _CMD_INFO[_fileData[filePos]].chipType;
+	UINT8 chipID;
+	CHIP_DEVICE* cDev;
+	UINT8 hasFunc;
+	
+	chipID = DecodeCmdWrite(filePos, op);
+	if (op->type == CMDOP_CALL || op->type == CMDOP_DELAY)
+		return;
+	
+	cDev = GetDevicePtr(chipType, chipID);
+	if (op->type == CMDOP_YM2612PCM)
+	{
+		if (cDev == NULL || cDev->write8 == NULL)
+		{
+			op->type = CMDOP_DELAY;	// there is nothing to write to
+			return;
+		}
+		op->dataPtr = cDev->base.defInf.dataPtr;
+		op->write.a8d8 = cDev->write8;
+		return;
+	}
+	if (cDev == NULL)
+	{
+		op->type = CMDOP_CALL;	// The device doesn't exist - let the command function ignore it.
+		return;
+	}
+	op->dataPtr = cDev->base.defInf.dataPtr;
+	switch(op->type)
+	{
+	case CMDOP_A8D8:
+	case CMDOP_YM:
+		op->write.a8d8 = cDev->write8;
+		hasFunc = (cDev->write8 != NULL);
+		break;
+	case CMDOP_A16D8:
+		op->write.a16d8 = cDev->writeM8;
+		hasFunc = (cDev->writeM8 != NULL);
+		break;
+	case CMDOP_A8D16:
+		op->write.a8d16 = cDev->writeD16;
+		hasFunc = (cDev->writeD16 != NULL);
+		break;
+	case CMDOP_A16D16:
+		op->write.a16d16 = cDev->writeM16;
+		hasFunc = (cDev->writeM16 != NULL);
+		break;
+	default:
+		hasFunc = 0;
+		break;
+	}
+	if (! hasFunc)
+		op->type = CMDOP_CALL;
+	
+	return;
+}
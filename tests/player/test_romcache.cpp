@@ -0,0 +1,148 @@
+/**
+ * ROM Cache Test
+ *
+ * Items of the RomCache are addressed by a hash of their source data.
+ * Hash collisions must never cause an item to be shared.
+ * This test verifies:
+ * - an item is found when key, source data and size match
+ * - a lookup with the same key, but different source data or size fails
+ * - inserting different contents with a used key is refused
+ *   and leaves the caller's data untouched
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "../../stdtype.h"
+#include "../../player/romcache.hpp"
+
+/* Test results structure */
+typedef struct {
+    int tests_run;
+    int tests_passed;
+    int tests_failed;
+} TestResults;
+
+static TestResults results = {0, 0, 0};
+
+/* Helper macros */
+#define TEST_ASSERT(cond, msg) do { \
+    results.tests_run++; \
+    if (!(cond)) { \
+        printf("FAIL: %s\n", msg); \
+        results.tests_failed++; \
+        return 0; \
+    } else { \
+        results.tests_passed++; \
+    } \
+} while(0)
+
+static std::vector<UINT8> MakeData(const char* text)
+{
+    return std::vector<UINT8>(text, text + strlen(text));
+}
+
+/**
+ * Test 1: Lookups compare the source data and data size, not just the key
+ */
+static int test_acquire_checks_item(void)
+{
+    RomCache cache;
+    std::vector<UINT8> src = MakeData("source A");
+    std::vector<UINT8> data = MakeData("data of A");
+    std::vector<UINT8> srcCopy = src;
+    const RomCache::ITEM* item;
+    const RomCache::ITEM* item2;
+    RomCache::HASH key = 0x1234;    /* fixed key, so that all items "collide" */
+
+    printf("Test: Acquire checks source data and size...\n");
+
+    item = cache.Insert(key, src, data);
+    TEST_ASSERT(item != NULL, "Insert into an empty cache failed");
+    TEST_ASSERT(src.empty() && data.empty(), "Insert didn't take over the data");
+    TEST_ASSERT(item->data.size() == 9, "item has a wrong size");
+
+    item2 = cache.Acquire(key, srcCopy, 9);
+    TEST_ASSERT(item2 == item, "matching item not found");
+    cache.Release(item2);
+    item2 = cache.Acquire(key, srcCopy, 0);
+    TEST_ASSERT(item2 == item, "matching item not found (any size)");
+    cache.Release(item2);
+
+    TEST_ASSERT(cache.Acquire(key, srcCopy, 8) == NULL, "item with a different size was returned");
+    TEST_ASSERT(cache.Acquire(key, MakeData("source B"), 0) == NULL, "item with different source data was returned");
+    TEST_ASSERT(cache.Acquire(key, MakeData("source"), 0) == NULL, "item with shorter source data was returned");
+
+    cache.Release(item);
+    printf("  PASS: only matching items are returned\n");
+    return 1;
+}
+
+/**
+ * Test 2: Inserting different contents with a used key is refused
+ */
+static int test_insert_collision(void)
+{
+    RomCache cache;
+    std::vector<UINT8> srcA = MakeData("source A");
+    std::vector<UINT8> dataA = MakeData("data of A");
+    std::vector<UINT8> srcA2 = MakeData("source A");
+    std::vector<UINT8> dataA2 = MakeData("data of A");
+    std::vector<UINT8> srcB = MakeData("source B");
+    std::vector<UINT8> dataB = MakeData("data of B, longer");
+    const RomCache::ITEM* itemA;
+    const RomCache::ITEM* item;
+    RomCache::HASH key = 0x1234;
+
+    printf("Test: Insert refuses colliding items...\n");
+
+    itemA = cache.Insert(key, srcA, dataA);
+    TEST_ASSERT(itemA != NULL, "Insert into an empty cache failed");
+
+    item = cache.Insert(key, srcB, dataB);
+    TEST_ASSERT(item == NULL, "colliding item was shared");
+    TEST_ASSERT(srcB.size() == 8 && dataB.size() == 17, "data of a refused item was modified");
+
+    item = cache.Insert(key, srcA2, dataA2);
+    TEST_ASSERT(item == itemA, "identical item wasn't shared");
+    TEST_ASSERT(srcA2.size() == 8 && dataA2.size() == 9, "data was modified although an existing item was used");
+    cache.Release(item);
+
+    TEST_ASSERT(cache.GetItemCount() == 1, "wrong number of cached items");
+    TEST_ASSERT(cache.GetMemoryUsage() == 8 + 9, "wrong memory usage");
+
+    cache.Release(itemA);
+    cache.Purge();
+    TEST_ASSERT(cache.GetItemCount() == 0, "unreferenced item wasn't purged");
+
+    printf("  PASS: colliding items are refused\n");
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    printf("===========================================\n");
+    printf("ROM Cache Test\n");
+    printf("===========================================\n\n");
+
+    test_acquire_checks_item();
+    test_insert_collision();
+
+    /* Print summary */
+    printf("\n===========================================\n");
+    printf("Test Summary\n");
+    printf("===========================================\n");
+    printf("Tests run:    %d\n", results.tests_run);
+    printf("Tests passed: %d\n", results.tests_passed);
+    printf("Tests failed: %d\n", results.tests_failed);
+    printf("===========================================\n");
+
+    if (results.tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    }
+
+    printf("\nAll tests PASSED!\n");
+    return 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * VGMPlayer ROM Reference Test
+ *
+ * Plays small in-memory VGMs whose data block contains the whole sample ROM.
+ * The player should pass such blocks to the device via DEVRW_ROMREF, so the
+ * device reads the samples straight from the file data instead of a copy.
+ * This test verifies (for C352 and QSound):
+ * - a keyed-on voice produces sound from the ROM
+ * - clearing the ROM inside the loaded file data silences the voice,
+ *   i.e. the device references the file data (waveIsRef/romIsRef set)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../../stdtype.h"
+#include "../../emu/SoundDevs.h"
+#include "../../utils/DataLoader.h"
+#include "../../utils/MemoryLoader.h"
+#include "../../player/playerbase.hpp"
+#include "../../player/vgmplayer.hpp"
+
+/* Test configuration */
+#define SAMPLE_RATE 44100
+#define ROM_SIZE 0x100
+#define ROM_VALUE 0x40
+#define RENDER_SMPLS 4410   /* 0.1 seconds */
+#define CHECK_SMPLS 441     /* only check the end, after filters/interpolation settled */
+
+/* Test results structure */
+typedef struct {
+    int tests_run;
+    int tests_passed;
+    int tests_failed;
+} TestResults;
+
+static TestResults results = {0, 0, 0};
+
+/* Helper macros */
+#define TEST_ASSERT(cond, msg) do { \
+    results.tests_run++; \
+    if (!(cond)) { \
+        printf("FAIL: %s\n", msg); \
+        results.tests_failed++; \
+        return 0; \
+    } else { \
+        results.tests_passed++; \
+    } \
+} while(0)
+
+/* VGM building helpers */
+static void WriteLE32(std::vector<UINT8>& vgm, size_t pos, UINT32 value)
+{
+    vgm[pos + 0] = (UINT8)(value >>  0);
+    vgm[pos + 1] = (UINT8)(value >>  8);
+    vgm[pos + 2] = (UINT8)(value >> 16);
+    vgm[pos + 3] = (UINT8)(value >> 24);
+}
+
+static void PutWait(std::vector<UINT8>& vgm, UINT16 smpls)
+{
+    vgm.push_back(0x61);
+    vgm.push_back((UINT8)(smpls >> 0));
+    vgm.push_back((UINT8)(smpls >> 8));
+}
+
+static void PutC352Write(std::vector<UINT8>& vgm, UINT16 reg, UINT16 data)
+{
+    vgm.push_back(0xE1);
+    vgm.push_back((UINT8)(reg >> 8));
+    vgm.push_back((UINT8)(reg >> 0));
+    vgm.push_back((UINT8)(data >> 8));
+    vgm.push_back((UINT8)(data >> 0));
+}
+
+static void PutQSoundWrite(std::vector<UINT8>& vgm, UINT8 reg, UINT16 data)
+{
+    vgm.push_back(0xC4);
+    vgm.push_back((UINT8)(data >> 8));
+    vgm.push_back((UINT8)(data >> 0));
+    vgm.push_back(reg);
+}
+
+/* Creates a VGM 1.71 header, followed by a data block with the full ROM.
+ * Returns the file offset of the ROM data. */
+static size_t StartVGM(std::vector<UINT8>& vgm, size_t clockOfs, UINT32 clock, UINT8 romType)
+{
+    size_t romOfs;
+
+    vgm.assign(0x100, 0x00);
+    memcpy(&vgm[0x00], "Vgm ", 4);
+    WriteLE32(vgm, 0x08, 0x171);
+    WriteLE32(vgm, 0x34, 0x100 - 0x34);
+    WriteLE32(vgm, clockOfs, clock);
+
+    vgm.push_back(0x67);
+    vgm.push_back(0x66);
+    vgm.push_back(romType);
+    vgm.resize(vgm.size() + 0x0C);
+    WriteLE32(vgm, vgm.size() - 0x0C, 0x08 + ROM_SIZE); /* block size */
+    WriteLE32(vgm, vgm.size() - 0x08, ROM_SIZE);        /* ROM size */
+    WriteLE32(vgm, vgm.size() - 0x04, 0x00);            /* start offset */
+    romOfs = vgm.size();
+    vgm.resize(vgm.size() + ROM_SIZE, ROM_VALUE);
+    return romOfs;
+}
+
+static void FinishVGM(std::vector<UINT8>& vgm, UINT32 totalSmpls)
+{
+    vgm.push_back(0x66);
+    WriteLE32(vgm, 0x04, (UINT32)vgm.size() - 0x04);
+    WriteLE32(vgm, 0x18, totalSmpls);
+}
+
+static UINT32 GetPeak(const WAVE_32BS* smpls, UINT32 count)
+{
+    UINT32 peak = 0;
+    UINT32 curSmpl;
+
+    for (curSmpl = 0; curSmpl < count; curSmpl++)
+    {
+        UINT32 l = (UINT32)abs(smpls[curSmpl].L);
+        UINT32 r = (UINT32)abs(smpls[curSmpl].R);
+        if (peak < l)
+            peak = l;
+        if (peak < r)
+            peak = r;
+    }
+    return peak;
+}
+
+/* Plays the VGM, then clears the ROM in the loaded file data and keeps playing.
+ * Returns the output peaks before and after clearing the ROM. */
+static int PlayAndClearROM(const std::vector<UINT8>& vgm, size_t romOfs,
+                           UINT32* peakBefore, UINT32* peakAfter)
+{
+    DATA_LOADER* dLoad;
+    VGMPlayer player;
+    std::vector<WAVE_32BS> smplBuf(RENDER_SMPLS);
+    UINT8* fileData;
+
+    dLoad = MemoryLoader_Init(&vgm[0], (UINT32)vgm.size());
+    if (dLoad == NULL)
+        return 0;
+    DataLoader_SetPreloadBytes(dLoad, 0x100);
+    if (DataLoader_Load(dLoad))
+    {
+        DataLoader_Deinit(dLoad);
+        return 0;
+    }
+    player.SetSampleRate(SAMPLE_RATE);
+    if (player.LoadFile(dLoad))
+    {
+        DataLoader_Deinit(dLoad);
+        return 0;
+    }
+    player.Start();
+
+    memset(&smplBuf[0], 0x00, RENDER_SMPLS * sizeof(WAVE_32BS));
+    player.Render(RENDER_SMPLS, &smplBuf[0]);
+    *peakBefore = GetPeak(&smplBuf[RENDER_SMPLS - CHECK_SMPLS], CHECK_SMPLS);
+
+    fileData = DataLoader_GetData(dLoad);
+    memset(&fileData[romOfs], 0x00, ROM_SIZE);
+
+    memset(&smplBuf[0], 0x00, RENDER_SMPLS * sizeof(WAVE_32BS));
+    player.Render(RENDER_SMPLS, &smplBuf[0]);
+    *peakAfter = GetPeak(&smplBuf[RENDER_SMPLS - CHECK_SMPLS], CHECK_SMPLS);
+
+    player.Stop();
+    player.UnloadFile();
+    DataLoader_Deinit(dLoad);
+    return 1;
+}
+
+/**
+ * Test 1: C352 with a full-ROM data block
+ * Voice 0 loops over the whole ROM as 8-bit linear PCM.
+ */
+static int test_c352_romref(void)
+{
+    std::vector<UINT8> vgm;
+    size_t romOfs;
+    UINT32 peakBefore;
+    UINT32 peakAfter;
+
+    printf("Test: C352 full-ROM block is referenced...\n");
+
+    romOfs = StartVGM(vgm, 0xDC, 24192000, 0x92);
+    vgm[0xD6] = 72;                     /* clock divider (288 / 4) */
+    PutC352Write(vgm, 0x00, 0xFFFF);    /* front volume */
+    PutC352Write(vgm, 0x01, 0xFFFF);    /* rear volume */
+    PutC352Write(vgm, 0x02, 0x8000);    /* frequency */
+    PutC352Write(vgm, 0x04, 0x0000);    /* bank */
+    PutC352Write(vgm, 0x05, 0x0000);    /* start */
+    PutC352Write(vgm, 0x06, ROM_SIZE - 1);  /* end */
+    PutC352Write(vgm, 0x07, 0x0000);    /* loop */
+    PutC352Write(vgm, 0x03, 0x4002);    /* flags: key on + loop */
+    PutC352Write(vgm, 0x202, 0x0000);   /* execute key on */
+    PutWait(vgm, 0xFFFF);
+    FinishVGM(vgm, 0xFFFF);
+
+    TEST_ASSERT(PlayAndClearROM(vgm, romOfs, &peakBefore, &peakAfter), "VGM failed to load");
+    printf("  Peak before: %u, after clearing the ROM: %u\n", peakBefore, peakAfter);
+    TEST_ASSERT(peakBefore > 0, "C352 voice produced no output");
+    TEST_ASSERT(peakAfter == 0, "C352 still plays the old ROM data (ROM was copied, not referenced)");
+
+    printf("  PASS: C352 reads the ROM from the file data\n");
+    return 1;
+}
+
+/**
+ * Test 2: QSound with a full-ROM data block
+ * Voice 0 loops over the ROM. The registers are written after the DSP's
+ * initialization, which would otherwise reset the voices.
+ */
+static int test_qsound_romref(void)
+{
+    std::vector<UINT8> vgm;
+    size_t romOfs;
+    UINT32 peakBefore;
+    UINT32 peakAfter;
+
+    printf("Test: QSound full-ROM block is referenced...\n");
+
+    romOfs = StartVGM(vgm, 0xB4, 60000000, 0x8F);
+    PutWait(vgm, 100);
+    PutQSoundWrite(vgm, 0x78, 0x8000);  /* bank of voice 0 (set via voice 15), bit 15 = sample ROM */
+    PutQSoundWrite(vgm, 0x01, 0x0000);  /* address */
+    PutQSoundWrite(vgm, 0x03, 0x0000);  /* phase */
+    PutQSoundWrite(vgm, 0x04, 0x0080);  /* loop length */
+    PutQSoundWrite(vgm, 0x05, 0x00FF);  /* end address */
+    PutQSoundWrite(vgm, 0x80, 0x0120);  /* pan: center */
+    PutQSoundWrite(vgm, 0x06, 0x2000);  /* volume */
+    PutQSoundWrite(vgm, 0x02, 0x1000);  /* rate */
+    PutWait(vgm, 0xFFFF);
+    FinishVGM(vgm, 0xFFFF + 100);
+
+    TEST_ASSERT(PlayAndClearROM(vgm, romOfs, &peakBefore, &peakAfter), "VGM failed to load");
+    printf("  Peak before: %u, after clearing the ROM: %u\n", peakBefore, peakAfter);
+    TEST_ASSERT(peakBefore > 0, "QSound voice produced no output");
+    TEST_ASSERT(peakAfter == 0, "QSound still plays the old ROM data (ROM was copied, not referenced)");
+
+    printf("  PASS: QSound reads the ROM from the file data\n");
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    printf("===========================================\n");
+    printf("VGMPlayer ROM Reference Test\n");
+    printf("===========================================\n\n");
+
+    test_c352_romref();
+    test_qsound_romref();
+
+    /* Print summary */
+    printf("\n===========================================\n");
+    printf("Test Summary\n");
+    printf("===========================================\n");
+    printf("Tests run:    %d\n", results.tests_run);
+    printf("Tests passed: %d\n", results.tests_passed);
+    printf("Tests failed: %d\n", results.tests_failed);
+    printf("===========================================\n");
+
+    if (results.tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    }
+
+    printf("\nAll tests PASSED!\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * YMF271 FM Throughput Benchmark
+ *
+ * Measures how fast the YMF271 core renders FM groups.
+ *
+ * All 12 groups are keyed on with sustained FM voices. Each pass uses a fixed
+ * sync mode (4-op, 2x 2-op, 3-op + PCM) and cycles the algorithms across the
+ * groups, so every operator kernel is exercised. Groups 0, 4 and 8 additionally
+ * run in PFM mode on the second pass of each sync mode.
+ *
+ * Usage: ymf271_throughput_bench [seconds of audio per pass]
+ *
+ * The output checksum only depends on the emulation, so it can be used to
+ * compare builds of the core against each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../stdtype.h"
+#include "../../emu/EmuStructs.h"
+#include "../../emu/SoundEmu.h"
+#include "../../emu/SoundDevs.h"
+#include "../../emu/EmuCores.h"
+
+#define SMPL_RATE       44100
+#define CHUNK_SMPLS     1024
+#define PCM_MEM_SIZE    0x10000
+
+/* group number -> register address nibble (inverse of the core's fm_tab) */
+static const UINT8 group_addr[12] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14 };
+
+static void write_slot_reg(DEVFUNC_WRITE_A8D8 writeFunc, void* chip, int bank, int group, int reg, UINT8 data)
+{
+    writeFunc(chip, bank * 2 + 0, (reg << 4) | group_addr[group]);
+    writeFunc(chip, bank * 2 + 1, data);
+}
+
+/**
+ * Key on all groups in the given sync mode.
+ *
+ * Slots get a slow envelope, so the voices stay audible for the whole pass.
+ */
+static void setup_groups(DEVFUNC_WRITE_A8D8 writeFunc, void* chip, UINT8 sync, UINT8 pfm)
+{
+    int group;
+    int bank;
+
+    for (group = 0; group < 12; group++)
+    {
+        /* group sync mode + PFM flag (timer register block) */
+        writeFunc(chip, 0xC, group);
+        writeFunc(chip, 0xD, (pfm << 7) | sync);
+
+        for (bank = 0; bank < 4; bank++)
+        {
+            write_slot_reg(writeFunc, chip, bank, group, 0x0, 0x00);                 /* key off */
+            write_slot_reg(writeFunc, chip, bank, group, 0x2, 0x1A | (bank << 6));   /* LFO: PMS 3, AMS */
+            write_slot_reg(writeFunc, chip, bank, group, 0x3, 0x01 + bank);          /* multiple */
+            write_slot_reg(writeFunc, chip, bank, group, 0x4, 0x10 + bank * 4);      /* TL */
+            write_slot_reg(writeFunc, chip, bank, group, 0x5, 0x1F);                 /* AR */
+            write_slot_reg(writeFunc, chip, bank, group, 0x6, 0x02);                 /* D1R */
+            write_slot_reg(writeFunc, chip, bank, group, 0x7, 0x01);                 /* D2R */
+            write_slot_reg(writeFunc, chip, bank, group, 0x8, 0x24);                 /* D1L, RR */
+            write_slot_reg(writeFunc, chip, bank, group, 0xA, 0x40 | (group & 3));   /* block, F-number high */
+            write_slot_reg(writeFunc, chip, bank, group, 0x9, 0x20 + group * 13);    /* F-number low */
+            write_slot_reg(writeFunc, chip, bank, group, 0xB, (bank == 0) ? 0x50 : (bank & 3)); /* feedback, waveform */
+            write_slot_reg(writeFunc, chip, bank, group, 0xC, (group + sync * 5) & 0xF); /* algorithm */
+            write_slot_reg(writeFunc, chip, bank, group, 0xD, 0x00);                 /* ch0/ch1 level */
+            write_slot_reg(writeFunc, chip, bank, group, 0xE, 0x44);                 /* ch2/ch3 level */
+        }
+
+        /* key on - slot 1, plus slot 2 for the second 2-op pair and slot 4 for the PCM slot */
+        write_slot_reg(writeFunc, chip, 0, group, 0x0, 0x01);
+        if (sync == 1)
+            write_slot_reg(writeFunc, chip, 1, group, 0x0, 0x01);
+        else if (sync == 2)
+            write_slot_reg(writeFunc, chip, 3, group, 0x0, 0x01);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    static const char* syncNames[3] = { "4-op FM", "2x 2-op FM", "3-op FM + PCM" };
+    DEV_GEN_CFG devCfg;
+    DEV_INFO devInf;
+    DEVFUNC_WRITE_A8D8 writeFunc;
+    DEVFUNC_WRITE_MEMSIZE allocFunc;
+    DEVFUNC_WRITE_BLOCK writeMemFunc;
+    UINT8* pcmMem;
+    DEV_SMPL* smplData[2];
+    UINT32 seconds;
+    UINT32 smplCount;
+    UINT32 curSmpl;
+    UINT32 checksum;
+    UINT32 i;
+    UINT8 sync;
+    UINT8 pfm;
+    clock_t startTime;
+    double totalTime;
+    double passTime;
+
+    seconds = (argc > 1) ? (UINT32)strtoul(argv[1], NULL, 0) : 10;
+    if (! seconds)
+        seconds = 1;
+    smplCount = seconds * SMPL_RATE;
+
+    memset(&devCfg, 0, sizeof(devCfg));
+    devCfg.emuCore = 0;
+    devCfg.srMode = DEVRI_SRMODE_NATIVE;
+    devCfg.flags = 0x00;
+    devCfg.clock = 16934400;  /* Standard YMF271 clock */
+    devCfg.smplRate = SMPL_RATE;
+
+    if (SndEmu_Start(DEVID_YMF271, &devCfg, &devInf))
+    {
+        printf("Could not start YMF271 device\n");
+        return 1;
+    }
+    SndEmu_GetDeviceFunc(devInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&writeFunc);
+    SndEmu_GetDeviceFunc(devInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&allocFunc);
+    SndEmu_GetDeviceFunc(devInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&writeMemFunc);
+    devInf.devDef->Reset(devInf.dataPtr);
+
+    /* PCM memory for PFM carriers and the PCM slots: a simple 8-bit triangle wave */
+    pcmMem = (UINT8*)malloc(PCM_MEM_SIZE);
+    for (i = 0; i < PCM_MEM_SIZE; i++)
+        pcmMem[i] = (UINT8)((i & 0x80) ? (i & 0x7F) * 2 : 0xFF - (i & 0x7F) * 2);
+    allocFunc(devInf.dataPtr, PCM_MEM_SIZE);
+    writeMemFunc(devInf.dataPtr, 0, PCM_MEM_SIZE, pcmMem);
+
+    smplData[0] = (DEV_SMPL*)malloc(CHUNK_SMPLS * sizeof(DEV_SMPL));
+    smplData[1] = (DEV_SMPL*)malloc(CHUNK_SMPLS * sizeof(DEV_SMPL));
+
+    printf("YMF271 FM throughput, %u s of audio per pass\n", seconds);
+    checksum = 0;
+    totalTime = 0.0;
+    for (sync = 0; sync < 3; sync++)
+    {
+        for (pfm = 0; pfm < 2; pfm++)
+        {
+            devInf.devDef->Reset(devInf.dataPtr);
+            setup_groups(writeFunc, devInf.dataPtr, sync, pfm);
+
+            startTime = clock();
+            for (curSmpl = 0; curSmpl < smplCount; curSmpl += CHUNK_SMPLS)
+            {
+                UINT32 len = smplCount - curSmpl;
+                if (len > CHUNK_SMPLS)
+                    len = CHUNK_SMPLS;
+                devInf.devDef->Update(devInf.dataPtr, len, smplData);
+                for (i = 0; i < len; i++)
+                    checksum = checksum * 31 + (UINT32)smplData[0][i] * 7 + (UINT32)smplData[1][i];
+            }
+            passTime = (double)(clock() - startTime) / CLOCKS_PER_SEC;
+            totalTime += passTime;
+
+            printf("  %-14s PFM %s: %7.1f ms  (%6.1fx realtime)\n", syncNames[sync], pfm ? "on " : "off",
+                   passTime * 1000.0, (passTime > 0.0) ? seconds / passTime : 0.0);
+        }
+    }
+    printf("Total: %.1f ms, checksum %08X\n", totalTime * 1000.0, checksum);
+
+    free(smplData[0]);
+    free(smplData[1]);
+    free(pcmMem);
+    SndEmu_Stop(&devInf);
+
+    return 0;
+}
@@ -11,8 +11,12 @@ UINT8 DataLoader_Reset(DATA_LOADER *loader)
 	DataLoader_CancelLoading(loader);
 
 	if(loader->_data) {
-		free(loader->_data);
+		if (loader->_dataMapped)
+			loader->_callbacks->dunmap(loader->_context);
+		else
+			free(loader->_data);
 		loader->_data = NULL;
+		loader->_dataMapped = 0;
 		loader->_bytesLoaded = 0;
 	}
 
@@ -61,6 +65,12 @@ UINT8 DataLoader_Load(DATA_LOADER *loader)
 	loader->_bytesLoaded = 0x00;
 	loader->_status = DLSTAT_LOADING;
 	loader->_bytesTotal = loader->_callbacks->dlength(loader->_context);
+	if (loader->_callbacks->dmap != NULL)
+	{
+		// zero-copy mode: "reading" just makes more of the mapped data visible
+		loader->_data = loader->_callbacks->dmap(loader->_context);
+		loader->_dataMapped = (loader->_data != NULL);
+	}
 
 	if (loader->_readStopOfs > 0)
 		DataLoader_Read(loader,loader->_readStopOfs);
@@ -102,13 +112,20 @@ UINT32 DataLoader_Read(DATA_LOADER *loader, UINT32 numBytes)
 	if (endOfs > loader->_bytesTotal)
 		endOfs = loader->_bytesTotal;
 
-	loader->_data = (UINT8 *)realloc(loader->_data,endOfs);
-	if(loader->_data == NULL) {
-		return 0;
+	numBytes = endOfs - loader->_bytesLoaded;
+	if (loader->_dataMapped)
+	{
+		readBytes = numBytes;
 	}
+	else
+	{
+		loader->_data = (UINT8 *)realloc(loader->_data,endOfs);
+		if(loader->_data == NULL) {
+			return 0;
+		}
 
-	numBytes = endOfs - loader->_bytesLoaded;
-	readBytes = loader->_callbacks->dread(loader->_context,&loader->_data[loader->_bytesLoaded],numBytes);
+		readBytes = loader->_callbacks->dread(loader->_context,&loader->_data[loader->_bytesLoaded],numBytes);
+	}
 	if(!readBytes) return 0;
 	loader->_bytesLoaded += readBytes;
 
@@ -139,6 +156,7 @@ void DataLoader_Deinit(DATA_LOADER *dLoader)
 
 void DataLoader_Setup(DATA_LOADER *loader, const DATA_LOADER_CALLBACKS *callbacks, void *context) {
 	loader->_data = NULL;
+	loader->_dataMapped = 0;
 	loader->_status = DLSTAT_EMPTY;
 	loader->_readStopOfs = (UINT32)-1;
 	loader->_context = context;
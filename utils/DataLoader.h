@@ -13,6 +13,7 @@ typedef UINT32 (*DLOADCB_READ)(void *context, UINT8 *buffer, UINT32 numBytes);
 typedef UINT8 (*DLOADCB_SEEK)(void *context, UINT32 offset, UINT8 whence);
 typedef INT32 (*DLOADCB_TELL)(void *context);
 typedef UINT32 (*DLOADCB_LENGTH)(void *context);
+typedef UINT8 *(*DLOADCB_MAP)(void *context);
 
 typedef struct _data_loader_callbacks
 {
@@ -26,6 +27,9 @@ typedef struct _data_loader_callbacks
 	DLOADCB_LENGTH dlength; /* returns the length of the data, in bytes */
 	DLOADCB_GENERIC deof;   /* determines if we've seen eof or not (return 1 for eof) */
 	DLOADCB_GEN_CALL ddeinit;   /* deinitialize loader and free context, may be NULL */
+	DLOADCB_MAP dmap;       /* returns a pointer to all dlength bytes of the data without copying them,
+	                           called after dopen, may be NULL or return NULL (data is then read using dread) */
+	DLOADCB_GEN_CALL dunmap;    /* releases the memory returned by dmap, may be NULL if dmap is NULL */
 } DATA_LOADER_CALLBACKS;
 
 enum
@@ -38,6 +42,7 @@ enum
 typedef struct _data_loader
 {
 	UINT8 _status;
+	UINT8 _dataMapped;      /* _data was returned by dmap and isn't owned by the DataLoader */
 	UINT32 _bytesTotal;
 	UINT32 _bytesLoaded;
 	UINT32 _readStopOfs;
@@ -56,7 +61,8 @@ UINT8 DataLoader_Reset(DATA_LOADER *loader);
 
 /* Returns a pointer to the DataLoader's memory buffer
  * call after any invocation of "Read", "ReadUntil", etc,
- * since the memory buffer pointer can change */
+ * since the memory buffer pointer can change
+ * Note: For mapped data, the buffer may be shared with the file and must not be modified. */
 UINT8 *DataLoader_GetData(DATA_LOADER *loader);
 
 /* returns _bytesTotal */
@@ -10,6 +10,16 @@
 #include <wchar.h>
 #endif
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>	// for _get_osfhandle()
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
 #ifdef _MSC_VER
 #define strdup	_strdup
 #define wcsdup	_wcsdup
@@ -39,8 +49,11 @@ typedef union _loader_handles
 struct _file_loader
 {
 	UINT8 modeCompr;
+	UINT8 useMapping;	// map uncompressed files into memory instead of reading them
 	UINT32 bytesTotal;
 	LOADER_HANDLES hLoad;
+	UINT8 *mapData;	// NULL = not mapped
+	UINT32 mapSize;
 	char *fileName;
 #if HAVE_FILELOADER_W
 	wchar_t* fileNameW;	// Note: used when fileName == NULL
@@ -61,6 +74,8 @@ static UINT8 FileLoader_dclose(void *context);
 static INT32 FileLoader_dtell(void *context);
 static UINT32 FileLoader_dlength(void *context);
 static UINT8 FileLoader_deof(void *context);
+static UINT8 *FileLoader_dmap(void *context);
+static void FileLoader_dunmap(void *context);
 
 static UINT32 FileLoader_ReadRaw(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBytes);
 static UINT8 FileLoader_SeekRaw(FILE_LOADER *loader, UINT32 offset, UINT8 whence);
@@ -76,6 +91,8 @@ static UINT8 FileLoader_EofGZ(FILE_LOADER *loader);
 
 //DATA_LOADER *FileLoader_Init(const char *fileName);
 //DATA_LOADER *FileLoader_InitW(const wchar_t *fileName);
+//DATA_LOADER *FileLoader_InitMapped(const char *fileName);
+//DATA_LOADER *FileLoader_InitMappedW(const wchar_t *fileName);
 static void FileLoader_dfree(void *context);
 
 
@@ -181,6 +198,60 @@ static UINT8 FileLoader_deof(void *context)
 	return loader->Eof(loader);
 }
 
+static UINT8 *FileLoader_dmap(void *context)
+{
+	FILE_LOADER *loader = (FILE_LOADER *)context;
+	FILE *hFile = loader->hLoad.hFileRaw;
+
+	FileLoader_dunmap(context);
+	// compressed files are decompressed via the usual read path
+	if (! loader->useMapping || loader->modeCompr != FLMODE_CMP_RAW || loader->bytesTotal == 0)
+		return NULL;
+
+	// The mapping is copy-on-write, so the data can't be changed via the file by accident.
+	// It stays valid after closing the file handle.
+#ifdef _WIN32
+	{
+		HANDLE hMap = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(hFile)), NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (hMap == NULL)
+			return NULL;
+		loader->mapData = (UINT8 *)MapViewOfFile(hMap, FILE_MAP_COPY, 0, 0, loader->bytesTotal);
+		CloseHandle(hMap);
+	}
+#else
+	{
+		struct stat fileStat;
+		void *mapPtr;
+
+		if (fstat(fileno(hFile), &fileStat) || (UINT64)fileStat.st_size < loader->bytesTotal)
+			return NULL;
+		mapPtr = mmap(NULL, loader->bytesTotal, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(hFile), 0);
+		if (mapPtr == MAP_FAILED)
+			return NULL;
+		loader->mapData = (UINT8 *)mapPtr;
+	}
+#endif
+	if (loader->mapData != NULL)
+		loader->mapSize = loader->bytesTotal;
+	return loader->mapData;
+}
+
+static void FileLoader_dunmap(void *context)
+{
+	FILE_LOADER *loader = (FILE_LOADER *)context;
+	if (loader->mapData == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(loader->mapData);
+#else
+	munmap(loader->mapData, loader->mapSize);
+#endif
+	loader->mapData = NULL;
+	loader->mapSize = 0;
+	return;
+}
+
 
 static UINT32 FileLoader_ReadRaw(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBytes)
 {
@@ -239,7 +310,7 @@ static UINT8 FileLoader_EofGZ(FILE_LOADER *loader)
 }
 
 
-DATA_LOADER *FileLoader_Init(const char *fileName)
+static DATA_LOADER *FileLoader_InitCommon(const char *fileName, UINT8 useMapping)
 {
 	DATA_LOADER *dLoader;
 	FILE_LOADER *fLoader;
@@ -255,14 +326,25 @@ DATA_LOADER *FileLoader_Init(const char *fileName)
 	}
 
 	fLoader->fileName = strdup(fileName);
+	fLoader->useMapping = useMapping;
 
-	DataLoader_Setup(dLoader,&fileLoader,fLoader);
+	DataLoader_Setup(dLoader,useMapping ? &fileMapLoader : &fileLoader,fLoader);
 
 	return dLoader;
 }
 
+DATA_LOADER *FileLoader_Init(const char *fileName)
+{
+	return FileLoader_InitCommon(fileName, 0);
+}
+
+DATA_LOADER *FileLoader_InitMapped(const char *fileName)
+{
+	return FileLoader_InitCommon(fileName, 1);
+}
+
 #if HAVE_FILELOADER_W
-DATA_LOADER *FileLoader_InitW(const wchar_t *fileName)
+static DATA_LOADER *FileLoader_InitCommonW(const wchar_t *fileName, UINT8 useMapping)
 {
 	DATA_LOADER *dLoader;
 	FILE_LOADER *fLoader;
@@ -279,16 +361,28 @@ DATA_LOADER *FileLoader_InitW(const wchar_t *fileName)
 
 	fLoader->fileName = NULL;	// explicitly mark as "unused"
 	fLoader->fileNameW = wcsdup(fileName);
+	fLoader->useMapping = useMapping;
 
-	DataLoader_Setup(dLoader,&fileLoader,fLoader);
+	DataLoader_Setup(dLoader,useMapping ? &fileMapLoader : &fileLoader,fLoader);
 
 	return dLoader;
 }
+
+DATA_LOADER *FileLoader_InitW(const wchar_t *fileName)
+{
+	return FileLoader_InitCommonW(fileName, 0);
+}
+
+DATA_LOADER *FileLoader_InitMappedW(const wchar_t *fileName)
+{
+	return FileLoader_InitCommonW(fileName, 1);
+}
 #endif
 
 static void FileLoader_dfree(void *context)
 {
 	FILE_LOADER *loader = (FILE_LOADER *)context;
+	FileLoader_dunmap(context);
 #if HAVE_FILELOADER_W
 	if (loader->fileName == NULL)
 		free(loader->fileNameW);
@@ -308,4 +402,21 @@ const DATA_LOADER_CALLBACKS fileLoader = {
 	FileLoader_dlength,
 	FileLoader_deof,
 	FileLoader_dfree,
+	NULL,
+	NULL,
+};
+
+const DATA_LOADER_CALLBACKS fileMapLoader = {
+	0x464D4150,		// "FMAP"
+	"Mapped File Loader",
+	FileLoader_dopen,
+	FileLoader_dread,
+	FileLoader_dseek,
+	FileLoader_dclose,
+	FileLoader_dtell,
+	FileLoader_dlength,
+	FileLoader_deof,
+	FileLoader_dfree,
+	FileLoader_dmap,
+	FileLoader_dunmap,
 };
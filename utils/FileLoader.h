@@ -12,9 +12,13 @@ extern "C" {
 #include "DataLoader.h"
 
 DATA_LOADER *FileLoader_Init(const char *fileName);
+/* Maps uncompressed files into memory, so that DataLoader_GetData() returns the file contents
+ * without copying them. Compressed (.gz) files and files that can't be mapped are read normally. */
+DATA_LOADER *FileLoader_InitMapped(const char *fileName);
 #ifdef HAVE_FILELOADER_W
 #include <wchar.h>
 DATA_LOADER *FileLoader_InitW(const wchar_t *fileName);
+DATA_LOADER *FileLoader_InitMappedW(const wchar_t *fileName);
 #endif
 
 #define FileLoader_Load				DataLoader_Load
@@ -31,6 +35,7 @@ DATA_LOADER *FileLoader_InitW(const wchar_t *fileName);
 #define FileLoader_Deinit			DataLoader_Deinit
 
 extern const DATA_LOADER_CALLBACKS fileLoader;
+extern const DATA_LOADER_CALLBACKS fileMapLoader;
 
 #ifdef __cplusplus
 }
@@ -182,4 +182,6 @@ const DATA_LOADER_CALLBACKS memoryLoader = {
 	MemoryLoader_dlength,
 	MemoryLoader_deof,
 	NULL,
+	NULL,
+	NULL,
 };
@@ -0,0 +1,104 @@
+#ifndef __OSONCE_H__
+#define __OSONCE_H__
+
+// One-time Initialization
+// -----------------------
+// Used for global data that is generated at runtime and then shared read-only,
+// like the lookup tables of sound cores.
+// This is header-only (it uses compiler atomics), so it works without linking vgm-utils.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../common_def.h"	// stdtype.h, INLINE
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__GNUC__) && ! defined(_WIN32)
+#include <sched.h>	// for sched_yield()
+#define OSONCE_YIELD()	sched_yield()
+#endif
+// Other compilers fall back to plain variable accesses, which are not thread-safe.
+#ifndef OSONCE_YIELD
+#define OSONCE_YIELD()
+#endif
+
+typedef volatile long OS_ONCE;
+typedef void (*OS_ONCE_FUNC)(void);
+
+#define OS_ONCE_INIT	0	// static initializer for OS_ONCE
+
+// states of an OS_ONCE object
+#define OSONCE_NONE		0
+#define OSONCE_BUSY		1
+#define OSONCE_DONE		2
+
+INLINE long OSOnce_Get(OS_ONCE* once)
+{
+#if defined(_MSC_VER)
+	return _InterlockedCompareExchange(once, OSONCE_NONE, OSONCE_NONE);
+#elif defined(__ATOMIC_ACQUIRE)
+	return __atomic_load_n(once, __ATOMIC_ACQUIRE);
+#elif defined(__GNUC__)
+	return __sync_fetch_and_add(once, 0);
+#else
+	return *once;
+#endif
+}
+
+INLINE long OSOnce_Claim(OS_ONCE* once)
+{
+#if defined(_MSC_VER)
+	return _InterlockedCompareExchange(once, OSONCE_BUSY, OSONCE_NONE);
+#elif defined(__GNUC__)
+	return __sync_val_compare_and_swap(once, OSONCE_NONE, OSONCE_BUSY);
+#else
+	long old = *once;
+	if (old == OSONCE_NONE)
+		*once = OSONCE_BUSY;
+	return old;
+#endif
+}
+
+INLINE void OSOnce_Finish(OS_ONCE* once)
+{
+#if defined(_MSC_VER)
+	_InterlockedExchange(once, OSONCE_DONE);
+#elif defined(__ATOMIC_RELEASE)
+	__atomic_store_n(once, OSONCE_DONE, __ATOMIC_RELEASE);
+#elif defined(__GNUC__)
+	__sync_synchronize();
+	*once = OSONCE_DONE;
+#else
+	*once = OSONCE_DONE;
+#endif
+}
+
+// Calls func() exactly once for the given OS_ONCE object.
+// Other threads calling this in the meantime wait until func() has returned.
+INLINE void OSOnce_Run(OS_ONCE* once, OS_ONCE_FUNC func)
+{
+	if (OSOnce_Get(once) == OSONCE_DONE)
+		return;
+
+	if (OSOnce_Claim(once) == OSONCE_NONE)
+	{
+		func();
+		OSOnce_Finish(once);
+		return;
+	}
+	// Another thread is generating the data. This takes only a few milliseconds,
+	// so just wait for it to finish.
+	while (OSOnce_Get(once) != OSONCE_DONE)
+		OSONCE_YIELD();
+
+	return;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __OSONCE_H__
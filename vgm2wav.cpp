@@ -11,9 +11,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <set>
 #ifdef _WIN32
 #include <io.h>
 #include <fcntl.h>
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>	// for sysconf()
+#include <dirent.h>
+#include <strings.h>	// for strcasecmp()
 #endif
 
 #include "player/playerbase.hpp"
@@ -22,14 +34,18 @@
 #include "player/droplayer.hpp"
 #include "player/gymplayer.hpp"
 #include "player/playera.hpp"
+#include "player/romcache.hpp"
 #include "utils/DataLoader.h"
 #include "utils/FileLoader.h"
+#include "utils/OSThread.h"
+#include "utils/OSMutex.h"
 #include "emu/SoundDevs.h"
 #include "emu/EmuCores.h"
 #include "emu/SoundEmu.h"
 
 #ifdef _MSC_VER
 #define strncasecmp	_strnicmp
+#define strcasecmp	_stricmp
 #define snprintf	_snprintf
 #endif
 
@@ -48,9 +64,34 @@ sample_rate = 44100;
 static unsigned int
 bit_depth = 16;
 
+/* write IEEE float samples instead of integer PCM */
+static unsigned int
+float_output = 0;
+
 static unsigned int
 loops = 2;
 
+/* batch mode: render a list/directory of files using multiple threads */
+static unsigned int
+batch_mode = 0;
+
+/* number of worker threads in batch mode, 0 = number of CPUs */
+static unsigned int
+batch_jobs = 0;
+
+static PlayerA *
+create_player(void);
+
+static int
+render_file(PlayerA *player, const char *inFile, const char *outFile, UINT8 *packed,
+            int verbose, unsigned int *renderedFrames);
+
+static int
+render_single(const char *inFile, const char *outFile);
+
+static int
+render_batch(const char *src, const char *outDir);
+
 /* vgm-specific functions */
 static void
 FCC2STR(char *str, UINT32 fcc);
@@ -93,25 +134,9 @@ static const char *
 extensible_guid_trailer= "\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71";
 
 int main(int argc, const char *argv[]) {
-    PlayerA player;
-    PlayerBase* plrEngine;
-
-    unsigned int totalFrames;
-    unsigned int fadeFrames;
-    unsigned int curFrames;
-    const char *const *tags;
     const char *self;
     const char *c;
     const char *s;
-    FILE *f;
-    DATA_LOADER *loader;
-    UINT8 *packed;
-    double complete;
-    double inc;
-
-    fadeFrames = 0;
-    complete = 0.0;
-    inc = 0.0;
 
     self = *argv++;
     argc--;
@@ -161,6 +186,11 @@ int main(int argc, const char *argv[]) {
             argv++;
             argc--;
         }
+        else if(str_equals(*argv,"--float")) {
+            float_output = 1;
+            argv++;
+            argc--;
+        }
         else if(str_istarts(*argv,"--fade")) {
             c = strchr(*argv,'=');
             if(c != NULL) {
@@ -174,6 +204,24 @@ int main(int argc, const char *argv[]) {
             argv++;
             argc--;
         }
+        else if(str_equals(*argv,"--batch")) {
+            batch_mode = 1;
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--jobs")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            batch_jobs = scan_uint(s);
+            argv++;
+            argc--;
+        }
         else {
             break;
         }
@@ -194,103 +242,133 @@ int main(int argc, const char *argv[]) {
         default: bit_depth = 16;
     }
 
+    if(float_output) {
+        bit_depth = 32;
+    }
+
     if(argc < 2) {
         fprintf(stderr,"Usage: %s [options] /path/to/vgm-file /path/to/out.wav\n",self);
+        fprintf(stderr,"       %s [options] --batch /path/to/list-or-dir /path/to/out-dir\n",self);
         fprintf(stderr,"Available options:\n");
         fprintf(stderr,"    --samplerate n - sample rate (default: %d)\n", 44100);
         fprintf(stderr,"    --bps n        - bits per sample (default: %d)\n", 16);
+        fprintf(stderr,"    --float        - write 32-bit float samples\n");
         fprintf(stderr,"    --fade x       - fade out length in seconds (default: %.1f)\n", 8.0);
         fprintf(stderr,"    --loops n      - numbers of loops before fade out (default: %d)\n", 2);
+        fprintf(stderr,"    --batch        - render all files from a list file (one path per line)\n");
+        fprintf(stderr,"                     or a directory into the output directory\n");
+        fprintf(stderr,"    --jobs n       - number of files to render in parallel in batch mode\n");
+        fprintf(stderr,"                     (default: number of CPUs)\n");
         fprintf(stderr,"Specify \"-\" as output file to write to stdout.\n");
         return 1;
     }
 
-    /* if we were writing a library that uses libvgm, we'd want
-     * to have way better clean-up of resources when we see an error
-     * (free all our allocated memory, close files, etc).
-     * Since this is just a CLI app, we can just quit and let
-     * the OS handle everything. */
-
-    /* we'll want to make sure to pack our audio samples
-     * into little-endian, interleaved format.
-     * If we only supported 16-bit samples this could be
-     * malloc(sizeof(INT16) * 2 * BUFFER_LEN) - but in
-     * this case we're using INT32 to ensure we can pack
-     * 16 and 24-bit frames */
-    packed = (UINT8 *)malloc(sizeof(INT32) * 2 * BUFFER_LEN);
-    if(packed == NULL) {
-        fprintf(stderr,"out of memory\n");
-        return 1;
+    if(batch_mode) {
+        return render_batch(argv[0],argv[1]);
     }
+    return render_single(argv[0],argv[1]);
+}
+
+/* sets up a player with all engines and the output settings from the command line */
+static PlayerA *create_player(void) {
+    PlayerA *player = new PlayerA;
 
     /* Register all player engines.
      * libvgm will automatically choose the correct one depending on the file format. */
-    player.RegisterPlayerEngine(new VGMPlayer);
-    player.RegisterPlayerEngine(new S98Player);
-    player.RegisterPlayerEngine(new DROPlayer);
-    player.RegisterPlayerEngine(new GYMPlayer);
+    player->RegisterPlayerEngine(new VGMPlayer);
+    player->RegisterPlayerEngine(new S98Player);
+    player->RegisterPlayerEngine(new DROPlayer);
+    player->RegisterPlayerEngine(new GYMPlayer);
 
     /* setup the player's output parameters and allocate internal buffers */
-    if (player.SetOutputSettings(sample_rate, 2, bit_depth, BUFFER_LEN)) {
+    if (player->SetOutputSettings(sample_rate, 2, bit_depth, BUFFER_LEN,
+                                  float_output ? PLAYSMPL_FLOAT : PLAYSMPL_INT)) {
         fprintf(stderr, "Unsupported sample rate / bps\n");
-        return 1;
+        delete player;
+        return NULL;
     }
 
     /* set playback parameters */
     {
-        PlayerA::Config pCfg = player.GetConfiguration();
+        PlayerA::Config pCfg = player->GetConfiguration();
         pCfg.masterVol = 0x10000;	// == 1.0 == 100%
         pCfg.loopCount = loops;
         pCfg.fadeSmpls = (UINT32)(sample_rate * fade_len);
         pCfg.endSilenceSmpls = 0;
         pCfg.pbSpeed = 1.0;
-        player.SetConfiguration(pCfg);
+        player->SetConfiguration(pCfg);
     }
 
-    if (!strcmp(argv[1], "-")) {
-        f = stdout;
-#ifdef _WIN32
-        _setmode(_fileno(f), _O_BINARY);	// force binary output mode
-#endif
-    }
-    else {
-        f = fopen(argv[1],"wb");
-    }
-    if(f == NULL) {
-        fprintf(stderr,"unable to open output file\n");
-        return 1;
-    }
+    return player;
+}
+
+/* renders one file, returns 0 on success
+ * verbose: print tags, device info and a progress bar
+ * renderedFrames: receives the number of rendered frames */
+static int render_file(PlayerA *player, const char *inFile, const char *outFile, UINT8 *packed,
+                       int verbose, unsigned int *renderedFrames) {
+    PlayerBase* plrEngine;
+
+    unsigned int totalFrames;
+    unsigned int curFrames;
+    const char *const *tags;
+    FILE *f;
+    DATA_LOADER *loader;
+    double complete;
+    double inc;
+
+    complete = 0.0;
+    inc = 0.0;
+    *renderedFrames = 0;
 
     /* past all the boilerplate now!
      * create a FileLoader object - able to read gzip'd
-     * files on-the-fly */
+     * files on-the-fly. Uncompressed files are mapped into
+     * memory instead of being copied. */
 
-    loader = FileLoader_Init(argv[0]);
+    loader = FileLoader_InitMapped(inFile);
     if(loader == NULL) {
-        fprintf(stderr,"failed to create FileLoader\n");
+        fprintf(stderr,"%s: failed to create FileLoader\n",inFile);
         return 1;
     }
 
     /* attempt to load 256 bytes, bail if not possible */
     DataLoader_SetPreloadBytes(loader,0x100);
     if(DataLoader_Load(loader)) {
-        fprintf(stderr,"failed to load DataLoader\n");
+        fprintf(stderr,"%s: failed to load DataLoader\n",inFile);
         DataLoader_Deinit(loader);
         return 1;
     }
 
     /* associate the fileloader to the player -
      * automatically reads the rest of the file */
-    if(player.LoadFile(loader)) {
-        fprintf(stderr,"failed to load file\n");
+    if(player->LoadFile(loader)) {
+        fprintf(stderr,"%s: failed to load file\n",inFile);
+        DataLoader_Deinit(loader);
+        return 1;
+    }
+    plrEngine = player->GetPlayer();
+
+    if (!strcmp(outFile, "-")) {
+        f = stdout;
+#ifdef _WIN32
+        _setmode(_fileno(f), _O_BINARY);	// force binary output mode
+#endif
+    }
+    else {
+        f = fopen(outFile,"wb");
+    }
+    if(f == NULL) {
+        fprintf(stderr,"%s: unable to open output file\n",outFile);
+        player->UnloadFile();
+        DataLoader_Deinit(loader);
         return 1;
     }
-    plrEngine = player.GetPlayer();
 
     if (plrEngine->GetPlayerType() == FCC_VGM)
     {
         VGMPlayer* vgmplay = dynamic_cast<VGMPlayer*>(plrEngine);
-        player.SetLoopCount(vgmplay->GetModifiedLoopCount(loops));
+        player->SetLoopCount(vgmplay->GetModifiedLoopCount(loops));
     }
 
     /* example for setting cores */
@@ -307,18 +385,22 @@ int main(int argc, const char *argv[]) {
      * if we wanted to get *really* fancy we could add
      * an "id3 " chunk or "LIST" "INFO" chunk to the
      * wave file. */
-    tags = plrEngine->GetTags();
-    while(*tags) {
-        fprintf(stderr,"%s: %s\n",tags[0],tags[1]);
-        tags += 2;
+    if(verbose) {
+        tags = plrEngine->GetTags();
+        while(*tags) {
+            fprintf(stderr,"%s: %s\n",tags[0],tags[1]);
+            tags += 2;
+        }
     }
 
     /* need to call Start before calls like Tick2Sample or
      * checking any kind of timing info, because
      * Start updates the sample rate multiplier/divisors */
-    player.Start();
+    player->Start();
 
-    dump_info(plrEngine);
+    if(verbose) {
+        dump_info(plrEngine);
+    }
 
     /* libvgm uses the term "Sample" but its' really a PCM frame! */
     /* In a mono configuration, 1 frame = 1 sample, in a stereo
@@ -330,15 +412,18 @@ int main(int argc, const char *argv[]) {
     /* we only want to fade if there's a looping section. Assumption is
      * if the VGM doesn't specify a loop, it's a song with an actual ending */
     if(plrEngine->GetLoopTicks() > 0) {
-        totalFrames += player.GetFadeSamples();
+        totalFrames += player->GetFadeSamples();
     }
+    *renderedFrames = totalFrames;
 
     /* Let's tell the user what we're doing */
-    fprintf(stderr,"Rendering %s to %s\n",argv[0],argv[1]);
-    fprintf(stderr,"Samplerate: %u\n",sample_rate);
-    fprintf(stderr,"BPS: %u\n",bit_depth);
-    fprintf(stderr,"Channels: 2\n");
-    fprintf(stderr,"Length: %s\n",fmt_time(plrEngine->Sample2Second(totalFrames)));
+    if(verbose) {
+        fprintf(stderr,"Rendering %s to %s\n",inFile,outFile);
+        fprintf(stderr,"Samplerate: %u\n",sample_rate);
+        fprintf(stderr,"BPS: %u%s\n",bit_depth,float_output ? " (float)" : "");
+        fprintf(stderr,"Channels: 2\n");
+        fprintf(stderr,"Length: %s\n",fmt_time(plrEngine->Sample2Second(totalFrames)));
+    }
 
     write_wav_header(f,totalFrames);
 
@@ -347,8 +432,10 @@ int main(int argc, const char *argv[]) {
 
     /* we'll just print a '-' character each time we've hit the
      * next 10% of the file */
-    fprintf(stderr,"[");
-    fflush(stderr);
+    if(verbose) {
+        fprintf(stderr,"[");
+        fflush(stderr);
+    }
 
     while(totalFrames) {
 
@@ -357,7 +444,7 @@ int main(int argc, const char *argv[]) {
         /* default to BUFFER_LEN PCM frames unless we have under BUFFER_LEN remaining */
         curFrames = (BUFFER_LEN > totalFrames ? totalFrames : BUFFER_LEN);
 
-        player.Render(curFrames * ((bit_depth / 8) * 2),packed);
+        player->Render(curFrames * ((bit_depth / 8) * 2),packed);
 
         /* convert machine-native frames into little-endian bytes */
         /* if this were a plugin in a music player, we likely wouldn't
@@ -375,24 +462,357 @@ int main(int argc, const char *argv[]) {
 
         /* if we've done the next 10% of rendering, update the progress bar */
         complete += inc;
-        if(complete >= 0.10) {
+        if(verbose && complete >= 0.10) {
             complete -= 0.10;
             fprintf(stderr,"-");
             fflush(stderr);
         }
     }
-    fprintf(stderr,"]\n");
-    player.Stop();
-    player.UnloadFile();
+    if(verbose) {
+        fprintf(stderr,"]\n");
+    }
+    player->Stop();
+    player->UnloadFile();
 
-    free(packed);
-    player.UnregisterAllPlayers();
     DataLoader_Deinit(loader);
-    fclose(f);
+    if(f != stdout) {
+        fclose(f);
+    }
+
+    return 0;
+}
+
+static int render_single(const char *inFile, const char *outFile) {
+    PlayerA *player;
+    UINT8 *packed;
+    unsigned int frames;
+    int retVal;
+
+    /* if we were writing a library that uses libvgm, we'd want
+     * to have way better clean-up of resources when we see an error
+     * (free all our allocated memory, close files, etc).
+     * Since this is just a CLI app, we can just quit and let
+     * the OS handle everything. */
+
+    /* we'll want to make sure to pack our audio samples
+     * into little-endian, interleaved format.
+     * If we only supported 16-bit samples this could be
+     * malloc(sizeof(INT16) * 2 * BUFFER_LEN) - but in
+     * this case we're using INT32 to ensure we can pack
+     * 16 and 24-bit frames */
+    packed = (UINT8 *)malloc(sizeof(INT32) * 2 * BUFFER_LEN);
+    if(packed == NULL) {
+        fprintf(stderr,"out of memory\n");
+        return 1;
+    }
+
+    player = create_player();
+    if(player == NULL) {
+        return 1;
+    }
+
+    retVal = render_file(player,inFile,outFile,packed,1,&frames);
+
+    free(packed);
+    delete player;	// also unregisters all player engines
+
+    return retVal;
+}
+
+/* ---- batch mode ---- */
+/* Every worker has its own PlayerA (with its own player engines and sound devices)
+ * and takes the next file from the shared list as soon as it is done with the previous one. */
+typedef struct batch_worker {
+    OS_THREAD *thread;
+    PlayerA *player;
+    UINT8 *packed;
+    unsigned int files;
+    unsigned int failed;
+    double audioSecs;
+} BATCH_WORKER;
+
+static std::vector<std::string> batch_inFiles;
+static std::vector<std::string> batch_outFiles;
+static std::string batch_outDir;
+static size_t batch_nextFile = 0;
+static OS_MUTEX *batch_mutex = NULL;
+
+static double get_time_sec(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER cnt;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+}
 
+static unsigned int get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    return (unsigned int)sysInfo.dwNumberOfProcessors;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (unsigned int)cpus : 1;
+#endif
+}
+
+static int is_batch_file_ext(const char *fileName) {
+    static const char *exts[] = {".vgm", ".vgz", ".s98", ".dro", ".gym", NULL};
+    const char *ext = strrchr(fileName,'.');
+    unsigned int i;
+
+    if(ext == NULL) return 0;
+    for(i=0;exts[i] != NULL;i++) {
+        if(!strcasecmp(ext,exts[i])) return 1;
+    }
     return 0;
 }
 
+/* collects the input files from a directory (non-recursive) or a list file, returns 0 on success */
+static int collect_batch_files(const char *src, std::vector<std::string> &files) {
+#ifdef _WIN32
+    std::string pattern = std::string(src) + "\\*";
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA(pattern.c_str(),&findData);
+    if(hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            if(is_batch_file_ext(findData.cFileName))
+                files.push_back(std::string(src) + "\\" + findData.cFileName);
+        } while(FindNextFileA(hFind,&findData));
+        FindClose(hFind);
+        std::sort(files.begin(),files.end());
+        return 0;
+    }
+#else
+    DIR *dir = opendir(src);
+    if(dir != NULL) {
+        struct dirent *entry;
+        while((entry = readdir(dir)) != NULL) {
+            if(entry->d_name[0] == '.') continue;
+            if(is_batch_file_ext(entry->d_name))
+                files.push_back(std::string(src) + "/" + entry->d_name);
+        }
+        closedir(dir);
+        std::sort(files.begin(),files.end());
+        return 0;
+    }
+#endif
+
+    /* not a directory - read a list with one file path per line */
+    {
+        char line[0x1000];
+        FILE *f = fopen(src,"r");
+        if(f == NULL) {
+            fprintf(stderr,"unable to open file list %s\n",src);
+            return 1;
+        }
+        while(fgets(line,sizeof(line),f) != NULL) {
+            size_t len = strlen(line);
+            while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+                line[--len] = '\0';
+            }
+            if(len == 0 || line[0] == '#') continue;
+            files.push_back(line);
+        }
+        fclose(f);
+    }
+    return 0;
+}
+
+static std::string remove_ext(const std::string &name) {
+    size_t extPos = name.rfind('.');
+    if(extPos != std::string::npos && extPos > 0) {
+        return name.substr(0,extPos);
+    }
+    return name;
+}
+
+static std::string lower_case(std::string str) {
+    size_t i;
+    for(i=0;i<str.size();i++) {
+        str[i] = (char)tolower((unsigned char)str[i]);
+    }
+    return str;
+}
+
+/* Output files: <output directory>/<input file name without extension>.wav
+ * Every input file gets its own output file, so that no two workers write to the same file:
+ * - when several input files have the same name without extension (song.vgm, song.vgz),
+ *   the extension is kept (song.vgm.wav, song.vgz.wav)
+ * - remaining duplicates (same file name in different directories) get a number (song_2.wav)
+ * Names are compared case-insensitively, as the file system may be case-insensitive. */
+static void batch_out_paths(const std::vector<std::string> &inFiles, std::vector<std::string> &outFiles) {
+    std::vector<std::string> names(inFiles.size());
+    std::map<std::string, std::set<std::string> > baseNames; /* base name -> all file names with it */
+    std::set<std::string> usedNames;
+    size_t i;
+
+    for(i=0;i<inFiles.size();i++) {
+        size_t namePos = inFiles[i].find_last_of("/\\");
+        names[i] = (namePos == std::string::npos) ? inFiles[i] : inFiles[i].substr(namePos + 1);
+        baseNames[lower_case(remove_ext(names[i]))].insert(lower_case(names[i]));
+    }
+
+    outFiles.resize(inFiles.size());
+    for(i=0;i<inFiles.size();i++) {
+        std::string name = names[i];
+        std::string outName;
+        unsigned int dupID;
+
+        if(baseNames[lower_case(remove_ext(name))].size() <= 1) {
+            name = remove_ext(name);
+        }
+        outName = name;
+        for(dupID = 2; usedNames.find(lower_case(outName)) != usedNames.end(); dupID ++) {
+            char suffix[0x10];
+            sprintf(suffix,"_%u",dupID);
+            outName = name + suffix;
+        }
+        usedNames.insert(lower_case(outName));
+        outFiles[i] = batch_outDir + "/" + outName + ".wav";
+        if(outName != remove_ext(names[i])) {
+            fprintf(stderr,"%s: output name %s.wav is used by another file, using %s.wav\n",
+              inFiles[i].c_str(),remove_ext(names[i]).c_str(),outName.c_str());
+        }
+    }
+    return;
+}
+
+static void batch_worker_main(void *args) {
+    BATCH_WORKER *wrk = (BATCH_WORKER *)args;
+
+    while(1) {
+        size_t fileID;
+        std::string outFile;
+        unsigned int frames;
+        double startTime;
+        double renderTime;
+        double audioSecs;
+        int retVal;
+
+        OSMutex_Lock(batch_mutex);
+        fileID = batch_nextFile;
+        if(batch_nextFile < batch_inFiles.size()) {
+            batch_nextFile ++;
+        }
+        OSMutex_Unlock(batch_mutex);
+        if(fileID >= batch_inFiles.size()) break;
+
+        outFile = batch_outFiles[fileID];
+        startTime = get_time_sec();
+        retVal = render_file(wrk->player,batch_inFiles[fileID].c_str(),outFile.c_str(),wrk->packed,0,&frames);
+        renderTime = get_time_sec() - startTime;
+        audioSecs = (double)frames / sample_rate;
+
+        wrk->files ++;
+        if(retVal) {
+            wrk->failed ++;
+            continue;
+        }
+        wrk->audioSecs += audioSecs;
+        fprintf(stderr,"[%u/%u] %s: %.1f s in %.2f s (%.1fx realtime)\n",
+          (unsigned int)fileID + 1,(unsigned int)batch_inFiles.size(),
+          batch_inFiles[fileID].c_str(),audioSecs,renderTime,
+          (renderTime > 0.0) ? audioSecs / renderTime : 0.0);
+    }
+    return;
+}
+
+static int render_batch(const char *src, const char *outDir) {
+    /* ROM/PCM data shared by all workers (tracks of the same game often use the same data) */
+    RomCache romCache;
+    std::vector<BATCH_WORKER> workers;
+    unsigned int jobs;
+    unsigned int i;
+    unsigned int files;
+    unsigned int failed;
+    double audioSecs;
+    double startTime;
+    double totalTime;
+
+    if(collect_batch_files(src,batch_inFiles)) {
+        return 1;
+    }
+    if(batch_inFiles.empty()) {
+        fprintf(stderr,"no files to render\n");
+        return 1;
+    }
+    batch_outDir = outDir;
+    batch_out_paths(batch_inFiles,batch_outFiles);
+    batch_nextFile = 0;
+
+    jobs = batch_jobs ? batch_jobs : get_cpu_count();
+    if(jobs > batch_inFiles.size()) {
+        jobs = (unsigned int)batch_inFiles.size();
+    }
+    if(OSMutex_Init(&batch_mutex,0)) {
+        fprintf(stderr,"failed to create mutex\n");
+        return 1;
+    }
+    fprintf(stderr,"Rendering %u files with %u jobs\n",(unsigned int)batch_inFiles.size(),jobs);
+
+    startTime = get_time_sec();
+    workers.resize(jobs);
+    for(i=0;i<jobs;i++) {
+        BATCH_WORKER &wrk = workers[i];
+        wrk.thread = NULL;
+        wrk.files = 0;
+        wrk.failed = 0;
+        wrk.audioSecs = 0.0;
+        wrk.packed = (UINT8 *)malloc(sizeof(INT32) * 2 * BUFFER_LEN);
+        wrk.player = create_player();
+        if(wrk.packed == NULL || wrk.player == NULL) {
+            fprintf(stderr,"failed to set up worker %u\n",i);
+            continue;
+        }
+        {
+            const std::vector<PlayerBase*>& engines = wrk.player->GetRegisteredPlayers();
+            for(size_t e=0;e<engines.size();e++) {
+                engines[e]->SetRomCache(&romCache);
+            }
+        }
+        if(OSThread_Init(&wrk.thread,batch_worker_main,&wrk)) {
+            fprintf(stderr,"failed to start worker thread %u\n",i);
+            wrk.thread = NULL;
+        }
+    }
+
+    files = 0;
+    failed = 0;
+    audioSecs = 0.0;
+    for(i=0;i<jobs;i++) {
+        BATCH_WORKER &wrk = workers[i];
+        if(wrk.thread != NULL) {
+            OSThread_Join(wrk.thread);
+            OSThread_Deinit(wrk.thread);
+        }
+        files += wrk.files;
+        failed += wrk.failed;
+        audioSecs += wrk.audioSecs;
+        delete wrk.player;
+        free(wrk.packed);
+    }
+    totalTime = get_time_sec() - startTime;
+    OSMutex_Deinit(batch_mutex);
+    batch_mutex = NULL;
+
+    /* files that no worker got to (only possible when all workers failed to start) */
+    failed += (unsigned int)batch_inFiles.size() - files;
+
+    fprintf(stderr,"Rendered %u files (%u failed): %.1f s of audio in %.2f s (%.1fx realtime)\n",
+      (unsigned int)batch_inFiles.size() - failed,failed,audioSecs,totalTime,
+      (totalTime > 0.0) ? audioSecs / totalTime : 0.0);
+
+    return failed ? 1 : 0;
+}
+
 static void set_core(PlayerBase *player, UINT8 devId, UINT32 coreId) {
     PLR_DEV_OPTS devOpts;
     UINT32 id;
@@ -595,7 +1015,7 @@ static int write_wav_header(FILE *f, unsigned int totalFrames) {
     if(fwrite(tmp,1,4,f) != 4) return 0;
 
     /* subformatcode - same as above audioFormat */
-    pack_uint16le(tmp,1);
+    pack_uint16le(tmp,float_output ? 3 : 1);
     if(fwrite(tmp,1,2,f) != 2) return 0;
 
     /* rest of the GUID */
@@ -613,7 +1033,7 @@ static void frames_to_little_endian(UINT8 *data, unsigned int frame_count) {
     unsigned int i = 0;
     while(i<frame_count) {
         switch(bit_depth) {
-            case 32: {
+            case 32: { /* also used for floats, it only swaps bytes */
                 repack_int32le(&data[0], &data[0]);
                 repack_int32le(&data[4], &data[4]);
                 break;
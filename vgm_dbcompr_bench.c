@@ -1,20 +1,26 @@
 #ifdef WIN32
 #include <Windows.h>
+#else
+#include <time.h>
 #endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common_def.h"
-#include "vgm/dblk_compr.h"
+#include "player/dblk_compr.h"
 
 
 INLINE UINT32 GetSysTimeMS(void);
+static UINT32 VerifyDecompression(void);
 static UINT8 DecompressDataBlk_Old(UINT32 OutDataLen, UINT8* OutData, UINT32 InDataLen, const UINT8* InData, const PCM_COMPR_TBL* comprTbl);
 static void CompressDataBlk_Old(UINT32 outLen, UINT8* outData, UINT32 inLen, const UINT8* inData, PCM_CMP_INF* ComprTbl);
 UINT16 DataBlkCompr_GetIntSize(void);
 
 // ---- Benchmarks ----
-// 256 MB of input data
+// 256 MB of input data (can be changed using the first command line argument)
+// Before benchmarking, the results of DecompressDataBlk are checked against the old implementation.
+// The benchmark itself compares the decompressed data of the old and new implementation as well.
 //	8-bit version: decompressed from 3 -> 8 bits (fits into UINT8)
 //	16-bit version: decompressed from 5 -> 12 bits (fits into UINT16)
 // All algorithms were executed once for warm up, then 4x for benchmarking.
@@ -58,7 +64,7 @@ typedef struct
 	UINT8 canCompr;
 } BENCH_LIST;
 
-#define BENCH_SIZE		256	// compressed data size in MB
+#define BENCH_SIZE		256	// default compressed data size in MB
 #define BENCH_WARM_REP	1	// number of times for warm up
 #define BENCH_REPEAT	4	// number of times the benchmark is repeated
 static UINT32 dblk_benchTime;
@@ -99,15 +105,19 @@ static void GenerateComprStr(char* buffer, UINT8 comprType, UINT8 subType, UINT8
 
 int main(int argc, char* argv[])
 {
-	UINT8 DPCMTbl[0x20] =
+	UINT8 DPCMTbl8[0x08] =
+	{
+		0x00, 0x01, 0x04, 0x10,-0x10,-0x04,-0x01, 0x80
+	};
+	UINT16 DPCMTbl16[0x20] =
 	{
-		0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40,
-		0x80,-0x01,-0x02,-0x04,-0x08,-0x10,-0x20,-0x40,
-		0x00, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04,
-		0x80,-0x10,-0x20,-0x40,-0x80,-0x01,-0x02,-0x04
+		0x000, 0x001, 0x002, 0x004, 0x008, 0x010, 0x020, 0x040,
+		0x080,-0x001,-0x002,-0x004,-0x008,-0x010,-0x020,-0x040,
+		0x000, 0x010, 0x020, 0x040, 0x080, 0x100, 0x200, 0x400,
+		0x800,-0x010,-0x020,-0x040,-0x080,-0x100,-0x200,-0x400
 	};
-	PCM_COMPR_TBL PCMTbl8 = {0x01, 0, 8, 3, 0x20, {DPCMTbl}};
-	PCM_COMPR_TBL PCMTbl16 = {0x01, 0, 12, 5, 0x20, {DPCMTbl}};
+	PCM_COMPR_TBL PCMTbl8 = {0x01, 0, 8, 3, 0x08, {DPCMTbl8}};
+	PCM_COMPR_TBL PCMTbl16 = {0x01, 0, 12, 5, 0x20, {NULL}};
 	PCM_CDB_INF cdbInf8 = {0, 0, {0x00, 0x00, 8, 3, 0x00, &PCMTbl8}};		// 3 -> 8 bits
 	PCM_CDB_INF cdbInf16 = {0, 0, {0x00, 0x00, 12, 5, 0x00, &PCMTbl16}};	// 5 -> 12 bits
 	PCM_CMP_INF* cmpInf8 = &cdbInf8.cmprInfo;
@@ -123,6 +133,10 @@ int main(int argc, char* argv[])
 	UINT8* dataRaw;
 	UINT32 decLen;
 	UINT8* decData;
+	UINT8* decDataOld;
+	UINT32 cmpLen;
+	UINT32 benchSize;
+	UINT32 errCnt;
 	UINT32 repCntr;
 	UINT32 curBench;
 	UINT32 curBT;
@@ -145,21 +159,43 @@ int main(int argc, char* argv[])
 		getchar();
 		return 0;
 	}*/
+	PCMTbl16.values.d16 = DPCMTbl16;
 	repCntr = DataBlkCompr_GetIntSize();
 	bitsFU8 = ((repCntr >> 0) & 0xFF) * 8;
 	bitsFU16 = ((repCntr >> 8) & 0xFF) * 8;
 	
-	dataLenRaw = BENCH_SIZE * 1048576;
+	benchSize = BENCH_SIZE;
+	if (argc >= 2)
+	{
+		benchSize = (UINT32)strtoul(argv[1], NULL, 0);
+		if (benchSize < 1 || benchSize > 1024)
+		{
+			printf("Usage: %s [data size in MB (1..1024)]\n", argv[0]);
+			return 1;
+		}
+	}
+	
+	errCnt = VerifyDecompression();
+	if (errCnt)
+	{
+		printf("Verification failed! %u mismatches found.\n", errCnt);
+		return 2;
+	}
+	printf("Verification passed.\n");
+	
+	dataLenRaw = benchSize * 1048576;
 	cdbInf8.decmpLen = BPACK_SIZE_DEC(dataLenRaw, cmpInf8->bitsCmp, cmpInf8->bitsDec);
 	cdbInf16.decmpLen = BPACK_SIZE_DEC(dataLenRaw, cmpInf16->bitsCmp, cmpInf16->bitsDec);
 	decLen = (cdbInf8.decmpLen < cdbInf16.decmpLen) ? cdbInf16.decmpLen : cdbInf8.decmpLen;
 	
 	dataLen = 0x0A + dataLenRaw;	// including VGM data block header
-	data = (UINT8*)malloc(dataLen);
+	data = (UINT8*)malloc(dataLen + 0x10);	// the old routine may read 1 byte too much
 	dataRaw = &data[0x0A];
 	memset(data, 0x00, 0x0A);
 	memset(dataRaw, bytePattern, dataLenRaw);
-	decData = (UINT8*)malloc(decLen);
+	memset(&dataRaw[dataLenRaw], 0x00, 0x10);
+	decData = (UINT8*)malloc(decLen + 0x10);
+	decDataOld = (UINT8*)malloc(decLen + 0x10);	// the old routine may write 1 value too much
 	
 	if (verbosity >= 1)
 	{
@@ -191,7 +227,7 @@ int main(int argc, char* argv[])
 			
 			// ---- decompression benchmark ----
 			WriteComprDataBlkHdr(dataLen, data, tempCDB);
-			DecompressDataBlk_Old(decLen, decData, dataLen, data, tempCInf->comprTbl);
+			DecompressDataBlk_Old(decLen, decDataOld, dataLen, data, tempCInf->comprTbl);
 			if (repCntr >= BENCH_WARM_REP)
 				benchTime[curBT + 0x00] += dblk_benchTime;
 			if (verbosity >= 2)
@@ -204,6 +240,14 @@ int main(int argc, char* argv[])
 				printf("Decompression Time [new]: %u\n", dblk_benchTime);
 			if (repCntr >= BENCH_WARM_REP)
 				benchTime[curBT + 0x01] += dblk_benchTime;
+			// only compare complete values, the old routine handles incomplete ones differently
+			cmpLen = tempCDB->decmpLen & ~((tempCInf->bitsDec + 7) / 8 - 1);
+			if (memcmp(decData, decDataOld, cmpLen))
+			{
+				GenerateComprStr(comprStr, tempBL->comprType, tempBL->subType, tempBL->bits);
+				printf("Error: Decompression mismatch for %s!\n", comprStr);
+				errCnt ++;
+			}
 			
 			if (tempBL->canCompr)
 			{
@@ -227,6 +271,7 @@ int main(int argc, char* argv[])
 	}
 	free(data);
 	free(decData);
+	free(decDataOld);
 	if (verbosity >= 1)
 		printf("\n");
 	
@@ -260,7 +305,7 @@ int main(int argc, char* argv[])
 #if defined(_MSC_VER) && defined(_DEBUG)
 	getchar();
 #endif
-	return 0;
+	return errCnt ? 2 : 0;
 }
 
 INLINE UINT32 GetSysTimeMS(void)
@@ -268,10 +313,116 @@ INLINE UINT32 GetSysTimeMS(void)
 #ifdef WIN32
 	return GetTickCount();
 #else
-	return 0;
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT32)ts.tv_sec * 1000 + (UINT32)(ts.tv_nsec / 1000000);
 #endif
 }
 
+static UINT32 rngState = 1;
+INLINE UINT32 NextRandom(void)
+{
+	// simple LCG, good enough for generating test data
+	rngState = rngState * 1103515245 + 12345;
+	return rngState >> 8;
+}
+
+static UINT32 VerifyDecompression(void)
+{
+	// value counts are chosen to hit the boundaries of the 8/16-value SIMD groups and 1024-value chunks
+	static const UINT32 VALUE_COUNTS[] = {1, 2, 7, 8, 9, 15, 16, 17, 31, 33, 100, 1023, 1024, 1025, 2048, 5003};
+	const UINT32 countCnt = sizeof(VALUE_COUNTS) / sizeof(VALUE_COUNTS[0]);
+	const UINT32 maxValues = 5003;
+	UINT8* lut8;
+	UINT16* lut16;
+	UINT8* inData;
+	UINT8* outOld;
+	UINT8* outNew;
+	PCM_COMPR_TBL pcmTbl;
+	PCM_CDB_INF cdbInf;
+	PCM_CMP_INF* cInf = &cdbInf.cmprInfo;
+	UINT8 valSize;
+	UINT8 bitsCmp;
+	UINT8 cmpMode;	// 0..2 - Bit Packing (sub-type), 3 - DPCM
+	UINT32 curCnt;
+	UINT32 curPos;
+	UINT32 inLen;
+	UINT32 outLen;
+	UINT32 errCnt;
+	char comprStr[0x20];
+	
+	lut8 = (UINT8*)malloc(0x100 * sizeof(UINT8));
+	lut16 = (UINT16*)malloc(0x10000 * sizeof(UINT16));
+	inData = (UINT8*)malloc(0x0A + maxValues * 2 + 0x10);
+	outOld = (UINT8*)malloc(maxValues * 2 + 0x10);
+	outNew = (UINT8*)malloc(maxValues * 2 + 0x10);
+	for (curPos = 0; curPos < 0x100; curPos ++)
+		lut8[curPos] = (UINT8)NextRandom();
+	for (curPos = 0; curPos < 0x10000; curPos ++)
+		lut16[curPos] = (UINT16)NextRandom();
+	
+	errCnt = 0;
+	for (valSize = 1; valSize <= 2; valSize ++)
+	{
+		for (bitsCmp = 1; bitsCmp <= valSize * 8; bitsCmp ++)
+		{
+			for (cmpMode = 0; cmpMode < 4; cmpMode ++)
+			{
+				cInf->comprType = (cmpMode < 3) ? 0x00 : 0x01;
+				cInf->subType = (cmpMode < 3) ? cmpMode : 0x00;
+				cInf->bitsDec = valSize * 8;
+				cInf->bitsCmp = bitsCmp;
+				cInf->baseVal = (UINT16)NextRandom();
+				cInf->comprTbl = &pcmTbl;
+				pcmTbl.comprType = cInf->comprType;
+				pcmTbl.cmpSubType = cInf->subType;
+				pcmTbl.bitsDec = cInf->bitsDec;
+				pcmTbl.bitsCmp = cInf->bitsCmp;
+				pcmTbl.valueCount = (UINT16)(1 << bitsCmp);	// Note: 0x10000 becomes 0, use 1 instead
+				if (! pcmTbl.valueCount)
+					pcmTbl.valueCount = 1;
+				if (valSize == 1)
+					pcmTbl.values.d8 = lut8;
+				else
+					pcmTbl.values.d16 = lut16;
+				
+				for (curCnt = 0; curCnt < countCnt; curCnt ++)
+				{
+					inLen = (VALUE_COUNTS[curCnt] * bitsCmp + 7) / 8;
+					outLen = VALUE_COUNTS[curCnt] * valSize;
+					if (valSize == 2 && (VALUE_COUNTS[curCnt] & 1))
+						outLen --;	// check odd output sizes as well
+					cdbInf.decmpLen = outLen;
+					WriteComprDataBlkHdr(0x0A, inData, &cdbInf);
+					for (curPos = 0; curPos < inLen; curPos ++)
+						inData[0x0A + curPos] = (UINT8)NextRandom();
+					memset(outOld, 0xCC, maxValues * 2 + 0x10);
+					memset(outNew, 0xCC, maxValues * 2 + 0x10);
+					
+					DecompressDataBlk_Old(outLen, outOld, 0x0A + inLen, inData, &pcmTbl);
+					DecompressDataBlk(outLen, outNew, inLen, &inData[0x0A], cInf);
+					// the new routine must not write beyond the end of the buffer
+					if (memcmp(outOld, outNew, outLen) || outNew[outLen] != 0xCC)
+					{
+						GenerateComprStr(comprStr, cInf->comprType, cInf->subType, bitsCmp);
+						printf("Mismatch: %s -> %u bits, %u values\n", comprStr, cInf->bitsDec, VALUE_COUNTS[curCnt]);
+						errCnt ++;
+					}
+				}
+			}
+		}
+	}
+	
+	free(lut8);
+	free(lut16);
+	free(inData);
+	free(outOld);
+	free(outNew);
+	
+	return errCnt;
+}
+
 void compression_test(void)
 {
 	PCM_CDB_INF cdbInf8 = {0, 0, {0x00, 0x01, 8, 4, 0x00, NULL}};		// 8 -> 4 bits